@@ -115,9 +115,20 @@ typedef struct aas_settings_s
 	qboolean sv_allowladders;
 } aas_settings_t;
 
+//routing cache types
+#define CACHETYPE_PORTAL        0
+#define CACHETYPE_AREA          1
+
+//routing cache flags
+#define RCF_HEAP                1               //allocated from the heap instead of the arena
+#define RCF_LRU                 2               //linked into the least recently used list of the size class
+
 //routing cache
 typedef struct aas_routingcache_s
 {
+	byte type;                                  //portal or area cache
+	byte flags;                                 //routing cache flags
+	short sizeclass;                            //arena size class, -1 if none
 	int size;                                   //size of the routing cache
 	float time;                                 //last time accessed or updated
 	int cluster;                                //cluster the cache is for
@@ -126,10 +137,39 @@ typedef struct aas_routingcache_s
 	float starttraveltime;                      //travel time to start with
 	int travelflags;                            //combinations of the travel flags
 	struct aas_routingcache_s *prev, *next;
+	struct aas_routingcache_s *time_prev, *time_next;   //least recently used list
 	unsigned char *reachabilities;              //reachabilities used for routing
-	unsigned short int traveltimes[1];          //travel time for every area (variable sized)
+	unsigned short int *traveltimes;            //travel time for every area, follows the cache or points into the route cache file
 } aas_routingcache_t;
 
+//routing cache arena
+#define RC_NUMSIZECLASSES       64              //cache sizes from 64 bytes up to 3.5 MB
+#define RC_SLABSIZE             0x10000         //minimum size of the slabs the caches are carved from
+
+typedef struct aas_cacheclass_s
+{
+	int size;                                   //size of every cache in this class
+	int numslabs;                               //number of slabs handed to this class
+	aas_routingcache_t *freecaches;             //free caches linked through next
+	aas_routingcache_t *oldestcache;            //least recently used cache
+	aas_routingcache_t *newestcache;            //most recently used cache
+} aas_cacheclass_t;
+
+typedef struct aas_cachearena_s
+{
+	int slabsize;                               //size of a single slab
+	int numslabs;                               //number of slabs allocated
+	int maxslabs;                               //number of slabs that fit in the budget
+	byte **slabs;                               //the slabs
+	aas_cacheclass_t classes[2][RC_NUMSIZECLASSES];     //size classes per cache type
+	qboolean noevict;                           //true while caches may not be evicted
+	//statistics
+	int hits;                                   //cache lookups that found a cache
+	int misses;                                 //cache lookups that had to create a cache
+	int evictions;                              //caches evicted to make room
+	int heapcaches;                             //caches that did not fit in the arena
+} aas_cachearena_t;
+
 //fields for the routing algorithm
 typedef struct aas_routingupdate_s
 {
@@ -245,6 +285,12 @@ typedef struct aas_s
 	//array of size numclusters with cluster cache
 	aas_routingcache_t ***clusterareacache;
 	aas_routingcache_t **portalcache;
+	//route cache file the travel times of loaded caches point into
+	byte *routecachedata;
+	int routecachelength;
+	qboolean routecachemapped;
+	//memory the routing caches are allocated from
+	aas_cachearena_t cachearena;
 	//maximum travel time through portals
 	int *portalmaxtraveltimes;
 	// Ridah, pointer to Route-Table information
@@ -111,13 +111,23 @@ void AAS_RoutingFreeMemory( void *ptr ) {
 // Returns:				-
 // Changes Globals:		-
 //===========================================================================
-#ifdef ROUTING_DEBUG
 void AAS_RoutingInfo( void ) {
+	aas_cachearena_t *arena;
+	int lookups;
+
+	arena = &aasworld->cachearena;
+#ifdef ROUTING_DEBUG
 	botimport.Print( PRT_MESSAGE, "%d area cache updates\n", numareacacheupdates );
 	botimport.Print( PRT_MESSAGE, "%d portal cache updates\n", numportalcacheupdates );
-	botimport.Print( PRT_MESSAGE, "%d bytes routing cache\n", routingcachesize );
-} //end of the function AAS_RoutingInfo
 #endif //ROUTING_DEBUG
+	botimport.Print( PRT_MESSAGE, "%d bytes routing cache, %d KB budget\n", routingcachesize, max_routingcachesize >> 10 );
+	botimport.Print( PRT_MESSAGE, "%d of %d slabs of %d bytes in use\n", arena->numslabs, arena->maxslabs, arena->slabsize );
+	lookups = arena->hits + arena->misses;
+	botimport.Print( PRT_MESSAGE, "%d cache hits, %d misses (%1.1f%% hit rate)\n",
+					 arena->hits, arena->misses, lookups ? (float) arena->hits * 100 / lookups : 0 );
+	botimport.Print( PRT_MESSAGE, "%d caches evicted, %d caches allocated outside the budget\n",
+					 arena->evictions, arena->heapcaches );
+} //end of the function AAS_RoutingInfo
 //===========================================================================
 // returns the number of the area in the cluster
 // assumes the given area is in the given cluster or a portal of the cluster
@@ -202,6 +212,186 @@ __inline float AAS_RoutingTime( void ) {
 	return AAS_Time();
 } //end of the function AAS_RoutingTime
 
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static int AAS_RoutingCacheClassSize( int sizeclass ) {
+	int base;
+
+	//four size classes for every power of two starting at 64 bytes
+	base = 64 << ( sizeclass >> 2 );
+	return base + ( base >> 2 ) * ( sizeclass & 3 );
+} //end of the function AAS_RoutingCacheClassSize
+//===========================================================================
+// returns the smallest size class a routing cache of the given size fits
+// in or -1 if the cache is too large for any of them
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static int AAS_RoutingCacheSizeClass( int size ) {
+	int sizeclass;
+
+	for ( sizeclass = 0; sizeclass < RC_NUMSIZECLASSES; sizeclass++ )
+	{
+		if ( AAS_RoutingCacheClassSize( sizeclass ) >= size ) {
+			return sizeclass;
+		}
+	} //end for
+	return -1;
+} //end of the function AAS_RoutingCacheSizeClass
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+void AAS_FreeRoutingCacheArena( void ) {
+	aas_cachearena_t *arena;
+	int i;
+
+	arena = &aasworld->cachearena;
+	for ( i = 0; i < arena->numslabs; i++ )
+	{
+		FreeMemory( arena->slabs[i] );
+	} //end for
+	if ( arena->slabs ) {
+		FreeMemory( arena->slabs );
+	}
+	memset( arena, 0, sizeof( aas_cachearena_t ) );
+} //end of the function AAS_FreeRoutingCacheArena
+//===========================================================================
+// the routing caches are carved from slabs that are handed out to the
+// size classes on demand until max_routingcachesize is used up
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+void AAS_InitRoutingCacheArena( void ) {
+	aas_cachearena_t *arena;
+	int i, type, maxtraveltimes, sizeclass;
+
+	AAS_FreeRoutingCacheArena();
+	arena = &aasworld->cachearena;
+	//the largest cache of the world has to fit in a single slab
+	maxtraveltimes = aasworld->numportals;
+	for ( i = 0; i < aasworld->numclusters; i++ )
+	{
+		if ( aasworld->clusters[i].numreachabilityareas > maxtraveltimes ) {
+			maxtraveltimes = aasworld->clusters[i].numreachabilityareas;
+		}
+	} //end for
+	arena->slabsize = RC_SLABSIZE;
+	sizeclass = AAS_RoutingCacheSizeClass( sizeof( aas_routingcache_t ) +
+										   maxtraveltimes * ( sizeof( unsigned short int ) + sizeof( unsigned char ) ) );
+	if ( sizeclass >= 0 && AAS_RoutingCacheClassSize( sizeclass ) > arena->slabsize ) {
+		arena->slabsize = AAS_RoutingCacheClassSize( sizeclass );
+	}
+	arena->maxslabs = max_routingcachesize / arena->slabsize;
+	if ( arena->maxslabs < 1 ) {
+		arena->maxslabs = 1;
+	}
+	arena->slabs = (byte **) GetClearedMemory( arena->maxslabs * sizeof( byte * ) );
+	for ( type = 0; type < 2; type++ )
+	{
+		for ( i = 0; i < RC_NUMSIZECLASSES; i++ )
+		{
+			arena->classes[type][i].size = AAS_RoutingCacheClassSize( i );
+		} //end for
+	} //end for
+} //end of the function AAS_InitRoutingCacheArena
+//===========================================================================
+// hands a new slab to the size class and puts its caches in the free list
+//
+// Parameter:			-
+// Returns:				qfalse if the budget is used up
+// Changes Globals:		-
+//===========================================================================
+static qboolean AAS_AddRoutingCacheSlab( aas_cacheclass_t *cacheclass ) {
+	aas_cachearena_t *arena;
+	aas_routingcache_t *cache;
+	byte *slab;
+	int i;
+
+	arena = &aasworld->cachearena;
+	if ( arena->numslabs >= arena->maxslabs || cacheclass->size > arena->slabsize ) {
+		return qfalse;
+	}
+	slab = (byte *) GetMemory( arena->slabsize );
+	arena->slabs[arena->numslabs++] = slab;
+	cacheclass->numslabs++;
+	for ( i = arena->slabsize / cacheclass->size - 1; i >= 0; i-- )
+	{
+		cache = (aas_routingcache_t *) ( slab + i * cacheclass->size );
+		cache->next = cacheclass->freecaches;
+		cacheclass->freecaches = cache;
+	} //end for
+	return qtrue;
+} //end of the function AAS_AddRoutingCacheSlab
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_UnlinkCache( aas_routingcache_t *cache ) {
+	aas_cacheclass_t *cacheclass;
+
+	if ( !( cache->flags & RCF_LRU ) ) {
+		return;
+	}
+	cacheclass = &aasworld->cachearena.classes[cache->type][cache->sizeclass];
+	if ( cache->time_next ) {
+		cache->time_next->time_prev = cache->time_prev;
+	} else { cacheclass->newestcache = cache->time_prev;}
+	if ( cache->time_prev ) {
+		cache->time_prev->time_next = cache->time_next;
+	} else { cacheclass->oldestcache = cache->time_next;}
+	cache->time_next = NULL;
+	cache->time_prev = NULL;
+	cache->flags &= ~RCF_LRU;
+} //end of the function AAS_UnlinkCache
+//===========================================================================
+// links the cache in as the most recently used cache of its size class,
+// only caches in these lists are ever evicted
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_LinkCache( aas_routingcache_t *cache ) {
+	aas_cacheclass_t *cacheclass;
+
+	if ( cache->sizeclass < 0 ) {
+		return;
+	}
+	cacheclass = &aasworld->cachearena.classes[cache->type][cache->sizeclass];
+	cache->time_prev = cacheclass->newestcache;
+	cache->time_next = NULL;
+	if ( cacheclass->newestcache ) {
+		cacheclass->newestcache->time_next = cache;
+	} else { cacheclass->oldestcache = cache;}
+	cacheclass->newestcache = cache;
+	cache->flags |= RCF_LRU;
+} //end of the function AAS_LinkCache
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_CacheAccessed( aas_routingcache_t *cache ) {
+	cache->time = AAS_RoutingTime();
+	if ( cache->flags & RCF_LRU ) {
+		AAS_UnlinkCache( cache );
+		AAS_LinkCache( cache );
+	} //end if
+} //end of the function AAS_CacheAccessed
 //===========================================================================
 //
 // Parameter:			-
@@ -209,10 +399,90 @@ __inline float AAS_RoutingTime( void ) {
 // Changes Globals:		-
 //===========================================================================
 void AAS_FreeRoutingCache( aas_routingcache_t *cache ) {
+	aas_cacheclass_t *cacheclass;
+
 	routingcachesize -= cache->size;
-	AAS_RoutingFreeMemory( cache );
+	AAS_UnlinkCache( cache );
+	if ( cache->flags & RCF_HEAP ) {
+		AAS_RoutingFreeMemory( cache );
+		return;
+	} //end if
+	cacheclass = &aasworld->cachearena.classes[cache->type][cache->sizeclass];
+	cache->next = cacheclass->freecaches;
+	cacheclass->freecaches = cache;
 } //end of the function AAS_FreeRoutingCache
 //===========================================================================
+// removes the cache from the area or portal cache list it is in and frees it
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_EvictRoutingCache( aas_routingcache_t *cache ) {
+	aas_routingcache_t **link;
+
+	if ( cache->type == CACHETYPE_PORTAL ) {
+		link = &aasworld->portalcache[cache->areanum];
+	} else { link = &aasworld->clusterareacache[cache->cluster][AAS_ClusterAreaNum( cache->cluster, cache->areanum )];}
+	if ( cache->prev ) {
+		cache->prev->next = cache->next;
+	} else { *link = cache->next;}
+	if ( cache->next ) {
+		cache->next->prev = cache->prev;
+	}
+	AAS_FreeRoutingCache( cache );
+	aasworld->cachearena.evictions++;
+} //end of the function AAS_EvictRoutingCache
+//===========================================================================
+// caches come from the arena, when the budget is used up the least
+// recently used cache of the same type and size class is reused, area
+// and portal caches never share a class so filling in a portal cache
+// cannot evict it
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+aas_routingcache_t *AAS_AllocRoutingCache( int type, int numtraveltimes ) {
+	aas_cachearena_t *arena;
+	aas_cacheclass_t *cacheclass;
+	aas_routingcache_t *cache;
+	int size, sizeclass;
+
+	arena = &aasworld->cachearena;
+	size = sizeof( aas_routingcache_t ) + numtraveltimes * sizeof( unsigned short int ) + numtraveltimes * sizeof( unsigned char );
+	sizeclass = AAS_RoutingCacheSizeClass( size );
+	cache = NULL;
+	if ( sizeclass >= 0 ) {
+		cacheclass = &arena->classes[type][sizeclass];
+		if ( !cacheclass->freecaches ) {
+			AAS_AddRoutingCacheSlab( cacheclass );
+		}
+		//evicted heap caches don't free up a cache in the arena
+		while ( !cacheclass->freecaches && cacheclass->oldestcache && !arena->noevict )
+		{
+			AAS_EvictRoutingCache( cacheclass->oldestcache );
+		} //end while
+		if ( cacheclass->freecaches ) {
+			cache = cacheclass->freecaches;
+			cacheclass->freecaches = cache->next;
+			memset( cache, 0, size );
+		} //end if
+	} //end if
+	if ( !cache ) {
+		cache = (aas_routingcache_t *) AAS_RoutingGetMemory( size );
+		cache->flags = RCF_HEAP;
+		arena->heapcaches++;
+	} //end if
+	routingcachesize += size;
+	cache->type = type;
+	cache->sizeclass = sizeclass;
+	cache->traveltimes = (unsigned short int *) ( cache + 1 );
+	cache->reachabilities = (unsigned char *) ( cache->traveltimes + numtraveltimes );
+	cache->size = size;
+	return cache;
+} //end of the function AAS_AllocRoutingCache
+//===========================================================================
 //
 // Parameter:			-
 // Returns:				-
@@ -634,138 +904,6 @@ void AAS_InitPortalMaxTravelTimes( void ) {
 		//botimport.Print(PRT_MESSAGE, "portal %d max tt = %d\n", i, aasworld->portalmaxtraveltimes[i]);
 	} //end for
 } //end of the function AAS_InitPortalMaxTravelTimes
-/*
-//===========================================================================
-//
-// Parameter:			-
-// Returns:				-
-// Changes Globals:		-
-//===========================================================================
-void AAS_UnlinkCache(aas_routingcache_t *cache)
-{
-	if (cache->time_next) cache->time_next->time_prev = cache->time_prev;
-	else newestcache = cache->time_prev;
-	if (cache->time_prev) cache->time_prev->time_next = cache->time_next;
-	else oldestcache = cache->time_next;
-	cache->time_next = NULL;
-	cache->time_prev = NULL;
-} //end of the function AAS_UnlinkCache
-//===========================================================================
-//
-// Parameter:			-
-// Returns:				-
-// Changes Globals:		-
-//===========================================================================
-void AAS_LinkCache(aas_routingcache_t *cache)
-{
-	if (newestcache)
-	{
-		newestcache->time_next = cache;
-		cache->time_prev = cache;
-	} //end if
-	else
-	{
-		oldestcache = cache;
-		cache->time_prev = NULL;
-	} //end else
-	cache->time_next = NULL;
-	newestcache = cache;
-} //end of the function AAS_LinkCache*/
-//===========================================================================
-//
-// Parameter:			-
-// Returns:				-
-// Changes Globals:		-
-//===========================================================================
-int AAS_FreeOldestCache( void ) {
-	int i, j, bestcluster, bestarea, freed;
-	float besttime;
-	aas_routingcache_t *cache, *bestcache;
-
-	freed = qfalse;
-	besttime = 999999999;
-	bestcache = NULL;
-	bestcluster = 0;
-	bestarea = 0;
-	//refresh cluster cache
-	for ( i = 0; i < aasworld->numclusters; i++ )
-	{
-		for ( j = 0; j < aasworld->clusters[i].numareas; j++ )
-		{
-			for ( cache = aasworld->clusterareacache[i][j]; cache; cache = cache->next )
-			{
-				//never remove cache leading towards a portal
-				if ( aasworld->areasettings[cache->areanum].cluster < 0 ) {
-					continue;
-				}
-				//if this cache is older than the cache we found so far
-				if ( cache->time < besttime ) {
-					bestcache = cache;
-					bestcluster = i;
-					bestarea = j;
-					besttime = cache->time;
-				} //end if
-			} //end for
-		} //end for
-	} //end for
-	if ( bestcache ) {
-		cache = bestcache;
-		if ( cache->prev ) {
-			cache->prev->next = cache->next;
-		} else { aasworld->clusterareacache[bestcluster][bestarea] = cache->next;}
-		if ( cache->next ) {
-			cache->next->prev = cache->prev;
-		}
-		AAS_FreeRoutingCache( cache );
-		freed = qtrue;
-	} //end if
-	besttime = 999999999;
-	bestcache = NULL;
-	bestarea = 0;
-	for ( i = 0; i < aasworld->numareas; i++ )
-	{
-		//refresh portal cache
-		for ( cache = aasworld->portalcache[i]; cache; cache = cache->next )
-		{
-			if ( cache->time < besttime ) {
-				bestcache = cache;
-				bestarea = i;
-				besttime = cache->time;
-			} //end if
-		} //end for
-	} //end for
-	if ( bestcache ) {
-		cache = bestcache;
-		if ( cache->prev ) {
-			cache->prev->next = cache->next;
-		} else { aasworld->portalcache[bestarea] = cache->next;}
-		if ( cache->next ) {
-			cache->next->prev = cache->prev;
-		}
-		AAS_FreeRoutingCache( cache );
-		freed = qtrue;
-	} //end if
-	return freed;
-} //end of the function AAS_FreeOldestCache
-//===========================================================================
-//
-// Parameter:			-
-// Returns:				-
-// Changes Globals:		-
-//===========================================================================
-aas_routingcache_t *AAS_AllocRoutingCache( int numtraveltimes ) {
-	aas_routingcache_t *cache;
-	int size;
-
-	size = sizeof( aas_routingcache_t ) + numtraveltimes * sizeof( unsigned short int ) + numtraveltimes * sizeof( unsigned char );
-
-	routingcachesize += size;
-
-	cache = (aas_routingcache_t *) AAS_RoutingGetMemory( size );
-	cache->reachabilities = (unsigned char *) cache + sizeof( aas_routingcache_t ) + numtraveltimes * sizeof( unsigned short int );
-	cache->size = size;
-	return cache;
-} //end of the function AAS_AllocRoutingCache
 //===========================================================================
 //
 // Parameter:			-
@@ -915,60 +1053,161 @@ void AAS_InitRoutingUpdate( void ) {
 	aasworld->portalupdate = (aas_routingupdate_t *) AAS_RoutingGetMemory( ( aasworld->numportals + 1 ) * sizeof( aas_routingupdate_t ) );
 } //end of the function AAS_InitRoutingUpdate
 //===========================================================================
+// fills in the area and portal routing caches for the given travel flags
+// instead of waiting for the bots to request them one by one, the caches
+// are allocated up front and then updated in parallel, every job has its
+// own routing update fields
 //
 // Parameter:			-
 // Returns:				-
 // Changes Globals:		-
 //===========================================================================
+#define MAX_PRECOMPUTE_JOBS         64
+
+extern int Sys_MilliSeconds( void );
+
+typedef struct aas_precompute_s
+{
+	aas_routingcache_t **caches;                //caches to update
+	int numcaches;
+	int numjobs;
+	aas_routingupdate_t *updates;               //numupdates routing update fields per job
+	int numupdates;
+} aas_precompute_t;
+
+static aas_routingcache_t *AAS_FindAreaRoutingCache( int clusternum, int areanum, int travelflags );
+static aas_routingcache_t *AAS_NewAreaRoutingCache( int clusternum, int areanum, int travelflags );
+static aas_routingcache_t *AAS_NewPortalRoutingCache( int clusternum, int areanum, int travelflags );
+static void AAS_CalcAreaRoutingCache( aas_routingcache_t *areacache, aas_routingupdate_t *areaupdate, int *routingupdates );
+static void AAS_CalcPortalRoutingCache( aas_routingcache_t *portalcache, aas_routingupdate_t *portalupdate, qboolean precomputed );
+
+static void AAS_PrecomputeAreaCacheJob( void *data, int job ) {
+	aas_precompute_t *pc;
+	aas_routingupdate_t *areaupdate;
+	int i, routingupdates;
+
+	pc = (aas_precompute_t *) data;
+	areaupdate = pc->updates + job * pc->numupdates;
+	routingupdates = 0;
+	for ( i = job; i < pc->numcaches; i += pc->numjobs )
+	{
+		AAS_CalcAreaRoutingCache( pc->caches[i], areaupdate, &routingupdates );
+	} //end for
+} //end of the function AAS_PrecomputeAreaCacheJob
+
+static void AAS_PrecomputePortalCacheJob( void *data, int job ) {
+	aas_precompute_t *pc;
+	aas_routingupdate_t *portalupdate;
+	int i;
+
+	pc = (aas_precompute_t *) data;
+	portalupdate = pc->updates + job * pc->numupdates;
+	for ( i = job; i < pc->numcaches; i += pc->numjobs )
+	{
+		AAS_CalcPortalRoutingCache( pc->caches[i], portalupdate, qtrue );
+	} //end for
+} //end of the function AAS_PrecomputePortalCacheJob
+
+static void AAS_PrecomputeAreaCache( aas_precompute_t *pc, int clusternum, int areanum, int travelflags ) {
+	int clusterareanum;
+
+	if ( clusternum <= 0 ) {
+		return;
+	}
+	//areas without reachabilities never get any travel times
+	clusterareanum = AAS_ClusterAreaNum( clusternum, areanum );
+	if ( clusterareanum >= aasworld->clusters[clusternum].numreachabilityareas ) {
+		return;
+	}
+	travelflags &= ~TFL_TEAM_FLAGS | aasworld->clusterTeamTravelFlags[clusternum];
+	if ( AAS_FindAreaRoutingCache( clusternum, areanum, travelflags ) ) {
+		return;
+	}
+	pc->caches[pc->numcaches++] = AAS_NewAreaRoutingCache( clusternum, areanum, travelflags );
+} //end of the function AAS_PrecomputeAreaCache
 
 void AAS_CreateAllRoutingCache( void ) {
-	int i, j, k, t, tfl, numroutingareas;
-	aas_areasettings_t *areasettings;
-	aas_reachability_t *reach;
+	int i, clusternum, numareacache, numportalcache, starttime;
+	aas_precompute_t pc;
+	aas_portal_t *portal;
+	aas_routingcache_t *cache;
 
-	numroutingareas = 0;
-	tfl = TFL_DEFAULT & ~( TFL_JUMPPAD | TFL_ROCKETJUMP | TFL_BFGJUMP | TFL_GRAPPLEHOOK | TFL_DOUBLEJUMP | TFL_RAMPJUMP | TFL_STRAFEJUMP | TFL_LAVA );  //----(SA)	modified since slime is no longer deadly
-//	tfl = TFL_DEFAULT & ~(TFL_JUMPPAD|TFL_ROCKETJUMP|TFL_BFGJUMP|TFL_GRAPPLEHOOK|TFL_DOUBLEJUMP|TFL_RAMPJUMP|TFL_STRAFEJUMP|TFL_SLIME|TFL_LAVA);
-	botimport.Print( PRT_MESSAGE, "AAS_CreateAllRoutingCache\n" );
+	starttime = Sys_MilliSeconds();
+	memset( &pc, 0, sizeof( pc ) );
+	//the area routing update fields are indexed by the area number in the cluster
+	pc.numupdates = aasworld->numportals + 1;
+	for ( i = 0; i < aasworld->numclusters; i++ )
+	{
+		if ( aasworld->clusters[i].numreachabilityareas > pc.numupdates ) {
+			pc.numupdates = aasworld->clusters[i].numreachabilityareas;
+		}
+	} //end for
+	//one job per thread bot_precomputeroutes asks for, every job has
+	//update fields for the largest cluster
+	pc.numjobs = (int) LibVarGetValue( "bot_precomputeroutes" );
+	if ( pc.numjobs < 1 ) {
+		pc.numjobs = 1;
+	}
+	if ( pc.numjobs > MAX_PRECOMPUTE_JOBS ) {
+		pc.numjobs = MAX_PRECOMPUTE_JOBS;
+	}
+	pc.updates = (aas_routingupdate_t *) GetClearedMemory( pc.numjobs * pc.numupdates * sizeof( aas_routingupdate_t ) );
+	//portal areas have a cache in both clusters
+	pc.caches = (aas_routingcache_t **) GetClearedMemory( 2 * aasworld->numareas * sizeof( aas_routingcache_t * ) );
+	//the jobs hold on to every cache so none may be evicted until they are done
+	aasworld->cachearena.noevict = qtrue;
 	//
 	for ( i = 1; i < aasworld->numareas; i++ )
 	{
-		if ( !AAS_AreaReachability( i ) ) {
-			continue;
-		}
-		areasettings = &aasworld->areasettings[i];
-		for ( k = 0; k < areasettings->numreachableareas; k++ )
+		clusternum = aasworld->areasettings[i].cluster;
+		if ( clusternum > 0 ) {
+			AAS_PrecomputeAreaCache( &pc, clusternum, i, TFL_DEFAULT );
+		} //end if
+		else
 		{
-			reach = &aasworld->reachability[areasettings->firstreachablearea + k];
-			if ( aasworld->travelflagfortype[reach->traveltype] & tfl ) {
-				break;
+			portal = &aasworld->portals[-clusternum];
+			AAS_PrecomputeAreaCache( &pc, portal->frontcluster, i, TFL_DEFAULT );
+			if ( portal->backcluster != portal->frontcluster ) {
+				AAS_PrecomputeAreaCache( &pc, portal->backcluster, i, TFL_DEFAULT );
 			}
-		}
-		if ( k >= areasettings->numreachableareas ) {
-			continue;
-		}
-		aasworld->areasettings[i].areaflags |= AREA_USEFORROUTING;
-		numroutingareas++;
-	}
+		} //end else
+	} //end for
+	numareacache = pc.numcaches;
+	botimport.RunJobs( AAS_PrecomputeAreaCacheJob, &pc, pc.numjobs );
+	//the portal caches are built from the area caches
+	pc.numcaches = 0;
 	for ( i = 1; i < aasworld->numareas; i++ )
 	{
-		if ( !( aasworld->areasettings[i].areaflags & AREA_USEFORROUTING ) ) {
+		clusternum = aasworld->areasettings[i].cluster;
+		if ( clusternum < 0 ) {
+			//AAS_AreaRouteToGoalArea assumes the goal area is part of the front cluster
+			clusternum = aasworld->portals[-clusternum].frontcluster;
+		}
+		if ( AAS_ClusterAreaNum( clusternum, i ) >= aasworld->clusters[clusternum].numreachabilityareas ) {
 			continue;
 		}
-		for ( j = 1; j < aasworld->numareas; j++ )
+		for ( cache = aasworld->portalcache[i]; cache; cache = cache->next )
 		{
-			if ( i == j ) {
-				continue;
-			}
-			if ( !( aasworld->areasettings[j].areaflags & AREA_USEFORROUTING ) ) {
-				continue;
+			if ( cache->travelflags == TFL_DEFAULT ) {
+				break;
 			}
-			t = AAS_AreaTravelTimeToGoalArea( j, aasworld->areawaypoints[j], i, tfl );
-			aasworld->frameroutingupdates = 0;
-			//if (t) break;
-			//Log_Write("traveltime from %d to %d is %d", i, j, t);
 		} //end for
+		if ( !cache ) {
+			pc.caches[pc.numcaches++] = AAS_NewPortalRoutingCache( clusternum, i, TFL_DEFAULT );
+		}
 	} //end for
+	numportalcache = pc.numcaches;
+	botimport.RunJobs( AAS_PrecomputePortalCacheJob, &pc, pc.numjobs );
+	//
+#ifdef ROUTING_DEBUG
+	numareacacheupdates += numareacache;
+	numportalcacheupdates += numportalcache;
+#endif //ROUTING_DEBUG
+	aasworld->cachearena.noevict = qfalse;
+	FreeMemory( pc.caches );
+	FreeMemory( pc.updates );
+	botimport.Print( PRT_MESSAGE, "%d area and %d portal routing caches created in %d msec\n",
+					 numareacache, numportalcache, Sys_MilliSeconds() - starttime );
 } //end of the function AAS_CreateAllRoutingCache
 //===========================================================================
 //
@@ -979,8 +1218,9 @@ void AAS_CreateAllRoutingCache( void ) {
 unsigned short CRC_ProcessString( unsigned char *data, int length );
 
 //the route cache header
-//this header is followed by numportalcache + numareacache aas_routingcache_t
-//structures that store routing cache
+//the cache directory at cacheofs has numportalcache + numareacache
+//routecacheinfo_t, portal caches first, the travel times and reachabilities
+//they point to are stored 4 byte aligned so the file can be used in place
 typedef struct routecacheheader_s
 {
 	int ident;
@@ -992,24 +1232,104 @@ typedef struct routecacheheader_s
 	int reachcrc;
 	int numportalcache;
 	int numareacache;
+	int cacheofs;
+	int waypointofs;                            //numareas vec3_t
+	int visofs;                                 //size and compressed vis for every area
 } routecacheheader_t;
 
+typedef struct routecacheinfo_s
+{
+	int cluster;
+	int areanum;
+	int travelflags;
+	vec3_t origin;
+	float starttraveltime;
+	int numtraveltimes;
+	int traveltimesofs;                         //travel times followed by the reachabilities
+} routecacheinfo_t;
+
 #define RCID                        ( ( 'C' << 24 ) + ( 'R' << 16 ) + ( 'E' << 8 ) + 'M' )
-#define RCVERSION                   16
+#define RCVERSION                   17
+
+#define RC_DATASIZE( numtraveltimes )   ( ( ( numtraveltimes ) * 3 + 3 ) & ~3 )
 
 void AAS_DecompressVis( byte *in, int numareas, byte *decompressed );
 int AAS_CompressVis( byte *vis, int numareas, byte *dest );
 
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static int AAS_CacheNumTravelTimes( aas_routingcache_t *cache, qboolean portal ) {
+	if ( portal ) {
+		return aasworld->numportals;
+	}
+	return aasworld->clusters[cache->cluster].numreachabilityareas;
+} //end of the function AAS_CacheNumTravelTimes
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_WriteCacheInfo( aas_routingcache_t *cache, qboolean portal, int *dataofs, fileHandle_t fp ) {
+	routecacheinfo_t info;
+	int numtraveltimes;
+
+	numtraveltimes = AAS_CacheNumTravelTimes( cache, portal );
+	info.cluster = LittleLong( cache->cluster );
+	info.areanum = LittleLong( cache->areanum );
+	info.travelflags = LittleLong( cache->travelflags );
+	info.origin[0] = LittleFloat( cache->origin[0] );
+	info.origin[1] = LittleFloat( cache->origin[1] );
+	info.origin[2] = LittleFloat( cache->origin[2] );
+	info.starttraveltime = LittleFloat( cache->starttraveltime );
+	info.numtraveltimes = LittleLong( numtraveltimes );
+	info.traveltimesofs = LittleLong( *dataofs );
+	botimport.FS_Write( &info, sizeof( info ), fp );
+	*dataofs += RC_DATASIZE( numtraveltimes );
+} //end of the function AAS_WriteCacheInfo
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_WriteCacheData( aas_routingcache_t *cache, qboolean portal, fileHandle_t fp ) {
+	int i, numtraveltimes, pad;
+	unsigned short int t;
+
+	numtraveltimes = AAS_CacheNumTravelTimes( cache, portal );
+	if ( LittleShort( 1 ) == 1 ) {
+		botimport.FS_Write( cache->traveltimes, numtraveltimes * sizeof( unsigned short int ), fp );
+	} else {
+		for ( i = 0; i < numtraveltimes; i++ )
+		{
+			t = LittleShort( cache->traveltimes[i] );
+			botimport.FS_Write( &t, sizeof( t ), fp );
+		} //end for
+	} //end else
+	botimport.FS_Write( cache->reachabilities, numtraveltimes, fp );
+	pad = 0;
+	botimport.FS_Write( &pad, RC_DATASIZE( numtraveltimes ) - numtraveltimes * 3, fp );
+} //end of the function AAS_WriteCacheData
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
 void AAS_WriteRouteCache( void ) {
-	int i, j, numportalcache, numareacache, size;
+	int i, j, numportalcache, numareacache, size, dataofs;
 	aas_routingcache_t *cache;
 	aas_cluster_t *cluster;
 	fileHandle_t fp;
 	char filename[MAX_QPATH];
 	routecacheheader_t routecacheheader;
 	byte *buf;
-
-	buf = (byte *) GetClearedMemory( aasworld->numareas * 2 * sizeof( byte ) ); // in case it ends up bigger than the decompressedvis, which is rare but possible
+	vec3_t waypoint;
 
 	numportalcache = 0;
 	for ( i = 0; i < aasworld->numareas; i++ )
@@ -1038,24 +1358,28 @@ void AAS_WriteRouteCache( void ) {
 		AAS_Error( "Unable to open file: %s\n", filename );
 		return;
 	} //end if
+	buf = (byte *) GetClearedMemory( aasworld->numareas * 2 * sizeof( byte ) ); // in case it ends up bigger than the decompressedvis, which is rare but possible
+	//the travel times follow the cache directory, then the waypoints and the vis
+	dataofs = sizeof( routecacheheader_t ) + ( numportalcache + numareacache ) * sizeof( routecacheinfo_t );
 	  //create the header
-	routecacheheader.ident = RCID;
-	routecacheheader.version = RCVERSION;
-	routecacheheader.numareas = aasworld->numareas;
-	routecacheheader.numclusters = aasworld->numclusters;
-	routecacheheader.areacrc = CRC_ProcessString( (unsigned char *)aasworld->areas, sizeof( aas_area_t ) * aasworld->numareas );
-	routecacheheader.clustercrc = CRC_ProcessString( (unsigned char *)aasworld->clusters, sizeof( aas_cluster_t ) * aasworld->numclusters );
-	routecacheheader.reachcrc = CRC_ProcessString( (unsigned char *)aasworld->reachability, sizeof( aas_reachability_t ) * aasworld->reachabilitysize );
-	routecacheheader.numportalcache = numportalcache;
-	routecacheheader.numareacache = numareacache;
+	routecacheheader.ident = LittleLong( RCID );
+	routecacheheader.version = LittleLong( RCVERSION );
+	routecacheheader.numareas = LittleLong( aasworld->numareas );
+	routecacheheader.numclusters = LittleLong( aasworld->numclusters );
+	routecacheheader.areacrc = LittleLong( CRC_ProcessString( (unsigned char *)aasworld->areas, sizeof( aas_area_t ) * aasworld->numareas ) );
+	routecacheheader.clustercrc = LittleLong( CRC_ProcessString( (unsigned char *)aasworld->clusters, sizeof( aas_cluster_t ) * aasworld->numclusters ) );
+	routecacheheader.reachcrc = LittleLong( CRC_ProcessString( (unsigned char *)aasworld->reachability, sizeof( aas_reachability_t ) * aasworld->reachabilitysize ) );
+	routecacheheader.numportalcache = LittleLong( numportalcache );
+	routecacheheader.numareacache = LittleLong( numareacache );
+	routecacheheader.cacheofs = LittleLong( sizeof( routecacheheader_t ) );
 	//write the header
 	botimport.FS_Write( &routecacheheader, sizeof( routecacheheader_t ), fp );
-	//write all the cache
+	//write the cache directory
 	for ( i = 0; i < aasworld->numareas; i++ )
 	{
 		for ( cache = aasworld->portalcache[i]; cache; cache = cache->next )
 		{
-			botimport.FS_Write( cache, cache->size, fp );
+			AAS_WriteCacheInfo( cache, qtrue, &dataofs, fp );
 		} //end for
 	} //end for
 	for ( i = 0; i < aasworld->numclusters; i++ )
@@ -1065,11 +1389,41 @@ void AAS_WriteRouteCache( void ) {
 		{
 			for ( cache = aasworld->clusterareacache[i][j]; cache; cache = cache->next )
 			{
-				botimport.FS_Write( cache, cache->size, fp );
+				AAS_WriteCacheInfo( cache, qfalse, &dataofs, fp );
 			} //end for
 		} //end for
 	} //end for
+	  //write all the cache
+	for ( i = 0; i < aasworld->numareas; i++ )
+	{
+		for ( cache = aasworld->portalcache[i]; cache; cache = cache->next )
+		{
+			AAS_WriteCacheData( cache, qtrue, fp );
+		} //end for
+	} //end for
+	for ( i = 0; i < aasworld->numclusters; i++ )
+	{
+		cluster = &aasworld->clusters[i];
+		for ( j = 0; j < cluster->numareas; j++ )
+		{
+			for ( cache = aasworld->clusterareacache[i][j]; cache; cache = cache->next )
+			{
+				AAS_WriteCacheData( cache, qfalse, fp );
+			} //end for
+		} //end for
+	} //end for
+	  // write the waypoints
+	routecacheheader.waypointofs = LittleLong( dataofs );
+	for ( i = 0; i < aasworld->numareas; i++ )
+	{
+		waypoint[0] = LittleFloat( aasworld->areawaypoints[i][0] );
+		waypoint[1] = LittleFloat( aasworld->areawaypoints[i][1] );
+		waypoint[2] = LittleFloat( aasworld->areawaypoints[i][2] );
+		botimport.FS_Write( waypoint, sizeof( vec3_t ), fp );
+	}
+	dataofs += aasworld->numareas * sizeof( vec3_t );
 	  // write the visareas
+	routecacheheader.visofs = LittleLong( dataofs );
 	for ( i = 0; i < aasworld->numareas; i++ )
 	{
 		if ( !aasworld->areavisibility[i] ) {
@@ -1079,54 +1433,111 @@ void AAS_WriteRouteCache( void ) {
 		}
 		AAS_DecompressVis( aasworld->areavisibility[i], aasworld->numareas, aasworld->decompressedvis );
 		size = AAS_CompressVis( aasworld->decompressedvis, aasworld->numareas, buf );
-		botimport.FS_Write( &size, sizeof( int ), fp );
+		j = LittleLong( size );
+		botimport.FS_Write( &j, sizeof( int ), fp );
 		botimport.FS_Write( buf, size, fp );
+		//keep the sizes aligned
+		j = 0;
+		botimport.FS_Write( &j, ( ( size + 3 ) & ~3 ) - size, fp );
 	}
-	// write the waypoints
-	botimport.FS_Write( aasworld->areawaypoints, sizeof( vec3_t ) * aasworld->numareas, fp );
+	//now that the offsets are known write the header again
+	botimport.FS_Seek( fp, 0, FS_SEEK_SET );
+	botimport.FS_Write( &routecacheheader, sizeof( routecacheheader_t ), fp );
 	//
 	botimport.FS_FCloseFile( fp );
+	FreeMemory( buf );
 	botimport.Print( PRT_MESSAGE, "\nroute cache written to %s\n", filename );
 } //end of the function AAS_WriteRouteCache
 //===========================================================================
+// releases the route cache file once no cache points into it anymore
 //
 // Parameter:			-
 // Returns:				-
 // Changes Globals:		-
 //===========================================================================
-aas_routingcache_t *AAS_ReadCache( fileHandle_t fp ) {
-	int size, i;
-	aas_routingcache_t *cache;
-
-	botimport.FS_Read( &size, sizeof( size ), fp );
-	size = LittleLong( size );
-	cache = (aas_routingcache_t *) AAS_RoutingGetMemory( size );
-	cache->size = size;
-	botimport.FS_Read( (unsigned char *)cache + sizeof( size ), size - sizeof( size ), fp );
-
-	if ( 1 != LittleLong( 1 ) ) {
-		cache->time = LittleFloat( cache->time );
-		cache->cluster = LittleLong( cache->cluster );
-		cache->areanum = LittleLong( cache->areanum );
-		cache->origin[0] = LittleFloat( cache->origin[0] );
-		cache->origin[1] = LittleFloat( cache->origin[1] );
-		cache->origin[2] = LittleFloat( cache->origin[2] );
-		cache->starttraveltime = LittleFloat( cache->starttraveltime );
-		cache->travelflags = LittleLong( cache->travelflags );
+static void AAS_FreeRouteCacheFile( void ) {
+	if ( !aasworld->routecachedata ) {
+		return;
+	}
+	if ( aasworld->routecachemapped ) {
+		botimport.FS_UnmapFile( aasworld->routecachedata, aasworld->routecachelength );
+	} else {
+		FreeMemory( aasworld->routecachedata );
 	}
+	aasworld->routecachedata = NULL;
+	aasworld->routecachelength = 0;
+	aasworld->routecachemapped = qfalse;
+} //end of the function AAS_FreeRouteCacheFile
+//===========================================================================
+// maps the route cache file, or reads it into memory when it's inside a
+// pak or the travel times have to be byte swapped
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static qboolean AAS_LoadRouteCacheFile( const char *filename ) {
+	fileHandle_t fp;
+	int length;
 
-//	cache->reachabilities = (unsigned char *) cache + sizeof(aas_routingcache_t) - sizeof(unsigned short) +
-//		(size - sizeof(aas_routingcache_t) + sizeof(unsigned short)) / 3 * 2;
-	cache->reachabilities = (unsigned char *) cache + sizeof( aas_routingcache_t ) +
-							( ( size - sizeof( aas_routingcache_t ) ) / 3 ) * 2;
+	if ( LittleShort( 1 ) == 1 && botimport.FS_MapFile ) {
+		aasworld->routecachedata = (byte *) botimport.FS_MapFile( filename, &length );
+		if ( aasworld->routecachedata ) {
+			aasworld->routecachelength = length;
+			aasworld->routecachemapped = qtrue;
+			return qtrue;
+		}
+	} //end if
+	length = botimport.FS_FOpenFile( filename, &fp, FS_READ );
+	if ( !fp ) {
+		return qfalse;
+	} //end if
+	if ( length <= 0 ) {
+		botimport.FS_FCloseFile( fp );
+		return qfalse;
+	} //end if
+	aasworld->routecachedata = (byte *) GetMemory( length );
+	aasworld->routecachelength = length;
+	aasworld->routecachemapped = qfalse;
+	botimport.FS_Read( aasworld->routecachedata, length, fp );
+	botimport.FS_FCloseFile( fp );
+	return qtrue;
+} //end of the function AAS_LoadRouteCacheFile
+//===========================================================================
+// checks a cache directory entry against the loaded aas file
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static qboolean AAS_ValidCacheInfo( routecacheinfo_t *info, qboolean portal ) {
+	int clusterareanum, numtraveltimes;
 
-	//DAJ BUGFIX for missing byteswaps for traveltimes
-	size = ( size - sizeof( aas_routingcache_t ) ) / 3 + 1;
-	for ( i = 0; i < size; i++ ) {
-		cache->traveltimes[i] = LittleShort( cache->traveltimes[i] );
+	if ( info->areanum <= 0 || info->areanum >= aasworld->numareas ) {
+		return qfalse;
 	}
-	return cache;
-} //end of the function AAS_ReadCache
+	if ( portal ) {
+		numtraveltimes = aasworld->numportals;
+	} else
+	{
+		if ( info->cluster <= 0 || info->cluster >= aasworld->numclusters ) {
+			return qfalse;
+		}
+		clusterareanum = AAS_ClusterAreaNum( info->cluster, info->areanum );
+		if ( clusterareanum < 0 || clusterareanum >= aasworld->clusters[info->cluster].numareas ) {
+			return qfalse;
+		}
+		numtraveltimes = aasworld->clusters[info->cluster].numreachabilityareas;
+	} //end else
+	if ( info->numtraveltimes != numtraveltimes ) {
+		return qfalse;
+	}
+	if ( info->traveltimesofs < 0 || ( info->traveltimesofs & 1 ) ||
+		 info->traveltimesofs > aasworld->routecachelength - numtraveltimes * 3 ) {
+		return qfalse;
+	}
+	return qtrue;
+} //end of the function AAS_ValidCacheInfo
 //===========================================================================
 //
 // Parameter:			-
@@ -1134,35 +1545,46 @@ aas_routingcache_t *AAS_ReadCache( fileHandle_t fp ) {
 // Changes Globals:		-
 //===========================================================================
 int AAS_ReadRouteCache( void ) {
-	int i, clusterareanum, size;
-	fileHandle_t fp = 0;
+	int i, j, clusterareanum, size, numcache, ofs;
 	char filename[MAX_QPATH];
 	routecacheheader_t routecacheheader;
-	aas_routingcache_t *cache;
+	routecacheinfo_t *info, *infos;
+	aas_routingcache_t *cache, **link;
+	unsigned short int *traveltimes;
+	byte *data;
 
 	Com_sprintf( filename, MAX_QPATH, "maps/%s.rcd", aasworld->mapname );
-	botimport.FS_FOpenFile( filename, &fp, FS_READ );
-	if ( !fp ) {
+	if ( !AAS_LoadRouteCacheFile( filename ) ) {
+		return qfalse;
+	} //end if
+	data = aasworld->routecachedata;
+	if ( aasworld->routecachelength < (int)sizeof( routecacheheader_t ) ) {
+		AAS_FreeRouteCacheFile();
 		return qfalse;
 	} //end if
-	botimport.FS_Read( &routecacheheader, sizeof( routecacheheader_t ), fp );
+	memcpy( &routecacheheader, data, sizeof( routecacheheader_t ) );
+	for ( i = 0; i < sizeof( routecacheheader_t ) / 4; i++ )
+	{
+		( (int *)&routecacheheader )[i] = LittleLong( ( (int *)&routecacheheader )[i] );
+	} //end for
 	if ( routecacheheader.ident != RCID ) {
-		botimport.FS_FCloseFile( fp );
-		AAS_Error( "%s is not a route cache dump\n" );
+		AAS_FreeRouteCacheFile();
+		AAS_Error( "%s is not a route cache dump\n", filename );
 		return qfalse;
 	} //end if
 	if ( routecacheheader.version != RCVERSION ) {
-		botimport.FS_FCloseFile( fp );
-		AAS_Error( "route cache dump has wrong version %d, should be %d", routecacheheader.version, RCVERSION );
+		AAS_FreeRouteCacheFile();
+		//older dumps are simply rebuilt
+		botimport.Print( PRT_MESSAGE, "route cache dump has wrong version %d, should be %d\n", routecacheheader.version, RCVERSION );
 		return qfalse;
 	} //end if
 	if ( routecacheheader.numareas != aasworld->numareas ) {
-		botimport.FS_FCloseFile( fp );
+		AAS_FreeRouteCacheFile();
 		//AAS_Error("route cache dump has wrong number of areas\n");
 		return qfalse;
 	} //end if
 	if ( routecacheheader.numclusters != aasworld->numclusters ) {
-		botimport.FS_FCloseFile( fp );
+		AAS_FreeRouteCacheFile();
 		//AAS_Error("route cache dump has wrong number of clusters\n");
 		return qfalse;
 	} //end if
@@ -1171,62 +1593,134 @@ int AAS_ReadRouteCache( void ) {
 #else
 	if ( routecacheheader.areacrc !=
 		 CRC_ProcessString( (unsigned char *)aasworld->areas, sizeof( aas_area_t ) * aasworld->numareas ) ) {
-		botimport.FS_FCloseFile( fp );
+		AAS_FreeRouteCacheFile();
 		//AAS_Error("route cache dump area CRC incorrect\n");
 		return qfalse;
 	} //end if
 	if ( routecacheheader.clustercrc !=
 		 CRC_ProcessString( (unsigned char *)aasworld->clusters, sizeof( aas_cluster_t ) * aasworld->numclusters ) ) {
-		botimport.FS_FCloseFile( fp );
+		AAS_FreeRouteCacheFile();
 		//AAS_Error("route cache dump cluster CRC incorrect\n");
 		return qfalse;
 	} //end if
 	if ( routecacheheader.reachcrc !=
 		 CRC_ProcessString( (unsigned char *)aasworld->reachability, sizeof( aas_reachability_t ) * aasworld->reachabilitysize ) ) {
-		botimport.FS_FCloseFile( fp );
+		AAS_FreeRouteCacheFile();
 		//AAS_Error("route cache dump reachability CRC incorrect\n");
 		return qfalse;
 	} //end if
 #endif
-	//read all the portal cache
-	for ( i = 0; i < routecacheheader.numportalcache; i++ )
+	numcache = aasworld->routecachelength / (int)sizeof( routecacheinfo_t );
+	if ( routecacheheader.numportalcache < 0 || routecacheheader.numportalcache > numcache ||
+		 routecacheheader.numareacache < 0 || routecacheheader.numareacache > numcache ) {
+		numcache = -1;
+	} else {
+		numcache = routecacheheader.numportalcache + routecacheheader.numareacache;
+	}
+	if ( numcache < 0 || routecacheheader.cacheofs < (int)sizeof( routecacheheader_t ) ||
+		 routecacheheader.cacheofs > aasworld->routecachelength - numcache * (int)sizeof( routecacheinfo_t ) ||
+		 routecacheheader.waypointofs < 0 ||
+		 routecacheheader.waypointofs > aasworld->routecachelength - aasworld->numareas * (int)sizeof( vec3_t ) ||
+		 routecacheheader.visofs < 0 || routecacheheader.visofs > aasworld->routecachelength ) {
+		AAS_FreeRouteCacheFile();
+		AAS_Error( "%s is truncated\n", filename );
+		return qfalse;
+	} //end if
+	//check the whole directory before any cache is linked in
+	infos = (routecacheinfo_t *) GetMemory( numcache * sizeof( routecacheinfo_t ) + 1 );
+	memcpy( infos, data + routecacheheader.cacheofs, numcache * sizeof( routecacheinfo_t ) );
+	for ( i = 0; i < numcache; i++ )
 	{
-		cache = AAS_ReadCache( fp );
-		cache->next = aasworld->portalcache[cache->areanum];
-		cache->prev = NULL;
-		if ( aasworld->portalcache[cache->areanum] ) {
-			aasworld->portalcache[cache->areanum]->prev = cache;
-		}
-		aasworld->portalcache[cache->areanum] = cache;
+		info = &infos[i];
+		for ( j = 0; j < sizeof( routecacheinfo_t ) / 4; j++ )
+		{
+			( (int *)info )[j] = LittleLong( ( (int *)info )[j] );
+		} //end for
+		if ( !AAS_ValidCacheInfo( info, i < routecacheheader.numportalcache ) ) {
+			FreeMemory( infos );
+			AAS_FreeRouteCacheFile();
+			AAS_Error( "%s has a bad routing cache\n", filename );
+			return qfalse;
+		} //end if
 	} //end for
-	  //read all the cluster area cache
-	for ( i = 0; i < routecacheheader.numareacache; i++ )
+	  //the caches use the travel times in place
+	for ( i = 0; i < numcache; i++ )
 	{
-		cache = AAS_ReadCache( fp );
-		clusterareanum = AAS_ClusterAreaNum( cache->cluster, cache->areanum );
-		cache->next = aasworld->clusterareacache[cache->cluster][clusterareanum];
+		info = &infos[i];
+		cache = (aas_routingcache_t *) AAS_RoutingGetMemory( sizeof( aas_routingcache_t ) );
+		//the travel times don't take up any of the arena so these are never evicted
+		cache->type = i < routecacheheader.numportalcache ? CACHETYPE_PORTAL : CACHETYPE_AREA;
+		cache->flags = RCF_HEAP;
+		cache->sizeclass = -1;
+		cache->size = sizeof( aas_routingcache_t );
+		routingcachesize += cache->size;
+		cache->cluster = info->cluster;
+		cache->areanum = info->areanum;
+		VectorCopy( info->origin, cache->origin );
+		cache->starttraveltime = info->starttraveltime;
+		cache->travelflags = info->travelflags;
+		traveltimes = (unsigned short int *) ( data + info->traveltimesofs );
+		if ( !aasworld->routecachemapped && LittleShort( 1 ) != 1 ) {
+			for ( j = 0; j < info->numtraveltimes; j++ )
+			{
+				traveltimes[j] = LittleShort( traveltimes[j] );
+			} //end for
+		} //end if
+		cache->traveltimes = traveltimes;
+		cache->reachabilities = (unsigned char *) ( traveltimes + info->numtraveltimes );
+		//
+		if ( i < routecacheheader.numportalcache ) {
+			link = &aasworld->portalcache[cache->areanum];
+		} else
+		{
+			clusterareanum = AAS_ClusterAreaNum( cache->cluster, cache->areanum );
+			link = &aasworld->clusterareacache[cache->cluster][clusterareanum];
+		} //end else
+		cache->next = *link;
 		cache->prev = NULL;
-		if ( aasworld->clusterareacache[cache->cluster][clusterareanum] ) {
-			aasworld->clusterareacache[cache->cluster][clusterareanum]->prev = cache;
+		if ( *link ) {
+			( *link )->prev = cache;
 		}
-		aasworld->clusterareacache[cache->cluster][clusterareanum] = cache;
+		*link = cache;
 	} //end for
+	FreeMemory( infos );
+	// read the area waypoints
+	aasworld->areawaypoints = (vec3_t *) GetClearedMemory( aasworld->numareas * sizeof( vec3_t ) );
+	memcpy( aasworld->areawaypoints, data + routecacheheader.waypointofs, aasworld->numareas * sizeof( vec3_t ) );
+	for ( i = 0; i < aasworld->numareas; i++ )
+	{
+		aasworld->areawaypoints[i][0] = LittleFloat( aasworld->areawaypoints[i][0] );
+		aasworld->areawaypoints[i][1] = LittleFloat( aasworld->areawaypoints[i][1] );
+		aasworld->areawaypoints[i][2] = LittleFloat( aasworld->areawaypoints[i][2] );
+	}
 	  // read the visareas
 	aasworld->areavisibility = (byte **) GetClearedMemory( aasworld->numareas * sizeof( byte * ) );
 	aasworld->decompressedvis = (byte *) GetClearedMemory( aasworld->numareas * sizeof( byte ) );
+	ofs = routecacheheader.visofs;
 	for ( i = 0; i < aasworld->numareas; i++ )
 	{
-		botimport.FS_Read( &size, sizeof( size ), fp );
+		if ( ofs > aasworld->routecachelength - (int)sizeof( int ) ) {
+			break;
+		}
+		memcpy( &size, data + ofs, sizeof( int ) );
+		size = LittleLong( size );
+		ofs += sizeof( int );
+		if ( size < 0 || size > aasworld->routecachelength - ofs ) {
+			break;
+		}
 		if ( size ) {
 			aasworld->areavisibility[i] = (byte *) GetMemory( size );
-			botimport.FS_Read( aasworld->areavisibility[i], size, fp );
+			memcpy( aasworld->areavisibility[i], data + ofs, size );
 		}
+		ofs += ( size + 3 ) & ~3;
+	}
+	if ( i < aasworld->numareas ) {
+		botimport.Print( PRT_WARNING, "%s has truncated visibility\n", filename );
+	}
+	//nothing points into the file if there were no caches
+	if ( !numcache ) {
+		AAS_FreeRouteCacheFile();
 	}
-	// read the area waypoints
-	aasworld->areawaypoints = (vec3_t *) GetClearedMemory( aasworld->numareas * sizeof( vec3_t ) );
-	botimport.FS_Read( aasworld->areawaypoints, aasworld->numareas * sizeof( vec3_t ), fp );
-	//
-	botimport.FS_FCloseFile( fp );
 	return qtrue;
 } //end of the function AAS_ReadRouteCache
 //===========================================================================
@@ -1237,6 +1731,8 @@ int AAS_ReadRouteCache( void ) {
 //===========================================================================
 void AAS_CreateVisibility( qboolean waypointsOnly );
 void AAS_InitRouting( void ) {
+	qboolean loaded, precompute;
+
 	AAS_InitTravelFlagFromType();
 	//initialize the routing update fields
 	AAS_InitRoutingUpdate();
@@ -1258,6 +1754,7 @@ void AAS_InitRouting( void ) {
 	   //
 	routingcachesize = 0;
 	max_routingcachesize = 1024 * (int) LibVarValue( "max_routingcache", DEFAULT_MAX_ROUTINGCACHESIZE );
+	AAS_InitRoutingCacheArena();
 	max_frameroutingupdates = (int) LibVarGetValue( "bot_frameroutingupdates" );
 	//
 	// enable this for quick testing of maps without enemies
@@ -1266,13 +1763,19 @@ void AAS_InitRouting( void ) {
 		AAS_CreateVisibility( qtrue );
 	} else {
 		// Ridah, load or create the routing cache
-		if ( !AAS_ReadRouteCache() ) {
+		loaded = AAS_ReadRouteCache();
+		if ( !loaded ) {
 			aasworld->initialized = qtrue;  // Hack, so routing can compute traveltimes
 			AAS_CreateVisibility( qfalse );
-			// RF, removed, going back to dynamic routes
-			//AAS_CreateAllRoutingCache();
 			aasworld->initialized = qfalse;
-
+		}
+		// RF, removed, going back to dynamic routes
+		// build all of it up front when the server has threads to spare, unless the file already had it
+		precompute = LibVarGetValue( "bot_precomputeroutes" ) > 0 && !routingcachesize;
+		if ( precompute ) {
+			AAS_CreateAllRoutingCache();
+		}
+		if ( !loaded || precompute ) {
 			AAS_WriteRouteCache();  // save it so we don't have to create it again
 		}
 		// done.
@@ -1285,10 +1788,18 @@ void AAS_InitRouting( void ) {
 // Changes Globals:		-
 //===========================================================================
 void AAS_FreeRoutingCaches( void ) {
+	// show how well the routing cache budget fit this map
+	if ( bot_developer && aasworld->cachearena.slabs ) {
+		AAS_RoutingInfo();
+	}
 	// free all the existing cluster area cache
 	AAS_FreeAllClusterAreaCache();
 	// free all the existing portal cache
 	AAS_FreeAllPortalCache();
+	// the loaded caches pointed into the route cache file
+	AAS_FreeRouteCacheFile();
+	// all caches are back in the arena
+	AAS_FreeRoutingCacheArena();
 	// free all the existing area visibility data
 	AAS_FreeAreaVisibility();
 	// free cached travel times within areas
@@ -1369,13 +1880,15 @@ int AAS_AreaContentsTravelFlag( int areanum ) {
 	return tfl;
 } //end of the function AAS_AreaContentsTravelFlag
 //===========================================================================
-// update the given routing cache
+// update the given routing cache using the given routing update fields
 //
 // Parameter:			areacache		: routing cache to update
+//						areaupdate		: update fields for every reachability area in the cluster
+//						routingupdates	: counts the routing updates
 // Returns:				-
 // Changes Globals:		-
 //===========================================================================
-void AAS_UpdateAreaRoutingCache( aas_routingcache_t *areacache ) {
+static void AAS_CalcAreaRoutingCache( aas_routingcache_t *areacache, aas_routingupdate_t *areaupdate, int *routingupdates ) {
 	int i, nextareanum, cluster, badtravelflags, clusterareanum, linknum;
 	int numreachabilityareas;
 	unsigned short int t, startareatraveltimes[128];
@@ -1384,10 +1897,7 @@ void AAS_UpdateAreaRoutingCache( aas_routingcache_t *areacache ) {
 	aas_reversedreachability_t *revreach;
 	aas_reversedlink_t *revlink;
 
-#ifdef ROUTING_DEBUG
-	numareacacheupdates++;
-#endif //ROUTING_DEBUG
-	   //number of reachability areas within this cluster
+	//number of reachability areas within this cluster
 	numreachabilityareas = aasworld->clusters[areacache->cluster].numreachabilityareas;
 	//
 	//clear the routing update fields
@@ -1402,7 +1912,7 @@ void AAS_UpdateAreaRoutingCache( aas_routingcache_t *areacache ) {
 	//
 	memset( startareatraveltimes, 0, sizeof( startareatraveltimes ) );
 	//
-	curupdate = &aasworld->areaupdate[clusterareanum];
+	curupdate = &areaupdate[clusterareanum];
 	curupdate->areanum = areacache->areanum;
 	//VectorCopy(areacache->origin, curupdate->start);
 	curupdate->areatraveltimes = aasworld->areatraveltimes[areacache->areanum][0];
@@ -1472,14 +1982,14 @@ void AAS_UpdateAreaRoutingCache( aas_routingcache_t *areacache ) {
 				t += 200; // + (curupdate->areatraveltimes[i] + reach->traveltime) * 30;
 			}
 			//
-			aasworld->frameroutingupdates++;
+			( *routingupdates )++;
 			//
 			if ( aasworld->areatraveltimes[nextareanum] &&
 				 ( !areacache->traveltimes[clusterareanum] ||
 				   areacache->traveltimes[clusterareanum] > t ) ) {
 				areacache->traveltimes[clusterareanum] = t;
 				areacache->reachabilities[clusterareanum] = linknum - aasworld->areasettings[nextareanum].firstreachablearea;
-				nextupdate = &aasworld->areaupdate[clusterareanum];
+				nextupdate = &areaupdate[clusterareanum];
 				nextupdate->areanum = nextareanum;
 				nextupdate->tmptraveltime = t;
 				//VectorCopy(reach->start, nextupdate->start);
@@ -1497,6 +2007,19 @@ void AAS_UpdateAreaRoutingCache( aas_routingcache_t *areacache ) {
 			} //end if
 		} //end for
 	} //end while
+} //end of the function AAS_CalcAreaRoutingCache
+//===========================================================================
+// update the given routing cache
+//
+// Parameter:			areacache		: routing cache to update
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+void AAS_UpdateAreaRoutingCache( aas_routingcache_t *areacache ) {
+#ifdef ROUTING_DEBUG
+	numareacacheupdates++;
+#endif //ROUTING_DEBUG
+	AAS_CalcAreaRoutingCache( areacache, aasworld->areaupdate, &aasworld->frameroutingupdates );
 } //end of the function AAS_UpdateAreaRoutingCache
 //===========================================================================
 //
@@ -1504,26 +2027,68 @@ void AAS_UpdateAreaRoutingCache( aas_routingcache_t *areacache ) {
 // Returns:				-
 // Changes Globals:		-
 //===========================================================================
-aas_routingcache_t *AAS_GetAreaRoutingCache( int clusternum, int areanum, int travelflags, qboolean forceUpdate ) {
+static aas_routingcache_t *AAS_FindAreaRoutingCache( int clusternum, int areanum, int travelflags ) {
+	aas_routingcache_t *cache;
+
+	//find the cache without undesired travel flags
+	for ( cache = aasworld->clusterareacache[clusternum][AAS_ClusterAreaNum( clusternum, areanum )]; cache; cache = cache->next )
+	{
+		//if there aren't used any undesired travel types for the cache
+		if ( cache->travelflags == travelflags ) {
+			break;
+		}
+	} //end for
+	return cache;
+} //end of the function AAS_FindAreaRoutingCache
+//===========================================================================
+// allocates a routing cache and links it in, the travel times still
+// have to be calculated
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static aas_routingcache_t *AAS_NewAreaRoutingCache( int clusternum, int areanum, int travelflags ) {
 	int clusterareanum;
 	aas_routingcache_t *cache, *clustercache;
 
+	//allocating the cache might evict one from the list so allocate it first
+	cache = AAS_AllocRoutingCache( CACHETYPE_AREA, aasworld->clusters[clusternum].numreachabilityareas );
 	//number of the area in the cluster
 	clusterareanum = AAS_ClusterAreaNum( clusternum, areanum );
 	//pointer to the cache for the area in the cluster
 	clustercache = aasworld->clusterareacache[clusternum][clusterareanum];
+	//
+	cache->cluster = clusternum;
+	cache->areanum = areanum;
+	VectorCopy( aasworld->areas[areanum].center, cache->origin );
+	cache->starttraveltime = 1;
+	cache->travelflags = travelflags;
+	cache->prev = NULL;
+	cache->next = clustercache;
+	if ( clustercache ) {
+		clustercache->prev = cache;
+	}
+	aasworld->clusterareacache[clusternum][clusterareanum] = cache;
+	//never evict cache leading towards a portal
+	if ( aasworld->areasettings[areanum].cluster > 0 ) {
+		AAS_LinkCache( cache );
+	}
+	return cache;
+} //end of the function AAS_NewAreaRoutingCache
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+aas_routingcache_t *AAS_GetAreaRoutingCache( int clusternum, int areanum, int travelflags, qboolean forceUpdate ) {
+	aas_routingcache_t *cache;
 
 	// RF, remove team-specific flags which don't exist in this cluster
 	travelflags &= ~TFL_TEAM_FLAGS | aasworld->clusterTeamTravelFlags[clusternum];
 
-	//find the cache without undesired travel flags
-	for ( cache = clustercache; cache; cache = cache->next )
-	{
-		//if there aren't used any undesired travel types for the cache
-		if ( cache->travelflags == travelflags ) {
-			break;
-		}
-	} //end for
+	cache = AAS_FindAreaRoutingCache( clusternum, areanum, travelflags );
 
 	//if there was no cache
 	if ( !cache ) {
@@ -1531,22 +2096,16 @@ aas_routingcache_t *AAS_GetAreaRoutingCache( int clusternum, int areanum, int tr
 		if ( !forceUpdate && ( aasworld->frameroutingupdates > max_frameroutingupdates ) ) {
 			return NULL;
 		} //end if
-		cache = AAS_AllocRoutingCache( aasworld->clusters[clusternum].numreachabilityareas );
-		cache->cluster = clusternum;
-		cache->areanum = areanum;
-		VectorCopy( aasworld->areas[areanum].center, cache->origin );
-		cache->starttraveltime = 1;
-		cache->travelflags = travelflags;
-		cache->prev = NULL;
-		cache->next = clustercache;
-		if ( clustercache ) {
-			clustercache->prev = cache;
-		}
-		aasworld->clusterareacache[clusternum][clusterareanum] = cache;
+		cache = AAS_NewAreaRoutingCache( clusternum, areanum, travelflags );
 		AAS_UpdateAreaRoutingCache( cache );
+		aasworld->cachearena.misses++;
 	} //end if
+	else
+	{
+		aasworld->cachearena.hits++;
+	} //end else
 	  //the cache has been accessed
-	cache->time = AAS_RoutingTime();
+	AAS_CacheAccessed( cache );
 	return cache;
 } //end of the function AAS_GetAreaRoutingCache
 //===========================================================================
@@ -1555,7 +2114,7 @@ aas_routingcache_t *AAS_GetAreaRoutingCache( int clusternum, int areanum, int tr
 // Returns:				-
 // Changes Globals:		-
 //===========================================================================
-void AAS_UpdatePortalRoutingCache( aas_routingcache_t *portalcache ) {
+static void AAS_CalcPortalRoutingCache( aas_routingcache_t *portalcache, aas_routingupdate_t *portalupdate, qboolean precomputed ) {
 	int i, portalnum, clusterareanum; //, clusternum;
 	unsigned short int t;
 	aas_portal_t *portal;
@@ -1563,13 +2122,10 @@ void AAS_UpdatePortalRoutingCache( aas_routingcache_t *portalcache ) {
 	aas_routingcache_t *cache;
 	aas_routingupdate_t *updateliststart, *updatelistend, *curupdate, *nextupdate;
 
-#ifdef ROUTING_DEBUG
-	numportalcacheupdates++;
-#endif //ROUTING_DEBUG
-	   //clear the routing update fields
+	//clear the routing update fields
 //	memset(aasworld->portalupdate, 0, (aasworld->numportals+1) * sizeof(aas_routingupdate_t));
 	//
-	curupdate = &aasworld->portalupdate[aasworld->numportals];
+	curupdate = &portalupdate[aasworld->numportals];
 	curupdate->cluster = portalcache->cluster;
 	curupdate->areanum = portalcache->areanum;
 	curupdate->tmptraveltime = portalcache->starttraveltime;
@@ -1592,8 +2148,17 @@ void AAS_UpdatePortalRoutingCache( aas_routingcache_t *portalcache ) {
 		//
 		cluster = &aasworld->clusters[curupdate->cluster];
 		//
-		cache = AAS_GetAreaRoutingCache( curupdate->cluster,
-										 curupdate->areanum, portalcache->travelflags, qtrue );
+		//the precomputed area caches are only looked up, they may be used by other threads
+		if ( precomputed ) {
+			cache = AAS_FindAreaRoutingCache( curupdate->cluster, curupdate->areanum,
+											  portalcache->travelflags & ( ~TFL_TEAM_FLAGS | aasworld->clusterTeamTravelFlags[curupdate->cluster] ) );
+			if ( !cache ) {
+				continue;
+			}
+		} else {
+			cache = AAS_GetAreaRoutingCache( curupdate->cluster,
+											 curupdate->areanum, portalcache->travelflags, qtrue );
+		}
 		//take all portals of the cluster
 		for ( i = 0; i < cluster->numportals; i++ )
 		{
@@ -1615,7 +2180,7 @@ void AAS_UpdatePortalRoutingCache( aas_routingcache_t *portalcache ) {
 				 portalcache->traveltimes[portalnum] > t ) {
 				portalcache->traveltimes[portalnum] = t;
 				portalcache->reachabilities[portalnum] = cache->reachabilities[clusterareanum];
-				nextupdate = &aasworld->portalupdate[portalnum];
+				nextupdate = &portalupdate[portalnum];
 				if ( portal->frontcluster == curupdate->cluster ) {
 					nextupdate->cluster = portal->backcluster;
 				} //end if
@@ -1638,6 +2203,18 @@ void AAS_UpdatePortalRoutingCache( aas_routingcache_t *portalcache ) {
 			} //end if
 		} //end for
 	} //end while
+} //end of the function AAS_CalcPortalRoutingCache
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+void AAS_UpdatePortalRoutingCache( aas_routingcache_t *portalcache ) {
+#ifdef ROUTING_DEBUG
+	numportalcacheupdates++;
+#endif //ROUTING_DEBUG
+	AAS_CalcPortalRoutingCache( portalcache, aasworld->portalupdate, qfalse );
 } //end of the function AAS_UpdatePortalRoutingCache
 //===========================================================================
 //
@@ -1645,6 +2222,31 @@ void AAS_UpdatePortalRoutingCache( aas_routingcache_t *portalcache ) {
 // Returns:				-
 // Changes Globals:		-
 //===========================================================================
+static aas_routingcache_t *AAS_NewPortalRoutingCache( int clusternum, int areanum, int travelflags ) {
+	aas_routingcache_t *cache;
+
+	cache = AAS_AllocRoutingCache( CACHETYPE_PORTAL, aasworld->numportals );
+	cache->cluster = clusternum;
+	cache->areanum = areanum;
+	VectorCopy( aasworld->areas[areanum].center, cache->origin );
+	cache->starttraveltime = 1;
+	cache->travelflags = travelflags;
+	//add the cache to the cache list
+	cache->prev = NULL;
+	cache->next = aasworld->portalcache[areanum];
+	if ( aasworld->portalcache[areanum] ) {
+		aasworld->portalcache[areanum]->prev = cache;
+	}
+	aasworld->portalcache[areanum] = cache;
+	AAS_LinkCache( cache );
+	return cache;
+} //end of the function AAS_NewPortalRoutingCache
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
 aas_routingcache_t *AAS_GetPortalRoutingCache( int clusternum, int areanum, int travelflags ) {
 	aas_routingcache_t *cache;
 
@@ -1657,24 +2259,17 @@ aas_routingcache_t *AAS_GetPortalRoutingCache( int clusternum, int areanum, int
 	} //end for
 	  //if the portal routing isn't cached
 	if ( !cache ) {
-		cache = AAS_AllocRoutingCache( aasworld->numportals );
-		cache->cluster = clusternum;
-		cache->areanum = areanum;
-		VectorCopy( aasworld->areas[areanum].center, cache->origin );
-		cache->starttraveltime = 1;
-		cache->travelflags = travelflags;
-		//add the cache to the cache list
-		cache->prev = NULL;
-		cache->next = aasworld->portalcache[areanum];
-		if ( aasworld->portalcache[areanum] ) {
-			aasworld->portalcache[areanum]->prev = cache;
-		}
-		aasworld->portalcache[areanum] = cache;
+		cache = AAS_NewPortalRoutingCache( clusternum, areanum, travelflags );
 		//update the cache
 		AAS_UpdatePortalRoutingCache( cache );
+		aasworld->cachearena.misses++;
 	} //end if
+	else
+	{
+		aasworld->cachearena.hits++;
+	} //end else
 	  //the cache has been accessed
-	cache->time = AAS_RoutingTime();
+	AAS_CacheAccessed( cache );
 	return cache;
 } //end of the function AAS_GetPortalRoutingCache
 //===========================================================================
@@ -1715,13 +2310,6 @@ int AAS_AreaRouteToGoalArea( int areanum, vec3_t origin, int goalareanum, int tr
 		return qfalse;
 	} //end if
 
-	//make sure the routing cache doesn't grow to large
-	while ( routingcachesize > max_routingcachesize ) {
-		if ( !AAS_FreeOldestCache() ) {
-			break;
-		}
-	}
-	//
 	if ( AAS_AreaDoNotEnter( areanum ) || AAS_AreaDoNotEnter( goalareanum ) ) {
 		travelflags |= TFL_DONOTENTER;
 	} //end if
@@ -31,6 +31,8 @@ If you have questions concerning this license or the applicable additional terms
 static mapEntityData_t mapEntities[MAX_GENTITIES];
 static int mapEntityCount = 0;
 static int mapEntityTime = 0;
+static mapEntitySnapshot_t mapEntitySnapshots[MAPENT_BACKUP];
+static int mapEntitySequence = 0;       // last binary update applied
 static qboolean expanded = qfalse;
 
 extern playerInfo_t pi;
@@ -223,6 +225,101 @@ void CG_ParseMapEntityInfo( int axis_number, int allied_number ) {
 	}
 
 	CG_TransformAutomapEntity();
+
+	// the server falls back to text until we have acked the binary channel
+	CG_SendMapEntityAck();
+}
+
+/*
+=======================
+CG_InitMapEntityChannel
+=======================
+*/
+void CG_InitMapEntityChannel( void ) {
+	memset( mapEntitySnapshots, 0, sizeof( mapEntitySnapshots ) );
+	mapEntitySequence = 0;
+}
+
+/*
+=======================
+CG_SendMapEntityAck
+
+Tells the server which state binary updates can be delta compressed against,
+an ack of 0 asks for a full update
+=======================
+*/
+void CG_SendMapEntityAck( void ) {
+	byte buffer[8];
+
+	if ( cg.demoPlayback ) {
+		return;
+	}
+
+	trap_SendMessage( (char *)buffer, BG_WriteMapEntityAck( buffer, mapEntitySequence ) );
+}
+
+/*
+=======================
+CG_ParseMapEntityDelta
+=======================
+*/
+void CG_ParseMapEntityDelta( const char *buf, int buflen ) {
+	mapEntitySnapshot_t *from, *to;
+	mapEntityData_t *mEnt;
+	mapEntityState_t *state;
+	int sequence, deltaSequence, i;
+
+	if ( !BG_ReadMapEntityHeader( (const byte *)buf, buflen, &sequence, &deltaSequence ) ) {
+		return;
+	}
+
+	if ( deltaSequence ) {
+		if ( sequence <= mapEntitySequence ) {
+			return;     // duplicated or out of order
+		}
+
+		from = &mapEntitySnapshots[deltaSequence & MAPENT_MASK];
+		if ( sequence - deltaSequence <= 0 || sequence - deltaSequence >= MAPENT_BACKUP || from->sequence != deltaSequence ) {
+			// we don't have the base, tell the server what we do have
+			CG_SendMapEntityAck();
+			return;
+		}
+	} else {
+		// a full update always applies, the server may have restarted its sequence
+		from = NULL;
+	}
+
+	to = &mapEntitySnapshots[sequence & MAPENT_MASK];
+	if ( !BG_ReadMapEntityDelta( (const byte *)buf, buflen, from, to ) ) {
+		CG_Printf( "CG_ParseMapEntityDelta: bad update %i\n", sequence );
+		to->sequence = 0;
+		return;
+	}
+
+	mapEntitySequence = sequence;
+	CG_SendMapEntityAck();
+
+	mapEntityCount = 0;
+	mapEntityTime = cg.time;
+
+	for ( i = 0; i < to->numEntities; i++ ) {
+		state = &to->entities[i];
+		mEnt = &mapEntities[mapEntityCount++];
+
+		mEnt->type = state->type;
+		mEnt->x = state->x * 128;
+		mEnt->y = state->y * 128;
+		mEnt->z = state->z * 128;
+		mEnt->yaw = state->yaw;
+		mEnt->data = state->data;
+
+		mEnt->transformed[0] = ( mEnt->x - cg.mapcoordsMins[0] ) * cg.mapcoordsScale[0] * CC_2D_W;
+		mEnt->transformed[1] = ( mEnt->y - cg.mapcoordsMins[1] ) * cg.mapcoordsScale[1] * CC_2D_H;
+
+		mEnt->team = ( state->key & MEK_ALLIES ) ? TEAM_ALLIES : TEAM_AXIS;
+	}
+
+	CG_TransformAutomapEntity();
 }
 
 static qboolean gridInitDone = qfalse;
@@ -767,6 +767,9 @@ typedef enum {
 } showView_t;
 
 void CG_ParseMapEntityInfo( int axis_number, int allied_number );
+void CG_InitMapEntityChannel( void );
+void CG_SendMapEntityAck( void );
+void CG_ParseMapEntityDelta( const char *buf, int buflen );
 
 #define MAX_BACKUP_STATES ( CMD_BACKUP + 2 )
 
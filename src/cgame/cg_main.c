@@ -94,7 +94,8 @@ int vmMain( int command, int arg0, int arg1, int arg2, int arg3, int arg4, int a
 	case CG_WANTSBINDKEYS:
 		return ( g_waitingForKey && g_bindItem ) ? qtrue : qfalse;
 	case CG_MESSAGERECEIVED:
-		return -1;
+		CG_ParseMapEntityDelta( (const char *)arg0, arg1 );
+		return 0;
 	default:
 		CG_Error( "vmMain: unknown command %i", command );
 		break;
@@ -2717,6 +2718,11 @@ void CG_Init( int serverMessageNum, int serverCommandSequence, int clientNum, qb
 	CG_ParseServerinfo();
 	CG_ParseWolfinfo();     // NERVE - SMF
 
+	CG_InitMapEntityChannel();
+	if ( !demoPlayback ) {
+		CG_SendMapEntityAck();
+	}
+
 	cgs.campaignInfoLoaded = qfalse;
 	if ( cgs.gametype == GT_WOLF_CAMPAIGN ) {
 		CG_LocateCampaign();
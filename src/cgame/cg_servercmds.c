@@ -895,6 +895,10 @@ static void CG_MapRestart( void ) {
 
 	CG_LimboPanel_RequestObjective();
 
+	// the game restarted its command map channel
+	CG_InitMapEntityChannel();
+	CG_SendMapEntityAck();
+
 	// (SA) clear zoom (so no warpies)
 	cg.zoomedBinoc = qfalse;
 	cg.zoomedScope = qfalse;
@@ -0,0 +1,660 @@
+/*
+===========================================================================
+
+Wolfenstein: Enemy Territory GPL Source Code
+Copyright (C) 1999-2010 id Software LLC, a ZeniMax Media company. 
+
+This file is part of the Wolfenstein: Enemy Territory GPL Source Code (Wolf ET Source Code).  
+
+Wolf ET Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Wolf ET Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Wolf ET Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Wolf: ET Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Wolf ET Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+
+
+#include "client.h"
+
+/*
+=======================================================================
+
+DEMO SEEK INDEX
+
+While recording, the client asks for a non-delta snapshot every
+cl_demoKeyframe msec.  Each one becomes a keyframe: the demo can be
+parsed from that message on without any of the messages before it.
+A keyframe also keeps what the parse wouldn't restore by itself, the
+configstrings that differ from the demo's gamestate and the reliable
+commands the cgame hadn't executed yet.
+
+The keyframes go after the demo's [-1] [-1] terminator, so older
+clients never see them:
+
+[long length] [keyframe] ...
+[long serverTime] [long message offset] [long keyframe offset] ...
+[long numKeyframes] [long table offset] [long DEMO_INDEX_MAGIC]
+
+A keyframe is [long serverCommandSequence before its message]
+[short count] ([short index] [bigstring]) ... [short count] ([string]) ...
+
+Seeking picks the last keyframe before the target with a binary search,
+hands the cgame the configstrings and commands it would have seen as
+new reliable commands, and parses forward from the keyframe's message.
+
+=======================================================================
+*/
+
+#define DEMO_INDEX_MAGIC    0x31584944      // "DIX1"
+#define DEMO_KEYFRAME_SIZE  0x40000
+
+typedef struct {
+	int serverTime;
+	int messageOffset;                  // of the [sequence] [length] header
+	int keyframeOffset;
+} demoKeyframe_t;
+
+typedef struct {
+	gameState_t baseState;              // the configstrings in the demo's gamestate
+
+	demoKeyframe_t  *keyframes;
+	int numKeyframes;
+	int maxKeyframes;
+
+	// recording only, the keyframes are written out when the demo stops
+	byte            *data;
+	int dataSize;
+	int maxData;
+	int lastKeyframeTime;
+
+	// playback only
+	int seekTarget;                     // applied when a restarted demo is loaded, -1 if none
+	int numSeeks;
+	int seekMsec;
+} demoIndex_t;
+
+static demoIndex_t cl_demoIndex = { { { 0 } }, NULL, 0, 0, NULL, 0, 0, 0, -1 };
+
+static byte cl_keyframeBuf[DEMO_KEYFRAME_SIZE];
+
+/*
+==================
+CL_DemoIndexFree
+==================
+*/
+static void CL_DemoIndexFree( void ) {
+	if ( cl_demoIndex.keyframes ) {
+		Z_Free( cl_demoIndex.keyframes );
+		cl_demoIndex.keyframes = NULL;
+	}
+	if ( cl_demoIndex.data ) {
+		Z_Free( cl_demoIndex.data );
+		cl_demoIndex.data = NULL;
+	}
+	cl_demoIndex.numKeyframes = cl_demoIndex.maxKeyframes = 0;
+	cl_demoIndex.dataSize = cl_demoIndex.maxData = 0;
+}
+
+/*
+==================
+CL_DemoConfigstring
+==================
+*/
+static const char *CL_DemoConfigstring( const gameState_t *gs, int index ) {
+	return gs->stringData + gs->stringOffsets[index];
+}
+
+/*
+=======================================================================
+
+RECORDING
+
+=======================================================================
+*/
+
+/*
+==================
+CL_DemoIndexBegin
+
+Called by CL_Record once the gamestate has been written
+==================
+*/
+void CL_DemoIndexBegin( void ) {
+	CL_DemoIndexFree();
+
+	cl_demoIndex.baseState = cl.gameState;
+	cl_demoIndex.lastKeyframeTime = 0;
+	clc.demokeyframe = qfalse;
+}
+
+/*
+==================
+CL_DemoAddKeyframe
+==================
+*/
+static void CL_DemoAddKeyframe( int commandSequence ) {
+	msg_t msg;
+	demoKeyframe_t  *key;
+	const char      *s;
+	int i, count, first;
+	void            *old;
+
+	MSG_InitOOB( &msg, cl_keyframeBuf, sizeof( cl_keyframeBuf ) );
+
+	MSG_WriteLong( &msg, commandSequence );
+
+	count = 0;
+	for ( i = 0 ; i < MAX_CONFIGSTRINGS ; i++ ) {
+		if ( strcmp( CL_DemoConfigstring( &cl.gameState, i ), CL_DemoConfigstring( &cl_demoIndex.baseState, i ) ) ) {
+			count++;
+		}
+	}
+	MSG_WriteShort( &msg, count );
+	for ( i = 0 ; i < MAX_CONFIGSTRINGS ; i++ ) {
+		s = CL_DemoConfigstring( &cl.gameState, i );
+		if ( strcmp( s, CL_DemoConfigstring( &cl_demoIndex.baseState, i ) ) ) {
+			MSG_WriteShort( &msg, i );
+			MSG_WriteBigString( &msg, s );
+		}
+	}
+
+	// commands in this message are parsed again after a seek, the ones
+	// before it that the cgame hasn't run yet have to be kept here
+	first = clc.lastExecutedServerCommand + 1;
+	if ( first <= commandSequence - MAX_RELIABLE_COMMANDS ) {
+		first = commandSequence - MAX_RELIABLE_COMMANDS + 1;
+	}
+	MSG_WriteShort( &msg, commandSequence - first + 1 );
+	for ( i = first ; i <= commandSequence ; i++ ) {
+		MSG_WriteString( &msg, clc.serverCommands[i & ( MAX_RELIABLE_COMMANDS - 1 )] );
+	}
+
+	if ( msg.overflowed ) {
+		Com_Printf( S_COLOR_YELLOW "WARNING: demo keyframe too large, skipped\n" );
+		return;
+	}
+
+	if ( cl_demoIndex.numKeyframes == cl_demoIndex.maxKeyframes ) {
+		old = cl_demoIndex.keyframes;
+		cl_demoIndex.maxKeyframes = cl_demoIndex.maxKeyframes ? cl_demoIndex.maxKeyframes * 2 : 64;
+		cl_demoIndex.keyframes = Z_Malloc( cl_demoIndex.maxKeyframes * sizeof( demoKeyframe_t ) );
+		if ( old ) {
+			memcpy( cl_demoIndex.keyframes, old, cl_demoIndex.numKeyframes * sizeof( demoKeyframe_t ) );
+			Z_Free( old );
+		}
+	}
+
+	if ( cl_demoIndex.dataSize + 4 + msg.cursize > cl_demoIndex.maxData ) {
+		old = cl_demoIndex.data;
+		cl_demoIndex.maxData = ( cl_demoIndex.dataSize + 4 + msg.cursize ) * 2;
+		cl_demoIndex.data = Z_Malloc( cl_demoIndex.maxData );
+		if ( old ) {
+			memcpy( cl_demoIndex.data, old, cl_demoIndex.dataSize );
+			Z_Free( old );
+		}
+	}
+
+	key = &cl_demoIndex.keyframes[cl_demoIndex.numKeyframes++];
+	key->serverTime = cl.snap.serverTime;
+	key->messageOffset = FS_FTell( clc.demofile );
+	key->keyframeOffset = cl_demoIndex.dataSize;     // relative until the index is written
+
+	*(int *)( cl_demoIndex.data + cl_demoIndex.dataSize ) = LittleLong( msg.cursize );
+	memcpy( cl_demoIndex.data + cl_demoIndex.dataSize + 4, msg.data, msg.cursize );
+	cl_demoIndex.dataSize += 4 + msg.cursize;
+}
+
+/*
+==================
+CL_DemoCheckKeyframe
+
+Called for every message about to be written to the demo, with the
+reliable command sequence from before the message was parsed
+==================
+*/
+void CL_DemoCheckKeyframe( int commandSequence ) {
+	// a non-delta snapshot in this message makes it a keyframe
+	if ( cl.snap.valid && cl.snap.messageNum == clc.serverMessageSequence && cl.snap.deltaNum == -1 ) {
+		CL_DemoAddKeyframe( commandSequence );
+		cl_demoIndex.lastKeyframeTime = cl.snap.serverTime;
+		clc.demokeyframe = qfalse;
+		return;
+	}
+
+	if ( cl_demoKeyframe->integer > 0 && cl.snap.serverTime - cl_demoIndex.lastKeyframeTime >= cl_demoKeyframe->integer ) {
+		clc.demokeyframe = qtrue;   // CL_WritePacket asks for a non-delta snapshot
+	}
+}
+
+/*
+==================
+CL_DemoIndexWrite
+
+Called by CL_StopRecord_f after the end of demo marker
+==================
+*/
+void CL_DemoIndexWrite( void ) {
+	int i, base, table, v;
+	demoKeyframe_t  *key;
+
+	if ( !cl_demoIndex.numKeyframes ) {
+		CL_DemoIndexFree();
+		return;
+	}
+
+	base = FS_FTell( clc.demofile );
+	FS_Write( cl_demoIndex.data, cl_demoIndex.dataSize, clc.demofile );
+
+	table = FS_FTell( clc.demofile );
+	for ( i = 0, key = cl_demoIndex.keyframes ; i < cl_demoIndex.numKeyframes ; i++, key++ ) {
+		v = LittleLong( key->serverTime );
+		FS_Write( &v, 4, clc.demofile );
+		v = LittleLong( key->messageOffset );
+		FS_Write( &v, 4, clc.demofile );
+		v = LittleLong( base + key->keyframeOffset );
+		FS_Write( &v, 4, clc.demofile );
+	}
+
+	v = LittleLong( cl_demoIndex.numKeyframes );
+	FS_Write( &v, 4, clc.demofile );
+	v = LittleLong( table );
+	FS_Write( &v, 4, clc.demofile );
+	v = LittleLong( DEMO_INDEX_MAGIC );
+	FS_Write( &v, 4, clc.demofile );
+
+	Com_DPrintf( "wrote %i demo keyframes, %i bytes\n", cl_demoIndex.numKeyframes, cl_demoIndex.dataSize + cl_demoIndex.numKeyframes * 12 + 12 );
+
+	CL_DemoIndexFree();
+}
+
+/*
+=======================================================================
+
+PLAYBACK
+
+=======================================================================
+*/
+
+/*
+==================
+CL_DemoIndexOpen
+
+Called by CL_PlayDemo_f once the gamestate has been parsed, loads the
+keyframe table if the demo has one
+==================
+*/
+void CL_DemoIndexOpen( const char *name ) {
+	int pos, trailer[3], i, num, table, length;
+	int target;
+	demoKeyframe_t  *key;
+
+	CL_DemoIndexFree();
+
+	target = cl_demoIndex.seekTarget;
+	cl_demoIndex.seekTarget = -1;
+	if ( target < 0 ) {
+		cl_demoIndex.numSeeks = cl_demoIndex.seekMsec = 0;
+	}
+
+	cl_demoIndex.baseState = cl.gameState;
+
+	// seeking inside a pk3 isn't supported
+	if ( FS_FileIsInPAK( name, NULL ) != -1 ) {
+		return;
+	}
+
+	pos = FS_FTell( clc.demofile );
+
+	if ( FS_Seek( clc.demofile, -12, FS_SEEK_END ) || FS_Read( trailer, 12, clc.demofile ) != 12
+		 || LittleLong( trailer[2] ) != DEMO_INDEX_MAGIC ) {
+		FS_Seek( clc.demofile, pos, FS_SEEK_SET );
+		return;
+	}
+
+	// the table has to fill the space between the demo messages and the
+	// trailer exactly, anything else is a damaged or foreign file
+	length = FS_FTell( clc.demofile );
+	num = LittleLong( trailer[0] );
+	table = LittleLong( trailer[1] );
+	if ( num <= 0 || table < pos || table > length - 12
+		 || ( length - 12 - table ) % sizeof( demoKeyframe_t ) || ( length - 12 - table ) / sizeof( demoKeyframe_t ) != num ) {
+		Com_Printf( "Demo seek index is damaged, seeking disabled.\n" );
+		FS_Seek( clc.demofile, pos, FS_SEEK_SET );
+		return;
+	}
+
+	cl_demoIndex.keyframes = Z_Malloc( num * sizeof( demoKeyframe_t ) );
+	cl_demoIndex.maxKeyframes = num;
+
+	FS_Seek( clc.demofile, table, FS_SEEK_SET );
+	if ( FS_Read( cl_demoIndex.keyframes, num * sizeof( demoKeyframe_t ), clc.demofile ) != num * sizeof( demoKeyframe_t ) ) {
+		Com_Printf( "Demo seek index was truncated.\n" );
+		CL_DemoIndexFree();
+		FS_Seek( clc.demofile, pos, FS_SEEK_SET );
+		return;
+	}
+	for ( i = 0, key = cl_demoIndex.keyframes ; i < num ; i++, key++ ) {
+		key->serverTime = LittleLong( key->serverTime );
+		key->messageOffset = LittleLong( key->messageOffset );
+		key->keyframeOffset = LittleLong( key->keyframeOffset );
+		if ( key->messageOffset < pos || key->messageOffset >= table
+			 || key->keyframeOffset < pos || key->keyframeOffset >= table ) {
+			Com_Printf( "Demo seek index is damaged, seeking disabled.\n" );
+			CL_DemoIndexFree();
+			FS_Seek( clc.demofile, pos, FS_SEEK_SET );
+			return;
+		}
+	}
+	cl_demoIndex.numKeyframes = num;
+
+	FS_Seek( clc.demofile, pos, FS_SEEK_SET );
+
+	Com_DPrintf( "demo has %i seek keyframes\n", num );
+
+	// a backwards seek restarts the demo, finish it now
+	if ( target >= 0 ) {
+		CL_DemoSeek( target );
+	}
+}
+
+/*
+==================
+CL_DemoIndexClose
+==================
+*/
+void CL_DemoIndexClose( void ) {
+	CL_DemoIndexFree();
+}
+
+/*
+==================
+CL_DemoAddCommand
+
+Queues a reliable command for the cgame as if it came from the demo
+==================
+*/
+static void CL_DemoAddCommand( const char *cmd ) {
+	clc.serverCommandSequence++;
+	Q_strncpyz( clc.serverCommands[clc.serverCommandSequence & ( MAX_RELIABLE_COMMANDS - 1 )], cmd, MAX_TOKEN_CHARS );
+}
+
+/*
+==================
+CL_DemoAddConfigstring
+
+Same chunking as SV_UpdateConfigStrings
+==================
+*/
+static void CL_DemoAddConfigstring( int index, const char *s ) {
+	int maxChunkSize = MAX_STRING_CHARS - 24;
+	int len, sent, remaining;
+	char        *cmd;
+	char buf[MAX_STRING_CHARS];
+
+	len = strlen( s );
+	if ( len < maxChunkSize ) {
+		CL_DemoAddCommand( va( "cs %i \"%s\"\n", index, s ) );
+		return;
+	}
+
+	sent = 0;
+	remaining = len;
+	while ( remaining > 0 ) {
+		if ( sent == 0 ) {
+			cmd = "bcs0";
+		} else if ( remaining < maxChunkSize ) {
+			cmd = "bcs2";
+		} else {
+			cmd = "bcs1";
+		}
+		Q_strncpyz( buf, &s[sent], maxChunkSize );
+
+		CL_DemoAddCommand( va( "%s %i \"%s\"\n", cmd, index, buf ) );
+
+		sent += ( maxChunkSize - 1 );
+		remaining -= ( maxChunkSize - 1 );
+	}
+}
+
+/*
+==================
+CL_DemoJumpToKeyframe
+
+Sets up the reliable commands for the keyframe and moves the demo file
+to its message, the next CL_ReadDemoMessage parses it
+==================
+*/
+static qboolean CL_DemoJumpToKeyframe( demoKeyframe_t *key ) {
+	msg_t msg;
+	static char stringData[MAX_GAMESTATE_CHARS];
+	static int stringOffsets[MAX_CONFIGSTRINGS];
+	const char  *s;
+	int len, i, count, index, commandSequence, dataCount;
+
+	if ( FS_Seek( clc.demofile, key->keyframeOffset, FS_SEEK_SET ) || FS_Read( &len, 4, clc.demofile ) != 4 ) {
+		return qfalse;
+	}
+	len = LittleLong( len );
+	if ( len < 0 || len > sizeof( cl_keyframeBuf ) || FS_Read( cl_keyframeBuf, len, clc.demofile ) != len ) {
+		return qfalse;
+	}
+
+	MSG_InitOOB( &msg, cl_keyframeBuf, sizeof( cl_keyframeBuf ) );
+	msg.cursize = len;
+	MSG_BeginReadingOOB( &msg );
+
+	commandSequence = MSG_ReadLong( &msg );
+
+	// the keyframe's configstrings are the gamestate's plus the ones it lists
+	memset( stringOffsets, -1, sizeof( stringOffsets ) );
+	dataCount = 0;
+	count = MSG_ReadShort( &msg );
+	for ( i = 0 ; i < count ; i++ ) {
+		index = MSG_ReadShort( &msg );
+		s = MSG_ReadBigString( &msg );
+		len = strlen( s );
+		if ( index < 0 || index >= MAX_CONFIGSTRINGS || dataCount + len + 1 > MAX_GAMESTATE_CHARS ) {
+			return qfalse;
+		}
+		memcpy( stringData + dataCount, s, len + 1 );
+		stringOffsets[index] = dataCount;
+		dataCount += len + 1;
+	}
+
+	// whatever the cgame hasn't run yet belongs to the part of the demo
+	// being skipped
+	for ( i = clc.lastExecutedServerCommand + 1 ; i <= clc.serverCommandSequence ; i++ ) {
+		clc.serverCommands[i & ( MAX_RELIABLE_COMMANDS - 1 )][0] = 0;
+	}
+
+	// update every configstring that differs from what the cgame has
+	for ( i = 0 ; i < MAX_CONFIGSTRINGS ; i++ ) {
+		if ( stringOffsets[i] >= 0 ) {
+			s = stringData + stringOffsets[i];
+		} else {
+			s = CL_DemoConfigstring( &cl_demoIndex.baseState, i );
+		}
+		if ( strcmp( s, CL_DemoConfigstring( &cl.gameState, i ) ) ) {
+			CL_DemoAddConfigstring( i, s );
+		}
+	}
+
+	// then the commands that were pending when the keyframe was recorded
+	count = MSG_ReadShort( &msg );
+	for ( i = 0 ; i < count ; i++ ) {
+		CL_DemoAddCommand( MSG_ReadString( &msg ) );
+	}
+
+	if ( msg.readcount > msg.cursize ) {
+		return qfalse;
+	}
+
+	if ( clc.serverCommandSequence - clc.lastExecutedServerCommand >= MAX_RELIABLE_COMMANDS ) {
+		Com_Printf( S_COLOR_YELLOW "WARNING: demo seek queued more than %i commands, some were lost\n", MAX_RELIABLE_COMMANDS );
+	}
+
+	// commands read from the demo from here on follow the ones just queued
+	clc.demoCommandOffset = clc.serverCommandSequence - commandSequence;
+
+	return FS_Seek( clc.demofile, key->messageOffset, FS_SEEK_SET ) == 0;
+}
+
+/*
+==================
+CL_DemoSeek
+
+Moves playback to the first snapshot at or after serverTime
+==================
+*/
+void CL_DemoSeek( int serverTime ) {
+	int start, low, high, mid, messages, oldTime;
+	demoKeyframe_t  *key;
+
+	if ( !clc.demoplaying || !clc.demofile ) {
+		return;
+	}
+
+	if ( !cl_demoIndex.numKeyframes ) {
+		Com_Printf( "This demo has no seek index.\n" );
+		return;
+	}
+
+	if ( cl.snap.valid && serverTime < cl.snap.serverTime ) {
+		// the cgame can't go back in time, start over and seek from there
+		cl_demoIndex.seekTarget = serverTime;
+		Cbuf_ExecuteText( EXEC_APPEND, va( "demo %s\n", clc.demoName ) );
+		return;
+	}
+
+	start = Sys_Milliseconds();
+
+	// last keyframe at or before the target
+	low = 0;
+	high = cl_demoIndex.numKeyframes - 1;
+	while ( low < high ) {
+		mid = ( low + high + 1 ) / 2;
+		if ( cl_demoIndex.keyframes[mid].serverTime <= serverTime ) {
+			low = mid;
+		} else {
+			high = mid - 1;
+		}
+	}
+	key = &cl_demoIndex.keyframes[low];
+
+	oldTime = cl.snap.valid ? cl.snap.serverTime : 0;
+
+	// no point jumping if the keyframe is behind what has already been parsed
+	if ( key->serverTime > oldTime ) {
+		if ( !CL_DemoJumpToKeyframe( key ) ) {
+			Com_Error( ERR_DROP, "CL_DemoSeek: bad keyframe in demo index" );
+			return;
+		}
+	}
+
+	messages = 0;
+	while ( clc.demoplaying && ( !cl.snap.valid || cl.snap.serverTime < serverTime ) ) {
+		CL_ReadDemoMessage();
+		messages++;
+	}
+
+	if ( !clc.demoplaying ) {
+		return;
+	}
+
+	// keep the same distance to the new snapshot so playback carries on from there
+	if ( cls.state == CA_ACTIVE ) {
+		cl.serverTimeDelta += cl.snap.serverTime - oldTime;
+		clc.timeDemoBaseTime += cl.snap.serverTime - oldTime;
+	}
+
+	cl_demoIndex.numSeeks++;
+	cl_demoIndex.seekMsec += Sys_Milliseconds() - start;
+
+	Com_Printf( "demoseek: %i:%02i, %i messages from the keyframe at %i:%02i, %i msec\n",
+				( cl.snap.serverTime - cl_demoIndex.keyframes[0].serverTime ) / 60000,
+				( ( cl.snap.serverTime - cl_demoIndex.keyframes[0].serverTime ) / 1000 ) % 60,
+				messages,
+				( key->serverTime - cl_demoIndex.keyframes[0].serverTime ) / 60000,
+				( ( key->serverTime - cl_demoIndex.keyframes[0].serverTime ) / 1000 ) % 60,
+				Sys_Milliseconds() - start );
+}
+
+/*
+==================
+CL_DemoSeekStats
+
+Printed with the timedemo results
+==================
+*/
+void CL_DemoSeekStats( void ) {
+	if ( !cl_demoIndex.numSeeks ) {
+		return;
+	}
+
+	Com_Printf( "%i seeks, %i msec, %.1f msec per seek\n", cl_demoIndex.numSeeks, cl_demoIndex.seekMsec,
+				(float)cl_demoIndex.seekMsec / cl_demoIndex.numSeeks );
+}
+
+/*
+==================
+CL_DemoSeek_f
+
+demoseek <[+|-]seconds | minutes:seconds>
+
+Times are from the start of the demo, or from the current position with + or -
+==================
+*/
+void CL_DemoSeek_f( void ) {
+	char        *s, *colon;
+	int msec, base;
+
+	if ( Cmd_Argc() != 2 ) {
+		Com_Printf( "demoseek <[+|-]seconds | minutes:seconds>\n" );
+		return;
+	}
+
+	if ( !clc.demoplaying || cls.state != CA_ACTIVE ) {
+		Com_Printf( "Not playing a demo.\n" );
+		return;
+	}
+
+	if ( !cl_demoIndex.numKeyframes ) {
+		Com_Printf( "This demo has no seek index.\n" );
+		return;
+	}
+
+	s = Cmd_Argv( 1 );
+
+	if ( s[0] == '+' || s[0] == '-' ) {
+		base = cl.snap.serverTime;
+	} else {
+		base = cl_demoIndex.keyframes[0].serverTime;
+	}
+
+	colon = strchr( s, ':' );
+	if ( colon ) {
+		msec = ( atoi( s ) * 60 + atoi( colon + 1 ) ) * 1000;
+	} else {
+		msec = atof( s ) * 1000;
+	}
+
+	if ( base + msec < cl_demoIndex.keyframes[0].serverTime ) {
+		msec = cl_demoIndex.keyframes[0].serverTime - base;
+	}
+
+	CL_DemoSeek( base + msec );
+}
@@ -1103,7 +1103,7 @@ static void CompleteCommand( void ) {
 			return;
 		}
 
-		Cmd_CommandCompletion( FindMatches );
+		Cmd_CommandCompletionPrefix( completionString, FindMatches );
 		Cvar_CommandCompletion( FindMatches );
 
 		if ( matchCount == 0 ) {
@@ -1131,7 +1131,7 @@ static void CompleteCommand( void ) {
 		Com_Printf( "]%s\n", edit->buffer );
 
 		// run through again, printing matches
-		Cmd_CommandCompletion( PrintMatches );
+		Cmd_CommandCompletionPrefix( currentMatch, PrintMatches );
 		Cvar_CommandCompletion( PrintCvarMatches );
 	} else {
 		if ( matchCount != 1 ) {
@@ -1145,7 +1145,7 @@ static void CompleteCommand( void ) {
 				matchIndex = 0;
 			}
 			findMatchIndex = 0;
-			Cmd_CommandCompletion( FindIndexMatch );
+			Cmd_CommandCompletionPrefix( completionString, FindIndexMatch );
 			Cvar_CommandCompletion( FindIndexMatch );
 
 			Com_Memcpy( &temp, edit, sizeof( field_t ) );
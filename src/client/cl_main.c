@@ -75,6 +75,7 @@ cvar_t  *m_filter;
 cvar_t  *cl_activeAction;
 
 cvar_t  *cl_autorecord;
+cvar_t  *cl_demoKeyframe;
 
 cvar_t  *cl_motdString;
 
@@ -291,6 +292,7 @@ void CL_StopRecord_f( void ) {
 	len = -1;
 	FS_Write( &len, 4, clc.demofile );
 	FS_Write( &len, 4, clc.demofile );
+	CL_DemoIndexWrite();
 	FS_FCloseFile( clc.demofile );
 	clc.demofile = 0;
 
@@ -454,6 +456,8 @@ void CL_Record( const char* name ) {
 	FS_Write( &len, 4, clc.demofile );
 	FS_Write( buf.data, buf.cursize, clc.demofile );
 
+	CL_DemoIndexBegin();
+
 	// the rest of the demo file will be copied from net messages
 }
 
@@ -480,6 +484,7 @@ void CL_DemoCompleted( void ) {
 			Com_Printf( "%i frames, %3.1f seconds: %3.1f fps\n", clc.timeDemoFrames,
 						time / 1000.0, clc.timeDemoFrames * 1000.0 / time );
 		}
+		CL_DemoSeekStats();
 	}
 
 	// fretn
@@ -825,6 +830,10 @@ void CL_PlayDemo_f( void ) {
 	// don't get the first snapshot this frame, to prevent the long
 	// time from the gamestate load from messing causing a time skip
 	clc.firstDemoFrameSkipped = qfalse;
+
+	if ( clc.demofile ) {
+		CL_DemoIndexOpen( name );
+	}
 //	if (clc.waverecording) {
 //		CL_WriteWaveClose();
 //		clc.waverecording = qfalse;
@@ -1030,6 +1039,7 @@ void CL_Disconnect( qboolean showMainMenu ) {
 		FS_FCloseFile( clc.demofile );
 		clc.demofile = 0;
 	}
+	CL_DemoIndexClose();
 
 	if ( uivm && showMainMenu ) {
 		VM_Call( uivm, UI_SET_ACTIVE_MENU, UIMENU_NONE );
@@ -2446,6 +2456,7 @@ A packet has arrived from the main event loop
 */
 void CL_PacketEvent( netadr_t from, msg_t *msg ) {
 	int headerBytes;
+	int commandSequence;
 
 	if ( msg->cursize >= 4 && *(int *)msg->data == -1 ) {
 		CL_ConnectionlessPacket( from, msg );
@@ -2486,6 +2497,7 @@ void CL_PacketEvent( netadr_t from, msg_t *msg ) {
 	clc.serverMessageSequence = LittleLong( *(int *)msg->data );
 
 	clc.lastPacketTime = cls.realtime;
+	commandSequence = clc.serverCommandSequence;
 	CL_ParseServerMessage( msg );
 
 	//
@@ -2494,6 +2506,7 @@ void CL_PacketEvent( netadr_t from, msg_t *msg ) {
 	//
 
 	if ( clc.demorecording && !clc.demowaiting ) {
+		CL_DemoCheckKeyframe( commandSequence );
 		CL_WriteDemoMessage( msg, headerBytes );
 	}
 }
@@ -3324,6 +3337,7 @@ void CL_Init( void ) {
 	rcon_client_password = Cvar_Get( "rconPassword", "", CVAR_TEMP );
 	cl_activeAction = Cvar_Get( "activeAction", "", CVAR_TEMP );
 	cl_autorecord = Cvar_Get( "cl_autorecord", "0", CVAR_TEMP );
+	cl_demoKeyframe = Cvar_Get( "cl_demoKeyframe", "10000", CVAR_ARCHIVE );
 
 	cl_timedemo = Cvar_Get( "timedemo", "0", 0 );
 	cl_avidemo = Cvar_Get( "cl_avidemo", "0", 0 );
@@ -3478,6 +3492,7 @@ void CL_Init( void ) {
 	Cmd_AddCommand( "demo", CL_PlayDemo_f );
 	Cmd_AddCommand( "cinematic", CL_PlayCinematic_f );
 	Cmd_AddCommand( "stoprecord", CL_StopRecord_f );
+	Cmd_AddCommand( "demoseek", CL_DemoSeek_f );
 	Cmd_AddCommand( "connect", CL_Connect_f );
 	Cmd_AddCommand( "reconnect", CL_Reconnect_f );
 	Cmd_AddCommand( "localservers", CL_LocalServers_f );
@@ -3582,6 +3597,7 @@ void CL_Shutdown( void ) {
 	Cmd_RemoveCommand( "demo" );
 	Cmd_RemoveCommand( "cinematic" );
 	Cmd_RemoveCommand( "stoprecord" );
+	Cmd_RemoveCommand( "demoseek" );
 	Cmd_RemoveCommand( "connect" );
 	Cmd_RemoveCommand( "localservers" );
 	Cmd_RemoveCommand( "globalservers" );
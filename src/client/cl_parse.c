@@ -816,7 +816,7 @@ void CL_ParseCommandString( msg_t *msg ) {
 	int seq;
 	int index;
 
-	seq = MSG_ReadLong( msg );
+	seq = MSG_ReadLong( msg ) + clc.demoCommandOffset;
 	s = MSG_ReadString( msg );
 
 	// see if we have already executed stored it off
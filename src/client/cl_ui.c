@@ -1261,7 +1261,7 @@ CL_InitUI
 void CL_InitUI( void ) {
 	int v;
 
-	uivm = VM_Create( "ui", CL_UISystemCalls, VMI_NATIVE );
+	uivm = VM_Create( "ui", CL_UISystemCalls, Cvar_VariableIntegerValue( "vm_ui" ) );
 	if ( !uivm ) {
 		Com_Error( ERR_FATAL, "VM_Create on UI failed" );
 	}
@@ -242,6 +242,8 @@ typedef struct {
 	qboolean demowaiting;       // don't record until a non-delta message is received
 	qboolean firstDemoFrameSkipped;
 	fileHandle_t demofile;
+	qboolean demokeyframe;      // ask for a non-delta message to record a seek keyframe
+	int demoCommandOffset;      // added to reliable command numbers read after a demo seek
 
 	qboolean waverecording;
 	fileHandle_t wavefile;
@@ -427,6 +429,7 @@ extern cvar_t  *cl_timedemo;
 
 extern cvar_t  *cl_activeAction;
 extern cvar_t  *cl_autorecord;
+extern cvar_t  *cl_demoKeyframe;
 
 extern cvar_t  *cl_allowDownload;
 extern cvar_t  *cl_conXOffset;
@@ -497,6 +500,18 @@ void CL_OpenURL( const char *url ); // TTimo
 
 void CL_Record( const char* name );
 
+//
+// cl_demo.c
+//
+void CL_DemoIndexBegin( void );
+void CL_DemoCheckKeyframe( int commandSequence );
+void CL_DemoIndexWrite( void );
+void CL_DemoIndexOpen( const char *name );
+void CL_DemoIndexClose( void );
+void CL_DemoSeek( int serverTime );
+void CL_DemoSeekStats( void );
+void CL_DemoSeek_f( void );
+
 //
 // cl_input
 //
@@ -5251,6 +5251,338 @@ qboolean BG_BBoxCollision( vec3_t min1, vec3_t max1, vec3_t min2, vec3_t max2 )
 	return qtrue;
 }
 
+/*
+=================================================================================
+
+Command map entity deltas
+
+Byte oriented so the game and cgame can share it without a msg_t:
+	byte	MAPENT_MSG_DELTA
+	long	sequence
+	long	delta sequence, 0 for a full state
+	short	removed count, followed by the removed keys
+	short	changed count, followed by key, field bits and the changed fields
+Both lists are in ascending key order.
+
+=================================================================================
+*/
+
+#define MAPENT_HEADER_SIZE  9
+#define MAPENT_MAX_CHANGE   16  // key, bits, type, x, y, z, yaw, data
+
+static byte *BG_MapEntWriteShort( byte *p, int v ) {
+	p[0] = v & 0xff;
+	p[1] = ( v >> 8 ) & 0xff;
+	return p + 2;
+}
+
+static byte *BG_MapEntWriteLong( byte *p, int v ) {
+	p[0] = v & 0xff;
+	p[1] = ( v >> 8 ) & 0xff;
+	p[2] = ( v >> 16 ) & 0xff;
+	p[3] = ( v >> 24 ) & 0xff;
+	return p + 4;
+}
+
+static int BG_MapEntReadShort( const byte *p ) {
+	return (short)( p[0] | ( p[1] << 8 ) );
+}
+
+static int BG_MapEntReadLong( const byte *p ) {
+	return (int)( (unsigned)p[0] | ( (unsigned)p[1] << 8 ) | ( (unsigned)p[2] << 16 ) | ( (unsigned)p[3] << 24 ) );
+}
+
+static int BG_MapEntityChangedFields( const mapEntityState_t *from, const mapEntityState_t *to ) {
+	int bits = 0;
+
+	if ( from->type != to->type ) {
+		bits |= MEF_TYPE;
+	}
+	if ( from->x != to->x ) {
+		bits |= MEF_X;
+	}
+	if ( from->y != to->y ) {
+		bits |= MEF_Y;
+	}
+	if ( from->z != to->z ) {
+		bits |= MEF_Z;
+	}
+	if ( from->yaw != to->yaw ) {
+		bits |= MEF_YAW;
+	}
+	if ( from->data != to->data ) {
+		bits |= MEF_DATA;
+	}
+
+	return bits;
+}
+
+/*
+=================
+BG_WriteMapEntityDelta
+
+Encodes to against from, or in full if from is NULL.
+Returns the message length, or -1 if it would not fit in size.
+=================
+*/
+int BG_WriteMapEntityDelta( byte *buf, int size, const mapEntitySnapshot_t *from, const mapEntitySnapshot_t *to ) {
+	mapEntityState_t nullState;
+	const mapEntityState_t *base, *ent;
+	byte *p, *countPos;
+	int numFrom, i, j, count, bits;
+
+	numFrom = from ? from->numEntities : 0;
+
+	// worst case is every old entity removed and every new one sent in full
+	if ( MAPENT_HEADER_SIZE + 4 + numFrom * 2 + to->numEntities * MAPENT_MAX_CHANGE > size ) {
+		return -1;
+	}
+
+	p = buf;
+	*p++ = MAPENT_MSG_DELTA;
+	p = BG_MapEntWriteLong( p, to->sequence );
+	p = BG_MapEntWriteLong( p, from ? from->sequence : 0 );
+
+	// removed entities
+	countPos = p;
+	p += 2;
+	count = 0;
+	for ( i = 0, j = 0; i < numFrom; i++ ) {
+		while ( j < to->numEntities && to->entities[j].key < from->entities[i].key ) {
+			j++;
+		}
+		if ( j < to->numEntities && to->entities[j].key == from->entities[i].key ) {
+			continue;
+		}
+		p = BG_MapEntWriteShort( p, from->entities[i].key );
+		count++;
+	}
+	BG_MapEntWriteShort( countPos, count );
+
+	// new and changed entities
+	memset( &nullState, 0, sizeof( nullState ) );
+	countPos = p;
+	p += 2;
+	count = 0;
+	for ( i = 0, j = 0; j < to->numEntities; j++ ) {
+		ent = &to->entities[j];
+
+		while ( i < numFrom && from->entities[i].key < ent->key ) {
+			i++;
+		}
+		if ( i < numFrom && from->entities[i].key == ent->key ) {
+			base = &from->entities[i];
+		} else {
+			base = &nullState;
+		}
+
+		bits = BG_MapEntityChangedFields( base, ent );
+		if ( !bits && base != &nullState ) {
+			continue;
+		}
+
+		p = BG_MapEntWriteShort( p, ent->key );
+		*p++ = bits;
+		if ( bits & MEF_TYPE ) {
+			*p++ = (byte)ent->type;
+		}
+		if ( bits & MEF_X ) {
+			p = BG_MapEntWriteShort( p, ent->x );
+		}
+		if ( bits & MEF_Y ) {
+			p = BG_MapEntWriteShort( p, ent->y );
+		}
+		if ( bits & MEF_Z ) {
+			p = BG_MapEntWriteShort( p, ent->z );
+		}
+		if ( bits & MEF_YAW ) {
+			p = BG_MapEntWriteShort( p, ent->yaw );
+		}
+		if ( bits & MEF_DATA ) {
+			p = BG_MapEntWriteLong( p, ent->data );
+		}
+		count++;
+	}
+	BG_MapEntWriteShort( countPos, count );
+
+	return p - buf;
+}
+
+/*
+=================
+BG_ReadMapEntityHeader
+=================
+*/
+qboolean BG_ReadMapEntityHeader( const byte *buf, int size, int *sequence, int *deltaSequence ) {
+	if ( size < MAPENT_HEADER_SIZE || buf[0] != MAPENT_MSG_DELTA ) {
+		return qfalse;
+	}
+
+	*sequence = BG_MapEntReadLong( buf + 1 );
+	*deltaSequence = BG_MapEntReadLong( buf + 5 );
+
+	return qtrue;
+}
+
+/*
+=================
+BG_ReadMapEntityDelta
+
+Applies the message on top of from, which the caller has matched against the
+delta sequence (NULL for a full state). Returns qfalse on a malformed message.
+=================
+*/
+qboolean BG_ReadMapEntityDelta( const byte *buf, int size, const mapEntitySnapshot_t *from, mapEntitySnapshot_t *to ) {
+	const byte *p, *end, *removed;
+	mapEntityState_t *out;
+	int numFrom, numRemoved, numChanged, deltaSequence;
+	int i, r, key, lastKey, bits;
+
+	if ( !BG_ReadMapEntityHeader( buf, size, &to->sequence, &deltaSequence ) ) {
+		return qfalse;
+	}
+
+	p = buf + MAPENT_HEADER_SIZE;
+	end = buf + size;
+	numFrom = from ? from->numEntities : 0;
+
+	if ( end - p < 2 ) {
+		return qfalse;
+	}
+	numRemoved = BG_MapEntReadShort( p );
+	p += 2;
+	if ( numRemoved < 0 || end - p < numRemoved * 2 + 2 ) {
+		return qfalse;
+	}
+	removed = p;
+	p += numRemoved * 2;
+
+	numChanged = BG_MapEntReadShort( p );
+	p += 2;
+	if ( numChanged < 0 ) {
+		return qfalse;
+	}
+
+	to->numEntities = 0;
+	lastKey = -1;
+	i = r = 0;
+	while ( 1 ) {
+		if ( numChanged > 0 ) {
+			if ( end - p < 3 ) {
+				return qfalse;
+			}
+			key = BG_MapEntReadShort( p );
+			if ( key <= lastKey ) {
+				return qfalse;
+			}
+		} else {
+			key = 1 << 16;     // past any key, flushes the rest of from
+		}
+
+		// carry over the unchanged entities in front of key
+		for ( ; i < numFrom && from->entities[i].key < key; i++ ) {
+			while ( r < numRemoved && BG_MapEntReadShort( removed + r * 2 ) < from->entities[i].key ) {
+				r++;
+			}
+			if ( r < numRemoved && BG_MapEntReadShort( removed + r * 2 ) == from->entities[i].key ) {
+				continue;
+			}
+			if ( to->numEntities >= MAX_MAPENT_STATES ) {
+				return qfalse;
+			}
+			to->entities[to->numEntities++] = from->entities[i];
+		}
+
+		if ( numChanged <= 0 ) {
+			break;
+		}
+		numChanged--;
+		lastKey = key;
+		p += 2;
+		bits = *p++;
+
+		if ( to->numEntities >= MAX_MAPENT_STATES ) {
+			return qfalse;
+		}
+		out = &to->entities[to->numEntities++];
+		if ( i < numFrom && from->entities[i].key == key ) {
+			*out = from->entities[i++];
+		} else {
+			memset( out, 0, sizeof( *out ) );
+			out->key = key;
+		}
+
+		if ( bits & MEF_TYPE ) {
+			if ( end - p < 1 ) {
+				return qfalse;
+			}
+			out->type = (char)*p++;
+		}
+		if ( bits & MEF_X ) {
+			if ( end - p < 2 ) {
+				return qfalse;
+			}
+			out->x = BG_MapEntReadShort( p );
+			p += 2;
+		}
+		if ( bits & MEF_Y ) {
+			if ( end - p < 2 ) {
+				return qfalse;
+			}
+			out->y = BG_MapEntReadShort( p );
+			p += 2;
+		}
+		if ( bits & MEF_Z ) {
+			if ( end - p < 2 ) {
+				return qfalse;
+			}
+			out->z = BG_MapEntReadShort( p );
+			p += 2;
+		}
+		if ( bits & MEF_YAW ) {
+			if ( end - p < 2 ) {
+				return qfalse;
+			}
+			out->yaw = BG_MapEntReadShort( p );
+			p += 2;
+		}
+		if ( bits & MEF_DATA ) {
+			if ( end - p < 4 ) {
+				return qfalse;
+			}
+			out->data = BG_MapEntReadLong( p );
+			p += 4;
+		}
+	}
+
+	return qtrue;
+}
+
+/*
+=================
+BG_WriteMapEntityAck
+=================
+*/
+int BG_WriteMapEntityAck( byte *buf, int sequence ) {
+	buf[0] = MAPENT_MSG_ACK;
+	return BG_MapEntWriteLong( buf + 1, sequence ) - buf;
+}
+
+/*
+=================
+BG_ReadMapEntityAck
+=================
+*/
+qboolean BG_ReadMapEntityAck( const byte *buf, int size, int *sequence ) {
+	if ( size < 5 || buf[0] != MAPENT_MSG_ACK ) {
+		return qfalse;
+	}
+
+	*sequence = BG_MapEntReadLong( buf + 1 );
+
+	return qtrue;
+}
+
 weapon_t bg_heavyWeapons[NUM_HEAVY_WEAPONS] = {
 	WP_FLAMETHROWER,
 	WP_MOBILE_MG42,
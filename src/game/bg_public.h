@@ -2116,6 +2116,48 @@ typedef enum {
 	ME_COMMANDMAP_MARKER,
 } mapEntityType_t;
 
+// command map entities are sent as binary deltas against the last state the
+// client acknowledged, rather than as a full "entnfo" server command
+#define MAPENT_MSG_DELTA        1       // server -> client: sequence, delta sequence, removed keys, changed entities
+#define MAPENT_MSG_ACK          2       // client -> server: sequence of the state the client now holds, 0 for none
+
+#define MAPENT_BACKUP           4       // states kept on both sides, must be a power of 2
+#define MAPENT_MASK             ( MAPENT_BACKUP - 1 )
+#define MAPENT_FULL_INTERVAL    16      // every n-th update is sent in full, so demos pick the map up
+#define MAX_MAPENT_STATES       256
+
+// key = entity number | flags, unique per entry a single client can see
+#define MEK_SINGLECLIENT        ( 1 << 10 )
+#define MEK_ALLIES              ( 1 << 11 )
+
+// changed field bits
+#define MEF_TYPE                1
+#define MEF_X                   2
+#define MEF_Y                   4
+#define MEF_Z                   8
+#define MEF_YAW                 16
+#define MEF_DATA                32
+
+typedef struct {
+	short key;
+	char type;
+	short x, y, z;                      // in 128 unit steps, as in "entnfo"
+	short yaw;
+	int data;
+} mapEntityState_t;
+
+typedef struct {
+	int sequence;
+	int numEntities;
+	mapEntityState_t entities[MAX_MAPENT_STATES];   // sorted by key
+} mapEntitySnapshot_t;
+
+int BG_WriteMapEntityDelta( byte *buf, int size, const mapEntitySnapshot_t *from, const mapEntitySnapshot_t *to );
+qboolean BG_ReadMapEntityHeader( const byte *buf, int size, int *sequence, int *deltaSequence );
+qboolean BG_ReadMapEntityDelta( const byte *buf, int size, const mapEntitySnapshot_t *from, mapEntitySnapshot_t *to );
+int BG_WriteMapEntityAck( byte *buf, int sequence );
+qboolean BG_ReadMapEntityAck( const byte *buf, int size, int *sequence );
+
 extern const char* rankNames_Axis[NUM_EXPERIENCE_LEVELS];
 extern const char* rankNames_Allies[NUM_EXPERIENCE_LEVELS];
 extern const char* miniRankNames_Axis[NUM_EXPERIENCE_LEVELS];
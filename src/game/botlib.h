@@ -206,6 +206,11 @@ typedef struct botlib_import_s
 	int ( *FS_Write )( const void *buffer, int len, fileHandle_t f );
 	void ( *FS_FCloseFile )( fileHandle_t f );
 	int ( *FS_Seek )( fileHandle_t f, long offset, int origin );
+	//read only mapping of a file on disk, NULL if it has to be read instead
+	void        *( *FS_MapFile )( const char *qpath, int *length );
+	void ( *FS_UnmapFile )( void *data, int length );
+	//run count jobs on the worker threads, returns once all of them are done
+	void ( *RunJobs )( void ( *func )( void *data, int index ), void *data, int count );
 	//debug visualisation stuff
 	int ( *DebugLineCreate )( void );
 	void ( *DebugLineDelete )( int line );
@@ -264,6 +264,30 @@ void G_HistoricalTraceEnd( gentity_t *ent ) {
 	G_AdjustClientPositions( ent, 0, qfalse );
 }
 
+/*
+==============
+G_TraceBatch
+
+Traces every ray, in a single system call when the engine supports it
+==============
+*/
+void G_TraceBatch( traceRay_t *rays, trace_t *results, int numRays ) {
+	int i;
+
+	if ( level.traceBatch ) {
+		trap_TraceBatch( rays, results, numRays );
+		return;
+	}
+
+	for ( i = 0; i < numRays; i++ ) {
+		if ( rays[i].capsule ) {
+			trap_TraceCapsule( &results[i], rays[i].start, rays[i].mins, rays[i].maxs, rays[i].end, rays[i].passEntityNum, rays[i].contentmask );
+		} else {
+			trap_Trace( &results[i], rays[i].start, rays[i].mins, rays[i].maxs, rays[i].end, rays[i].passEntityNum, rays[i].contentmask );
+		}
+	}
+}
+
 //bani - Run a trace without fixups (historical fixups will be done externally)
 void G_Trace( gentity_t* ent, trace_t *results, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int passEntityNum, int contentmask ) {
 	int res;
@@ -1552,6 +1552,8 @@ char *ClientConnect( int clientNum, qboolean firstTime, qboolean isBot ) {
 	client->pers.connected = CON_CONNECTING;
 	client->pers.connectTime = level.time;          // DHM - Nerve
 
+	G_ResetMapEntityChannel( clientNum );
+
 	if ( firstTime ) {
 		client->pers.initialSpawn = qtrue;              // DHM - Nerve
 
@@ -1589,6 +1591,7 @@ char *ClientConnect( int clientNum, qboolean firstTime, qboolean isBot ) {
 		if ( value && value[0] ) {
 			Q_strncpyz( client->pers.botScriptName, value, sizeof( client->pers.botScriptName ) );
 			ent->scriptName = client->pers.botScriptName;
+			G_IndexEntityNames( ent );
 		}
 		ent->aiName = ent->scriptName;
 		ent->s.number = clientNum;
@@ -1633,6 +1636,7 @@ char *ClientConnect( int clientNum, qboolean firstTime, qboolean isBot ) {
 
 		if ( !isBot ) {
 			ent->scriptName = "player";
+			G_IndexEntityNames( ent );
 
 // START	Mad Doctor I changes, 8/14/2002
 			// We must store this here, so that BotFindEntityForName can find the
@@ -2316,7 +2320,7 @@ void ClientDisconnect( int clientNum ) {
 		for ( i = 0; i < 2; i++ ) {
 			teamList = &mapEntityData[i];
 
-			if ( ( mEnt = G_FindMapEntityData( &mapEntityData[0], ent - g_entities ) ) != NULL ) {
+			if ( ( mEnt = G_FindMapEntityData( teamList, ent - g_entities ) ) != NULL ) {
 				G_FreeMapEntityData( teamList, mEnt );
 			}
 
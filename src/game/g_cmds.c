@@ -864,7 +864,7 @@ qboolean SetTeam( gentity_t *ent, char *s, qboolean force, weapon_t w1, weapon_t
 		for ( i = 0; i < 2; i++ ) {
 			teamList = &mapEntityData[i];
 
-			if ( ( mEnt = G_FindMapEntityData( &mapEntityData[0], ent - g_entities ) ) != NULL ) {
+			if ( ( mEnt = G_FindMapEntityData( teamList, ent - g_entities ) ) != NULL ) {
 				G_FreeMapEntityData( teamList, mEnt );
 			}
 
@@ -228,9 +228,13 @@ extern void G_UseTargets ( gentity_t * ent , gentity_t * activator ) ;
 extern void G_UseEntity ( gentity_t * ent , gentity_t * other , gentity_t * activator ) ;
 extern qboolean G_AllowTeamsAllowed ( gentity_t * ent , gentity_t * activator ) ;
 extern gentity_t * G_PickTarget ( char * targetname ) ;
+extern gentity_t * G_FindByScriptName ( gentity_t * from , const char * match ) ;
 extern gentity_t * G_FindByTargetnameFast ( gentity_t * from , const char * match , int hash ) ;
 extern gentity_t * G_FindByTargetname ( gentity_t * from , const char * match ) ;
 extern gentity_t * G_Find ( gentity_t * from , int fieldofs , const char * match ) ;
+extern void G_RebuildNameIndex ( void ) ;
+extern void G_ClearNameIndex ( void ) ;
+extern void G_IndexEntityNames ( gentity_t * ent ) ;
 extern void G_TeamCommand ( team_t team , char * cmd ) ;
 extern int G_StringIndex ( const char * string ) ;
 extern int G_CharacterIndex ( const char * name ) ;
@@ -295,6 +299,9 @@ extern void InitTrigger ( gentity_t * self ) ;
 extern void G_UpdateTeamMapData ( void ) ;
 extern void G_SendMapEntityInfo ( gentity_t * e ) ;
 extern void G_SendSpectatorMapEntityInfo ( gentity_t * e ) ;
+extern qboolean G_SendMapEntityDelta ( gentity_t * e ) ;
+extern void G_MapEntityMessageReceived ( int clientNum , const char * buf , int buflen ) ;
+extern void G_ResetMapEntityChannel ( int clientNum ) ;
 extern void G_UpdateTeamMapData_CommandmapMarker ( gentity_t * ent ) ;
 extern void G_UpdateTeamMapData_LandMine ( gentity_t * ent , qboolean forceAllied , qboolean forceAxis ) ;
 extern void G_UpdateTeamMapData_Player ( gentity_t * ent , qboolean forceAllied , qboolean forceAxis ) ;
@@ -302,12 +309,13 @@ extern void G_UpdateTeamMapData_Destruct ( gentity_t * ent ) ;
 extern void G_UpdateTeamMapData_Tank ( gentity_t * ent ) ;
 extern void G_UpdateTeamMapData_Construct ( gentity_t * ent ) ;
 extern void G_ResetTeamMapData ( ) ;
+extern qboolean G_PlayerVisibleFromBinoculars ( gentity_t * viewer , gentity_t * ent ) ;
 extern qboolean G_VisibleFromBinoculars ( gentity_t * viewer , gentity_t * ent , vec3_t origin ) ;
 extern void G_SetupFrustum_ForBinoculars ( gentity_t * ent ) ;
 extern void G_SetupFrustum ( gentity_t * ent ) ;
 extern mapEntityData_t * G_FindMapEntityDataSingleClient ( mapEntityData_Team_t * teamList , mapEntityData_t * start , int entNum , int clientNum ) ;
 extern mapEntityData_t * G_FindMapEntityData ( mapEntityData_Team_t * teamList , int entNum ) ;
-extern mapEntityData_t * G_AllocMapEntityData ( mapEntityData_Team_t * teamList ) ;
+extern mapEntityData_t * G_AllocMapEntityData ( mapEntityData_Team_t * teamList , int entNum , int singleClient ) ;
 extern mapEntityData_t * G_FreeMapEntityData ( mapEntityData_Team_t * teamList , mapEntityData_t * mEnt ) ;
 extern void G_InitMapEntityData ( mapEntityData_Team_t * teamList ) ;
 extern void G_PushMapEntityToBuffer ( char * buffer , int size , mapEntityData_t * mEnt ) ;
@@ -228,9 +228,13 @@ If you have questions concerning this license or the applicable additional terms
 {"G_UseEntity", (byte *)G_UseEntity},
 {"G_AllowTeamsAllowed", (byte *)G_AllowTeamsAllowed},
 {"G_PickTarget", (byte *)G_PickTarget},
+{"G_FindByScriptName", (byte *)G_FindByScriptName},
 {"G_FindByTargetnameFast", (byte *)G_FindByTargetnameFast},
 {"G_FindByTargetname", (byte *)G_FindByTargetname},
 {"G_Find", (byte *)G_Find},
+{"G_RebuildNameIndex", (byte *)G_RebuildNameIndex},
+{"G_ClearNameIndex", (byte *)G_ClearNameIndex},
+{"G_IndexEntityNames", (byte *)G_IndexEntityNames},
 {"G_TeamCommand", (byte *)G_TeamCommand},
 {"G_StringIndex", (byte *)G_StringIndex},
 {"G_CharacterIndex", (byte *)G_CharacterIndex},
@@ -295,6 +299,9 @@ If you have questions concerning this license or the applicable additional terms
 {"G_UpdateTeamMapData", (byte *)G_UpdateTeamMapData},
 {"G_SendMapEntityInfo", (byte *)G_SendMapEntityInfo},
 {"G_SendSpectatorMapEntityInfo", (byte *)G_SendSpectatorMapEntityInfo},
+{"G_SendMapEntityDelta", (byte *)G_SendMapEntityDelta},
+{"G_MapEntityMessageReceived", (byte *)G_MapEntityMessageReceived},
+{"G_ResetMapEntityChannel", (byte *)G_ResetMapEntityChannel},
 {"G_UpdateTeamMapData_CommandmapMarker", (byte *)G_UpdateTeamMapData_CommandmapMarker},
 {"G_UpdateTeamMapData_LandMine", (byte *)G_UpdateTeamMapData_LandMine},
 {"G_UpdateTeamMapData_Player", (byte *)G_UpdateTeamMapData_Player},
@@ -302,6 +309,7 @@ If you have questions concerning this license or the applicable additional terms
 {"G_UpdateTeamMapData_Tank", (byte *)G_UpdateTeamMapData_Tank},
 {"G_UpdateTeamMapData_Construct", (byte *)G_UpdateTeamMapData_Construct},
 {"G_ResetTeamMapData", (byte *)G_ResetTeamMapData},
+{"G_PlayerVisibleFromBinoculars", (byte *)G_PlayerVisibleFromBinoculars},
 {"G_VisibleFromBinoculars", (byte *)G_VisibleFromBinoculars},
 {"G_SetupFrustum_ForBinoculars", (byte *)G_SetupFrustum_ForBinoculars},
 {"G_SetupFrustum", (byte *)G_SetupFrustum},
@@ -237,6 +237,15 @@ typedef struct commanderTeamChat_s {
 	int index;
 } commanderTeamChat_t;
 
+// names with a hashed entity index, see G_IndexEntityNames
+typedef enum {
+	NAMEINDEX_TARGETNAME,
+	NAMEINDEX_SCRIPTNAME,
+	NAMEINDEX_NUM
+} nameIndex_t;
+
+#define NAMEINDEX_SIZE      1024    // chains per name, must be a power of 2
+
 struct gentity_s {
 	entityState_t s;                // communicated by server to clients
 	entityShared_t r;               // shared by both the server system and game
@@ -309,6 +318,9 @@ struct gentity_s {
 	char        *targetname;
 	int targetnamehash;         // Gordon: adding a hash for this for faster lookups
 
+	gentity_t   *nameIndexNext[NAMEINDEX_NUM];      // next entity in the same name index chain
+	int nameIndexChain[NAMEINDEX_NUM];              // chain + 1 we're linked into, 0 if none
+
 	char        *team;
 	gentity_t   *target_ent;
 
@@ -505,7 +517,7 @@ struct gentity_s {
 
 	vec3_t oldOrigin;
 
-	qboolean runthisframe;
+	int runFrameNum;                    // level.framenum G_RunEntity last ran this entity
 
 	g_constructible_stats_t constructibleStats;
 
@@ -1037,6 +1049,12 @@ typedef struct {
 	int covertopsChargeTime[2];
 
 	int lastMapEntityUpdate;
+	int mapEntityCandidates;            // players checked for spotting by the last G_UpdateTeamMapData
+	int mapEntityCulled;                // of those, outside the spotter's frustum
+	int mapEntityTraces;
+
+	int entitiesRun;                    // entities G_RunFrame ran, the rest were idle
+	int entitiesIdle;
 	int objectiveStatsAllies[MAX_OBJECTIVES];
 	int objectiveStatsAxis[MAX_OBJECTIVES];
 
@@ -1115,6 +1133,10 @@ typedef struct {
 	int commanderLastSoundTime[2];
 
 	qboolean tempTraceIgnoreEnts[ MAX_GENTITIES ];
+
+	qboolean traceBatch;                    // the engine has G_TRACEBATCH
+
+	gentity_t   *nameIndex[NAMEINDEX_NUM][NAMEINDEX_SIZE];  // entity number order within a chain
 } level_locals_t;
 
 typedef struct {
@@ -1216,6 +1238,10 @@ void    G_KillBox( gentity_t *ent );
 gentity_t *G_Find( gentity_t *from, int fieldofs, const char *match );
 gentity_t* G_FindByTargetname( gentity_t *from, const char* match );
 gentity_t* G_FindByTargetnameFast( gentity_t *from, const char* match, int hash );
+gentity_t* G_FindByScriptName( gentity_t *from, const char* match );
+void    G_IndexEntityNames( gentity_t *ent );
+void    G_ClearNameIndex( void );
+void    G_RebuildNameIndex( void );
 gentity_t *G_PickTarget( char *targetname );
 void    G_UseTargets( gentity_t *ent, gentity_t *activator );
 void    G_SetMovedir( vec3_t angles, vec3_t movedir );
@@ -1706,6 +1732,8 @@ extern vmCvar_t g_soldierChargeTime;
 
 extern vmCvar_t g_covertopsChargeTime;
 extern vmCvar_t g_debugConstruct;
+extern vmCvar_t g_debugTeamMapData;
+extern vmCvar_t g_debugRunFrame;
 extern vmCvar_t g_landminetimeout;
 
 // What level of detail do we want script printing to go to.
@@ -1853,6 +1881,7 @@ void    trap_Trace( trace_t *results, const vec3_t start, const vec3_t mins, con
 void    trap_TraceCapsule( trace_t *results, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int passEntityNum, int contentmask );
 void    trap_TraceCapsuleNoEnts( trace_t *results, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int passEntityNum, int contentmask );
 void    trap_TraceNoEnts( trace_t *results, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int passEntityNum, int contentmask );
+void    trap_TraceBatch( traceRay_t *rays, trace_t *results, int numRays );
 int     trap_PointContents( const vec3_t point, int passEntityNum );
 qboolean trap_InPVS( const vec3_t p1, const vec3_t p2 );
 qboolean trap_InPVSIgnorePortals( const vec3_t p1, const vec3_t p2 );
@@ -2085,6 +2114,7 @@ void G_HistoricalTrace( gentity_t* ent, trace_t *results, const vec3_t start, co
 void G_HistoricalTraceBegin( gentity_t *ent );
 void G_HistoricalTraceEnd( gentity_t *ent );
 void G_Trace( gentity_t* ent, trace_t *results, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int passEntityNum, int contentmask );
+void G_TraceBatch( traceRay_t *rays, trace_t *results, int numRays );
 
 #define BODY_VALUE( ENT ) ENT->watertype
 #define BODY_TEAM( ENT ) ENT->s.modelindex
@@ -2128,19 +2158,22 @@ typedef struct mapEntityData_s {
 	int status;
 	int entNum;
 	struct mapEntityData_s *next, *prev;
+	struct mapEntityData_s *nextSingleClient;           // other singleClient entries for entNum
 } mapEntityData_t;
 
 typedef struct mapEntityData_Team_s {
 	mapEntityData_t mapEntityData_Team[MAX_GENTITIES];
 	mapEntityData_t *freeMapEntityData;                 // single linked list
 	mapEntityData_t activeMapEntityData;                // double linked list
+	mapEntityData_t *entityMap[MAX_GENTITIES];          // the entry sent to the whole team, by entity number
+	mapEntityData_t *singleClientMap[MAX_GENTITIES];    // entries sent to one client, by entity number
 } mapEntityData_Team_t;
 
 extern mapEntityData_Team_t mapEntityData[2];
 
 void G_InitMapEntityData( mapEntityData_Team_t *teamList );
 mapEntityData_t *G_FreeMapEntityData( mapEntityData_Team_t *teamList, mapEntityData_t *mEnt );
-mapEntityData_t *G_AllocMapEntityData( mapEntityData_Team_t *teamList );
+mapEntityData_t *G_AllocMapEntityData( mapEntityData_Team_t *teamList, int entNum, int singleClient );
 mapEntityData_t *G_FindMapEntityData( mapEntityData_Team_t *teamList, int entNum );
 mapEntityData_t *G_FindMapEntityDataSingleClient( mapEntityData_Team_t *teamList, mapEntityData_t *start, int entNum, int clientNum );
 
@@ -2150,6 +2183,7 @@ void G_UpdateTeamMapData();
 void G_SetupFrustum( gentity_t* ent );
 void G_SetupFrustum_ForBinoculars( gentity_t* ent );
 qboolean G_VisibleFromBinoculars( gentity_t* viewer, gentity_t* ent, vec3_t origin );
+qboolean G_PlayerVisibleFromBinoculars( gentity_t* viewer, gentity_t* ent );
 
 void G_LogTeamKill(     gentity_t* ent, weapon_t weap );
 void G_LogDeath(        gentity_t* ent, weapon_t weap );
@@ -2190,6 +2224,9 @@ typedef enum {
 void G_CheckForNeededClasses( void );
 void G_CheckMenDown( void );
 void G_SendMapEntityInfo( gentity_t* e );
+qboolean G_SendMapEntityDelta( gentity_t* e );
+void G_MapEntityMessageReceived( int clientNum, const char *buf, int buflen );
+void G_ResetMapEntityChannel( int clientNum );
 void G_SendSystemMessage( sysMsg_t message, int team );
 int G_GetSysMessageNumber( const char* sysMsg );
 int G_CountTeamLandmines( team_t team );
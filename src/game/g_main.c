@@ -185,6 +185,8 @@ vmCvar_t z_serverflags;
 vmCvar_t g_covertopsChargeTime;
 vmCvar_t refereePassword;
 vmCvar_t g_debugConstruct;
+vmCvar_t g_debugTeamMapData;
+vmCvar_t g_debugRunFrame;
 vmCvar_t g_landminetimeout;
 
 // Variable for setting the current level of debug printing/logging
@@ -397,6 +399,8 @@ cvarTable_t gameCvarTable[] = {
 	{ &z_serverflags, "z_serverflags", "0", 0, 0, qfalse, qfalse },
 
 	{ &g_debugConstruct, "g_debugConstruct", "0", CVAR_CHEAT, 0, qfalse },
+	{ &g_debugTeamMapData, "g_debugTeamMapData", "0", 0, 0, qfalse },
+	{ &g_debugRunFrame, "g_debugRunFrame", "0", 0, 0, qfalse },
 
 	{ &g_scriptDebug, "g_scriptDebug", "0", CVAR_CHEAT, 0, qfalse },
 
@@ -533,7 +537,8 @@ int vmMain( int command, int arg0, int arg1, int arg2, int arg3, int arg4, int a
 	case GAME_SNAPSHOT_CALLBACK:
 		return G_SnapshotCallback( arg0, arg1 );
 	case GAME_MESSAGERECEIVED:
-		return -1;
+		G_MapEntityMessageReceived( arg0, (const char *)arg1, arg2 );
+		return 0;
 	}
 
 	return -1;
@@ -1147,10 +1152,10 @@ void G_CheckForCursorHints( gentity_t *ent ) {
 void G_SetTargetName( gentity_t* ent, char* targetname ) {
 	if ( targetname && *targetname ) {
 		ent->targetname = targetname;
-		ent->targetnamehash = BG_StringHashValue( targetname );
 	} else {
-		ent->targetnamehash = -1;
+		ent->targetname = NULL;
 	}
+	G_IndexEntityNames( ent );
 }
 
 /*
@@ -1226,7 +1231,7 @@ void G_FindTeams( void ) {
 					// note to self: added this because of problems
 					// pertaining to keys and double doors
 					if ( Q_stricmp( e2->classname, "func_door_rotating" ) ) {
-						e2->targetname = NULL;
+						G_SetTargetName( e2, NULL );
 					}
 				}
 			}
@@ -1649,6 +1654,9 @@ void G_InitGame( int levelTime, int randomSeed, int restart ) {
 	level.startTime = levelTime;
 	level.server_settings = i;
 
+	// stock engines don't know G_TRACEBATCH and drop the game if it is used
+	level.traceBatch = trap_Cvar_VariableIntegerValue( "sv_traceBatch" ) ? qtrue : qfalse;
+
 	for ( i = 0; i < level.numConnectedClients; i++ ) {
 		level.clients[ level.sortedClients[ i ] ].sess.spawnObjectiveIndex = 0;
 	}
@@ -3562,11 +3570,11 @@ void G_TagLinkEntity( gentity_t* ent, int msec ) {
 }
 
 void G_RunEntity( gentity_t* ent, int msec ) {
-	if ( ent->runthisframe ) {
+	if ( ent->runFrameNum == level.framenum ) {
 		return;
 	}
 
-	ent->runthisframe = qtrue;
+	ent->runFrameNum = level.framenum;
 
 	if ( !ent->inuse ) {
 		return;
@@ -3724,6 +3732,96 @@ void G_RunEntity( gentity_t* ent, int msec ) {
 	VectorScale( ent->instantVelocity, 1000.0f / msec, ent->instantVelocity );
 }
 
+/*
+================
+G_EntityIsIdle
+
+True if G_RunEntity would have nothing to do for this entity this frame, so
+G_RunFrame can skip it. Has to stay in step with G_RunEntity and G_RunThink.
+================
+*/
+static qboolean G_EntityIsIdle( gentity_t *ent ) {
+	if ( !ent->inuse ) {
+		return qtrue;
+	}
+
+	// clients, attached entities and anything during a pause always run
+	if ( ent->s.number < MAX_CLIENTS || ent->tagParent || ( ent->s.eFlags & EF_PATH_LINK ) || level.match_pause != PAUSE_NONE ) {
+		return qfalse;
+	}
+
+	// the instantaneous velocity hack has to be settled at zero
+	if ( !VectorCompare( ent->r.currentOrigin, ent->oldOrigin ) || !VectorCompare( ent->instantVelocity, vec3_origin ) ) {
+		return qfalse;
+	}
+
+	// EF_NODRAW out of sync with FL_NODRAW
+	if ( ent - g_entities > level.maxclients && !( ent->flags & FL_NODRAW ) != !( ent->s.eFlags & EF_NODRAW ) ) {
+		return qfalse;
+	}
+
+	// events to clear, temp entities to free
+	if ( ent->s.event || ent->freeAfterEvent || ent->unlinkAfterEvent ) {
+		return qfalse;
+	}
+
+	// scripts with an event, a move or an animation in progress
+	if ( ent->scriptStatus.scriptEventIndex != -1 || ( ent->scriptStatus.scriptFlags & ( SCFL_GOING_TO_MARKER | SCFL_ANIMATING ) ) ) {
+		return qfalse;
+	}
+
+	// invisible entities only run scripts, and unlinked neverFree ones nothing at all
+	if ( ent->s.eType != ET_CONSTRUCTIBLE && ( ent->entstate == STATE_INVISIBLE || ent->entstate == STATE_UNDERCONSTRUCTION ) ) {
+		return qtrue;
+	}
+	if ( !ent->r.linked && ent->neverFree ) {
+		return qtrue;
+	}
+
+	if ( ent->physicsObject ) {
+		return qfalse;
+	}
+
+	switch ( ent->s.eType ) {
+	case ET_MISSILE:
+	case ET_FLAMEBARREL:
+	case ET_FP_PARTS:
+	case ET_FIRE_COLUMN:
+	case ET_FIRE_COLUMN_SMOKE:
+	case ET_EXPLO_PART:
+	case ET_RAMJET:
+	case ET_FLAMETHROWER_CHUNK:
+	case ET_ITEM:
+	case ET_PORTAL:
+		return qfalse;
+	case ET_MOVER:
+	case ET_PROP:
+		// team slaves are moved by their captain and never think
+		if ( ent->flags & FL_TEAMSLAVE ) {
+			return !ent->r.linked;
+		}
+		if ( ent->s.pos.trType != TR_STATIONARY || ent->s.apos.trType != TR_STATIONARY ) {
+			return qfalse;
+		}
+		break;
+	case ET_HEALER:
+	case ET_SUPPLIER:
+		if ( ent->target_ent ) {
+			return qfalse;
+		}
+		break;
+	default:
+		break;
+	}
+
+	// think due
+	if ( ent->nextthink > 0 && ent->nextthink <= level.time ) {
+		return qfalse;
+	}
+
+	return qtrue;
+}
+
 /*
 ================
 G_RunFrame
@@ -3794,13 +3892,20 @@ uebrgpiebrpgibqeripgubeqrpigubqifejbgipegbrtibgurepqgbn%i"
 	// get any cvar changes
 	G_UpdateCvars();
 
+	// go through all allocated objects, skipping the ones with nothing to do
+	level.entitiesRun = level.entitiesIdle = 0;
 	for ( i = 0; i < level.num_entities; i++ ) {
-		g_entities[i].runthisframe = qfalse;
-	}
+		if ( G_EntityIsIdle( &g_entities[ i ] ) ) {
+			level.entitiesIdle++;
+			continue;
+		}
 
-	// go through all allocated objects
-	for ( i = 0; i < level.num_entities; i++ ) {
 		G_RunEntity( &g_entities[ i ], msec );
+		level.entitiesRun++;
+	}
+
+	if ( g_debugRunFrame.integer ) {
+		G_Printf( "runframe: %i entities run, %i idle\n", level.entitiesRun, level.entitiesIdle );
 	}
 
 
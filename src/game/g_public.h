@@ -114,6 +114,21 @@ typedef struct {
 
 
 
+// one trace of a G_TRACEBATCH request, results come back in a parallel trace_t array
+#define MAX_TRACEBATCH      128
+
+typedef struct {
+	vec3_t start;
+	vec3_t mins;
+	vec3_t maxs;
+	vec3_t end;
+	int passEntityNum;          // -2 to skip entities, as trap_TraceNoEnts
+	int contentmask;
+	int capsule;
+} traceRay_t;
+
+
+
 //===============================================================
 
 //
@@ -459,6 +474,8 @@ typedef enum {
 	// JH
 	G_FS_PAK_INFO_FOR_FILE,
 	// -JH
+
+	G_TRACEBATCH,   // ( traceRay_t *rays, trace_t *results, int numRays );
 } gameImport_t;
 
 
@@ -1720,6 +1720,9 @@ void G_LoadGame( void ) {
 	// reset all AAS blocking entities
 	trap_AAS_SetAASBlockingEntity( vec3_origin, vec3_origin, -1 );
 
+	// entities are overwritten below, don't let G_FreeEntity walk stale chains
+	G_ClearNameIndex();
+
 	// read the entity structures
 	trap_FS_Read( &i, sizeof( i ), f );
 	size = i;
@@ -1771,6 +1774,8 @@ void G_LoadGame( void ) {
 		ent->inuse = qfalse;
 	}
 
+	G_RebuildNameIndex();
+
 	// read the client structures
 	trap_FS_Read( &i, sizeof( i ), f );
 	size = i;
@@ -1291,6 +1291,7 @@ void SP_script_camera( gentity_t *ent ) {
 */
 void SP_script_multiplayer( gentity_t *ent ) {
 	ent->scriptName = "game_manager";
+	G_IndexEntityNames( ent );
 
 	// Gordon: broadcasting this to clients now, should be cheaper in bandwidth for sending landmine info
 	ent->s.eType = ET_GAMEMANAGER;
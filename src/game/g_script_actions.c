@@ -4275,13 +4275,11 @@ qboolean etpro_ScriptAction_SetValues( gentity_t *ent, char *params ) {
 		level.numSpawnVars++;
 
 		G_ParseField( key, value, ent );
-
-		if ( !Q_stricmp( key, "targetname" ) ) {
-			//need to hash this ent targetname for setstate script targets...
-			ent->targetnamehash = BG_StringHashValue( ent->targetname );
-		}
 	}
 
+	// targetname or scriptName may have changed
+	G_IndexEntityNames( ent );
+
 	// move editor origin to pos
 	VectorCopy( ent->s.origin, ent->s.pos.trBase );
 	VectorCopy( ent->s.origin, ent->r.currentOrigin );
@@ -4289,6 +4287,7 @@ qboolean etpro_ScriptAction_SetValues( gentity_t *ent, char *params ) {
 	// rain - if the classname was changed, call the spawn func again
 	if ( classchanged ) {
 		G_CallSpawn( ent );
+		G_IndexEntityNames( ent );
 		trap_LinkEntity( ent );
 	}
 
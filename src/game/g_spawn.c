@@ -873,11 +873,7 @@ void G_SpawnGEntityFromSpawnVars( void ) {
 		}
 	}
 
-	if ( ent->targetname && *ent->targetname ) {
-		ent->targetnamehash = BG_StringHashValue( ent->targetname );
-	} else {
-		ent->targetnamehash = -1;
-	}
+	G_IndexEntityNames( ent );
 
 	// move editor origin to pos
 	VectorCopy( ent->s.origin, ent->s.pos.trBase );
@@ -886,6 +882,9 @@ void G_SpawnGEntityFromSpawnVars( void ) {
 	// if we didn't get a classname, don't bother spawning anything
 	if ( !G_CallSpawn( ent ) ) {
 		G_FreeEntity( ent );
+	} else if ( ent->inuse ) {
+		// spawn functions may name themselves
+		G_IndexEntityNames( ent );
 	}
 
 	// RF, try and move it into the bot entities if possible
@@ -172,6 +172,10 @@ void trap_TraceNoEnts( trace_t *results, const vec3_t start, const vec3_t mins,
 	syscall( G_TRACE, results, start, mins, maxs, end, -2, contentmask );
 }
 
+void trap_TraceBatch( traceRay_t *rays, trace_t *results, int numRays ) {
+	syscall( G_TRACEBATCH, rays, results, numRays );
+}
+
 void trap_TraceCapsule( trace_t *results, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int passEntityNum, int contentmask ) {
 	syscall( G_TRACECAPSULE, results, start, mins, maxs, end, passEntityNum, contentmask );
 }
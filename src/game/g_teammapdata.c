@@ -89,14 +89,31 @@ returns next entity in the array
 */
 mapEntityData_t *G_FreeMapEntityData( mapEntityData_Team_t *teamList, mapEntityData_t *mEnt ) {
 	mapEntityData_t *ret = mEnt->next;
+	mapEntityData_t **link;
 
 	if ( !mEnt->prev ) {
 		G_Error( "G_FreeMapEntityData: not active" );
 	}
+	if ( mEnt < teamList->mapEntityData_Team || mEnt >= teamList->mapEntityData_Team + MAX_GENTITIES ) {
+		G_Error( "G_FreeMapEntityData: not in this team list" );
+	}
+
+	// remove from the entity number index
+	if ( mEnt->singleClient >= 0 ) {
+		for ( link = &teamList->singleClientMap[mEnt->entNum]; *link; link = &( *link )->nextSingleClient ) {
+			if ( *link == mEnt ) {
+				*link = mEnt->nextSingleClient;
+				break;
+			}
+		}
+	} else if ( teamList->entityMap[mEnt->entNum] == mEnt ) {
+		teamList->entityMap[mEnt->entNum] = NULL;
+	}
 
 	// remove from the doubly linked active list
 	mEnt->prev->next = mEnt->next;
 	mEnt->next->prev = mEnt->prev;
+	mEnt->prev = NULL;
 
 	// the free list is only singly linked
 	mEnt->next = teamList->freeMapEntityData;
@@ -108,11 +125,17 @@ mapEntityData_t *G_FreeMapEntityData( mapEntityData_Team_t *teamList, mapEntityD
 /*
 ===================
 G_AllocMapEntityData
+
+singleClient is the only client the entry is sent to, -1 for the whole team
 ===================
 */
-mapEntityData_t *G_AllocMapEntityData( mapEntityData_Team_t *teamList ) {
+mapEntityData_t *G_AllocMapEntityData( mapEntityData_Team_t *teamList, int entNum, int singleClient ) {
 	mapEntityData_t *mEnt;
 
+	if ( entNum < 0 || entNum >= MAX_GENTITIES ) {
+		G_Error( "G_AllocMapEntityData: bad entity number %i", entNum );
+	}
+
 	if ( !teamList->freeMapEntityData ) {
 		// no free entities - bomb out
 		G_Error( "G_AllocMapEntityData: out of entities" );
@@ -123,7 +146,16 @@ mapEntityData_t *G_AllocMapEntityData( mapEntityData_Team_t *teamList ) {
 
 	memset( mEnt, 0, sizeof( *mEnt ) );
 
-	mEnt->singleClient = -1;
+	mEnt->entNum = entNum;
+	mEnt->singleClient = singleClient;
+
+	// index by entity number
+	if ( singleClient >= 0 ) {
+		mEnt->nextSingleClient = teamList->singleClientMap[entNum];
+		teamList->singleClientMap[entNum] = mEnt;
+	} else {
+		teamList->entityMap[entNum] = mEnt;
+	}
 
 	// link into the active list
 	mEnt->next = teamList->activeMapEntityData.next;
@@ -139,50 +171,50 @@ G_FindMapEntityData
 ===================
 */
 mapEntityData_t *G_FindMapEntityData( mapEntityData_Team_t *teamList, int entNum ) {
-	mapEntityData_t *mEnt;
-
-	for ( mEnt = teamList->activeMapEntityData.next; mEnt && mEnt != &teamList->activeMapEntityData; mEnt = mEnt->next ) {
-		if ( mEnt->singleClient >= 0 ) {
-			continue;
-		}
-		if ( entNum == mEnt->entNum ) {
-			return( mEnt );
-		}
+	if ( entNum < 0 || entNum >= MAX_GENTITIES ) {
+		return( NULL );
 	}
 
-	// not found
-	return( NULL );
+	return( teamList->entityMap[entNum] );
 }
 
 /*
 ===============================
 G_FindMapEntityDataSingleClient
+
+clientNum -1 finds every entry for entNum that is only sent to one client,
+otherwise the entry sent to clientNum comes before the one for the whole team
 ===============================
 */
 mapEntityData_t *G_FindMapEntityDataSingleClient( mapEntityData_Team_t *teamList, mapEntityData_t *start, int entNum, int clientNum ) {
 	mapEntityData_t *mEnt;
 
+	if ( entNum < 0 || entNum >= MAX_GENTITIES ) {
+		return( NULL );
+	}
+
+	if ( start && start->singleClient < 0 ) {
+		// the whole team entry is always last
+		return( NULL );
+	}
+
 	if ( start ) {
-		mEnt = start->next;
+		mEnt = start->nextSingleClient;
 	} else {
-		mEnt = teamList->activeMapEntityData.next;
+		mEnt = teamList->singleClientMap[entNum];
 	}
 
-	for ( ; mEnt && mEnt != &teamList->activeMapEntityData; mEnt = mEnt->next ) {
-		if ( clientNum == -1 ) {
-			if ( mEnt->singleClient < 0 ) {
-				continue;
-			}
-		} else if ( mEnt->singleClient >= 0 && clientNum != mEnt->singleClient ) {
-			continue;
-		}
-		if ( entNum == mEnt->entNum ) {
+	for ( ; mEnt; mEnt = mEnt->nextSingleClient ) {
+		if ( clientNum == -1 || clientNum == mEnt->singleClient ) {
 			return( mEnt );
 		}
 	}
 
-	// not found
-	return( NULL );
+	if ( clientNum == -1 ) {
+		return( NULL );
+	}
+
+	return( teamList->entityMap[entNum] );
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -300,7 +332,7 @@ static qboolean G_CullPointAndRadius( vec3_t pt, float radius ) {
 		frust = &frustum[i];
 
 		dist = DotProduct( pt, frust->normal ) - frust->dist;
-		if ( dist < -radius || dist <= radius ) {
+		if ( dist <= -radius ) {
 			return( qfalse );
 		}
 	}
@@ -323,6 +355,7 @@ qboolean G_VisibleFromBinoculars( gentity_t* viewer, gentity_t* ent, vec3_t orig
 		return qfalse;
 	}
 
+	level.mapEntityTraces++;
 	trap_Trace( &trace, vieworg, NULL, NULL, origin, viewer->s.number, MASK_SHOT );
 
 /*	if( ent && trace.entityNum != ent-g_entities ) {
@@ -344,6 +377,38 @@ qboolean G_VisibleFromBinoculars( gentity_t* viewer, gentity_t* ent, vec3_t orig
 	return qtrue;
 }
 
+/*
+========================
+G_PlayerVisibleFromBinoculars
+
+Checks the feet, origin and head of a player against the frustum set up
+for the viewer.  The sphere around all three is culled first, so players
+outside the frustum cost no pvs checks or traces
+========================
+*/
+qboolean G_PlayerVisibleFromBinoculars( gentity_t* viewer, gentity_t* ent ) {
+	vec3_t pos[3];
+	float radius;
+
+	level.mapEntityCandidates++;
+
+	radius = max( -ent->client->ps.mins[2], ent->client->ps.maxs[2] );
+	if ( !G_CullPointAndRadius( ent->client->ps.origin, radius ) ) {
+		level.mapEntityCulled++;
+		return qfalse;
+	}
+
+	VectorCopy( ent->client->ps.origin, pos[0] );
+	pos[0][2] += ent->client->ps.mins[2];
+	VectorCopy( ent->client->ps.origin, pos[1] );
+	VectorCopy( ent->client->ps.origin, pos[2] );
+	pos[2][2] += ent->client->ps.maxs[2];
+
+	return G_VisibleFromBinoculars( viewer, ent, pos[0] ) ||
+		   G_VisibleFromBinoculars( viewer, ent, pos[1] ) ||
+		   G_VisibleFromBinoculars( viewer, ent, pos[2] );
+}
+
 void G_ResetTeamMapData() {
 	G_InitMapEntityData( &mapEntityData[0] );
 	G_InitMapEntityData( &mapEntityData[1] );
@@ -358,8 +423,7 @@ void G_UpdateTeamMapData_Construct( gentity_t* ent ) {
 		teamList = &mapEntityData[0];
 		mEnt = G_FindMapEntityData( teamList, num );
 		if ( !mEnt ) {
-			mEnt = G_AllocMapEntityData( teamList );
-			mEnt->entNum = num;
+			mEnt = G_AllocMapEntityData( teamList, num, -1 );
 		}
 		VectorCopy( ent->s.pos.trBase, mEnt->org );
 		mEnt->data = mEnt->entNum; //ent->s.modelindex2;
@@ -370,8 +434,7 @@ void G_UpdateTeamMapData_Construct( gentity_t* ent ) {
 		teamList = &mapEntityData[1];
 		mEnt = G_FindMapEntityData( teamList, num );
 		if ( !mEnt ) {
-			mEnt = G_AllocMapEntityData( teamList );
-			mEnt->entNum = num;
+			mEnt = G_AllocMapEntityData( teamList, num, -1 );
 		}
 		VectorCopy( ent->s.pos.trBase, mEnt->org );
 		mEnt->data = mEnt->entNum; //ent->s.modelindex2;
@@ -386,8 +449,7 @@ void G_UpdateTeamMapData_Construct( gentity_t* ent ) {
 		teamList = &mapEntityData[0];
 		mEnt = G_FindMapEntityData( teamList, num );
 		if ( !mEnt ) {
-			mEnt = G_AllocMapEntityData( teamList );
-			mEnt->entNum = num;
+			mEnt = G_AllocMapEntityData( teamList, num, -1 );
 		}
 		VectorCopy( ent->s.pos.trBase, mEnt->org );
 		mEnt->data = mEnt->entNum; //ent->s.modelindex2;
@@ -401,8 +463,7 @@ void G_UpdateTeamMapData_Construct( gentity_t* ent ) {
 		teamList = &mapEntityData[1];
 		mEnt = G_FindMapEntityData( teamList, num );
 		if ( !mEnt ) {
-			mEnt = G_AllocMapEntityData( teamList );
-			mEnt->entNum = num;
+			mEnt = G_AllocMapEntityData( teamList, num, -1 );
 		}
 		VectorCopy( ent->s.pos.trBase, mEnt->org );
 		mEnt->data = mEnt->entNum; //ent->s.modelindex2;
@@ -421,8 +482,7 @@ void G_UpdateTeamMapData_Tank( gentity_t* ent ) {
 	teamList = &mapEntityData[0];
 	mEnt = G_FindMapEntityData( teamList, num );
 	if ( !mEnt ) {
-		mEnt = G_AllocMapEntityData( teamList );
-		mEnt->entNum = num;
+		mEnt = G_AllocMapEntityData( teamList, num, -1 );
 	}
 	VectorCopy( ent->s.pos.trBase, mEnt->org );
 	mEnt->data = ent->s.modelindex2;
@@ -437,8 +497,7 @@ void G_UpdateTeamMapData_Tank( gentity_t* ent ) {
 	teamList = &mapEntityData[1];
 	mEnt = G_FindMapEntityData( teamList, num );
 	if ( !mEnt ) {
-		mEnt = G_AllocMapEntityData( teamList );
-		mEnt->entNum = num;
+		mEnt = G_AllocMapEntityData( teamList, num, -1 );
 	}
 	VectorCopy( ent->s.pos.trBase, mEnt->org );
 	mEnt->data = ent->s.modelindex2;
@@ -460,8 +519,7 @@ void G_UpdateTeamMapData_Destruct( gentity_t* ent ) {
 		teamList = &mapEntityData[1];   // inverted
 		mEnt = G_FindMapEntityData( teamList, num );
 		if ( !mEnt ) {
-			mEnt = G_AllocMapEntityData( teamList );
-			mEnt->entNum = num;
+			mEnt = G_AllocMapEntityData( teamList, num, -1 );
 		}
 		VectorCopy( ent->s.pos.trBase, mEnt->org );
 		mEnt->data = mEnt->entNum; //ent->s.modelindex2;
@@ -474,8 +532,7 @@ void G_UpdateTeamMapData_Destruct( gentity_t* ent ) {
 				teamList = &mapEntityData[1];   // inverted
 				mEnt = G_FindMapEntityData( teamList, num );
 				if ( !mEnt ) {
-					mEnt = G_AllocMapEntityData( teamList );
-					mEnt->entNum = num;
+					mEnt = G_AllocMapEntityData( teamList, num, -1 );
 				}
 				VectorCopy( ent->s.pos.trBase, mEnt->org );
 				mEnt->data = mEnt->entNum; //ent->s.modelindex2;
@@ -490,8 +547,7 @@ void G_UpdateTeamMapData_Destruct( gentity_t* ent ) {
 		teamList = &mapEntityData[0];   // inverted
 		mEnt = G_FindMapEntityData( teamList, num );
 		if ( !mEnt ) {
-			mEnt = G_AllocMapEntityData( teamList );
-			mEnt->entNum = num;
+			mEnt = G_AllocMapEntityData( teamList, num, -1 );
 		}
 		VectorCopy( ent->s.pos.trBase, mEnt->org );
 		mEnt->data = mEnt->entNum; //ent->s.modelindex2;
@@ -504,8 +560,7 @@ void G_UpdateTeamMapData_Destruct( gentity_t* ent ) {
 				teamList = &mapEntityData[0];   // inverted
 				mEnt = G_FindMapEntityData( teamList, num );
 				if ( !mEnt ) {
-					mEnt = G_AllocMapEntityData( teamList );
-					mEnt->entNum = num;
+					mEnt = G_AllocMapEntityData( teamList, num, -1 );
 				}
 				VectorCopy( ent->s.pos.trBase, mEnt->org );
 				mEnt->data = mEnt->entNum; //ent->s.modelindex2;
@@ -541,8 +596,7 @@ void G_UpdateTeamMapData_Player( gentity_t* ent, qboolean forceAllied, qboolean
 		teamList = &mapEntityData[0];
 		mEnt = G_FindMapEntityData( teamList, num );
 		if ( !mEnt ) {
-			mEnt = G_AllocMapEntityData( teamList );
-			mEnt->entNum = num;
+			mEnt = G_AllocMapEntityData( teamList, num, -1 );
 		}
 		VectorCopy( ent->client->ps.origin, mEnt->org );
 		mEnt->yaw = ent->client->ps.viewangles[YAW];
@@ -560,8 +614,7 @@ void G_UpdateTeamMapData_Player( gentity_t* ent, qboolean forceAllied, qboolean
 		teamList = &mapEntityData[1];
 		mEnt = G_FindMapEntityData( teamList, num );
 		if ( !mEnt ) {
-			mEnt = G_AllocMapEntityData( teamList );
-			mEnt->entNum = num;
+			mEnt = G_AllocMapEntityData( teamList, num, -1 );
 		}
 
 		VectorCopy( ent->client->ps.origin, mEnt->org );
@@ -602,9 +655,7 @@ static void G_UpdateTeamMapData_DisguisedPlayer( gentity_t* spotter, gentity_t*
 
 			mEnt = G_FindMapEntityDataSingleClient( teamList, NULL, num, spotter->s.clientNum );
 			if ( !mEnt ) {
-				mEnt = G_AllocMapEntityData( teamList );
-				mEnt->entNum = num;
-				mEnt->singleClient = spotter->s.clientNum;
+				mEnt = G_AllocMapEntityData( teamList, num, spotter->s.clientNum );
 			}
 			VectorCopy( ent->client->ps.origin, mEnt->org );
 			mEnt->yaw = ent->client->ps.viewangles[YAW];
@@ -617,9 +668,7 @@ static void G_UpdateTeamMapData_DisguisedPlayer( gentity_t* spotter, gentity_t*
 
 			mEnt = G_FindMapEntityDataSingleClient( teamList, NULL, num, spotter->s.clientNum );
 			if ( !mEnt ) {
-				mEnt = G_AllocMapEntityData( teamList );
-				mEnt->entNum = num;
-				mEnt->singleClient = spotter->s.clientNum;
+				mEnt = G_AllocMapEntityData( teamList, num, spotter->s.clientNum );
 			}
 			VectorCopy( ent->client->ps.origin, mEnt->org );
 			mEnt->yaw = ent->client->ps.viewangles[YAW];
@@ -651,8 +700,7 @@ void G_UpdateTeamMapData_LandMine( gentity_t* ent, qboolean forceAllied, qboolea
 		teamList = &mapEntityData[0];
 		mEnt = G_FindMapEntityData( teamList, num );
 		if ( !mEnt ) {
-			mEnt = G_AllocMapEntityData( teamList );
-			mEnt->entNum = num;
+			mEnt = G_AllocMapEntityData( teamList, num, -1 );
 		}
 
 		VectorCopy( ent->r.currentOrigin, mEnt->org );
@@ -669,8 +717,7 @@ void G_UpdateTeamMapData_LandMine( gentity_t* ent, qboolean forceAllied, qboolea
 		teamList = &mapEntityData[1];
 		mEnt = G_FindMapEntityData( teamList, num );
 		if ( !mEnt ) {
-			mEnt = G_AllocMapEntityData( teamList );
-			mEnt->entNum = num;
+			mEnt = G_AllocMapEntityData( teamList, num, -1 );
 		}
 
 		VectorCopy( ent->r.currentOrigin, mEnt->org );
@@ -701,8 +748,7 @@ void G_UpdateTeamMapData_CommandmapMarker( gentity_t* ent ) {
 		teamList = &mapEntityData[0];
 		mEnt = G_FindMapEntityData( teamList, num );
 		if ( !mEnt ) {
-			mEnt = G_AllocMapEntityData( teamList );
-			mEnt->entNum = num;
+			mEnt = G_AllocMapEntityData( teamList, num, -1 );
 		}
 		VectorCopy( ent->s.origin, mEnt->org );
 		mEnt->data = ent->parent->s.teamNum;
@@ -715,8 +761,7 @@ void G_UpdateTeamMapData_CommandmapMarker( gentity_t* ent ) {
 		teamList = &mapEntityData[1];
 		mEnt = G_FindMapEntityData( teamList, num );
 		if ( !mEnt ) {
-			mEnt = G_AllocMapEntityData( teamList );
-			mEnt->entNum = num;
+			mEnt = G_AllocMapEntityData( teamList, num, -1 );
 		}
 		VectorCopy( ent->s.origin, mEnt->org );
 		mEnt->data = ent->parent ? ent->parent->s.teamNum : -1;
@@ -726,6 +771,201 @@ void G_UpdateTeamMapData_CommandmapMarker( gentity_t* ent ) {
 	}
 }
 
+/*
+=================================================================================
+
+Binary command map channel
+
+Each client's cgame acknowledges the last state it holds, and updates are sent
+through trap_SendMessage as a delta against that state. Until the cgame has
+acknowledged anything, or when an update does not fit, "entnfo" is used.
+
+=================================================================================
+*/
+
+typedef struct {
+	qboolean active;                                // cgame understands binary updates
+	int sequence;                                   // last state sent
+	int ackSequence;                                // state the cgame holds, 0 for none
+	mapEntitySnapshot_t states[MAPENT_BACKUP];
+} mapEntityChannel_t;
+
+static mapEntityChannel_t mapEntityChannels[MAX_CLIENTS];
+
+/*
+===================
+G_ResetMapEntityChannel
+===================
+*/
+void G_ResetMapEntityChannel( int clientNum ) {
+	memset( &mapEntityChannels[clientNum], 0, sizeof( mapEntityChannels[0] ) );
+}
+
+/*
+===================
+G_MapEntityMessageReceived
+===================
+*/
+void G_MapEntityMessageReceived( int clientNum, const char *buf, int buflen ) {
+	mapEntityChannel_t *chan;
+	int sequence;
+
+	if ( clientNum < 0 || clientNum >= level.maxclients ) {
+		return;
+	}
+
+	if ( !BG_ReadMapEntityAck( (const byte *)buf, buflen, &sequence ) ) {
+		return;
+	}
+
+	chan = &mapEntityChannels[clientNum];
+	chan->active = qtrue;
+
+	// anything we never sent is left over from before a restart, start over
+	if ( sequence < 0 || sequence > chan->sequence ) {
+		chan->ackSequence = 0;
+	} else {
+		chan->ackSequence = sequence;
+	}
+}
+
+static int QDECL G_SortMapEntityStates( const void *a, const void *b ) {
+	return ( (mapEntityState_t *)a )->key - ( (mapEntityState_t *)b )->key;
+}
+
+/*
+===================
+G_BuildMapEntitySnapshot
+
+The entries G_SendMapEntityInfo / G_SendSpectatorMapEntityInfo would send, in key order
+===================
+*/
+static void G_BuildMapEntitySnapshot( gentity_t* e, mapEntitySnapshot_t *snap ) {
+	mapEntityData_t *mEnt;
+	mapEntityData_Team_t *teamList;
+	mapEntityState_t *state;
+	team_t team = e->client->sess.sessionTeam;
+	int i, j;
+
+	snap->numEntities = 0;
+
+	for ( i = 0; i < 2; i++ ) {
+		if ( team != TEAM_SPECTATOR && team != ( i ? TEAM_ALLIES : TEAM_AXIS ) ) {
+			continue;
+		}
+
+		teamList = &mapEntityData[i];
+		for ( mEnt = teamList->activeMapEntityData.next; mEnt && mEnt != &teamList->activeMapEntityData; mEnt = mEnt->next ) {
+			if ( team == TEAM_SPECTATOR && mEnt->type != ME_CONSTRUCT && mEnt->type != ME_DESTRUCT && mEnt->type != ME_TANK && mEnt->type != ME_TANK_DEAD && mEnt->type != ME_DESTRUCT_2 ) {
+				continue;
+			}
+
+			if ( mEnt->singleClient >= 0 && e->s.clientNum != mEnt->singleClient ) {
+				continue;
+			}
+
+			if ( mEnt->entNum < 0 || snap->numEntities >= MAX_MAPENT_STATES ) {
+				continue;
+			}
+
+			state = &snap->entities[snap->numEntities++];
+			memset( state, 0, sizeof( *state ) );
+
+			state->key = mEnt->entNum;
+			if ( mEnt->singleClient >= 0 ) {
+				state->key |= MEK_SINGLECLIENT;
+			}
+			if ( i ) {
+				state->key |= MEK_ALLIES;
+			}
+			state->type = mEnt->type;
+			state->data = mEnt->data;
+
+			// same fields as G_PushMapEntityToBuffer, the rest stay 0 and cost nothing
+			switch ( mEnt->type ) {
+			case ME_CONSTRUCT:
+			case ME_DESTRUCT:
+			case ME_DESTRUCT_2:
+			case ME_COMMANDMAP_MARKER:
+				break;
+			default:
+				if ( mEnt->type != ME_TANK && mEnt->type != ME_TANK_DEAD ) {
+					state->yaw = mEnt->yaw;
+				}
+				state->x = ( (int)mEnt->org[0] ) / 128;
+				state->y = ( (int)mEnt->org[1] ) / 128;
+				if ( level.ccLayers ) {
+					state->z = ( (int)mEnt->org[2] ) / 128;
+				}
+				break;
+			}
+		}
+	}
+
+	qsort( snap->entities, snap->numEntities, sizeof( snap->entities[0] ), G_SortMapEntityStates );
+
+	// keys are unique per entry, but don't let a stray duplicate break the delta
+	for ( i = 1, j = 1; i < snap->numEntities; i++ ) {
+		if ( snap->entities[i].key != snap->entities[j - 1].key ) {
+			snap->entities[j++] = snap->entities[i];
+		}
+	}
+	if ( snap->numEntities > 1 ) {
+		snap->numEntities = j;
+	}
+}
+
+/*
+===================
+G_SendMapEntityDelta
+
+Returns qfalse if the update has to go out as "entnfo" instead
+===================
+*/
+qboolean G_SendMapEntityDelta( gentity_t* e ) {
+	static byte buffer[MAX_BINARY_MESSAGE];
+	mapEntityChannel_t *chan;
+	mapEntitySnapshot_t *from, *to;
+	int clientNum = e - g_entities;
+	int sequence, len;
+
+	chan = &mapEntityChannels[clientNum];
+	if ( !chan->active ) {
+		return qfalse;
+	}
+
+	if ( trap_MessageStatus( clientNum ) == MESSAGE_WAITING_OVERFLOW ) {
+		// the last update never fit in a packet, drop it and send this one as text
+		trap_SendMessage( clientNum, (char *)buffer, 0 );
+		return qfalse;
+	}
+
+	sequence = chan->sequence + 1;
+
+	from = NULL;
+	if ( chan->ackSequence > 0 && sequence - chan->ackSequence < MAPENT_BACKUP && sequence % MAPENT_FULL_INTERVAL ) {
+		from = &chan->states[chan->ackSequence & MAPENT_MASK];
+		if ( from->sequence != chan->ackSequence ) {
+			from = NULL;
+		}
+	}
+
+	to = &chan->states[sequence & MAPENT_MASK];
+	G_BuildMapEntitySnapshot( e, to );
+	to->sequence = sequence;
+
+	len = BG_WriteMapEntityDelta( buffer, sizeof( buffer ), from, to );
+	if ( len < 0 ) {
+		to->sequence = 0;
+		return qfalse;
+	}
+
+	chan->sequence = sequence;
+	trap_SendMessage( clientNum, (char *)buffer, len );
+
+	return qtrue;
+}
+
 void G_SendSpectatorMapEntityInfo( gentity_t* e ) {
 	// special version, sends different set of ents - only the objectives, but also team info (string is split in two basically)
 	mapEntityData_t *mEnt;
@@ -738,7 +978,7 @@ void G_SendSpectatorMapEntityInfo( gentity_t* e ) {
 
 	ax_cnt = 0;
 	for ( mEnt = teamList->activeMapEntityData.next; mEnt && mEnt != &teamList->activeMapEntityData; mEnt = mEnt->next ) {
-		if ( mEnt->type != ME_CONSTRUCT && mEnt->type != ME_DESTRUCT && mEnt->type != ME_TANK && mEnt->type != ME_TANK_DEAD ) {
+		if ( mEnt->type != ME_CONSTRUCT && mEnt->type != ME_DESTRUCT && mEnt->type != ME_TANK && mEnt->type != ME_TANK_DEAD && mEnt->type != ME_DESTRUCT_2 ) {
 			continue;
 		}
 
@@ -757,7 +997,7 @@ void G_SendSpectatorMapEntityInfo( gentity_t* e ) {
 
 	al_cnt = 0;
 	for ( mEnt = teamList->activeMapEntityData.next; mEnt && mEnt != &teamList->activeMapEntityData; mEnt = mEnt->next ) {
-		if ( mEnt->type != ME_CONSTRUCT && mEnt->type != ME_DESTRUCT && mEnt->type != ME_TANK && mEnt->type != ME_TANK_DEAD ) {
+		if ( mEnt->type != ME_CONSTRUCT && mEnt->type != ME_DESTRUCT && mEnt->type != ME_TANK && mEnt->type != ME_TANK_DEAD && mEnt->type != ME_DESTRUCT_2 ) {
 			continue;
 		}
 
@@ -813,7 +1053,9 @@ void G_SendMapEntityInfo( gentity_t* e ) {
 	int cnt = 0;
 
 	if ( e->client->sess.sessionTeam == TEAM_SPECTATOR ) {
-		G_SendSpectatorMapEntityInfo( e );
+		if ( !G_SendMapEntityDelta( e ) ) {
+			G_SendSpectatorMapEntityInfo( e );
+		}
 		return;
 	}
 
@@ -841,11 +1083,18 @@ void G_SendMapEntityInfo( gentity_t* e ) {
 		} else {
 			mEnt->status = 2;
 		}
-		cnt++;
+
+		if ( mEnt->singleClient < 0 || e->s.clientNum == mEnt->singleClient ) {
+			cnt++;
+		}
 
 		mEnt = mEnt->next;
 	}
 
+	if ( G_SendMapEntityDelta( e ) ) {
+		return;
+	}
+
 	if ( e->client->sess.sessionTeam == TEAM_AXIS ) {
 		Com_sprintf( buffer, sizeof( buffer ), "entnfo %i 0", cnt );
 	} else {
@@ -874,6 +1123,10 @@ void G_UpdateTeamMapData( void ) {
 	}
 	level.lastMapEntityUpdate = level.time;
 
+	level.mapEntityCandidates = 0;
+	level.mapEntityCulled = 0;
+	level.mapEntityTraces = 0;
+
 	for ( i = 0, ent = g_entities; i < level.num_entities; i++, ent++ ) {
 		if ( !ent->inuse ) {
 //			mapEntityData[0][i].valid = qfalse;
@@ -932,8 +1185,6 @@ void G_UpdateTeamMapData( void ) {
 
 		if ( ent->client->sess.playerType == PC_FIELDOPS ) {
 			if ( ent->client->sess.skill[SK_SIGNALS] >= 4 && ent->health > 0 ) {
-				vec3_t pos[3];
-
 				f1 = ent->client->sess.sessionTeam == TEAM_ALLIES ? qtrue : qfalse;
 				f2 = ent->client->sess.sessionTeam == TEAM_AXIS ?   qtrue : qfalse;
 
@@ -958,15 +1209,7 @@ void G_UpdateTeamMapData( void ) {
 						continue;
 					}
 
-					VectorCopy( ent2->client->ps.origin, pos[0] );
-					pos[0][2] += ent2->client->ps.mins[2];
-					VectorCopy( ent2->client->ps.origin, pos[1] );
-					VectorCopy( ent2->client->ps.origin, pos[2] );
-					pos[2][2] += ent2->client->ps.maxs[2];
-
-					if ( G_VisibleFromBinoculars( ent, ent2, pos[0] ) ||
-						 G_VisibleFromBinoculars( ent, ent2, pos[1] ) ||
-						 G_VisibleFromBinoculars( ent, ent2, pos[2] ) ) {
+					if ( G_PlayerVisibleFromBinoculars( ent, ent2 ) ) {
 						G_UpdateTeamMapData_DisguisedPlayer( ent, ent2, f1, f2 );
 					}
 				}
@@ -978,23 +1221,21 @@ void G_UpdateTeamMapData( void ) {
 
 				G_SetupFrustum( ent );
 
-				for ( j = 0, ent2 = g_entities; j < level.num_entities; j++, ent2++ ) {
+				// only clients can be ET_PLAYER
+				for ( j = 0, ent2 = g_entities; j < level.maxclients; j++, ent2++ ) {
 					if ( !ent2->inuse || ent2 == ent ) {
 						continue;
 					}
 
+					// teammates were already updated by the first pass
+					if ( ent2->client->sess.sessionTeam == ent->client->sess.sessionTeam ) {
+						continue;
+					}
+
 					switch ( ent2->s.eType ) {
 					case ET_PLAYER:
 					{
-						vec3_t pos[3];
-						VectorCopy( ent2->client->ps.origin, pos[0] );
-						pos[0][2] += ent2->client->ps.mins[2];
-						VectorCopy( ent2->client->ps.origin, pos[1] );
-						VectorCopy( ent2->client->ps.origin, pos[2] );
-						pos[2][2] += ent2->client->ps.maxs[2];
-						if ( ent2->health > 0 && ( G_VisibleFromBinoculars( ent, ent2, pos[0] ) ||
-												   G_VisibleFromBinoculars( ent, ent2, pos[1] ) ||
-												   G_VisibleFromBinoculars( ent, ent2, pos[2] ) ) ) {
+						if ( ent2->health > 0 && G_PlayerVisibleFromBinoculars( ent, ent2 ) ) {
 							if ( ent2->client->sess.sessionTeam != ent->client->sess.sessionTeam ) {
 								int k;
 
@@ -1204,5 +1445,10 @@ void G_UpdateTeamMapData( void ) {
 		}
 	}
 
+	if ( g_debugTeamMapData.integer ) {
+		G_Printf( "teammapdata: %i players checked, %i culled, %i traces\n",
+				  level.mapEntityCandidates, level.mapEntityCulled, level.mapEntityTraces );
+	}
+
 //	G_SendAllMapEntityInfo();
 }
@@ -176,6 +176,133 @@ void G_TeamCommand( team_t team, char *cmd ) {
 }
 
 
+/*
+=================================================================================
+
+Entity name index
+
+targetname and scriptName lookups walk a hash chain of the entities carrying
+that name rather than every entity. Chains are kept in entity number order, so
+iterating with a from pointer returns the same entities in the same order as a
+linear scan. G_IndexEntityNames has to be called whenever either name changes,
+G_FreeEntity takes the entity out.
+
+=================================================================================
+*/
+
+static void G_UnindexEntityName( gentity_t *ent, nameIndex_t index ) {
+	gentity_t **link;
+
+	if ( !ent->nameIndexChain[index] ) {
+		return;
+	}
+
+	for ( link = &level.nameIndex[index][ent->nameIndexChain[index] - 1]; *link; link = &( *link )->nameIndexNext[index] ) {
+		if ( *link == ent ) {
+			*link = ent->nameIndexNext[index];
+			break;
+		}
+	}
+
+	ent->nameIndexNext[index] = NULL;
+	ent->nameIndexChain[index] = 0;
+}
+
+static void G_IndexEntityName( gentity_t *ent, nameIndex_t index, long hash ) {
+	gentity_t **link;
+	int chain = hash & ( NAMEINDEX_SIZE - 1 );
+
+	for ( link = &level.nameIndex[index][chain]; *link && *link < ent; link = &( *link )->nameIndexNext[index] ) {
+	}
+
+	ent->nameIndexNext[index] = *link;
+	*link = ent;
+	ent->nameIndexChain[index] = chain + 1;
+}
+
+/*
+=============
+G_IndexEntityNames
+
+(Re)links ent under its current targetname and scriptName, and updates targetnamehash
+=============
+*/
+void G_IndexEntityNames( gentity_t *ent ) {
+	G_UnindexEntityName( ent, NAMEINDEX_TARGETNAME );
+	G_UnindexEntityName( ent, NAMEINDEX_SCRIPTNAME );
+
+	if ( ent->targetname && *ent->targetname ) {
+		ent->targetnamehash = BG_StringHashValue( ent->targetname );
+		G_IndexEntityName( ent, NAMEINDEX_TARGETNAME, ent->targetnamehash );
+	} else {
+		ent->targetnamehash = -1;
+	}
+
+	if ( ent->scriptName && *ent->scriptName ) {
+		G_IndexEntityName( ent, NAMEINDEX_SCRIPTNAME, BG_StringHashValue( ent->scriptName ) );
+	}
+}
+
+/*
+=============
+G_ClearNameIndex
+
+Drops every chain, for when entities are about to be overwritten wholesale
+=============
+*/
+void G_ClearNameIndex( void ) {
+	int i;
+
+	memset( level.nameIndex, 0, sizeof( level.nameIndex ) );
+
+	for ( i = 0; i < MAX_GENTITIES; i++ ) {
+		memset( g_entities[i].nameIndexNext, 0, sizeof( g_entities[i].nameIndexNext ) );
+		memset( g_entities[i].nameIndexChain, 0, sizeof( g_entities[i].nameIndexChain ) );
+	}
+}
+
+/*
+=============
+G_RebuildNameIndex
+=============
+*/
+void G_RebuildNameIndex( void ) {
+	int i;
+
+	G_ClearNameIndex();
+
+	for ( i = 0; i < level.num_entities; i++ ) {
+		if ( g_entities[i].inuse ) {
+			G_IndexEntityNames( &g_entities[i] );
+		}
+	}
+}
+
+static gentity_t *G_FindIndexedName( gentity_t *from, nameIndex_t index, int fieldofs, const char *match, long hash ) {
+	gentity_t *ent;
+	char *s;
+
+	if ( !match || !*match ) {
+		return NULL;
+	}
+
+	for ( ent = level.nameIndex[index][hash & ( NAMEINDEX_SIZE - 1 )]; ent; ent = ent->nameIndexNext[index] ) {
+		if ( from && ent <= from ) {
+			continue;
+		}
+		if ( !ent->inuse ) {
+			continue;
+		}
+
+		s = *( char ** )( (byte *)ent + fieldofs );
+		if ( s && !Q_stricmp( s, match ) ) {
+			return ent;
+		}
+	}
+
+	return NULL;
+}
+
 /*
 =============
 G_Find
@@ -192,6 +319,16 @@ gentity_t *G_Find( gentity_t *from, int fieldofs, const char *match ) {
 	char    *s;
 	gentity_t *max = &g_entities[level.num_entities];
 
+	// indexed names only walk the entities carrying them
+	if ( match && *match ) {
+		if ( fieldofs == FOFS( targetname ) ) {
+			return G_FindByTargetname( from, match );
+		}
+		if ( fieldofs == FOFS( scriptName ) ) {
+			return G_FindByScriptName( from, match );
+		}
+	}
+
 	if ( !from ) {
 		from = g_entities;
 	} else {
@@ -221,50 +358,23 @@ G_FindByTargetname
 =============
 */
 gentity_t* G_FindByTargetname( gentity_t *from, const char* match ) {
-	gentity_t* max = &g_entities[level.num_entities];
-	int hash = BG_StringHashValue( match );
-
-	if ( !from ) {
-		from = g_entities;
-	} else {
-		from++;
-	}
-
-	for ( ; from < max ; from++ ) {
-		if ( !from->inuse ) {
-			continue;
-		}
-
-		if ( from->targetnamehash == hash && !Q_stricmp( from->targetname, match ) ) {
-			return from;
-		}
-	}
-
-	return NULL;
+	return G_FindIndexedName( from, NAMEINDEX_TARGETNAME, FOFS( targetname ), match, BG_StringHashValue( match ) );
 }
 
 // digibob: this version should be used for loops, saves the constant hash building
 gentity_t* G_FindByTargetnameFast( gentity_t *from, const char* match, int hash ) {
-	gentity_t* max = &g_entities[level.num_entities];
-
-	if ( !from ) {
-		from = g_entities;
-	} else {
-		from++;
-	}
-
-	for ( ; from < max ; from++ ) {
-		if ( !from->inuse ) {
-			continue;
-		}
-
-		if ( from->targetnamehash == hash && !Q_stricmp( from->targetname, match ) ) {
-			return from;
-		}
-	}
+	return G_FindIndexedName( from, NAMEINDEX_TARGETNAME, FOFS( targetname ), match, hash );
+}
 
-	return NULL;
+/*
+=============
+G_FindByScriptName
+=============
+*/
+gentity_t* G_FindByScriptName( gentity_t *from, const char* match ) {
+	return G_FindIndexedName( from, NAMEINDEX_SCRIPTNAME, FOFS( scriptName ), match, BG_StringHashValue( match ) );
 }
+
 /*
 =============
 G_PickTarget
@@ -616,6 +726,9 @@ void G_FreeEntity( gentity_t *ed ) {
 		return;
 	}
 
+	G_UnindexEntityName( ed, NAMEINDEX_TARGETNAME );
+	G_UnindexEntityName( ed, NAMEINDEX_SCRIPTNAME );
+
 	spawnCount = ed->spawnCount;
 
 	memset( ed, 0, sizeof( *ed ) );
@@ -2424,9 +2424,12 @@ void G_RailTrail( vec_t* start, vec_t* end );
 
 
 void weapon_callAirStrike( gentity_t *ent ) {
-	int i, j;
-	vec3_t bombaxis, lookaxis, pos, bomboffset, fallaxis, temp, dir, skypoint;
+	int i, j, numRays;
+	vec3_t bombaxis, lookaxis, pos, bomboffset, temp, dir, skypoint;
 	gentity_t *bomb;
+	gentity_t *bombs[NUMBOMBS];
+	traceRay_t rays[NUMBOMBS];
+	trace_t results[NUMBOMBS];
 	trace_t tr;
 	float traceheight, bottomtraceheight;
 
@@ -2533,37 +2536,67 @@ void weapon_callAirStrike( gentity_t *ent ) {
 			bomboffset[2]       = 0.f;
 			VectorAdd( pos, bomboffset, bomb->s.pos.trBase );
 
-			VectorCopy( bomb->s.pos.trBase, bomboffset ); // make sure bombs fall "on top of" nonuniform scenery
-			bomboffset[2]       = traceheight;
+			// make sure bombs fall "on top of" nonuniform scenery
+			VectorCopy( bomb->s.pos.trBase, rays[i].start );
+			rays[i].start[2]        = traceheight;
 
-			VectorCopy( bomboffset, fallaxis );
-			fallaxis[2]         = bottomtraceheight;
+			VectorCopy( rays[i].start, rays[i].end );
+			rays[i].end[2]          = bottomtraceheight;
 
+			VectorClear( rays[i].mins );
+			VectorClear( rays[i].maxs );
+			rays[i].passEntityNum   = ent - g_entities;
+			rays[i].contentmask     = bomb->clipmask;
+			rays[i].capsule         = qfalse;
 
-			trap_Trace( &tr, bomboffset, NULL, NULL, fallaxis, ent - g_entities, bomb->clipmask );
-			if ( tr.fraction != 1.0 ) {
-				VectorCopy( tr.endpos,bomb->s.pos.trBase );
+			bombs[i] = bomb;
+
+			// move pos for next bomb
+			VectorAdd( pos, bombaxis, pos );
+		}
+
+		// drop the whole pass at once
+		G_TraceBatch( rays, results, NUMBOMBS );
+
+		numRays = 0;
+		for ( i = 0; i < NUMBOMBS; i++ ) {
+			bomb = bombs[i];
+
+			if ( results[i].fraction != 1.0 ) {
+				VectorCopy( results[i].endpos, bomb->s.pos.trBase );
 
 				// Snap origin!
-				VectorMA( bomb->s.pos.trBase, 2.f, tr.plane.normal, temp );
+				VectorMA( bomb->s.pos.trBase, 2.f, results[i].plane.normal, temp );
 				SnapVectorTowards( bomb->s.pos.trBase, temp );          // save net bandwidth
 
 //				G_RailTrail( skypoint, bomb->s.pos.trBase );
-				trap_TraceNoEnts( &tr, skypoint, NULL, NULL, bomb->s.pos.trBase, 0, CONTENTS_SOLID );
-				if ( tr.fraction < 1.f ) {
-					G_FreeEntity( bomb );
+				// check the plane can see where it landed
+				VectorCopy( skypoint, rays[numRays].start );
+				VectorCopy( bomb->s.pos.trBase, rays[numRays].end );
+				rays[numRays].passEntityNum = -2;
+				rays[numRays].contentmask   = CONTENTS_SOLID;
+				bombs[numRays++] = bomb;
+				continue;
+			}
+
+			VectorCopy( bomb->s.pos.trBase, bomb->r.currentOrigin );
+		}
+
+		if ( !numRays ) {
+			continue;
+		}
 
-					// move pos for next bomb
-					VectorAdd( pos, bombaxis, pos );
+		G_TraceBatch( rays, results, numRays );
 
-					continue;
-				}
+		for ( i = 0; i < numRays; i++ ) {
+			bomb = bombs[i];
+
+			if ( results[i].fraction < 1.f ) {
+				G_FreeEntity( bomb );
+				continue;
 			}
 
 			VectorCopy( bomb->s.pos.trBase, bomb->r.currentOrigin );
-
-			// move pos for next bomb
-			VectorAdd( pos, bombaxis, pos );
 		}
 	}
 }
@@ -3922,13 +3955,6 @@ void CalcMuzzlePoints( gentity_t *ent, int weapon ) {
 qboolean G_PlayerCanBeSeenByOthers( gentity_t *ent ) {
 	int i;
 	gentity_t   *ent2;
-	vec3_t pos[3];
-
-	VectorCopy( ent->client->ps.origin, pos[0] );
-	pos[0][2] += ent->client->ps.mins[2];
-	VectorCopy( ent->client->ps.origin, pos[1] );
-	VectorCopy( ent->client->ps.origin, pos[2] );
-	pos[2][2] += ent->client->ps.maxs[2];
 
 	for ( i = 0, ent2 = g_entities; i < level.maxclients; i++, ent2++ ) {
 		if ( !ent2->inuse || ent2 == ent ) {
@@ -3950,9 +3976,7 @@ qboolean G_PlayerCanBeSeenByOthers( gentity_t *ent ) {
 			G_SetupFrustum( ent2 );
 		}
 
-		if ( G_VisibleFromBinoculars( ent2, ent, pos[0] ) ||
-			 G_VisibleFromBinoculars( ent2, ent, pos[1] ) ||
-			 G_VisibleFromBinoculars( ent2, ent, pos[2] ) ) {
+		if ( G_PlayerVisibleFromBinoculars( ent2, ent ) ) {
 			return qtrue;
 		}
 	}
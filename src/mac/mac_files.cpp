@@ -750,6 +750,26 @@ void Sys_FreeFileList( char **list ) {
 	Z_Free( list );
 }
 
+// pk3 files are read through stdio on the mac
+void *Sys_MapFile( const char *path, int *length ) {
+	return NULL;
+}
+
+void Sys_UnmapFile( void *data, int length ) {
+}
+
+qboolean Sys_FileStat( const char *path, int *size, int *mtime ) {
+	struct stat st;
+
+	if ( stat( path, &st ) == -1 || st.st_size > 0x7fffffff ) {
+		return qfalse;
+	}
+
+	*size = (int)st.st_size;
+	*mtime = (int)st.st_mtime;
+	return qtrue;
+}
+
 void Mac_GetOSPath( short inDomain, OSType inFolderType, char *outPath ) {
 	OSStatus err = noErr;
 	char temp[PATH_MAX];
@@ -987,6 +987,33 @@ void Sys_EnterCriticalSection( void *ptr ) {
 void Sys_LeaveCriticalSection( void *ptr ) {
 }
 
+// no worker threads on mac yet, Sys_RunWorkers runs the jobs serially
+int Sys_StartWorkers( int count ) {
+	return 0;
+}
+
+void Sys_StopWorkers( void ) {
+}
+
+void Sys_RunWorkers( workerFunc_t func, void *data, int count ) {
+	int i;
+
+	for ( i = 0 ; i < count ; i++ ) {
+		func( data, i );
+	}
+}
+
+// no background thread on mac either, jobs run as soon as they are queued
+int Sys_QueueBackgroundJob( backgroundFunc_t func, void *data ) {
+	static int ticket;
+
+	func( data );
+	return ++ticket;
+}
+
+void Sys_WaitBackgroundJob( int ticket ) {
+}
+
 int Sys_GetHighQualityCPU() {
 	// FIXME TTimo see win_shared.c
 	return 0;
@@ -1331,6 +1358,21 @@ int Sys_Milliseconds( void ) {
 }
 #endif
 
+/*
+================
+Sys_Microseconds
+================
+*/
+int Sys_Microseconds( void ) {
+	Nanoseconds nano;
+	double doub;
+
+	nano = AbsoluteToNanoseconds( UpTime() );
+	doub = ( ( (double) nano.hi ) * 4294967296.0 ) + nano.lo;
+
+	return (int)(long long)( doub * 0.001 );
+}
+
 /*
 ================
 Sys_Error
@@ -488,6 +488,13 @@ void Sys_SendPacket( int length, const void *data, netadr_t to ) {
 	}
 }
 
+// OpenTransport has no batched send, packets go out as they are sent
+void Sys_BeginPacketBatch( void ) {
+}
+
+void Sys_FlushPacketBatch( void ) {
+}
+
 /*
 ==================
 Sys_GetPacket
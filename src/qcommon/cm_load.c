@@ -71,6 +71,7 @@ cvar_t      *cm_noAreas;
 cvar_t      *cm_noCurves;
 cvar_t      *cm_playerCurveClip;
 cvar_t      *cm_optimize;
+cvar_t      *cm_traceRecord;
 #endif
 
 cmodel_t box_model;
@@ -239,6 +240,52 @@ void CM_BoundBrush( cbrush_t *b ) {
 }
 
 
+#ifdef CM_SIMD_TRACE
+/*
+=================
+CMod_CreateBrushPlanes
+
+Copies the side planes of every brush into blocks of four planes so
+CM_TraceThroughBrush can test them together.  The unused planes of the
+last block of a brush are never crossed by any trace.
+=================
+*/
+static void CMod_CreateBrushPlanes( void ) {
+	cbrush_t        *brush;
+	cbrushplanes_t  *block;
+	cplane_t        *plane;
+	int i, j, k;
+
+	cm.numBrushPlanes = 0;
+	for ( i = 0 ; i < cm.numBrushes ; i++ ) {
+		cm.numBrushPlanes += ( cm.brushes[i].numsides + 3 ) >> 2;
+	}
+	cm.brushplanes = Hunk_Alloc( cm.numBrushPlanes * sizeof( *cm.brushplanes ), h_high );
+
+	block = cm.brushplanes;
+	for ( i = 0, brush = cm.brushes ; i < cm.numBrushes ; i++, brush++ ) {
+		if ( !brush->numsides ) {
+			continue;
+		}
+		brush->planes = block;
+		for ( j = 0 ; j < brush->numsides ; j += 4, block++ ) {
+			for ( k = 0 ; k < 4 ; k++ ) {
+				if ( j + k >= brush->numsides ) {
+					block->dist[k] = 1e30f;
+					continue;
+				}
+				plane = brush->sides[j + k].plane;
+				block->normal[0][k] = plane->normal[0];
+				block->normal[1][k] = plane->normal[1];
+				block->normal[2][k] = plane->normal[2];
+				block->dist[k] = plane->dist;
+				block->signbits[k] = plane->signbits;
+			}
+		}
+	}
+}
+#endif
+
 /*
 =================
 CMod_LoadBrushes
@@ -274,6 +321,9 @@ void CMod_LoadBrushes( lump_t *l ) {
 		CM_BoundBrush( out );
 	}
 
+#ifdef CM_SIMD_TRACE
+	CMod_CreateBrushPlanes();
+#endif
 }
 
 /*
@@ -620,6 +670,7 @@ void CM_LoadMap( const char *name, qboolean clientload, int *checksum ) {
 	cm_noCurves = Cvar_Get( "cm_noCurves", "0", CVAR_CHEAT );
 	cm_playerCurveClip = Cvar_Get( "cm_playerCurveClip", "1", CVAR_ARCHIVE | CVAR_CHEAT );
 	cm_optimize = Cvar_Get( "cm_optimize", "1", CVAR_CHEAT );
+	cm_traceRecord = Cvar_Get( "cm_traceRecord", "0", CVAR_CHEAT );
 #endif
 	Com_DPrintf( "CM_LoadMap( %s, %i )\n", name, clientload );
 
@@ -43,6 +43,13 @@ If you have questions concerning this license or the applicable additional terms
 // enable to make the collision detection a bunch faster
 #define MRE_OPTIMIZE
 
+// trace through brushes four planes at a time, only where the scalar code
+// does its float math with SSE as well so both give the same results,
+// i386 builds need -msse2 -mfpmath=sse for that
+#if defined( __x86_64__ ) || defined( _M_X64 ) || ( defined( __i386__ ) && defined( __SSE2_MATH__ ) )
+#define CM_SIMD_TRACE
+#endif
+
 typedef struct {
 	cplane_t    *plane;
 	int children[2];                // negative numbers are leafs
@@ -70,12 +77,20 @@ typedef struct {
 	int shaderNum;
 } cbrushside_t;
 
+// copy of the side planes of a brush, four planes per block
+typedef struct {
+	float normal[3][4];
+	float dist[4];
+	int signbits[4];
+} cbrushplanes_t;
+
 typedef struct {
 	int shaderNum;              // the shader that determined the contents
 	int contents;
 	vec3_t bounds[2];
 	int numsides;
 	cbrushside_t    *sides;
+	cbrushplanes_t  *planes;    // NULL if the sides have to be tested one at a time
 	int checkcount;             // to avoid repeated testings
 } cbrush_t;
 
@@ -123,6 +138,9 @@ typedef struct {
 	int numBrushes;
 	cbrush_t    *brushes;
 
+	int numBrushPlanes;
+	cbrushplanes_t *brushplanes;
+
 	int numClusters;
 	int clusterBytes;
 	byte        *visibility;
@@ -154,6 +172,7 @@ extern cvar_t      *cm_noAreas;
 extern cvar_t      *cm_noCurves;
 extern cvar_t      *cm_playerCurveClip;
 extern cvar_t      *cm_optimize;
+extern cvar_t      *cm_traceRecord;
 
 // cm_test.c
 
@@ -83,3 +83,6 @@ int CM_MarkFragments( int numPoints, const vec3_t *points, const vec3_t projecti
 
 // cm_patch.c
 void CM_DrawDebugSurface( void ( *drawPoly )( int color, int numPoints, float *points ) );
+
+// cm_trace.c
+void CM_TraceBench_f( void );
@@ -57,7 +57,10 @@ int CM_PointLeafnum_r( const vec3_t p, int num ) {
 		}
 	}
 
-	c_pointcontents++;      // optimize counter
+	// worker threads test points as well, leave the counter alone while they run
+	if ( !com_workersActive ) {
+		c_pointcontents++;      // optimize counter
+	}
 
 	return -1 - num;
 }
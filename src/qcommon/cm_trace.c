@@ -30,6 +30,18 @@ If you have questions concerning this license or the applicable additional terms
 #include "cm_local.h"
 #include "cm_patch.h"
 
+#ifdef CM_SIMD_TRACE
+#include <emmintrin.h>
+
+// i386 callers, the qvm among them, don't keep the stack 16 byte aligned
+// for the __m128 spills
+#if defined( __i386__ )
+#define CM_SIMD_ALIGN_STACK __attribute__( ( force_align_arg_pointer, noinline ) )
+#else
+#define CM_SIMD_ALIGN_STACK
+#endif
+#endif
+
 // always use bbox vs. bbox collision and never capsule vs. bbox or vice versa
 #define ALWAYS_BBOX_VS_BBOX
 // always use capsule vs. capsule collision and never capsule vs. bbox or vice versa
@@ -611,6 +623,169 @@ static int CM_TraceThroughBounds( traceWork_t *tw, vec3_t mins, vec3_t maxs ) {
 
 #endif
 
+// set by tracebench to time the plane at a time code
+static qboolean cm_scalarTrace;
+
+#ifdef CM_SIMD_TRACE
+/*
+================
+CM_TraceThroughBrushPlanes
+
+Does the plane loop of CM_TraceThroughBrush four planes at a time.  The
+fractions are divided in double precision like the scalar code does and
+ties keep the first plane, so the trace comes out exactly the same.
+Returns qfalse if the trace is completely in front of one of the planes.
+================
+*/
+static CM_SIMD_ALIGN_STACK qboolean CM_TraceThroughBrushPlanes( traceWork_t *tw, cbrush_t *brush, float *enterFrac, float *leaveFrac,
+											cbrushside_t **leadside, qboolean *getout, qboolean *startout ) {
+	cbrushplanes_t  *block;
+	__m128 nx, ny, nz, dist, d1, d2, mask, above, enter, cross, offset, den, f;
+	__m128 sx, sy, sz, ex, ey, ez, ox, oy, oz, o0x, o0y, o0z, o1x, o1y, o1z;
+	__m128 e0x, e0y, e0z, e1x, e1y, e1z;
+	__m128 zero, one, epsilon;
+	__m128d lo, hi;
+	__m128i signbits, bit0, bit1, bit2;
+	float fraction[4];
+	int i, j, crossMask, enterMask;
+
+	zero = _mm_setzero_ps();
+	one = _mm_set1_ps( 1.0f );
+	epsilon = _mm_set1_ps( SURFACE_CLIP_EPSILON );
+	bit0 = _mm_set1_epi32( 1 );
+	bit1 = _mm_set1_epi32( 2 );
+	bit2 = _mm_set1_epi32( 4 );
+
+	if ( tw->sphere.use ) {
+		// start (o) and end (e) points of the capsule ends, 1 is
+		// used for the planes the capsule offset points into
+		o0x = _mm_set1_ps( tw->start[0] + tw->sphere.offset[0] );
+		o0y = _mm_set1_ps( tw->start[1] + tw->sphere.offset[1] );
+		o0z = _mm_set1_ps( tw->start[2] + tw->sphere.offset[2] );
+		o1x = _mm_set1_ps( tw->start[0] - tw->sphere.offset[0] );
+		o1y = _mm_set1_ps( tw->start[1] - tw->sphere.offset[1] );
+		o1z = _mm_set1_ps( tw->start[2] - tw->sphere.offset[2] );
+		e0x = _mm_set1_ps( tw->end[0] + tw->sphere.offset[0] );
+		e0y = _mm_set1_ps( tw->end[1] + tw->sphere.offset[1] );
+		e0z = _mm_set1_ps( tw->end[2] + tw->sphere.offset[2] );
+		e1x = _mm_set1_ps( tw->end[0] - tw->sphere.offset[0] );
+		e1y = _mm_set1_ps( tw->end[1] - tw->sphere.offset[1] );
+		e1z = _mm_set1_ps( tw->end[2] - tw->sphere.offset[2] );
+		sx = sy = sz = ex = ey = ez = zero;
+	} else {
+		// box corners for clear and set plane signbits
+		o0x = _mm_set1_ps( tw->size[0][0] );
+		o0y = _mm_set1_ps( tw->size[0][1] );
+		o0z = _mm_set1_ps( tw->size[0][2] );
+		o1x = _mm_set1_ps( tw->size[1][0] );
+		o1y = _mm_set1_ps( tw->size[1][1] );
+		o1z = _mm_set1_ps( tw->size[1][2] );
+		sx = _mm_set1_ps( tw->start[0] );
+		sy = _mm_set1_ps( tw->start[1] );
+		sz = _mm_set1_ps( tw->start[2] );
+		ex = _mm_set1_ps( tw->end[0] );
+		ey = _mm_set1_ps( tw->end[1] );
+		ez = _mm_set1_ps( tw->end[2] );
+		e0x = e0y = e0z = e1x = e1y = e1z = zero;
+	}
+
+	for ( i = 0, block = brush->planes ; i < brush->numsides ; i += 4, block++ ) {
+		nx = _mm_loadu_ps( block->normal[0] );
+		ny = _mm_loadu_ps( block->normal[1] );
+		nz = _mm_loadu_ps( block->normal[2] );
+
+		if ( tw->sphere.use ) {
+			// adjust the plane distance apropriately for radius
+			dist = _mm_add_ps( _mm_loadu_ps( block->dist ), _mm_set1_ps( tw->sphere.radius ) );
+
+			// find the closest point on the capsule to the plane
+			f = _mm_add_ps( _mm_add_ps( _mm_mul_ps( nx, _mm_set1_ps( tw->sphere.offset[0] ) ),
+										_mm_mul_ps( ny, _mm_set1_ps( tw->sphere.offset[1] ) ) ),
+							_mm_mul_ps( nz, _mm_set1_ps( tw->sphere.offset[2] ) ) );
+			mask = _mm_cmpgt_ps( f, zero );
+			ox = _mm_or_ps( _mm_and_ps( mask, o1x ), _mm_andnot_ps( mask, o0x ) );
+			oy = _mm_or_ps( _mm_and_ps( mask, o1y ), _mm_andnot_ps( mask, o0y ) );
+			oz = _mm_or_ps( _mm_and_ps( mask, o1z ), _mm_andnot_ps( mask, o0z ) );
+			d1 = _mm_sub_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( ox, nx ), _mm_mul_ps( oy, ny ) ), _mm_mul_ps( oz, nz ) ), dist );
+			ox = _mm_or_ps( _mm_and_ps( mask, e1x ), _mm_andnot_ps( mask, e0x ) );
+			oy = _mm_or_ps( _mm_and_ps( mask, e1y ), _mm_andnot_ps( mask, e0y ) );
+			oz = _mm_or_ps( _mm_and_ps( mask, e1z ), _mm_andnot_ps( mask, e0z ) );
+			d2 = _mm_sub_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( ox, nx ), _mm_mul_ps( oy, ny ) ), _mm_mul_ps( oz, nz ) ), dist );
+		} else {
+			// pick the corner of the box from the plane signbits
+			signbits = _mm_loadu_si128( (__m128i *)block->signbits );
+			mask = _mm_castsi128_ps( _mm_cmpeq_epi32( _mm_and_si128( signbits, bit0 ), bit0 ) );
+			ox = _mm_or_ps( _mm_and_ps( mask, o1x ), _mm_andnot_ps( mask, o0x ) );
+			mask = _mm_castsi128_ps( _mm_cmpeq_epi32( _mm_and_si128( signbits, bit1 ), bit1 ) );
+			oy = _mm_or_ps( _mm_and_ps( mask, o1y ), _mm_andnot_ps( mask, o0y ) );
+			mask = _mm_castsi128_ps( _mm_cmpeq_epi32( _mm_and_si128( signbits, bit2 ), bit2 ) );
+			oz = _mm_or_ps( _mm_and_ps( mask, o1z ), _mm_andnot_ps( mask, o0z ) );
+
+			// adjust the plane distance apropriately for mins/maxs
+			dist = _mm_sub_ps( _mm_loadu_ps( block->dist ),
+							   _mm_add_ps( _mm_add_ps( _mm_mul_ps( ox, nx ), _mm_mul_ps( oy, ny ) ), _mm_mul_ps( oz, nz ) ) );
+
+			d1 = _mm_sub_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( sx, nx ), _mm_mul_ps( sy, ny ) ), _mm_mul_ps( sz, nz ) ), dist );
+			d2 = _mm_sub_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( ex, nx ), _mm_mul_ps( ey, ny ) ), _mm_mul_ps( ez, nz ) ), dist );
+		}
+
+		// if completely in front of face, no intersection with the entire brush
+		above = _mm_cmpgt_ps( d1, zero );
+		mask = _mm_and_ps( above, _mm_or_ps( _mm_cmpge_ps( d2, epsilon ), _mm_cmpge_ps( d2, d1 ) ) );
+		if ( _mm_movemask_ps( mask ) ) {
+			return qfalse;
+		}
+
+		if ( _mm_movemask_ps( _mm_cmpgt_ps( d2, zero ) ) ) {
+			*getout = qtrue;    // endpoint is not in solid
+		}
+		if ( _mm_movemask_ps( above ) ) {
+			*startout = qtrue;
+		}
+
+		// if it doesn't cross the plane, the plane isn't relevent
+		cross = _mm_or_ps( above, _mm_cmpgt_ps( d2, zero ) );
+		crossMask = _mm_movemask_ps( cross );
+		if ( !crossMask ) {
+			continue;
+		}
+		enter = _mm_cmpgt_ps( d1, d2 );
+		enterMask = _mm_movemask_ps( enter ) & crossMask;
+
+		// ( d1 -/+ SURFACE_CLIP_EPSILON ) / ( d1 - d2 ), evaluated in double
+		offset = _mm_xor_ps( epsilon, _mm_and_ps( enter, _mm_set1_ps( -0.0f ) ) );
+		den = _mm_sub_ps( d1, d2 );
+		lo = _mm_div_pd( _mm_add_pd( _mm_cvtps_pd( d1 ), _mm_cvtps_pd( offset ) ), _mm_cvtps_pd( den ) );
+		d1 = _mm_movehl_ps( d1, d1 );
+		offset = _mm_movehl_ps( offset, offset );
+		den = _mm_movehl_ps( den, den );
+		hi = _mm_div_pd( _mm_add_pd( _mm_cvtps_pd( d1 ), _mm_cvtps_pd( offset ) ), _mm_cvtps_pd( den ) );
+		f = _mm_movelh_ps( _mm_cvtpd_ps( lo ), _mm_cvtpd_ps( hi ) );
+		// clamp entering fractions at 0 and leaving fractions at 1
+		f = _mm_andnot_ps( _mm_and_ps( enter, _mm_cmplt_ps( f, zero ) ), f );
+		mask = _mm_andnot_ps( enter, _mm_cmpgt_ps( f, one ) );
+		f = _mm_or_ps( _mm_and_ps( mask, one ), _mm_andnot_ps( mask, f ) );
+		_mm_storeu_ps( fraction, f );
+
+		for ( j = 0 ; j < 4 ; j++ ) {
+			if ( !( crossMask & ( 1 << j ) ) ) {
+				continue;
+			}
+			if ( enterMask & ( 1 << j ) ) {
+				if ( fraction[j] > *enterFrac ) {
+					*enterFrac = fraction[j];
+					*leadside = brush->sides + i + j;
+				}
+			} else if ( fraction[j] < *leaveFrac ) {
+				*leaveFrac = fraction[j];
+			}
+		}
+	}
+
+	return qtrue;
+}
+#endif
+
 /*
 ================
 CM_TraceThroughBrush
@@ -644,6 +819,16 @@ static void CM_TraceThroughBrush( traceWork_t *tw, cbrush_t *brush ) {
 
 	leadside = NULL;
 
+#ifdef CM_SIMD_TRACE
+	if ( brush->planes && !cm_scalarTrace ) {
+		if ( !CM_TraceThroughBrushPlanes( tw, brush, &enterFrac, &leaveFrac, &leadside, &getout, &startout ) ) {
+			return;
+		}
+		if ( leadside ) {
+			clipplane = leadside->plane;
+		}
+	} else
+#endif
 	if ( tw->sphere.use ) {
 		//
 		// compare the trace against all planes of the brush
@@ -1318,6 +1503,73 @@ static void CM_TraceThroughTree( traceWork_t *tw, int num, float p1f, float p2f,
 //======================================================================
 
 
+#ifndef BSPC
+/*
+===============================================================================
+
+TRACE RECORDING
+
+===============================================================================
+*/
+
+#define MAX_RECORDED_TRACES     16384   // must be a power of two
+
+typedef struct {
+	vec3_t start, end;
+	vec3_t mins, maxs;
+	vec3_t origin;
+	clipHandle_t model;
+	int brushmask;
+	int capsule;
+	qboolean useSphere;
+	sphere_t sphere;
+} recordedTrace_t;
+
+static recordedTrace_t  *cm_recordedTraces;
+static int cm_numRecordedTraces;
+static char cm_recordedMap[MAX_QPATH];
+static qboolean cm_replayingTraces;
+
+/*
+==================
+CM_RecordTrace
+
+Keeps the last MAX_RECORDED_TRACES traces for tracebench
+==================
+*/
+static void CM_RecordTrace( const vec3_t start, const vec3_t end, const vec3_t mins, const vec3_t maxs,
+							clipHandle_t model, const vec3_t origin, int brushmask, int capsule, sphere_t *sphere ) {
+	recordedTrace_t *rec;
+
+	// the temp box models change with every CM_TempBoxModel
+	if ( cm_replayingTraces || model == BOX_MODEL_HANDLE || model == CAPSULE_MODEL_HANDLE ) {
+		return;
+	}
+	if ( !cm_recordedTraces ) {
+		cm_recordedTraces = Z_Malloc( MAX_RECORDED_TRACES * sizeof( *cm_recordedTraces ) );
+	}
+	if ( strcmp( cm_recordedMap, cm.name ) ) {
+		Q_strncpyz( cm_recordedMap, cm.name, sizeof( cm_recordedMap ) );
+		cm_numRecordedTraces = 0;
+	}
+
+	rec = &cm_recordedTraces[cm_numRecordedTraces & ( MAX_RECORDED_TRACES - 1 )];
+	VectorCopy( start, rec->start );
+	VectorCopy( end, rec->end );
+	VectorCopy( mins, rec->mins );
+	VectorCopy( maxs, rec->maxs );
+	VectorCopy( origin, rec->origin );
+	rec->model = model;
+	rec->brushmask = brushmask;
+	rec->capsule = capsule;
+	rec->useSphere = ( sphere != NULL );
+	if ( sphere ) {
+		rec->sphere = *sphere;
+	}
+	cm_numRecordedTraces++;
+}
+#endif
+
 /*
 ==================
 CM_Trace
@@ -1362,6 +1614,12 @@ static void CM_Trace( trace_t *results, const vec3_t start, const vec3_t end,
 		maxs = vec3_origin;
 	}
 
+#ifndef BSPC
+	if ( cm_traceRecord && cm_traceRecord->integer ) {
+		CM_RecordTrace( start, end, mins, maxs, model, origin, brushmask, capsule, sphere );
+	}
+#endif
+
 	// set basic parms
 	tw.contents = brushmask;
 
@@ -1673,3 +1931,90 @@ void CM_TransformedBoxTrace( trace_t *results, const vec3_t start, const vec3_t
 
 	*results = trace;
 }
+
+#ifndef BSPC
+/*
+==================
+CM_TracesEqual
+==================
+*/
+static qboolean CM_TracesEqual( const trace_t *a, const trace_t *b ) {
+	return a->allsolid == b->allsolid && a->startsolid == b->startsolid &&
+		   !memcmp( &a->fraction, &b->fraction, sizeof( a->fraction ) ) &&
+		   !memcmp( a->endpos, b->endpos, sizeof( a->endpos ) ) &&
+		   !memcmp( a->plane.normal, b->plane.normal, sizeof( a->plane.normal ) ) &&
+		   !memcmp( &a->plane.dist, &b->plane.dist, sizeof( a->plane.dist ) ) &&
+		   a->plane.type == b->plane.type && a->plane.signbits == b->plane.signbits &&
+		   a->surfaceFlags == b->surfaceFlags && a->contents == b->contents &&
+		   a->entityNum == b->entityNum;
+}
+
+/*
+==================
+CM_TraceBench_f
+
+Replays the traces recorded with cm_traceRecord one plane at a time and
+four planes at a time, and checks that both give the same results
+==================
+*/
+void CM_TraceBench_f( void ) {
+	recordedTrace_t *rec;
+	trace_t         *results, trace;
+	int i, pass, passes, numTraces, mismatches;
+	int t0, scalarTime, simdTime;
+
+	numTraces = cm_numRecordedTraces < MAX_RECORDED_TRACES ? cm_numRecordedTraces : MAX_RECORDED_TRACES;
+	if ( !numTraces ) {
+		Com_Printf( "no traces recorded, set cm_traceRecord 1 and play for a while\n" );
+		return;
+	}
+	if ( strcmp( cm_recordedMap, cm.name ) ) {
+		Com_Printf( "traces were recorded on %s\n", cm_recordedMap );
+		return;
+	}
+
+	passes = atoi( Cmd_Argv( 1 ) );
+	if ( passes <= 0 ) {
+		passes = 20;
+	}
+
+	results = Z_Malloc( numTraces * sizeof( *results ) );
+	cm_replayingTraces = qtrue;
+
+	cm_scalarTrace = qtrue;
+	t0 = Sys_Milliseconds();
+	for ( pass = 0; pass < passes; pass++ ) {
+		for ( i = 0, rec = cm_recordedTraces; i < numTraces; i++, rec++ ) {
+			CM_Trace( &results[i], rec->start, rec->end, rec->mins, rec->maxs, rec->model, rec->origin,
+					  rec->brushmask, rec->capsule, rec->useSphere ? &rec->sphere : NULL );
+		}
+	}
+	scalarTime = Sys_Milliseconds() - t0;
+
+	cm_scalarTrace = qfalse;
+	mismatches = 0;
+	t0 = Sys_Milliseconds();
+	for ( pass = 0; pass < passes; pass++ ) {
+		for ( i = 0, rec = cm_recordedTraces; i < numTraces; i++, rec++ ) {
+			CM_Trace( &trace, rec->start, rec->end, rec->mins, rec->maxs, rec->model, rec->origin,
+					  rec->brushmask, rec->capsule, rec->useSphere ? &rec->sphere : NULL );
+			if ( !pass && !CM_TracesEqual( &trace, &results[i] ) ) {
+				mismatches++;
+			}
+		}
+	}
+	simdTime = Sys_Milliseconds() - t0;
+
+	cm_replayingTraces = qfalse;
+	Z_Free( results );
+
+	Com_Printf( "%i x %i traces\n", passes, numTraces );
+	Com_Printf( "plane at a time: %i msec\n", scalarTime );
+#ifdef CM_SIMD_TRACE
+	Com_Printf( "four planes at a time: %i msec\n", simdTime );
+#else
+	Com_Printf( "four planes at a time: not supported on this platform\n" );
+#endif
+	Com_Printf( "%i mismatches\n", mismatches );
+}
+#endif
@@ -38,12 +38,15 @@ typedef struct {
 	byte    *data;
 	int maxsize;
 	int cursize;
+	int start;          // offset of the first unexecuted byte in data
 } cmd_t;
 
 int cmd_wait;
 cmd_t cmd_text;
 byte cmd_text_buf[MAX_CMD_BUFFER];
 
+static qboolean cmd_tokenCache;     // set while Cbuf_Execute runs a line, see Cmd_TokenizeString
+
 
 //=============================================================================
 
@@ -82,6 +85,23 @@ void Cbuf_Init( void ) {
 	cmd_text.data = cmd_text_buf;
 	cmd_text.maxsize = MAX_CMD_BUFFER;
 	cmd_text.cursize = 0;
+	cmd_text.start = 0;
+}
+
+/*
+============
+Cbuf_Compact
+
+Moves the unexecuted text back to the start of the buffer so that
+it can be appended to again
+============
+*/
+static void Cbuf_Compact( void ) {
+	if ( !cmd_text.start ) {
+		return;
+	}
+	memmove( cmd_text.data, cmd_text.data + cmd_text.start, cmd_text.cursize );
+	cmd_text.start = 0;
 }
 
 /*
@@ -100,7 +120,10 @@ void Cbuf_AddText( const char *text ) {
 		Com_Printf( "Cbuf_AddText: overflow\n" );
 		return;
 	}
-	memcpy( &cmd_text.data[cmd_text.cursize], text, l );
+	if ( cmd_text.start + cmd_text.cursize + l >= cmd_text.maxsize ) {
+		Cbuf_Compact();
+	}
+	memcpy( &cmd_text.data[cmd_text.start + cmd_text.cursize], text, l );
 	cmd_text.cursize += l;
 }
 
@@ -115,7 +138,6 @@ Adds a \n to the text
 */
 void Cbuf_InsertText( const char *text ) {
 	int len;
-	int i;
 
 	len = strlen( text ) + 1;
 	if ( len + cmd_text.cursize > cmd_text.maxsize ) {
@@ -123,16 +145,20 @@ void Cbuf_InsertText( const char *text ) {
 		return;
 	}
 
-	// move the existing command text
-	for ( i = cmd_text.cursize - 1 ; i >= 0 ; i-- ) {
-		cmd_text.data[ i + len ] = cmd_text.data[ i ];
+	// text already executed by Cbuf_Execute leaves room in front of the
+	// remaining commands, only move them when there isn't enough of it
+	if ( cmd_text.start < len ) {
+		Cbuf_Compact();
+		memmove( cmd_text.data + len, cmd_text.data, cmd_text.cursize );
+		cmd_text.start = len;
 	}
+	cmd_text.start -= len;
 
 	// copy the new text in
-	memcpy( cmd_text.data, text, len - 1 );
+	memcpy( cmd_text.data + cmd_text.start, text, len - 1 );
 
 	// add a \n
-	cmd_text.data[ len - 1 ] = '\n';
+	cmd_text.data[ cmd_text.start + len - 1 ] = '\n';
 
 	cmd_text.cursize += len;
 }
@@ -185,7 +211,7 @@ void Cbuf_Execute( void ) {
 		}
 
 		// find a \n or ; line break
-		text = (char *)cmd_text.data;
+		text = (char *)cmd_text.data + cmd_text.start;
 
 		quotes = 0;
 		for ( i = 0 ; i < cmd_text.cursize ; i++ )
@@ -208,21 +234,24 @@ void Cbuf_Execute( void ) {
 		memcpy( line, text, i );
 		line[i] = 0;
 
-// delete the text from the command buffer and move remaining commands down
+// delete the text from the command buffer before executing it
 // this is necessary because commands (exec) can insert data at the
-// beginning of the text buffer
+// beginning of the text buffer, the remaining commands stay where they
+// are until Cbuf_AddText or Cbuf_InsertText need the room
 
 		if ( i == cmd_text.cursize ) {
 			cmd_text.cursize = 0;
+			cmd_text.start = 0;
 		} else
 		{
 			i++;
 			cmd_text.cursize -= i;
-			memmove( text, text + i, cmd_text.cursize );
+			cmd_text.start += i;
 		}
 
 // execute the command line
 
+		cmd_tokenCache = qtrue;
 		Cmd_ExecuteString( line );
 	}
 }
@@ -316,17 +345,150 @@ void Cmd_Echo_f( void ) {
 typedef struct cmd_function_s
 {
 	struct cmd_function_s   *next;
+	struct cmd_function_s   *hashNext;
 	char                    *name;
 	xcommand_t function;
 } cmd_function_t;
 
+// completion trie, one node for every lowercased prefix of a command name
+typedef struct cmdTrieNode_s
+{
+	struct cmdTrieNode_s    *child;         // first node one character further in
+	struct cmdTrieNode_s    *sibling;       // next child of the same parent, sorted by c
+	cmd_function_t          *cmd;           // command whose name ends at this node
+	char c;
+} cmdTrieNode_t;
+
 
 static int cmd_argc;
 static char        *cmd_argv[MAX_STRING_TOKENS];        // points into cmd_tokenized
 static char cmd_tokenized[BIG_INFO_STRING + MAX_STRING_TOKENS];         // will have 0 bytes inserted
 static char cmd_cmd[BIG_INFO_STRING];         // the original command we received (no token processing)
 
+// the last line Cbuf_Execute tokenized, scripts tend to repeat the same lines
+static char cmd_cacheCmd[MAX_CMD_LINE];
+static char cmd_cacheTokenized[MAX_CMD_LINE + MAX_STRING_TOKENS];
+static int cmd_cacheArgv[MAX_STRING_TOKENS];
+static int cmd_cacheArgc = -1;
+static int cmd_cacheLength;
+
+#define CMD_HASH_SIZE       512
+
 static cmd_function_t  *cmd_functions;      // possible commands to execute
+static cmd_function_t  *cmd_hashTable[CMD_HASH_SIZE];
+static cmdTrieNode_t cmd_trie;
+
+/*
+================
+Cmd_HashValue
+
+Case insensitive, like the lookup in Cmd_ExecuteString
+================
+*/
+static int Cmd_HashValue( const char *name ) {
+	int i;
+	long hash;
+
+	hash = 0;
+	for ( i = 0 ; name[i] ; i++ ) {
+		hash += (long)( tolower( (unsigned char)name[i] ) ) * ( i + 119 );
+	}
+	return hash & ( CMD_HASH_SIZE - 1 );
+}
+
+/*
+============
+Cmd_FindCommand
+============
+*/
+static cmd_function_t *Cmd_FindCommand( const char *cmd_name ) {
+	cmd_function_t  *cmd;
+
+	for ( cmd = cmd_hashTable[Cmd_HashValue( cmd_name )] ; cmd ; cmd = cmd->hashNext ) {
+		if ( !Q_stricmp( cmd_name, cmd->name ) ) {
+			return cmd;
+		}
+	}
+	return NULL;
+}
+
+/*
+============
+Cmd_TrieInsert
+============
+*/
+static void Cmd_TrieInsert( cmd_function_t *cmd ) {
+	cmdTrieNode_t   *node, *child, **back;
+	const char      *s;
+	char c;
+
+	node = &cmd_trie;
+	for ( s = cmd->name ; *s ; s++ ) {
+		c = tolower( (unsigned char)*s );
+		for ( back = &node->child ; ( child = *back ) && child->c < c ; back = &child->sibling ) {
+		}
+		if ( !child || child->c != c ) {
+			child = S_Malloc( sizeof( cmdTrieNode_t ) );
+			child->child = NULL;
+			child->sibling = *back;
+			child->cmd = NULL;
+			child->c = c;
+			*back = child;
+		}
+		node = child;
+	}
+	node->cmd = cmd;
+}
+
+/*
+============
+Cmd_TrieRemove
+
+Clears the command ending below parent and frees the nodes
+no other command goes through
+============
+*/
+static void Cmd_TrieRemove( cmdTrieNode_t *parent, const char *s ) {
+	cmdTrieNode_t   *node, **back;
+	char c;
+
+	if ( !*s ) {
+		parent->cmd = NULL;
+		return;
+	}
+
+	c = tolower( (unsigned char)*s );
+	for ( back = &parent->child ; ( node = *back ) ; back = &node->sibling ) {
+		if ( node->c == c ) {
+			break;
+		}
+	}
+	if ( !node ) {
+		return;
+	}
+
+	Cmd_TrieRemove( node, s + 1 );
+	if ( !node->cmd && !node->child ) {
+		*back = node->sibling;
+		Z_Free( node );
+	}
+}
+
+/*
+============
+Cmd_TrieWalk
+
+Calls back every command at or below node in alphabetical order
+============
+*/
+static void Cmd_TrieWalk( cmdTrieNode_t *node, void ( *callback )(const char *s) ) {
+	if ( node->cmd ) {
+		callback( node->cmd->name );
+	}
+	for ( node = node->child ; node ; node = node->sibling ) {
+		Cmd_TrieWalk( node, callback );
+	}
+}
 
 /*
 ============
@@ -362,6 +524,29 @@ void    Cmd_ArgvBuffer( int arg, char *buffer, int bufferLength ) {
 }
 
 
+/*
+============
+Cmd_ConcatArgs
+============
+*/
+static void Cmd_ConcatArgs( char *buffer, int bufferLength, int arg ) {
+	char    *out, *end;
+	char    *in;
+	int i;
+
+	out = buffer;
+	end = buffer + bufferLength - 1;
+	for ( i = arg ; i < cmd_argc && out < end ; i++ ) {
+		for ( in = cmd_argv[i] ; *in && out < end ; ) {
+			*out++ = *in++;
+		}
+		if ( i != cmd_argc - 1 && out < end ) {
+			*out++ = ' ';
+		}
+	}
+	*out = 0;
+}
+
 /*
 ============
 Cmd_Args
@@ -371,16 +556,8 @@ Returns a single string containing argv(1) to argv(argc()-1)
 */
 char    *Cmd_Args( void ) {
 	static char cmd_args[MAX_STRING_CHARS];
-	int i;
-
-	cmd_args[0] = 0;
-	for ( i = 1 ; i < cmd_argc ; i++ ) {
-		strcat( cmd_args, cmd_argv[i] );
-		if ( i != cmd_argc - 1 ) {
-			strcat( cmd_args, " " );
-		}
-	}
 
+	Cmd_ConcatArgs( cmd_args, sizeof( cmd_args ), 1 );
 	return cmd_args;
 }
 
@@ -393,19 +570,11 @@ Returns a single string containing argv(arg) to argv(argc()-1)
 */
 char *Cmd_ArgsFrom( int arg ) {
 	static char cmd_args[BIG_INFO_STRING];
-	int i;
 
-	cmd_args[0] = 0;
 	if ( arg < 0 ) {
 		arg = 0;
 	}
-	for ( i = arg ; i < cmd_argc ; i++ ) {
-		strcat( cmd_args, cmd_argv[i] );
-		if ( i != cmd_argc - 1 ) {
-			strcat( cmd_args, " " );
-		}
-	}
-
+	Cmd_ConcatArgs( cmd_args, sizeof( cmd_args ), arg );
 	return cmd_args;
 }
 
@@ -436,7 +605,7 @@ char *Cmd_Cmd() {
 
 /*
 ============
-Cmd_TokenizeString
+Cmd_TokenizeText
 
 Parses the given string into command line tokens.
 The text is copied to a seperate buffer and 0 characters
@@ -444,7 +613,7 @@ are inserted in the apropriate place, The argv array
 will point into this temporary buffer.
 ============
 */
-void Cmd_TokenizeString( const char *text_in ) {
+static void Cmd_TokenizeText( const char *text_in ) {
 	const char  *text;
 	char    *textOut;
 
@@ -547,6 +716,53 @@ void Cmd_TokenizeString( const char *text_in ) {
 }
 
 
+/*
+============
+Cmd_TokenizeString
+
+Lines run by Cbuf_Execute are checked against the last one it
+tokenized first, the argv strings are handed out as writable pointers
+so a cache hit restores them from a separate copy
+============
+*/
+void Cmd_TokenizeString( const char *text_in ) {
+	qboolean useCache;
+	int i;
+
+	// only the line itself, not whatever the command tokenizes in turn
+	useCache = cmd_tokenCache;
+	cmd_tokenCache = qfalse;
+
+	if ( useCache && cmd_cacheArgc >= 0 && text_in && !strcmp( text_in, cmd_cacheCmd ) ) {
+		Q_strncpyz( cmd_cmd, text_in, sizeof( cmd_cmd ) );
+		memcpy( cmd_tokenized, cmd_cacheTokenized, cmd_cacheLength );
+		cmd_argc = cmd_cacheArgc;
+		for ( i = 0 ; i < cmd_argc ; i++ ) {
+			cmd_argv[i] = cmd_tokenized + cmd_cacheArgv[i];
+		}
+		return;
+	}
+
+	Cmd_TokenizeText( text_in );
+
+	if ( !useCache || !text_in || strlen( text_in ) >= sizeof( cmd_cacheCmd ) ) {
+		return;
+	}
+
+	// tokens are never longer than the text they came from
+	cmd_cacheLength = 0;
+	if ( cmd_argc ) {
+		cmd_cacheLength = cmd_argv[cmd_argc - 1] + strlen( cmd_argv[cmd_argc - 1] ) + 1 - cmd_tokenized;
+	}
+	memcpy( cmd_cacheTokenized, cmd_tokenized, cmd_cacheLength );
+	for ( i = 0 ; i < cmd_argc ; i++ ) {
+		cmd_cacheArgv[i] = cmd_argv[i] - cmd_tokenized;
+	}
+	cmd_cacheArgc = cmd_argc;
+	strcpy( cmd_cacheCmd, text_in );
+}
+
+
 /*
 ============
 Cmd_AddCommand
@@ -554,16 +770,15 @@ Cmd_AddCommand
 */
 void    Cmd_AddCommand( const char *cmd_name, xcommand_t function ) {
 	cmd_function_t  *cmd;
+	int hash;
 
 	// fail if the command already exists
-	for ( cmd = cmd_functions ; cmd ; cmd = cmd->next ) {
-		if ( !strcmp( cmd_name, cmd->name ) ) {
-			// allow completion-only commands to be silently doubled
-			if ( function != NULL ) {
-				Com_Printf( "Cmd_AddCommand: %s already defined\n", cmd_name );
-			}
-			return;
+	if ( Cmd_FindCommand( cmd_name ) ) {
+		// allow completion-only commands to be silently doubled
+		if ( function != NULL ) {
+			Com_Printf( "Cmd_AddCommand: %s already defined\n", cmd_name );
 		}
+		return;
 	}
 
 	// use a small malloc to avoid zone fragmentation
@@ -572,6 +787,12 @@ void    Cmd_AddCommand( const char *cmd_name, xcommand_t function ) {
 	cmd->function = function;
 	cmd->next = cmd_functions;
 	cmd_functions = cmd;
+
+	hash = Cmd_HashValue( cmd_name );
+	cmd->hashNext = cmd_hashTable[hash];
+	cmd_hashTable[hash] = cmd;
+
+	Cmd_TrieInsert( cmd );
 }
 
 /*
@@ -582,23 +803,26 @@ Cmd_RemoveCommand
 void    Cmd_RemoveCommand( const char *cmd_name ) {
 	cmd_function_t  *cmd, **back;
 
-	back = &cmd_functions;
-	while ( 1 ) {
-		cmd = *back;
-		if ( !cmd ) {
-			// command wasn't active
-			return;
-		}
-		if ( !strcmp( cmd_name, cmd->name ) ) {
-			*back = cmd->next;
-			if ( cmd->name ) {
-				Z_Free( cmd->name );
-			}
-			Z_Free( cmd );
-			return;
-		}
-		back = &cmd->next;
+	cmd = Cmd_FindCommand( cmd_name );
+	if ( !cmd ) {
+		// command wasn't active
+		return;
+	}
+
+	for ( back = &cmd_hashTable[Cmd_HashValue( cmd_name )] ; *back != cmd ; back = &( *back )->hashNext ) {
+	}
+	*back = cmd->hashNext;
+
+	for ( back = &cmd_functions ; *back != cmd ; back = &( *back )->next ) {
+	}
+	*back = cmd->next;
+
+	Cmd_TrieRemove( &cmd_trie, cmd->name );
+
+	if ( cmd->name ) {
+		Z_Free( cmd->name );
 	}
+	Z_Free( cmd );
 }
 
 
@@ -608,11 +832,30 @@ Cmd_CommandCompletion
 ============
 */
 void    Cmd_CommandCompletion( void ( *callback )(const char *s) ) {
-	cmd_function_t  *cmd;
+	Cmd_TrieWalk( &cmd_trie, callback );
+}
 
-	for ( cmd = cmd_functions ; cmd ; cmd = cmd->next ) {
-		callback( cmd->name );
+/*
+============
+Cmd_CommandCompletionPrefix
+
+Only calls back the commands starting with prefix, ignoring case
+============
+*/
+void    Cmd_CommandCompletionPrefix( const char *prefix, void ( *callback )(const char *s) ) {
+	cmdTrieNode_t   *node;
+	char c;
+
+	node = &cmd_trie;
+	for ( ; *prefix ; prefix++ ) {
+		c = tolower( (unsigned char)*prefix );
+		for ( node = node->child ; node && node->c < c ; node = node->sibling ) {
+		}
+		if ( !node || node->c != c ) {
+			return;
+		}
 	}
+	Cmd_TrieWalk( node, callback );
 }
 
 
@@ -624,7 +867,7 @@ A complete command line has been parsed, so try to execute it
 ============
 */
 void    Cmd_ExecuteString( const char *text ) {
-	cmd_function_t  *cmd, **prev;
+	cmd_function_t  *cmd;
 
 	// execute the command line
 	Cmd_TokenizeString( text );
@@ -633,25 +876,13 @@ void    Cmd_ExecuteString( const char *text ) {
 	}
 
 	// check registered command functions
-	for ( prev = &cmd_functions ; *prev ; prev = &cmd->next ) {
-		cmd = *prev;
-		if ( !Q_stricmp( cmd_argv[0],cmd->name ) ) {
-			// rearrange the links so that the command will be
-			// near the head of the list next time it is used
-			*prev = cmd->next;
-			cmd->next = cmd_functions;
-			cmd_functions = cmd;
-
-			// perform the action
-			if ( !cmd->function ) {
-				// let the cgame or game handle it
-				break;
-			} else {
-				cmd->function();
-			}
-			return;
-		}
+	cmd = Cmd_FindCommand( cmd_argv[0] );
+	if ( cmd && cmd->function ) {
+		// perform the action
+		cmd->function();
+		return;
 	}
+	// a command without a function is left for the cgame or game to handle
 
 	// check cvars
 	if ( Cvar_Command() ) {
@@ -118,6 +118,7 @@ int com_hunkusedvalue;
 
 qboolean com_errorEntered;
 qboolean com_fullyInitialized;
+qboolean com_workersActive;
 
 char com_errorMessage[MAXPRINTMSG];
 
@@ -784,7 +785,10 @@ int Com_RealTime( qtime_t *qtime ) {
 There is never any space between memblocks, and there will never be two
 contiguous free memblocks.
 
-The rover can be left pointing at a non-empty block
+Free blocks are kept in a tree ordered by size so allocations take the
+best fit instead of scanning the block list. Small allocations come from
+slabs, zone blocks cut into equal size chunks, so cvar and command strings
+and other short lived small blocks don't fragment the zone.
 
 The zone calls are pretty much only used for small strings and structures,
 all big things are allocated on the hunk.
@@ -794,6 +798,10 @@ all big things are allocated on the hunk.
 #define ZONEID  0x1d4a11
 #define MINFRAGMENT 64
 
+#define ZONE_SIZE_CLASSES   10
+#define ZONE_SLAB_SIZE      4096
+#define TAG_SLAB            ( TAG_STATIC + 1 )    // zone block cut into chunks
+
 typedef struct zonedebug_s {
 	char *label;
 	char *file;
@@ -801,6 +809,8 @@ typedef struct zonedebug_s {
 	int allocSize;
 } zonedebug_t;
 
+// slab chunks have a NULL prev, next is their slab while in use and
+// the next free chunk while free
 typedef struct memblock_s {
 	int size;               // including the header and possibly tiny fragments
 	int tag;                // a tag of 0 is a free block
@@ -811,11 +821,29 @@ typedef struct memblock_s {
 #endif
 } memblock_t;
 
+// follows the memblock_t of a TAG_SLAB block
+typedef struct zoneSlab_s {
+	struct zoneSlab_s   *next, *prev;   // slabs of the size class with free chunks
+	memblock_t          *freeChunks;
+	int sizeClass;
+	int numChunks;
+	int numUsed;
+} zoneSlab_t;
+
+// tree links, stored in the memory of a free block
+typedef struct {
+	memblock_t  *left, *right;
+} zoneFreeLinks_t;
+
+#define FREELINKS( block )  ( (zoneFreeLinks_t *)( (block) + 1 ) )
+
 typedef struct {
 	int size;               // total bytes malloced, including header
 	int used;               // total bytes used
 	memblock_t blocklist;   // start / end cap for linked list
-	memblock_t  *rover;
+	memblock_t  *rover;     // Z_FreeTags cursor
+	memblock_t  *freeTree;  // free blocks by size and address
+	zoneSlab_t  *slabs[ZONE_SIZE_CLASSES];    // slabs with free chunks
 } memzone_t;
 
 // main zone for all "dynamic" memory allocation
@@ -824,9 +852,137 @@ memzone_t   *mainzone;
 // fragment the main zone (think of cvar and cmd strings)
 memzone_t   *smallzone;
 
+// largest request of each size class
+static const int zoneClassPayload[ZONE_SIZE_CLASSES] = { 8, 16, 24, 32, 48, 64, 96, 128, 192, 256 };
+static int zoneChunkSize[ZONE_SIZE_CLASSES];
+static byte zoneSizeClass[256 / 8 + 1];         // ( size + 7 ) / 8 -> size class
+
 
 void Z_CheckHeap( void );
 
+/*
+========================
+Z_TreePriority
+
+The free tree is a treap, priorities come from a hash of the address
+========================
+*/
+static unsigned int Z_TreePriority( memblock_t *block ) {
+	unsigned int v;
+
+	v = (unsigned int)( (size_t)block >> 2 ) * 2654435761u;
+	return v ^ ( v >> 15 );
+}
+
+static qboolean Z_TreeLess( memblock_t *a, memblock_t *b ) {
+	if ( a->size != b->size ) {
+		return a->size < b->size;
+	}
+	return a < b;
+}
+
+static void Z_TreeRotateRight( memblock_t **node ) {
+	memblock_t  *left;
+
+	left = FREELINKS( *node )->left;
+	FREELINKS( *node )->left = FREELINKS( left )->right;
+	FREELINKS( left )->right = *node;
+	*node = left;
+}
+
+static void Z_TreeRotateLeft( memblock_t **node ) {
+	memblock_t  *right;
+
+	right = FREELINKS( *node )->right;
+	FREELINKS( *node )->right = FREELINKS( right )->left;
+	FREELINKS( right )->left = *node;
+	*node = right;
+}
+
+/*
+========================
+Z_TreeInsert
+========================
+*/
+static void Z_TreeInsert( memblock_t **node, memblock_t *block ) {
+	if ( !*node ) {
+		FREELINKS( block )->left = FREELINKS( block )->right = NULL;
+		*node = block;
+		return;
+	}
+
+	if ( Z_TreeLess( block, *node ) ) {
+		Z_TreeInsert( &FREELINKS( *node )->left, block );
+		if ( Z_TreePriority( FREELINKS( *node )->left ) > Z_TreePriority( *node ) ) {
+			Z_TreeRotateRight( node );
+		}
+	} else {
+		Z_TreeInsert( &FREELINKS( *node )->right, block );
+		if ( Z_TreePriority( FREELINKS( *node )->right ) > Z_TreePriority( *node ) ) {
+			Z_TreeRotateLeft( node );
+		}
+	}
+}
+
+/*
+========================
+Z_TreeRemove
+========================
+*/
+static void Z_TreeRemove( memblock_t **node, memblock_t *block ) {
+	memblock_t  *left, *right;
+
+	if ( !*node ) {
+		Com_Error( ERR_FATAL, "Z_TreeRemove: free block not in the tree" );
+	}
+
+	if ( *node != block ) {
+		if ( Z_TreeLess( block, *node ) ) {
+			Z_TreeRemove( &FREELINKS( *node )->left, block );
+		} else {
+			Z_TreeRemove( &FREELINKS( *node )->right, block );
+		}
+		return;
+	}
+
+	// rotate the block down until it has at most one child
+	left = FREELINKS( block )->left;
+	right = FREELINKS( block )->right;
+	if ( !left ) {
+		*node = right;
+	} else if ( !right ) {
+		*node = left;
+	} else if ( Z_TreePriority( left ) > Z_TreePriority( right ) ) {
+		Z_TreeRotateRight( node );
+		Z_TreeRemove( &FREELINKS( *node )->right, block );
+	} else {
+		Z_TreeRotateLeft( node );
+		Z_TreeRemove( &FREELINKS( *node )->left, block );
+	}
+}
+
+/*
+========================
+Z_TreeBestFit
+
+Smallest free block of at least size bytes
+========================
+*/
+static memblock_t *Z_TreeBestFit( memblock_t *node, int size ) {
+	memblock_t  *best;
+
+	best = NULL;
+	while ( node ) {
+		if ( node->size >= size ) {
+			best = node;
+			node = FREELINKS( node )->left;
+		} else {
+			node = FREELINKS( node )->right;
+		}
+	}
+	return best;
+}
+
 /*
 ========================
 Z_ClearZone
@@ -834,6 +990,18 @@ Z_ClearZone
 */
 void Z_ClearZone( memzone_t *zone, int size ) {
 	memblock_t  *block;
+	int i, c;
+
+	// size classes, a chunk is laid out like any other block
+	for ( i = 0, c = 0 ; i <= 256 / 8 ; i++ ) {
+		while ( zoneClassPayload[c] < i * 8 ) {
+			c++;
+		}
+		zoneSizeClass[i] = c;
+	}
+	for ( c = 0 ; c < ZONE_SIZE_CLASSES ; c++ ) {
+		zoneChunkSize[c] = ( sizeof( memblock_t ) + zoneClassPayload[c] + 4 + 3 ) & ~3;
+	}
 
 	// set the entire zone to one free block
 
@@ -845,13 +1013,216 @@ void Z_ClearZone( memzone_t *zone, int size ) {
 	zone->rover = block;
 	zone->size = size;
 	zone->used = 0;
+	zone->freeTree = NULL;
+	Com_Memset( zone->slabs, 0, sizeof( zone->slabs ) );
 
 	block->prev = block->next = &zone->blocklist;
 	block->tag = 0;         // free block
 	block->id = ZONEID;
 	block->size = size - sizeof( memzone_t );
+	Z_TreeInsert( &zone->freeTree, block );
 }
 
+/*
+========================
+Z_AllocBlock
+
+Best fit from the free tree, NULL if nothing is large enough
+========================
+*/
+static memblock_t *Z_AllocBlock( memzone_t *zone, int size, int tag ) {
+	int extra;
+	memblock_t  *base, *new;
+
+	base = Z_TreeBestFit( zone->freeTree, size );
+	if ( !base ) {
+		return NULL;
+	}
+	Z_TreeRemove( &zone->freeTree, base );
+
+	extra = base->size - size;
+	if ( extra > MINFRAGMENT ) {
+		// there will be a free fragment after the allocated block
+		new = ( memblock_t * )( (byte *)base + size );
+		new->size = extra;
+		new->tag = 0;           // free block
+		new->prev = base;
+		new->id = ZONEID;
+		new->next = base->next;
+		new->next->prev = new;
+		base->next = new;
+		base->size = size;
+		Z_TreeInsert( &zone->freeTree, new );
+	}
+
+	base->tag = tag;            // no longer a free block
+	base->id = ZONEID;
+	zone->used += base->size;
+
+	return base;
+}
+
+/*
+========================
+Z_FreeBlock
+========================
+*/
+static void Z_FreeBlock( memzone_t *zone, memblock_t *block ) {
+	memblock_t  *other;
+
+	zone->used -= block->size;
+	block->tag = 0;     // mark as free
+
+	other = block->prev;
+	if ( !other->tag ) {
+		// merge with previous free block
+		Z_TreeRemove( &zone->freeTree, other );
+		other->size += block->size;
+		other->next = block->next;
+		other->next->prev = other;
+		block = other;
+	}
+
+	other = block->next;
+	if ( !other->tag ) {
+		// merge the next free block onto the end
+		Z_TreeRemove( &zone->freeTree, other );
+		block->size += other->size;
+		block->next = other->next;
+		block->next->prev = block;
+	}
+
+	Z_TreeInsert( &zone->freeTree, block );
+
+	// Z_FreeTags continues from here
+	zone->rover = block;
+}
+
+/*
+========================
+Z_NewSlab
+========================
+*/
+static zoneSlab_t *Z_NewSlab( memzone_t *zone, int sizeClass ) {
+	memblock_t  *block, *chunk;
+	zoneSlab_t  *slab;
+	int i;
+
+	block = Z_AllocBlock( zone, ZONE_SLAB_SIZE, TAG_SLAB );
+	if ( !block ) {
+		return NULL;
+	}
+
+	slab = (zoneSlab_t *)( block + 1 );
+	slab->sizeClass = sizeClass;
+	slab->numUsed = 0;
+	slab->numChunks = ( block->size - sizeof( memblock_t ) - sizeof( zoneSlab_t ) ) / zoneChunkSize[sizeClass];
+	slab->freeChunks = NULL;
+
+	// free list in address order
+	for ( i = slab->numChunks - 1 ; i >= 0 ; i-- ) {
+		chunk = ( memblock_t * )( (byte *)( slab + 1 ) + i * zoneChunkSize[sizeClass] );
+		chunk->size = zoneChunkSize[sizeClass];
+		chunk->tag = 0;
+		chunk->id = ZONEID;
+		chunk->prev = NULL;
+		chunk->next = slab->freeChunks;
+		slab->freeChunks = chunk;
+	}
+
+	slab->prev = NULL;
+	slab->next = zone->slabs[sizeClass];
+	if ( slab->next ) {
+		slab->next->prev = slab;
+	}
+	zone->slabs[sizeClass] = slab;
+
+	return slab;
+}
+
+/*
+========================
+Z_UnlinkSlab
+========================
+*/
+static void Z_UnlinkSlab( memzone_t *zone, zoneSlab_t *slab ) {
+	if ( slab->prev ) {
+		slab->prev->next = slab->next;
+	} else {
+		zone->slabs[slab->sizeClass] = slab->next;
+	}
+	if ( slab->next ) {
+		slab->next->prev = slab->prev;
+	}
+	slab->next = slab->prev = NULL;
+}
+
+/*
+========================
+Z_AllocChunk
+========================
+*/
+static memblock_t *Z_AllocChunk( memzone_t *zone, int sizeClass, int tag ) {
+	zoneSlab_t  *slab;
+	memblock_t  *chunk;
+
+	slab = zone->slabs[sizeClass];
+	if ( !slab ) {
+		slab = Z_NewSlab( zone, sizeClass );
+		if ( !slab ) {
+			return NULL;
+		}
+	}
+
+	chunk = slab->freeChunks;
+	slab->freeChunks = chunk->next;
+	slab->numUsed++;
+	if ( !slab->freeChunks ) {
+		// full slabs aren't searched
+		Z_UnlinkSlab( zone, slab );
+	}
+
+	chunk->tag = tag;
+	chunk->next = (memblock_t *)slab;
+
+	return chunk;
+}
+
+/*
+========================
+Z_FreeChunk
+
+Returns qtrue if the slab was given back to the zone
+========================
+*/
+static qboolean Z_FreeChunk( memzone_t *zone, memblock_t *chunk ) {
+	zoneSlab_t  *slab;
+
+	slab = (zoneSlab_t *)chunk->next;
+	if ( !slab->freeChunks ) {
+		// was full
+		slab->prev = NULL;
+		slab->next = zone->slabs[slab->sizeClass];
+		if ( slab->next ) {
+			slab->next->prev = slab;
+		}
+		zone->slabs[slab->sizeClass] = slab;
+	}
+
+	chunk->tag = 0;
+	chunk->next = slab->freeChunks;
+	slab->freeChunks = chunk;
+	slab->numUsed--;
+
+	// keep the last slab of a size class around so a single string
+	// doesn't keep getting a new slab
+	if ( !slab->numUsed && ( slab->prev || slab->next ) ) {
+		Z_UnlinkSlab( zone, slab );
+		Z_FreeBlock( zone, (memblock_t *)slab - 1 );
+		return qtrue;
+	}
+	return qfalse;
+}
 
 /*
 ========================
@@ -859,7 +1230,7 @@ Z_Free
 ========================
 */
 void Z_Free( void *ptr ) {
-	memblock_t  *block, *other;
+	memblock_t  *block;
 	memzone_t *zone;
 
 	if ( !ptr ) {
@@ -889,40 +1260,48 @@ void Z_Free( void *ptr ) {
 		zone = mainzone;
 	}
 
-	zone->used -= block->size;
 	// set the block to something that should cause problems
 	// if it is referenced...
 	memset( ptr, 0xaa, block->size - sizeof( *block ) );
 
-	block->tag = 0;     // mark as free
-
-	other = block->prev;
-	if ( !other->tag ) {
-		// merge with previous free block
-		other->size += block->size;
-		other->next = block->next;
-		other->next->prev = other;
-		if ( block == zone->rover ) {
-			zone->rover = other;
-		}
-		block = other;
+	if ( !block->prev ) {
+		Z_FreeChunk( zone, block );
+	} else {
+		Z_FreeBlock( zone, block );
 	}
+}
 
-	zone->rover = block;
+/*
+================
+Z_FreeSlabTags
 
-	other = block->next;
-	if ( !other->tag ) {
-		// merge the next free block onto the end
-		block->size += other->size;
-		block->next = other->next;
-		block->next->prev = block;
-		if ( other == zone->rover ) {
-			zone->rover = block;
+Returns qtrue if the slab was given back to the zone
+================
+*/
+static qboolean Z_FreeSlabTags( memzone_t *zone, memblock_t *block, int tag ) {
+	zoneSlab_t  *slab;
+	memblock_t  *chunk;
+	int i, numChunks, chunkSize;
+
+	slab = (zoneSlab_t *)( block + 1 );
+	numChunks = slab->numChunks;
+	chunkSize = zoneChunkSize[slab->sizeClass];
+	for ( i = 0 ; i < numChunks ; i++ ) {
+		chunk = ( memblock_t * )( (byte *)( slab + 1 ) + i * chunkSize );
+		if ( chunk->tag != tag ) {
+			continue;
+		}
+		if ( *( int * )( (byte *)chunk + chunk->size - 4 ) != ZONEID ) {
+			Com_Error( ERR_FATAL, "Z_FreeTags: memory block wrote past end" );
+		}
+		memset( chunk + 1, 0xaa, chunk->size - sizeof( *chunk ) );
+		if ( Z_FreeChunk( zone, chunk ) ) {
+			return qtrue;
 		}
 	}
+	return qfalse;
 }
 
-
 /*
 ================
 Z_FreeTags
@@ -942,7 +1321,11 @@ void Z_FreeTags( int tag ) {
 	// Z_Free automatically adjusts it
 	zone->rover = zone->blocklist.next;
 	do {
-		if ( zone->rover->tag == tag ) {
+		if ( zone->rover->tag == TAG_SLAB ) {
+			if ( Z_FreeSlabTags( zone, zone->rover, tag ) ) {
+				continue;
+			}
+		} else if ( zone->rover->tag == tag ) {
 			count++;
 			Z_Free( ( void * )( zone->rover + 1 ) );
 			continue;
@@ -964,8 +1347,8 @@ void *Z_TagMallocDebug( int size, int tag, char *label, char *file, int line ) {
 #else
 void *Z_TagMalloc( int size, int tag ) {
 #endif
-	int extra, allocSize;
-	memblock_t  *start, *rover, *new, *base;
+	int allocSize;
+	memblock_t  *base;
 	memzone_t *zone;
 
 	if ( !tag ) {
@@ -979,58 +1362,30 @@ void *Z_TagMalloc( int size, int tag ) {
 	}
 
 	allocSize = size;
-	//
-	// scan through the block list looking for the first free block
-	// of sufficient size
-	//
 	size += sizeof( memblock_t ); // account for size of block header
 	size += 4;                  // space for memory trash tester
 	size = ( size + 3 ) & ~3;     // align to 32 bit boundary
 
-	base = rover = zone->rover;
-	start = base->prev;
-
-	do {
-		if ( rover == start ) {
+	base = NULL;
+	if ( allocSize >= 0 && allocSize <= zoneClassPayload[ZONE_SIZE_CLASSES - 1] ) {
+		base = Z_AllocChunk( zone, zoneSizeClass[( allocSize + 7 ) >> 3], tag );
+	}
+	if ( !base ) {
+		// a free block must be able to hold the tree links
+		if ( size < sizeof( memblock_t ) + sizeof( zoneFreeLinks_t ) ) {
+			size = sizeof( memblock_t ) + sizeof( zoneFreeLinks_t );
+		}
+		base = Z_AllocBlock( zone, size, tag );
+	}
+	if ( !base ) {
 #ifdef ZONE_DEBUG
-			Z_LogHeap();
+		Z_LogHeap();
 #endif
-			// scaned all the way around the list
-			Com_Error( ERR_FATAL, "Z_Malloc: failed on allocation of %i bytes from the %s zone",
-					   size, zone == smallzone ? "small" : "main" );
-			return NULL;
-		}
-		if ( rover->tag ) {
-			base = rover = rover->next;
-		} else {
-			rover = rover->next;
-		}
-	} while ( base->tag || base->size < size );
-
-	//
-	// found a block big enough
-	//
-	extra = base->size - size;
-	if ( extra > MINFRAGMENT ) {
-		// there will be a free fragment after the allocated block
-		new = ( memblock_t * )( (byte *)base + size );
-		new->size = extra;
-		new->tag = 0;           // free block
-		new->prev = base;
-		new->id = ZONEID;
-		new->next = base->next;
-		new->next->prev = new;
-		base->next = new;
-		base->size = size;
+		Com_Error( ERR_FATAL, "Z_Malloc: failed on allocation of %i bytes from the %s zone",
+				   size, zone == smallzone ? "small" : "main" );
+		return NULL;
 	}
 
-	base->tag = tag;            // no longer a free block
-
-	zone->rover = base->next;   // next allocation will start looking here
-	zone->used += base->size;   //
-
-	base->id = ZONEID;
-
 #ifdef ZONE_DEBUG
 	base->d.label = label;
 	base->d.file = file;
@@ -1104,17 +1459,104 @@ void Z_CheckHeap( void ) {
 
 /*
 ========================
-Z_LogZoneHeap
+Z_ZoneStats
+
+Totals for meminfo, looking inside the slabs
 ========================
 */
-void Z_LogZoneHeap( memzone_t *zone, char *name ) {
+typedef struct {
+	int usedBytes;          // handed out, including headers
+	int usedBlocks;
+	int botlibBytes;
+	int rendererBytes;
+	int freeBytes;
+	int freeBlocks;
+	int largestFree;
+	int slabs;
+	int slabBytes;          // zone blocks given to slabs
+	int slabUsedBytes;      // chunks in use
+} zoneStats_t;
+
+static void Z_CountBlock( zoneStats_t *stats, memblock_t *block ) {
+	stats->usedBytes += block->size;
+	stats->usedBlocks++;
+	if ( block->tag == TAG_BOTLIB ) {
+		stats->botlibBytes += block->size;
+	} else if ( block->tag == TAG_RENDERER ) {
+		stats->rendererBytes += block->size;
+	}
+}
+
+static void Z_ZoneStats( memzone_t *zone, zoneStats_t *stats ) {
+	memblock_t  *block, *chunk;
+	zoneSlab_t  *slab;
+	int i;
+
+	Com_Memset( stats, 0, sizeof( *stats ) );
+	for ( block = zone->blocklist.next ; block != &zone->blocklist ; block = block->next ) {
+		if ( !block->tag ) {
+			stats->freeBytes += block->size;
+			stats->freeBlocks++;
+			if ( block->size > stats->largestFree ) {
+				stats->largestFree = block->size;
+			}
+		} else if ( block->tag == TAG_SLAB ) {
+			slab = (zoneSlab_t *)( block + 1 );
+			stats->slabs++;
+			stats->slabBytes += block->size;
+			for ( i = 0 ; i < slab->numChunks ; i++ ) {
+				chunk = ( memblock_t * )( (byte *)( slab + 1 ) + i * zoneChunkSize[slab->sizeClass] );
+				if ( chunk->tag ) {
+					Z_CountBlock( stats, chunk );
+					stats->slabUsedBytes += chunk->size;
+				}
+			}
+		} else {
+			Z_CountBlock( stats, block );
+		}
+	}
+}
+
+/*
+========================
+Z_LogBlock
+========================
+*/
+static void Z_LogBlock( memblock_t *block, int *size, int *allocSize, int *numBlocks ) {
 #ifdef ZONE_DEBUG
+	char buf[4096];
 	char dump[32], *ptr;
 	int i, j;
+
+	ptr = ( (char *) block ) + sizeof( memblock_t );
+	j = 0;
+	for ( i = 0; i < 20 && i < block->d.allocSize; i++ ) {
+		if ( ptr[i] >= 32 && ptr[i] < 127 ) {
+			dump[j++] = ptr[i];
+		} else {
+			dump[j++] = '_';
+		}
+	}
+	dump[j] = '\0';
+	Com_sprintf( buf, sizeof( buf ), "size = %8d: %s, line: %d (%s) [%s]\r\n", block->d.allocSize, block->d.file, block->d.line, block->d.label, dump );
+	FS_Write( buf, strlen( buf ), logfile );
+	*allocSize += block->d.allocSize;
 #endif
-	memblock_t  *block;
+	*size += block->size;
+	( *numBlocks )++;
+}
+
+/*
+========================
+Z_LogZoneHeap
+========================
+*/
+void Z_LogZoneHeap( memzone_t *zone, char *name ) {
+	memblock_t  *block, *chunk;
+	zoneSlab_t  *slab;
 	char buf[4096];
 	int size, allocSize, numBlocks;
+	int i;
 
 	if ( !logfile || !FS_Initialized() ) {
 		return;
@@ -1123,24 +1565,16 @@ void Z_LogZoneHeap( memzone_t *zone, char *name ) {
 	Com_sprintf( buf, sizeof( buf ), "\r\n================\r\n%s log\r\n================\r\n", name );
 	FS_Write( buf, strlen( buf ), logfile );
 	for ( block = zone->blocklist.next ; block->next != &zone->blocklist; block = block->next ) {
-		if ( block->tag ) {
-#ifdef ZONE_DEBUG
-			ptr = ( (char *) block ) + sizeof( memblock_t );
-			j = 0;
-			for ( i = 0; i < 20 && i < block->d.allocSize; i++ ) {
-				if ( ptr[i] >= 32 && ptr[i] < 127 ) {
-					dump[j++] = ptr[i];
-				} else {
-					dump[j++] = '_';
+		if ( block->tag == TAG_SLAB ) {
+			slab = (zoneSlab_t *)( block + 1 );
+			for ( i = 0 ; i < slab->numChunks ; i++ ) {
+				chunk = ( memblock_t * )( (byte *)( slab + 1 ) + i * zoneChunkSize[slab->sizeClass] );
+				if ( chunk->tag ) {
+					Z_LogBlock( chunk, &size, &allocSize, &numBlocks );
 				}
 			}
-			dump[j] = '\0';
-			Com_sprintf( buf, sizeof( buf ), "size = %8d: %s, line: %d (%s) [%s]\r\n", block->d.allocSize, block->d.file, block->d.line, block->d.label, dump );
-			FS_Write( buf, strlen( buf ), logfile );
-			allocSize += block->d.allocSize;
-#endif
-			size += block->size;
-			numBlocks++;
+		} else if ( block->tag ) {
+			Z_LogBlock( block, &size, &allocSize, &numBlocks );
 		}
 	}
 #ifdef ZONE_DEBUG
@@ -1288,29 +1722,14 @@ Com_Meminfo_f
 */
 void Com_Meminfo_f( void ) {
 	memblock_t  *block;
-	int zoneBytes, zoneBlocks;
-	int smallZoneBytes, smallZoneBlocks;
-	int botlibBytes, rendererBytes;
+	zoneStats_t zone, small;
 	int unused;
 
-	zoneBytes = 0;
-	botlibBytes = 0;
-	rendererBytes = 0;
-	zoneBlocks = 0;
 	for ( block = mainzone->blocklist.next ; ; block = block->next ) {
 		if ( Cmd_Argc() != 1 ) {
 			Com_Printf( "block:%p    size:%7i    tag:%3i\n",
 						block, block->size, block->tag );
 		}
-		if ( block->tag ) {
-			zoneBytes += block->size;
-			zoneBlocks++;
-			if ( block->tag == TAG_BOTLIB ) {
-				botlibBytes += block->size;
-			} else if ( block->tag == TAG_RENDERER ) {
-				rendererBytes += block->size;
-			}
-		}
 
 		if ( block->next == &mainzone->blocklist ) {
 			break;          // all blocks have been hit
@@ -1326,18 +1745,8 @@ void Com_Meminfo_f( void ) {
 		}
 	}
 
-	smallZoneBytes = 0;
-	smallZoneBlocks = 0;
-	for ( block = smallzone->blocklist.next ; ; block = block->next ) {
-		if ( block->tag ) {
-			smallZoneBytes += block->size;
-			smallZoneBlocks++;
-		}
-
-		if ( block->next == &smallzone->blocklist ) {
-			break;          // all blocks have been hit
-		}
-	}
+	Z_ZoneStats( mainzone, &zone );
+	Z_ZoneStats( smallzone, &small );
 
 	Com_Printf( "%9i bytes (%6.2f MB) total hunk\n", s_hunkTotal, s_hunkTotal / Square( 1024.f ) );
 	Com_Printf( "%9i bytes (%6.2f MB) total zone\n", s_zoneTotal, s_zoneTotal / Square( 1024.f ) );
@@ -1366,11 +1775,18 @@ void Com_Meminfo_f( void ) {
 	}
 	Com_Printf( "%9i bytes (%6.2f MB) unused highwater\n", unused, unused / Square( 1024.f ) );
 	Com_Printf( "\n" );
-	Com_Printf( "%9i bytes (%6.2f MB) in %i zone blocks\n", zoneBytes, zoneBytes / Square( 1024.f ), zoneBlocks );
-	Com_Printf( "        %9i bytes (%6.2f MB) in dynamic botlib\n", botlibBytes, botlibBytes / Square( 1024.f ) );
-	Com_Printf( "        %9i bytes (%6.2f MB) in dynamic renderer\n", rendererBytes, rendererBytes / Square( 1024.f ) );
-	Com_Printf( "        %9i bytes (%6.2f MB) in dynamic other\n", zoneBytes - ( botlibBytes + rendererBytes ), ( zoneBytes - ( botlibBytes + rendererBytes ) ) / Square( 1024.f ) );
-	Com_Printf( "        %9i bytes (%6.2f MB) in small Zone memory\n", smallZoneBytes, smallZoneBytes / Square( 1024.f ) );
+	Com_Printf( "%9i bytes (%6.2f MB) in %i zone blocks\n", zone.usedBytes, zone.usedBytes / Square( 1024.f ), zone.usedBlocks );
+	Com_Printf( "        %9i bytes (%6.2f MB) in dynamic botlib\n", zone.botlibBytes, zone.botlibBytes / Square( 1024.f ) );
+	Com_Printf( "        %9i bytes (%6.2f MB) in dynamic renderer\n", zone.rendererBytes, zone.rendererBytes / Square( 1024.f ) );
+	Com_Printf( "        %9i bytes (%6.2f MB) in dynamic other\n", zone.usedBytes - ( zone.botlibBytes + zone.rendererBytes ), ( zone.usedBytes - ( zone.botlibBytes + zone.rendererBytes ) ) / Square( 1024.f ) );
+	Com_Printf( "        %9i bytes (%6.2f MB) in small Zone memory\n", small.usedBytes, small.usedBytes / Square( 1024.f ) );
+	Com_Printf( "\n" );
+	Com_Printf( "main zone:  %9i bytes free in %i blocks, largest %i (%.1f%% fragmented)\n", zone.freeBytes, zone.freeBlocks, zone.largestFree,
+				zone.freeBytes ? 100.0f * ( zone.freeBytes - zone.largestFree ) / zone.freeBytes : 0.0f );
+	Com_Printf( "            %9i bytes in %i slabs, %i in use\n", zone.slabBytes, zone.slabs, zone.slabUsedBytes );
+	Com_Printf( "small zone: %9i bytes free in %i blocks, largest %i (%.1f%% fragmented)\n", small.freeBytes, small.freeBlocks, small.largestFree,
+				small.freeBytes ? 100.0f * ( small.freeBytes - small.largestFree ) / small.freeBytes : 0.0f );
+	Com_Printf( "            %9i bytes in %i slabs, %i in use\n", small.slabBytes, small.slabs, small.slabUsedBytes );
 }
 
 /*
@@ -2121,7 +2537,7 @@ Com_RunAndTimeServerPacket
 =================
 */
 void Com_RunAndTimeServerPacket( netadr_t *evFrom, msg_t *buf ) {
-	int t1, t2, msec;
+	int t1, t2, msec, perfStart;
 
 	t1 = 0;
 
@@ -2129,7 +2545,9 @@ void Com_RunAndTimeServerPacket( netadr_t *evFrom, msg_t *buf ) {
 		t1 = Sys_Milliseconds();
 	}
 
+	perfStart = Perf_Begin();
 	SV_PacketEvent( *evFrom, buf );
+	Perf_End( PERF_PACKET_EVENT, perfStart );
 
 	if ( com_speeds->integer ) {
 		t2 = Sys_Milliseconds();
@@ -2846,6 +3264,7 @@ void Com_Init( char *commandLine ) {
 	com_dropsim = Cvar_Get( "com_dropsim", "0", CVAR_CHEAT );
 	com_viewlog = Cvar_Get( "viewlog", "0", CVAR_CHEAT );
 	com_speeds = Cvar_Get( "com_speeds", "0", 0 );
+	Perf_Init();
 	com_timedemo = Cvar_Get( "timedemo", "0", CVAR_CHEAT );
 	com_cameraMode = Cvar_Get( "com_cameraMode", "0", CVAR_CHEAT );
 
@@ -2884,6 +3303,9 @@ void Com_Init( char *commandLine ) {
 		Cmd_AddCommand( "crash", Com_Crash_f );
 		Cmd_AddCommand( "freeze", Com_Freeze_f );
 		Cmd_AddCommand( "cpuspeed", Com_CPUSpeed_f );
+		Cmd_AddCommand( "huffbench", MSG_HuffmanBench_f );
+		Cmd_AddCommand( "tracebench", CM_TraceBench_f );
+		Cmd_AddCommand( "vmbench", VM_Bench_f );
 	}
 	Cmd_AddCommand( "quit", Com_Quit_f );
 	Cmd_AddCommand( "changeVectors", MSG_ReportChangeVectors_f );
@@ -3294,6 +3716,8 @@ void Com_Shutdown( qboolean badProfile ) {
 		FS_FCloseFile( com_journalFile );
 		com_journalFile = 0;
 	}
+
+	Perf_Shutdown();
 }
 
 #if !( defined __linux__ || defined __FreeBSD__ )  // r010123 - include FreeBSD
@@ -3758,7 +4182,7 @@ void Field_CompleteCommand( field_t *field ) {
 		return;
 	}
 
-	Cmd_CommandCompletion( FindMatches );
+	Cmd_CommandCompletionPrefix( completionString, FindMatches );
 	Cvar_CommandCompletion( FindMatches );
 
 	if ( matchCount == 0 ) {
@@ -3786,7 +4210,7 @@ void Field_CompleteCommand( field_t *field ) {
 	Com_Printf( "]%s\n", completionField->buffer );
 
 	// run through again, printing matches
-	Cmd_CommandCompletion( PrintMatches );
+	Cmd_CommandCompletionPrefix( shortestMatch, PrintMatches );
 	Cvar_CommandCompletion( PrintMatches );
 }
 
@@ -261,11 +261,14 @@ static cvar_t      *fs_cdpath;
 static cvar_t      *fs_copyfiles;
 static cvar_t      *fs_gamedirvar;
 static cvar_t      *fs_restrict;
+static cvar_t      *fs_mapPaks;
+static cvar_t      *fs_pakIndex;
 static searchpath_t    *fs_searchpaths;
 static int fs_readCount;                    // total bytes read
 static int fs_loadCount;                    // total files read
 static int fs_loadStack;                    // total files in memory
 static int fs_packFiles;                    // total number of files in packs
+static int fs_mappedPaks;                   // total number of packs read through a mapping
 
 static int fs_fakeChkSum;
 static int fs_checksumFeed;
@@ -910,6 +913,34 @@ fileHandle_t FS_FOpenFileWrite( const char *filename ) {
 	return f;
 }
 
+/*
+===========
+FS_FOpenRawFileWrite
+
+Opens the file in the write directory without taking a handle, so it can
+be written from other threads with plain stdio calls
+===========
+*/
+FILE *FS_FOpenRawFileWrite( const char *filename ) {
+	char            *ospath;
+
+	if ( !fs_searchpaths ) {
+		Com_Error( ERR_FATAL, "Filesystem call made without initialization\n" );
+	}
+
+	ospath = FS_BuildOSPath( fs_homepath->string, fs_gamedir, filename );
+
+	if ( fs_debug->integer ) {
+		Com_Printf( "FS_FOpenRawFileWrite: %s\n", ospath );
+	}
+
+	if ( FS_CreatePath( ospath ) ) {
+		return NULL;
+	}
+
+	return fopen( ospath, "wb" );
+}
+
 /*
 ===========
 FS_FOpenFileAppend
@@ -2119,6 +2150,47 @@ void FS_FreeFile( void *buffer ) {
 	}
 }
 
+/*
+=============
+FS_MapFile
+
+Maps a file from the home directory, where FS_FOpenFileWrite puts
+generated data, read only.  Returns NULL if there is no such file or
+it can't be mapped, the caller should read it through the search path
+then.  Directory files are only used when a pure server allows them,
+same as in FS_FOpenFileRead.
+=============
+*/
+void *FS_MapFile( const char *qpath, int *length ) {
+	char    *ospath;
+
+	if ( !fs_searchpaths ) {
+		Com_Error( ERR_FATAL, "Filesystem call made without initialization\n" );
+	}
+	if ( !qpath || !qpath[0] ) {
+		Com_Error( ERR_FATAL, "FS_MapFile with empty name\n" );
+	}
+
+	if ( fs_restrict->integer || fs_numServerPaks ) {
+		return NULL;
+	}
+
+	ospath = FS_BuildOSPath( fs_homepath->string, fs_gamedir, qpath );
+	if ( fs_debug->integer ) {
+		Com_Printf( "FS_MapFile: %s\n", ospath );
+	}
+	return Sys_MapFile( ospath, length );
+}
+
+/*
+=============
+FS_UnmapFile
+=============
+*/
+void FS_UnmapFile( void *data, int length ) {
+	Sys_UnmapFile( data, length );
+}
+
 /*
 ============
 FS_WriteFile
@@ -2158,6 +2230,306 @@ ZIP FILE LOADING
 ==========================================================================
 */
 
+/*
+=================================================================================
+
+PK3 INDEX CACHE
+
+pk3index.dat in the home path keeps the file list and header checksums of
+every pk3 loaded by the last FS_Startup, keyed by path, size and modification
+time, so FS_LoadZipFile can skip walking the central directory of pk3 files
+that didn't change.
+
+=================================================================================
+*/
+
+#define PAKINDEX_IDENT      ( ( 'X' << 24 ) + ( 'I' << 16 ) + ( 'K' << 8 ) + 'P' )
+#define PAKINDEX_VERSION    1
+#define PAKINDEX_NAME       "pk3index.dat"
+
+// every record is ints followed by data padded to a multiple of 4 bytes
+typedef struct {
+	int pathLen;
+	int size;
+	int mtime;
+	int numfiles;
+	int numHeaderLongs;
+	int namesLen;
+	// char path[pathLen];
+	// int pos[numfiles];
+	// int headerLongs[numHeaderLongs];
+	// char names[namesLen];
+} pakIndexRecord_t;
+
+typedef struct {
+	const pakIndexRecord_t  *record;
+	const char              *path;
+	const int               *pos;
+	const int               *headerLongs;
+	const char              *names;
+} pakIndexEntry_t;
+
+static int             *fs_pakIndexData;        // index read at FS_Startup
+static pakIndexEntry_t *fs_pakIndexEntries;
+static int fs_numPakIndexEntries;
+
+static byte            *fs_newPakIndex;         // index of the pk3 files loaded by this FS_Startup
+static int fs_newPakIndexSize;
+static int fs_newPakIndexMax;
+static int fs_numNewPakIndexEntries;
+static qboolean fs_pakIndexActive;              // FS_Startup is building a new index
+static qboolean fs_pakIndexDirty;
+
+/*
+=================
+FS_LoadPakIndex
+
+Reads the whole index in one go, any inconsistency discards it
+=================
+*/
+static void FS_LoadPakIndex( void ) {
+	const pakIndexRecord_t *record;
+	pakIndexEntry_t *entry;
+	const char      *names, *end;
+	char            *ospath;
+	FILE            *f;
+	int len, ofs, count, i, j;
+
+	fs_pakIndexData = NULL;
+	fs_pakIndexEntries = NULL;
+	fs_numPakIndexEntries = 0;
+	fs_pakIndexActive = qtrue;
+
+	ospath = FS_BuildOSPath( fs_homepath->string, BASEGAME, PAKINDEX_NAME );
+	f = fopen( ospath, "rb" );
+	if ( !f ) {
+		return;
+	}
+
+	fseek( f, 0, SEEK_END );
+	len = ftell( f );
+	fseek( f, 0, SEEK_SET );
+	if ( len < (int)( 3 * sizeof( int ) ) || len & 3 ) {
+		fclose( f );
+		return;
+	}
+
+	fs_pakIndexData = Z_Malloc( len );
+	if ( fread( fs_pakIndexData, len, 1, f ) != 1 ) {
+		fclose( f );
+		goto discard;
+	}
+	fclose( f );
+
+	count = fs_pakIndexData[2];
+	if ( fs_pakIndexData[0] != PAKINDEX_IDENT || fs_pakIndexData[1] != PAKINDEX_VERSION || count <= 0 || count > len ) {
+		goto discard;
+	}
+
+	fs_pakIndexEntries = Z_Malloc( count * sizeof( pakIndexEntry_t ) );
+	ofs = 3 * sizeof( int );
+
+	for ( i = 0, entry = fs_pakIndexEntries; i < count; i++, entry++ ) {
+		if ( len - ofs < (int)sizeof( pakIndexRecord_t ) ) {
+			goto discard;
+		}
+		record = ( pakIndexRecord_t * )( (byte *)fs_pakIndexData + ofs );
+		ofs += sizeof( pakIndexRecord_t );
+
+		if ( record->pathLen <= 0 || record->numfiles <= 0 || record->namesLen <= 0
+			 || record->numHeaderLongs < 0 || record->numHeaderLongs > record->numfiles
+			 || ( record->pathLen & 3 ) || ( record->namesLen & 3 ) ) {
+			goto discard;
+		}
+		if ( record->pathLen > len - ofs ) {
+			goto discard;
+		}
+		entry->record = record;
+		entry->path = (char *)fs_pakIndexData + ofs;
+		ofs += record->pathLen;
+
+		if ( record->numfiles > ( len - ofs ) / 4 ) {
+			goto discard;
+		}
+		entry->pos = ( int * )( (byte *)fs_pakIndexData + ofs );
+		ofs += record->numfiles * 4;
+
+		if ( record->numHeaderLongs > ( len - ofs ) / 4 ) {
+			goto discard;
+		}
+		entry->headerLongs = ( int * )( (byte *)fs_pakIndexData + ofs );
+		ofs += record->numHeaderLongs * 4;
+
+		if ( record->namesLen > len - ofs ) {
+			goto discard;
+		}
+		entry->names = (char *)fs_pakIndexData + ofs;
+		ofs += record->namesLen;
+
+		// the path and every name have to be terminated inside the record
+		if ( entry->path[record->pathLen - 1] ) {
+			goto discard;
+		}
+		names = entry->names;
+		end = entry->names + record->namesLen;
+		for ( j = 0; j < record->numfiles; j++ ) {
+			while ( names < end && *names ) {
+				names++;
+			}
+			if ( names == end ) {
+				goto discard;
+			}
+			names++;
+		}
+	}
+
+	fs_numPakIndexEntries = count;
+	return;
+
+discard:
+	Com_DPrintf( "Discarding %s\n", ospath );
+	if ( fs_pakIndexEntries ) {
+		Z_Free( fs_pakIndexEntries );
+		fs_pakIndexEntries = NULL;
+	}
+	Z_Free( fs_pakIndexData );
+	fs_pakIndexData = NULL;
+}
+
+/*
+=================
+FS_FindPakIndex
+=================
+*/
+static const pakIndexEntry_t *FS_FindPakIndex( const char *zipfile, int size, int mtime ) {
+	const pakIndexEntry_t *entry;
+	int i;
+
+	for ( i = 0, entry = fs_pakIndexEntries; i < fs_numPakIndexEntries; i++, entry++ ) {
+		if ( entry->record->size == size && entry->record->mtime == mtime && !strcmp( entry->path, zipfile ) ) {
+			return entry;
+		}
+	}
+	return NULL;
+}
+
+/*
+=================
+FS_AppendPakIndex
+=================
+*/
+static void FS_AppendPakIndex( const void *data, int len ) {
+	byte    *buf;
+	int pad;
+
+	pad = ( 4 - ( len & 3 ) ) & 3;
+	if ( fs_newPakIndexSize + len + pad > fs_newPakIndexMax ) {
+		fs_newPakIndexMax = ( fs_newPakIndexSize + len + pad ) * 2;
+		buf = Z_Malloc( fs_newPakIndexMax );
+		if ( fs_newPakIndex ) {
+			Com_Memcpy( buf, fs_newPakIndex, fs_newPakIndexSize );
+			Z_Free( fs_newPakIndex );
+		}
+		fs_newPakIndex = buf;
+	}
+
+	Com_Memcpy( fs_newPakIndex + fs_newPakIndexSize, data, len );
+	Com_Memset( fs_newPakIndex + fs_newPakIndexSize + len, 0, pad );
+	fs_newPakIndexSize += len + pad;
+}
+
+/*
+=================
+FS_AddPakIndex
+
+Records a loaded pk3 for the index written at the end of FS_Startup
+=================
+*/
+static void FS_AddPakIndex( const char *zipfile, int size, int mtime, const pack_t *pack, const int *headerLongs, int numHeaderLongs ) {
+	pakIndexRecord_t record;
+	char    *names, *namePtr;
+	int i, len;
+	int pos;
+
+	len = 0;
+	for ( i = 0; i < pack->numfiles; i++ ) {
+		len += strlen( pack->buildBuffer[i].name ) + 1;
+	}
+	names = Z_Malloc( len );
+	namePtr = names;
+	for ( i = 0; i < pack->numfiles; i++ ) {
+		strcpy( namePtr, pack->buildBuffer[i].name );
+		namePtr += strlen( namePtr ) + 1;
+	}
+
+	record.pathLen = ( strlen( zipfile ) + 1 + 3 ) & ~3;
+	record.size = size;
+	record.mtime = mtime;
+	record.numfiles = pack->numfiles;
+	record.numHeaderLongs = numHeaderLongs;
+	record.namesLen = ( len + 3 ) & ~3;
+
+	FS_AppendPakIndex( &record, sizeof( record ) );
+	FS_AppendPakIndex( zipfile, strlen( zipfile ) + 1 );
+	for ( i = 0; i < pack->numfiles; i++ ) {
+		pos = pack->buildBuffer[i].pos;
+		FS_AppendPakIndex( &pos, sizeof( pos ) );
+	}
+	FS_AppendPakIndex( headerLongs, numHeaderLongs * sizeof( int ) );
+	FS_AppendPakIndex( names, len );
+
+	Z_Free( names );
+	fs_numNewPakIndexEntries++;
+}
+
+/*
+=================
+FS_WritePakIndex
+
+Saves the index if a pk3 was parsed or went away, and drops both indexes
+=================
+*/
+static void FS_WritePakIndex( void ) {
+	char    *ospath;
+	FILE    *f;
+	int header[3];
+
+	if ( fs_pakIndexActive && ( fs_pakIndexDirty || fs_numNewPakIndexEntries != fs_numPakIndexEntries ) ) {
+		ospath = FS_BuildOSPath( fs_homepath->string, BASEGAME, PAKINDEX_NAME );
+		FS_CreatePath( ospath );
+		f = fopen( ospath, "wb" );
+		if ( f ) {
+			header[0] = PAKINDEX_IDENT;
+			header[1] = PAKINDEX_VERSION;
+			header[2] = fs_numNewPakIndexEntries;
+			if ( fwrite( header, sizeof( header ), 1, f ) != 1
+				 || fwrite( fs_newPakIndex, fs_newPakIndexSize, 1, f ) != 1 ) {
+				Com_Printf( "WARNING: couldn't write %s\n", ospath );
+			}
+			fclose( f );
+		}
+	}
+
+	if ( fs_newPakIndex ) {
+		Z_Free( fs_newPakIndex );
+	}
+	if ( fs_pakIndexEntries ) {
+		Z_Free( fs_pakIndexEntries );
+	}
+	if ( fs_pakIndexData ) {
+		Z_Free( fs_pakIndexData );
+	}
+	fs_newPakIndex = NULL;
+	fs_newPakIndexSize = 0;
+	fs_newPakIndexMax = 0;
+	fs_numNewPakIndexEntries = 0;
+	fs_pakIndexActive = qfalse;
+	fs_pakIndexDirty = qfalse;
+	fs_pakIndexData = NULL;
+	fs_pakIndexEntries = NULL;
+	fs_numPakIndexEntries = 0;
+}
+
 /*
 =================
 FS_LoadZipFile
@@ -2179,10 +2551,18 @@ static pack_t *FS_LoadZipFile( char *zipfile, const char *basename ) {
 	int fs_numHeaderLongs;
 	int             *fs_headerLongs;
 	char            *namePtr;
+	const pakIndexEntry_t *index;
+	const char      *indexName;
+	qboolean indexed;
+	int size, mtime;
 
 	fs_numHeaderLongs = 0;
 
 	uf = unzOpen( zipfile );
+	// read the directory and the contents straight out of memory
+	if ( uf && fs_mapPaks->integer && unzMapFile( uf, zipfile ) == UNZ_OK ) {
+		fs_mappedPaks++;
+	}
 	err = unzGetGlobalInfo( uf,&gi );
 
 	if ( err != UNZ_OK ) {
@@ -2191,16 +2571,30 @@ static pack_t *FS_LoadZipFile( char *zipfile, const char *basename ) {
 
 	fs_packFiles += gi.number_entry;
 
-	len = 0;
-	unzGoToFirstFile( uf );
-	for ( i = 0; i < gi.number_entry; i++ )
-	{
-		err = unzGetCurrentFileInfo( uf, &file_info, filename_inzip, sizeof( filename_inzip ), NULL, 0, NULL, 0 );
-		if ( err != UNZ_OK ) {
-			break;
+	// an unchanged pk3 gets its file list from the index
+	index = NULL;
+	indexed = fs_pakIndexActive && gi.number_entry > 0 && Sys_FileStat( zipfile, &size, &mtime );
+	if ( indexed ) {
+		index = FS_FindPakIndex( zipfile, size, mtime );
+		if ( index && index->record->numfiles != gi.number_entry ) {
+			index = NULL;
+		}
+	}
+
+	if ( index ) {
+		len = index->record->namesLen;
+	} else {
+		len = 0;
+		unzGoToFirstFile( uf );
+		for ( i = 0; i < gi.number_entry; i++ )
+		{
+			err = unzGetCurrentFileInfo( uf, &file_info, filename_inzip, sizeof( filename_inzip ), NULL, 0, NULL, 0 );
+			if ( err != UNZ_OK ) {
+				break;
+			}
+			len += strlen( filename_inzip ) + 1;
+			unzGoToNextFile( uf );
 		}
-		len += strlen( filename_inzip ) + 1;
-		unzGoToNextFile( uf );
 	}
 
 	buildBuffer = Z_Malloc( ( gi.number_entry * sizeof( fileInPack_t ) ) + len );
@@ -2232,28 +2626,50 @@ static pack_t *FS_LoadZipFile( char *zipfile, const char *basename ) {
 
 	pack->handle = uf;
 	pack->numfiles = gi.number_entry;
-	unzGoToFirstFile( uf );
 
-	for ( i = 0; i < gi.number_entry; i++ )
-	{
-		err = unzGetCurrentFileInfo( uf, &file_info, filename_inzip, sizeof( filename_inzip ), NULL, 0, NULL, 0 );
-		if ( err != UNZ_OK ) {
-			break;
+	if ( index ) {
+		indexName = index->names;
+		for ( i = 0; i < gi.number_entry; i++ )
+		{
+			hash = FS_HashFileName( indexName, pack->hashSize );
+			buildBuffer[i].name = namePtr;
+			strcpy( buildBuffer[i].name, indexName );
+			namePtr += strlen( indexName ) + 1;
+			indexName += strlen( indexName ) + 1;
+			buildBuffer[i].pos = (unsigned int)index->pos[i];
+			buildBuffer[i].next = pack->hashTable[hash];
+			pack->hashTable[hash] = &buildBuffer[i];
+		}
+		fs_numHeaderLongs = index->record->numHeaderLongs;
+		Com_Memcpy( fs_headerLongs, index->headerLongs, fs_numHeaderLongs * sizeof( int ) );
+	} else {
+		unzGoToFirstFile( uf );
+		for ( i = 0; i < gi.number_entry; i++ )
+		{
+			err = unzGetCurrentFileInfo( uf, &file_info, filename_inzip, sizeof( filename_inzip ), NULL, 0, NULL, 0 );
+			if ( err != UNZ_OK ) {
+				break;
+			}
+			if ( file_info.uncompressed_size > 0 ) {
+				fs_headerLongs[fs_numHeaderLongs++] = LittleLong( file_info.crc );
+			}
+			Q_strlwr( filename_inzip );
+			hash = FS_HashFileName( filename_inzip, pack->hashSize );
+			buildBuffer[i].name = namePtr;
+			strcpy( buildBuffer[i].name, filename_inzip );
+			namePtr += strlen( filename_inzip ) + 1;
+			// store the file position in the zip
+			unzGetCurrentFileInfoPosition( uf, &buildBuffer[i].pos );
+			//
+			buildBuffer[i].next = pack->hashTable[hash];
+			pack->hashTable[hash] = &buildBuffer[i];
+			unzGoToNextFile( uf );
 		}
-		if ( file_info.uncompressed_size > 0 ) {
-			fs_headerLongs[fs_numHeaderLongs++] = LittleLong( file_info.crc );
+		// only a complete walk can go in the index
+		if ( i < gi.number_entry ) {
+			indexed = qfalse;
 		}
-		Q_strlwr( filename_inzip );
-		hash = FS_HashFileName( filename_inzip, pack->hashSize );
-		buildBuffer[i].name = namePtr;
-		strcpy( buildBuffer[i].name, filename_inzip );
-		namePtr += strlen( filename_inzip ) + 1;
-		// store the file position in the zip
-		unzGetCurrentFileInfoPosition( uf, &buildBuffer[i].pos );
-		//
-		buildBuffer[i].next = pack->hashTable[hash];
-		pack->hashTable[hash] = &buildBuffer[i];
-		unzGoToNextFile( uf );
+		fs_pakIndexDirty = qtrue;
 	}
 
 	pack->checksum = Com_BlockChecksum( fs_headerLongs, 4 * fs_numHeaderLongs );
@@ -2261,9 +2677,14 @@ static pack_t *FS_LoadZipFile( char *zipfile, const char *basename ) {
 	pack->checksum = LittleLong( pack->checksum );
 	pack->pure_checksum = LittleLong( pack->pure_checksum );
 
+	pack->buildBuffer = buildBuffer;
+
+	if ( indexed ) {
+		FS_AddPakIndex( zipfile, size, mtime, pack, fs_headerLongs, fs_numHeaderLongs );
+	}
+
 	Z_Free( fs_headerLongs );
 
-	pack->buildBuffer = buildBuffer;
 	return pack;
 }
 
@@ -3473,6 +3894,12 @@ static void FS_Startup( const char *gameName ) {
 	fs_homepath = Cvar_Get( "fs_homepath", homePath, CVAR_INIT );
 	fs_gamedirvar = Cvar_Get( "fs_game", "", CVAR_INIT | CVAR_SYSTEMINFO );
 	fs_restrict = Cvar_Get( "fs_restrict", "", CVAR_INIT );
+	fs_mapPaks = Cvar_Get( "fs_mapPaks", "0", CVAR_INIT );
+	fs_pakIndex = Cvar_Get( "fs_pakIndex", "1", CVAR_INIT );
+
+	if ( fs_pakIndex->integer ) {
+		FS_LoadPakIndex();
+	}
 
 	// add search path elements in reverse priority order
 	if ( fs_cdpath->string[0] ) {
@@ -3547,6 +3974,8 @@ static void FS_Startup( const char *gameName ) {
 		}
 	}
 
+	FS_WritePakIndex();
+
 	Com_ReadCDKey( BASEGAME );
 	fs = Cvar_Get( "fs_game", "", CVAR_INIT | CVAR_SYSTEMINFO );
 	if ( fs && fs->string[0] != 0 ) {
@@ -3579,6 +4008,9 @@ static void FS_Startup( const char *gameName ) {
 	}
 #endif
 	Com_Printf( "%d files in pk3 files\n", fs_packFiles );
+	if ( fs_mappedPaks ) {
+		Com_Printf( "%d pk3 files mapped\n", fs_mappedPaks );
+	}
 }
 
 
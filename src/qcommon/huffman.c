@@ -38,27 +38,24 @@ static int bloc = 0;
 
 //bani - optimized version
 //clears data along the way so we dont have to memset() it ahead of time
+// the offset versions don't touch bloc, so several msg_t can be written in parallel
 void    Huff_putBit( int bit, byte *fout, int *offset ) {
 	int x, y;
-	bloc = *offset;
-	x = bloc >> 3;
-	y = bloc & 7;
+	x = *offset >> 3;
+	y = *offset & 7;
 	if ( !y ) {
 		fout[ x ] = 0;
 	}
 	fout[ x ] |= bit << y;
-	bloc++;
-	*offset = bloc;
+	( *offset )++;
 }
 
 //bani - optimized version
 //optimization works on gcc 3.x, but not 2.95 ? most curious.
 int Huff_getBit( byte *fin, int *offset ) {
 	int t;
-	bloc = *offset;
-	t = fin[ bloc >> 3 ] >> ( bloc & 7 ) & 0x1;
-	bloc++;
-	*offset = bloc;
+	t = fin[ *offset >> 3 ] >> ( *offset & 7 ) & 0x1;
+	( *offset )++;
 	return t;
 }
 
@@ -289,13 +286,14 @@ int Huff_Receive( node_t *node, int *ch, byte *fin ) {
 
 /* Get a symbol */
 void Huff_offsetReceive( node_t *node, int *ch, byte *fin, int *offset ) {
-	bloc = *offset;
+	int pos = *offset;
 	while ( node && node->symbol == INTERNAL_NODE ) {
-		if ( get_bit( fin ) ) {
+		if ( ( fin[ pos >> 3 ] >> ( pos & 7 ) ) & 0x1 ) {
 			node = node->right;
 		} else {
 			node = node->left;
 		}
+		pos++;
 	}
 	if ( !node ) {
 		*ch = 0;
@@ -303,7 +301,7 @@ void Huff_offsetReceive( node_t *node, int *ch, byte *fin, int *offset ) {
 //		Com_Error(ERR_DROP, "Illegal tree!\n");
 	}
 	*ch = node->symbol;
-	*offset = bloc;
+	*offset = pos;
 }
 
 /* Send the prefix code for this node */
@@ -334,10 +332,165 @@ void Huff_transmit( huff_t *huff, int ch, byte *fout ) {
 	}
 }
 
+/* Send the prefix code for this node at *offset, without using bloc */
+static void offsetSend( node_t *node, node_t *child, byte *fout, int *offset ) {
+	if ( node->parent ) {
+		offsetSend( node->parent, node, fout, offset );
+	}
+	if ( child ) {
+		Huff_putBit( node->right == child, fout, offset );
+	}
+}
+
 void Huff_offsetTransmit( huff_t *huff, int ch, byte *fout, int *offset ) {
-	bloc = *offset;
-	send( huff->loc[ch], NULL, fout );
-	*offset = bloc;
+	offsetSend( huff->loc[ch], NULL, fout, offset );
+}
+
+/*
+=============================================================================
+
+static code tables
+
+Once a tree stops adapting every symbol always maps to the same code, so
+instead of walking the tree a bit at a time, codes are written from a
+code / length table and read HUFF_LOOKUP_BITS at a time through a lookup
+table, only falling back to the tree for the few codes that are longer.
+
+=============================================================================
+*/
+
+/* Write several raw bits, first bit from bit 0 of value */
+void Huff_putBits( int value, int bits, byte *fout, int *offset ) {
+	int x, y, n;
+	unsigned int v = value;
+
+	while ( bits > 0 ) {
+		x = *offset >> 3;
+		y = *offset & 7;
+		if ( !y ) {
+			fout[ x ] = 0;
+		}
+		n = 8 - y;
+		if ( n > bits ) {
+			n = bits;
+		}
+		fout[ x ] |= ( v & ( ( 1 << n ) - 1 ) ) << y;
+		v >>= n;
+		bits -= n;
+		*offset += n;
+	}
+}
+
+/* Read several raw bits, first bit into bit 0 */
+int Huff_getBits( int bits, byte *fin, int *offset ) {
+	int x, y, n, got;
+	unsigned int v = 0;
+
+	for ( got = 0 ; got < bits ; got += n ) {
+		x = *offset >> 3;
+		y = *offset & 7;
+		n = 8 - y;
+		if ( n > bits - got ) {
+			n = bits - got;
+		}
+		v |= ( ( fin[ x ] >> y ) & ( ( 1 << n ) - 1 ) ) << got;
+		*offset += n;
+	}
+	return v;
+}
+
+/* Build the code of every symbol and the lookup table for the current trees */
+void Huff_BuildTable( huffTable_t *table, huff_t *compressor, huff_t *decompressor ) {
+	int i, j, length;
+	unsigned int code;
+	node_t *node, *child;
+
+	Com_Memset( table, 0, sizeof( *table ) );
+	table->tree = decompressor->tree;
+
+	for ( i = 0; i < HMAX; i++ ) {
+		if ( !compressor->loc[i] ) {
+			continue;
+		}
+
+		// walk up to the root, the bit nearest the root is sent first
+		code = 0;
+		length = 0;
+		for ( child = compressor->loc[i], node = child->parent; node; child = node, node = node->parent ) {
+			code = ( code << 1 ) | ( node->right == child );
+			length++;
+		}
+		if ( length > HUFF_MAX_CODE_BITS ) {
+			continue;
+		}
+		table->code[i] = code;
+		table->length[i] = length;
+	}
+
+	for ( i = 0; i < ( 1 << HUFF_LOOKUP_BITS ); i++ ) {
+		node = decompressor->tree;
+		for ( j = 0; j < HUFF_LOOKUP_BITS && node && node->symbol == INTERNAL_NODE; j++ ) {
+			node = ( i >> j ) & 1 ? node->right : node->left;
+		}
+		table->lookup[i].node = node;
+		if ( node && node->symbol != INTERNAL_NODE ) {
+			table->lookup[i].symbol = node->symbol;
+			table->lookup[i].length = j;
+		}
+	}
+}
+
+/* Send a symbol through the code table, same bits as Huff_offsetTransmit */
+void Huff_tableTransmit( huffTable_t *table, huff_t *huff, int ch, byte *fout, int *offset ) {
+	if ( !table->length[ch] ) {
+		Huff_offsetTransmit( huff, ch, fout, offset );
+		return;
+	}
+	Huff_putBits( table->code[ch], table->length[ch], fout, offset );
+}
+
+/* Get a symbol through the lookup table, same result as Huff_offsetReceive.
+   Bytes at or past maxoffset are never read ahead. */
+void Huff_tableReceive( huffTable_t *table, int *ch, byte *fin, int *offset, int maxoffset ) {
+	huffLookup_t *entry;
+	node_t *node;
+	int pos, x;
+	unsigned int window;
+
+	pos = *offset;
+	x = pos >> 3;
+	if ( x + 2 >= maxoffset ) {
+		// too close to the end of the buffer to peek ahead
+		Huff_offsetReceive( table->tree, ch, fin, offset );
+		return;
+	}
+
+	window = ( fin[x] | ( fin[x + 1] << 8 ) | ( fin[x + 2] << 16 ) ) >> ( pos & 7 );
+	entry = &table->lookup[ window & ( ( 1 << HUFF_LOOKUP_BITS ) - 1 ) ];
+
+	if ( entry->length ) {
+		*ch = entry->symbol;
+		*offset = pos + entry->length;
+		return;
+	}
+
+	// longer code, continue down the tree from where the table stopped
+	node = entry->node;
+	pos += HUFF_LOOKUP_BITS;
+	while ( node && node->symbol == INTERNAL_NODE ) {
+		if ( ( fin[ pos >> 3 ] >> ( pos & 7 ) ) & 0x1 ) {
+			node = node->right;
+		} else {
+			node = node->left;
+		}
+		pos++;
+	}
+	if ( !node ) {
+		*ch = 0;
+		return;
+	}
+	*ch = node->symbol;
+	*offset = pos;
 }
 
 void Huff_Decompress( msg_t *mbuf, int offset ) {
@@ -392,8 +545,6 @@ void Huff_Decompress( msg_t *mbuf, int offset ) {
 	Com_Memcpy( mbuf->data + offset, seq, cch );
 }
 
-extern int oldsize;
-
 void Huff_Compress( msg_t *mbuf, int offset ) {
 	int i, ch, size;
 	byte seq[65536];
@@ -30,12 +30,11 @@ If you have questions concerning this license or the applicable additional terms
 #include "qcommon.h"
 
 static huffman_t msgHuff;
+static huffTable_t msgHuffTable;        // msgHuff never adapts after MSG_initHuffman
 static qboolean msgInit = qfalse;
 
 int pcount[256];
-int wastedbits = 0;
 
-static int oldsize = 0;
 // static int overflows = 0;
 
 /*
@@ -129,8 +128,6 @@ void MSG_WriteBits( msg_t *msg, int value, int bits ) {
 	int i;
 //	FILE*	fp;
 
-	oldsize += bits;
-
 	msg->uncompsize += bits;            // NERVE - SMF - net debugging
 
 	// this isn't an exact overflow check, but close enough
@@ -187,16 +184,14 @@ void MSG_WriteBits( msg_t *msg, int value, int bits ) {
 		if ( bits & 7 ) {
 			int nbits;
 			nbits = bits & 7;
-			for ( i = 0; i < nbits; i++ ) {
-				Huff_putBit( ( value & 1 ), msg->data, &msg->bit );
-				value = ( value >> 1 );
-			}
+			Huff_putBits( value, nbits, msg->data, &msg->bit );
+			value = (unsigned int)value >> nbits;
 			bits = bits - nbits;
 		}
 		if ( bits ) {
 			for ( i = 0; i < bits; i += 8 ) {
 //				fwrite(bp, 1, 1, fp);
-				Huff_offsetTransmit( &msgHuff.compressor, ( value & 0xff ), msg->data, &msg->bit );
+				Huff_tableTransmit( &msgHuffTable, &msgHuff.compressor, ( value & 0xff ), msg->data, &msg->bit );
 				value = ( value >> 8 );
 			}
 		}
@@ -243,15 +238,13 @@ int MSG_ReadBits( msg_t *msg, int bits ) {
 		nbits = 0;
 		if ( bits & 7 ) {
 			nbits = bits & 7;
-			for ( i = 0; i < nbits; i++ ) {
-				value |= ( Huff_getBit( msg->data, &msg->bit ) << i );
-			}
+			value = Huff_getBits( nbits, msg->data, &msg->bit );
 			bits = bits - nbits;
 		}
 		if ( bits ) {
 //			fp = fopen("c:\\netchan.bin", "a");
 			for ( i = 0; i < bits; i += 8 ) {
-				Huff_offsetReceive( msgHuff.decompressor.tree, &get, msg->data, &msg->bit );
+				Huff_tableReceive( &msgHuffTable, &get, msg->data, &msg->bit, msg->maxsize );
 //				fwrite(&get, 1, 1, fp);
 				value |= ( get << ( i + nbits ) );
 			}
@@ -740,7 +733,6 @@ void MSG_WriteDeltaUsercmdKey( msg_t *msg, int key, usercmd_t *from, usercmd_t *
 		 from->doubleTap == to->doubleTap &&
 		 from->identClient == to->identClient ) {   // NERVE - SMF
 		MSG_WriteBits( msg, 0, 1 );                 // no change
-		oldsize += 7;
 		return;
 	}
 	key ^= to->serverTime;
@@ -1003,7 +995,10 @@ void MSG_WriteDeltaEntity( msg_t *msg, struct entityState_s *from, struct entity
 		if ( *fromF != *toF ) {
 			lc = i + 1;
 
-			field->used++;
+			// the stats would race with the worker threads
+			if ( !com_workersActive ) {
+				field->used++;
+			}
 		}
 	}
 
@@ -1025,8 +1020,6 @@ void MSG_WriteDeltaEntity( msg_t *msg, struct entityState_s *from, struct entity
 
 	MSG_WriteByte( msg, lc );   // # of changes
 
-	oldsize += numFields;
-
 //	Com_Printf( "Delta for ent %i: ", to->number );
 
 	for ( i = 0, field = entityStateFields ; i < lc ; i++, field++ ) {
@@ -1035,9 +1028,6 @@ void MSG_WriteDeltaEntity( msg_t *msg, struct entityState_s *from, struct entity
 
 		if ( *fromF == *toF ) {
 			MSG_WriteBits( msg, 0, 1 ); // no change
-
-			wastedbits++;
-
 			continue;
 		}
 
@@ -1050,7 +1040,6 @@ void MSG_WriteDeltaEntity( msg_t *msg, struct entityState_s *from, struct entity
 
 			if ( fullFloat == 0.0f ) {
 				MSG_WriteBits( msg, 0, 1 );
-				oldsize += FLOAT_INT_BITS;
 			} else {
 				MSG_WriteBits( msg, 1, 1 );
 				if ( trunc == fullFloat && trunc + FLOAT_INT_BIAS >= 0 &&
@@ -1100,6 +1089,69 @@ void MSG_WriteDeltaEntity( msg_t *msg, struct entityState_s *from, struct entity
 */
 }
 
+/*
+==================
+MSG_DeltaEntityBits
+
+Uncompressed size of what MSG_WriteDeltaEntity( msg, from, to, qfalse )
+would write, without writing it
+==================
+*/
+int MSG_DeltaEntityBits( const entityState_t *from, const entityState_t *to ) {
+	int i, lc, bits, trunc;
+	int numFields;
+	netField_t  *field;
+	const int   *fromF, *toF;
+	float fullFloat;
+
+	numFields = sizeof( entityStateFields ) / sizeof( entityStateFields[0] );
+
+	lc = 0;
+	for ( i = 0, field = entityStateFields ; i < numFields ; i++, field++ ) {
+		fromF = ( const int * )( (const byte *)from + field->offset );
+		toF = ( const int * )( (const byte *)to + field->offset );
+		if ( *fromF != *toF ) {
+			lc = i + 1;
+		}
+	}
+
+	if ( lc == 0 ) {
+		return 0;
+	}
+
+	// number, not removed, has delta, change count, one changed bit per field
+	bits = GENTITYNUM_BITS + 2 + 8 + lc;
+
+	for ( i = 0, field = entityStateFields ; i < lc ; i++, field++ ) {
+		fromF = ( const int * )( (const byte *)from + field->offset );
+		toF = ( const int * )( (const byte *)to + field->offset );
+
+		if ( *fromF == *toF ) {
+			continue;
+		}
+
+		if ( field->bits == 0 ) {
+			fullFloat = *(const float *)toF;
+			trunc = (int)fullFloat;
+
+			if ( fullFloat == 0.0f ) {
+				bits += 1;
+			} else if ( trunc == fullFloat && trunc + FLOAT_INT_BIAS >= 0 &&
+						trunc + FLOAT_INT_BIAS < ( 1 << FLOAT_INT_BITS ) ) {
+				bits += 2 + FLOAT_INT_BITS;
+			} else {
+				bits += 2 + 32;
+			}
+		} else if ( *toF == 0 ) {
+			bits += 1;
+		} else {
+			bits += 1 + abs( field->bits );
+		}
+	}
+
+	return bits;
+}
+
 /*
 ==================
 MSG_ReadDeltaEntity
@@ -1416,21 +1468,20 @@ void MSG_WriteDeltaPlayerstate( msg_t *msg, struct playerState_s *from, struct p
 		if ( *fromF != *toF ) {
 			lc = i + 1;
 
-			field->used++;
+			// the stats would race with the worker threads
+			if ( !com_workersActive ) {
+				field->used++;
+			}
 		}
 	}
 
 	MSG_WriteByte( msg, lc );   // # of changes
 
-	oldsize += numFields - lc;
-
 	for ( i = 0, field = playerStateFields ; i < lc ; i++, field++ ) {
 		fromF = ( int * )( (byte *)from + field->offset );
 		toF = ( int * )( (byte *)to + field->offset );
 
 		if ( *fromF == *toF ) {
-			wastedbits++;
-
 			MSG_WriteBits( msg, 0, 1 ); // no change
 			continue;
 		}
@@ -1554,7 +1605,6 @@ void MSG_WriteDeltaPlayerstate( msg_t *msg, struct playerState_s *from, struct p
 		}
 	} else {
 		MSG_WriteBits( msg, 0, 1 ); // no change to any
-		oldsize += 4;
 	}
 
 
@@ -2179,6 +2229,7 @@ void MSG_initHuffman() {
 			Huff_addRef( &msgHuff.decompressor,  (byte)i );           /* Do update */
 		}
 	}
+	Huff_BuildTable( &msgHuffTable, &msgHuff.compressor, &msgHuff.decompressor );
 }
 
 /*
@@ -2217,3 +2268,107 @@ void MSG_NUinitHuffman() {
 */
 
 //===========================================================================
+
+/*
+===============
+MSG_HuffmanBench_f
+
+Times the tree walking and the table driven msgHuff codecs on the same
+data, drawn from the msg_hData distribution, and checks they agree bit for bit
+===============
+*/
+#define HUFFBENCH_BYTES     65536
+
+void MSG_HuffmanBench_f( void ) {
+	byte        *src, *treeBuf, *tableBuf;
+	int i, j, pass, passes, total, seed, ch;
+	int treeBits, tableBits, bit;
+	int t0, treeEnc, tableEnc, treeDec, tableDec;
+	qboolean match;
+
+	if ( !msgInit ) {
+		MSG_initHuffman();
+	}
+
+	passes = atoi( Cmd_Argv( 1 ) );
+	if ( passes <= 0 ) {
+		passes = 50;
+	}
+
+	src = Z_Malloc( HUFFBENCH_BYTES );
+	treeBuf = Z_Malloc( HUFFBENCH_BYTES * 4 );
+	tableBuf = Z_Malloc( HUFFBENCH_BYTES * 4 );
+
+	total = 0;
+	for ( i = 0; i < 256; i++ ) {
+		total += msg_hData[i];
+	}
+	seed = 0x1234;
+	for ( i = 0; i < HUFFBENCH_BYTES; i++ ) {
+		seed = seed * 1103515245 + 12345;
+		ch = ( (unsigned int)seed >> 1 ) % total;
+		for ( j = 0; j < 255 && ch >= msg_hData[j]; j++ ) {
+			ch -= msg_hData[j];
+		}
+		src[i] = j;
+	}
+
+	treeBits = tableBits = 0;
+
+	t0 = Sys_Milliseconds();
+	for ( pass = 0; pass < passes; pass++ ) {
+		treeBits = 0;
+		for ( i = 0; i < HUFFBENCH_BYTES; i++ ) {
+			Huff_offsetTransmit( &msgHuff.compressor, src[i], treeBuf, &treeBits );
+		}
+	}
+	treeEnc = Sys_Milliseconds() - t0;
+
+	t0 = Sys_Milliseconds();
+	for ( pass = 0; pass < passes; pass++ ) {
+		tableBits = 0;
+		for ( i = 0; i < HUFFBENCH_BYTES; i++ ) {
+			Huff_tableTransmit( &msgHuffTable, &msgHuff.compressor, src[i], tableBuf, &tableBits );
+		}
+	}
+	tableEnc = Sys_Milliseconds() - t0;
+
+	match = ( treeBits == tableBits && !memcmp( treeBuf, tableBuf, ( treeBits + 7 ) >> 3 ) );
+
+	t0 = Sys_Milliseconds();
+	for ( pass = 0; pass < passes; pass++ ) {
+		bit = 0;
+		for ( i = 0; i < HUFFBENCH_BYTES; i++ ) {
+			Huff_offsetReceive( msgHuff.decompressor.tree, &ch, treeBuf, &bit );
+			if ( ch != src[i] ) {
+				match = qfalse;
+			}
+		}
+	}
+	treeDec = Sys_Milliseconds() - t0;
+
+	t0 = Sys_Milliseconds();
+	for ( pass = 0; pass < passes; pass++ ) {
+		bit = 0;
+		for ( i = 0; i < HUFFBENCH_BYTES; i++ ) {
+			Huff_tableReceive( &msgHuffTable, &ch, treeBuf, &bit, HUFFBENCH_BYTES * 4 );
+			if ( ch != src[i] ) {
+				match = qfalse;
+			}
+		}
+	}
+	tableDec = Sys_Milliseconds() - t0;
+
+	Com_Printf( "%i x %i bytes, %i bits per pass\n", passes, HUFFBENCH_BYTES, treeBits );
+	Com_Printf( "encode: tree %.1f MB/s, table %.1f MB/s\n",
+				(float)passes * HUFFBENCH_BYTES / ( 1000.0f * ( treeEnc ? treeEnc : 1 ) ),
+				(float)passes * HUFFBENCH_BYTES / ( 1000.0f * ( tableEnc ? tableEnc : 1 ) ) );
+	Com_Printf( "decode: tree %.1f MB/s, table %.1f MB/s\n",
+				(float)passes * HUFFBENCH_BYTES / ( 1000.0f * ( treeDec ? treeDec : 1 ) ),
+				(float)passes * HUFFBENCH_BYTES / ( 1000.0f * ( tableDec ? tableDec : 1 ) ) );
+	Com_Printf( "%s\n", match ? "streams match" : "^1STREAMS DIFFER" );
+
+	Z_Free( tableBuf );
+	Z_Free( treeBuf );
+	Z_Free( src );
+}
@@ -607,6 +607,7 @@ void NET_SendPacket( netsrc_t sock, int length, const void *data, netadr_t to )
 //bani
 	int packetloss, packetdelay;
 	delaybuf_t **delaybuf_head, **delaybuf_tail;
+	int perfStart;
 
 	switch ( sock ) {
 #ifndef DEDICATED
@@ -720,7 +721,9 @@ void NET_SendPacket( netsrc_t sock, int length, const void *data, netadr_t to )
 		return;
 	}
 
+	perfStart = Perf_Begin();
 	Sys_SendPacket( length, data, to );
+	Perf_End( PERF_SEND_PACKET, perfStart );
 }
 
 /*
@@ -0,0 +1,298 @@
+/*
+===========================================================================
+
+Wolfenstein: Enemy Territory GPL Source Code
+Copyright (C) 1999-2010 id Software LLC, a ZeniMax Media company. 
+
+This file is part of the Wolfenstein: Enemy Territory GPL Source Code (Wolf ET Source Code).  
+
+Wolf ET Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Wolf ET Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Wolf ET Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Wolf: ET Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Wolf ET Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+// perfstats.c -- per server frame timers with percentile reporting
+
+/*
+Every timer accumulates the microseconds and calls of one server frame,
+Perf_EndFrame then files those totals into a window of the last PERF_WINDOW
+frames.  perfstats prints p50/p95/p99/max over the window, com_perfLog
+appends the same figures for every second of play to perfstats.csv
+(1) or perfstats.json (2, one object per line) so they can be graphed
+against the player count.
+*/
+
+#include "../game/q_shared.h"
+#include "qcommon.h"
+
+#define PERF_WINDOW     1024        // ~50 seconds at sv_fps 20
+
+typedef struct {
+	const char  *name;
+	int frameTime;                  // accumulated during the current frame
+	int frameCalls;
+	int time[PERF_WINDOW];          // per frame totals
+	int calls[PERF_WINDOW];
+} perfTimerData_t;
+
+typedef struct {
+	int frames;
+	float calls;                    // average per frame
+	int mean, p50, p95, p99, max;
+} perfSummary_t;
+
+cvar_t  *com_perfStats;
+cvar_t  *com_perfLog;
+
+static perfTimerData_t perf_timers[PERF_NUM_TIMERS] = {
+	{ "sv_frame" },
+	{ "packet_event" },
+	{ "game_run_frame" },
+	{ "send_messages" },
+	{ "build_snapshot" },
+	{ "trace" },
+	{ "send_packet" },
+};
+
+static int perf_numFrames;          // frames filed since the last reset
+static int perf_clients[PERF_WINDOW];
+
+static fileHandle_t perf_logFile;
+static int perf_logMode;
+static int perf_logFrame;           // first frame not written to the log yet
+static int perf_logTime;
+
+/*
+================
+Perf_End
+================
+*/
+void Perf_End( perfTimer_t timer, int start ) {
+	perfTimerData_t *t;
+
+	// profiling was switched on between begin and end
+	if ( !start ) {
+		return;
+	}
+
+	t = &perf_timers[timer];
+	t->frameTime += Sys_Microseconds() - start;
+	t->frameCalls++;
+}
+
+static int Perf_CompareInts( const void *a, const void *b ) {
+	return *(const int *)a - *(const int *)b;
+}
+
+/*
+================
+Perf_Summarize
+
+Percentiles of the per frame totals of the frames [first, perf_numFrames)
+================
+*/
+static void Perf_Summarize( perfTimer_t timer, int first, perfSummary_t *s ) {
+	static int sorted[PERF_WINDOW];
+	perfTimerData_t *t;
+	int i, n, calls;
+	double total;
+
+	if ( first < perf_numFrames - PERF_WINDOW ) {
+		first = perf_numFrames - PERF_WINDOW;
+	}
+
+	memset( s, 0, sizeof( *s ) );
+	n = perf_numFrames - first;
+	if ( n <= 0 ) {
+		return;
+	}
+
+	t = &perf_timers[timer];
+	total = 0;
+	calls = 0;
+	for ( i = 0 ; i < n ; i++ ) {
+		sorted[i] = t->time[( first + i ) % PERF_WINDOW];
+		calls += t->calls[( first + i ) % PERF_WINDOW];
+		total += sorted[i];
+	}
+	qsort( sorted, n, sizeof( int ), Perf_CompareInts );
+
+	s->frames = n;
+	s->calls = (float)calls / n;
+	s->mean = (int)( total / n );
+	s->p50 = sorted[( n - 1 ) * 50 / 100];
+	s->p95 = sorted[( n - 1 ) * 95 / 100];
+	s->p99 = sorted[( n - 1 ) * 99 / 100];
+	s->max = sorted[n - 1];
+}
+
+/*
+================
+Perf_WriteLog
+================
+*/
+static void Perf_WriteLog( int numClients ) {
+	perfSummary_t s;
+	int i;
+
+	if ( perf_logMode != com_perfLog->integer ) {
+		if ( perf_logFile ) {
+			FS_FCloseFile( perf_logFile );
+			perf_logFile = 0;
+		}
+
+		perf_logMode = com_perfLog->integer;
+		if ( perf_logMode == 1 || perf_logMode == 2 ) {
+			perf_logFile = FS_FOpenFileWrite( perf_logMode == 1 ? "perfstats.csv" : "perfstats.json" );
+			if ( !perf_logFile ) {
+				Com_Printf( "Perf_WriteLog: couldn't open the log\n" );
+			} else if ( perf_logMode == 1 ) {
+				FS_Printf( perf_logFile, "msec,clients,frames" );
+				for ( i = 0 ; i < PERF_NUM_TIMERS ; i++ ) {
+					FS_Printf( perf_logFile, ",%s_calls,%s_p50,%s_p95,%s_p99,%s_max",
+							   perf_timers[i].name, perf_timers[i].name, perf_timers[i].name,
+							   perf_timers[i].name, perf_timers[i].name );
+				}
+				FS_Printf( perf_logFile, "\n" );
+			}
+		}
+
+		perf_logFrame = perf_numFrames;
+		perf_logTime = Sys_Milliseconds();
+	}
+
+	if ( !perf_logFile || Sys_Milliseconds() - perf_logTime < 1000 ) {
+		return;
+	}
+	perf_logTime = Sys_Milliseconds();
+
+	if ( perf_logMode == 1 ) {
+		FS_Printf( perf_logFile, "%i,%i,%i", perf_logTime, numClients, perf_numFrames - perf_logFrame );
+	} else {
+		FS_Printf( perf_logFile, "{\"msec\":%i,\"clients\":%i,\"frames\":%i", perf_logTime, numClients, perf_numFrames - perf_logFrame );
+	}
+
+	for ( i = 0 ; i < PERF_NUM_TIMERS ; i++ ) {
+		Perf_Summarize( i, perf_logFrame, &s );
+		if ( perf_logMode == 1 ) {
+			FS_Printf( perf_logFile, ",%.1f,%i,%i,%i,%i", s.calls, s.p50, s.p95, s.p99, s.max );
+		} else {
+			FS_Printf( perf_logFile, ",\"%s\":{\"calls\":%.1f,\"p50\":%i,\"p95\":%i,\"p99\":%i,\"max\":%i}",
+					   perf_timers[i].name, s.calls, s.p50, s.p95, s.p99, s.max );
+		}
+	}
+
+	FS_Printf( perf_logFile, perf_logMode == 1 ? "\n" : "}\n" );
+	FS_Flush( perf_logFile );
+
+	perf_logFrame = perf_numFrames;
+}
+
+/*
+================
+Perf_EndFrame
+
+Called once per server frame, after the messages went out
+================
+*/
+void Perf_EndFrame( int numClients ) {
+	perfTimerData_t *t;
+	int i, slot;
+
+	if ( !com_perfStats->integer ) {
+		return;
+	}
+
+	slot = perf_numFrames % PERF_WINDOW;
+	for ( i = 0, t = perf_timers ; i < PERF_NUM_TIMERS ; i++, t++ ) {
+		t->time[slot] = t->frameTime;
+		t->calls[slot] = t->frameCalls;
+		t->frameTime = 0;
+		t->frameCalls = 0;
+	}
+	perf_clients[slot] = numClients;
+	perf_numFrames++;
+
+	if ( com_perfLog->integer || perf_logFile ) {
+		Perf_WriteLog( numClients );
+	}
+}
+
+/*
+================
+Perf_Stats_f
+================
+*/
+static void Perf_Stats_f( void ) {
+	perfSummary_t s;
+	int i, n, clients;
+
+	if ( Cmd_Argc() > 1 && !Q_stricmp( Cmd_Argv( 1 ), "reset" ) ) {
+		for ( i = 0 ; i < PERF_NUM_TIMERS ; i++ ) {
+			perf_timers[i].frameTime = 0;
+			perf_timers[i].frameCalls = 0;
+		}
+		perf_numFrames = 0;
+		perf_logFrame = 0;
+		return;
+	}
+
+	if ( !perf_numFrames ) {
+		Com_Printf( "no frames recorded%s\n", com_perfStats->integer ? "" : ", set com_perfStats 1" );
+		return;
+	}
+
+	n = perf_numFrames < PERF_WINDOW ? perf_numFrames : PERF_WINDOW;
+	clients = 0;
+	for ( i = 0 ; i < n ; i++ ) {
+		clients += perf_clients[i];
+	}
+
+	Com_Printf( "last %i frames, %.1f clients, usec per frame\n", n, (float)clients / n );
+	Com_Printf( "timer            calls    mean     p50     p95     p99     max\n" );
+	Com_Printf( "---------------- ------ ------- ------- ------- ------- -------\n" );
+	for ( i = 0 ; i < PERF_NUM_TIMERS ; i++ ) {
+		Perf_Summarize( i, 0, &s );
+		Com_Printf( "%-16s %6.1f %7i %7i %7i %7i %7i\n", perf_timers[i].name, s.calls, s.mean, s.p50, s.p95, s.p99, s.max );
+	}
+}
+
+/*
+================
+Perf_Init
+================
+*/
+void Perf_Init( void ) {
+	com_perfStats = Cvar_Get( "com_perfStats", "1", 0 );
+	com_perfLog = Cvar_Get( "com_perfLog", "0", 0 );
+
+	Cmd_AddCommand( "perfstats", Perf_Stats_f );
+}
+
+/*
+================
+Perf_Shutdown
+================
+*/
+void Perf_Shutdown( void ) {
+	if ( perf_logFile ) {
+		FS_FCloseFile( perf_logFile );
+		perf_logFile = 0;
+	}
+	perf_logMode = 0;
+}
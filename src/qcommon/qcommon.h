@@ -116,6 +116,7 @@ void MSG_ReadDeltaUsercmdKey( msg_t *msg, int key, usercmd_t *from, usercmd_t *t
 
 void MSG_WriteDeltaEntity( msg_t *msg, struct entityState_s *from, struct entityState_s *to
 						   , qboolean force );
+int MSG_DeltaEntityBits( const entityState_t *from, const entityState_t *to );
 void MSG_ReadDeltaEntity( msg_t *msg, entityState_t *from, entityState_t *to,
 						  int number );
 
@@ -124,6 +125,7 @@ void MSG_ReadDeltaPlayerstate( msg_t *msg, struct playerState_s *from, struct pl
 
 
 void MSG_ReportChangeVectors_f( void );
+void MSG_HuffmanBench_f( void );
 
 //============================================================================
 
@@ -399,6 +401,7 @@ vm_t    *VM_Restart( vm_t *vm );
 int QDECL VM_Call( vm_t *vm, int callNum, ... );
 
 void    VM_Debug( int level );
+void    VM_Bench_f( void );
 
 void    *VM_ArgPtr( int intValue );
 void    *VM_ExplicitArgPtr( vm_t *vm, int intValue );
@@ -460,6 +463,8 @@ void    Cmd_RemoveCommand( const char *cmd_name );
 
 void Cmd_CommandCompletion( void ( *callback )( const char *s ) );
 // callback with each valid string
+void Cmd_CommandCompletionPrefix( const char *prefix, void ( *callback )( const char *s ) );
+// callback with each valid string starting with prefix
 
 int     Cmd_Argc( void );
 char    *Cmd_Argv( int arg );
@@ -634,6 +639,10 @@ int     FS_GetModList(  char *listbuf, int bufsize );
 fileHandle_t    FS_FOpenFileWrite( const char *qpath );
 // will properly create any needed paths and deal with seperater character issues
 
+FILE    *FS_FOpenRawFileWrite( const char *qpath );
+// like FS_FOpenFileWrite, but returns the stdio FILE for threads that can't
+// use file handles, the caller must fclose it
+
 qboolean FS_AppendTextToFile(const char *filename, const char *text);
 
 int     FS_filelength( fileHandle_t f );
@@ -685,6 +694,11 @@ void    FS_ForceFlush( fileHandle_t f );
 void    FS_FreeFile( void *buffer );
 // frees the memory returned by FS_ReadFile
 
+void    *FS_MapFile( const char *qpath, int *length );
+void    FS_UnmapFile( void *data, int length );
+// read only mapping of a file written to the home directory, NULL if there
+// is none and the file has to be read through FS_ReadFile instead
+
 void    FS_WriteFile( const char *qpath, const void *buffer, int size );
 // writes a complete file, creating any subdirectories needed
 
@@ -906,6 +920,7 @@ extern int com_expectedhunkusage;
 extern int com_hunkusedvalue;
 
 extern qboolean com_errorEntered;
+extern qboolean com_workersActive;      // Sys_RunWorkers has jobs out on other threads
 
 extern fileHandle_t com_journalFile;
 extern fileHandle_t com_journalDataFile;
@@ -979,6 +994,37 @@ void Com_Frame( void );
 void Com_Shutdown( qboolean badProfile );
 
 
+/*
+==============================================================
+
+PERFORMANCE COUNTERS
+
+==============================================================
+*/
+
+typedef enum {
+	PERF_SV_FRAME,          // SV_Frame, from the first game frame to the heartbeat
+	PERF_PACKET_EVENT,      // SV_PacketEvent
+	PERF_GAME_RUN_FRAME,    // VM_Call( gvm, GAME_RUN_FRAME )
+	PERF_SEND_MESSAGES,     // SV_SendClientMessages
+	PERF_BUILD_SNAPSHOT,    // SV_BuildClientSnapshot, or the parallel build phases
+	PERF_TRACE,             // SV_Trace
+	PERF_SEND_PACKET,       // NET_SendPacket to a real address
+	PERF_NUM_TIMERS
+} perfTimer_t;
+
+extern cvar_t  *com_perfStats;
+extern cvar_t  *com_perfLog;
+
+// returns the start time to hand to Perf_End, 0 while com_perfStats is off
+#define Perf_Begin()    ( com_perfStats->integer ? Sys_Microseconds() : 0 )
+
+void Perf_End( perfTimer_t timer, int start );
+void Perf_EndFrame( int numClients );
+void Perf_Init( void );
+void Perf_Shutdown( void );
+
+
 /*
 ==============================================================
 
@@ -1111,6 +1157,21 @@ void *Sys_InitializeCriticalSection();
 void Sys_EnterCriticalSection( void *ptr );
 void Sys_LeaveCriticalSection( void *ptr );
 
+// worker threads for data parallel jobs, the calling thread always takes part
+// in Sys_RunWorkers, so starting 0 workers just runs the jobs serially
+#define MAX_SYS_WORKERS 16
+typedef void ( *workerFunc_t )( void *data, int index );
+int     Sys_StartWorkers( int count );      // returns the number of threads actually started
+void    Sys_StopWorkers( void );
+void    Sys_RunWorkers( workerFunc_t func, void *data, int count );     // blocks until all count jobs are done
+
+// a single background thread for work the main thread doesn't wait on, such
+// as streaming files to disk, jobs run one at a time in the order queued
+#define MAX_BACKGROUND_JOBS 64
+typedef void ( *backgroundFunc_t )( void *data );
+int     Sys_QueueBackgroundJob( backgroundFunc_t func, void *data );   // returns a ticket for Sys_WaitBackgroundJob
+void    Sys_WaitBackgroundJob( int ticket );    // blocks until the job and every job queued before it have run
+
 char* Sys_GetDLLName( const char *name );
 // fqpath param added 2/15/02 by T.Ray - Sys_LoadDll is only called in vm.c at this time
 void    * QDECL Sys_LoadDll( const char *name, char *fqpath, int( QDECL * *entryPoint ) ( int, ... ),
@@ -1143,6 +1204,10 @@ void    Sys_Print( const char *msg );
 // any game related timing information should come from event timestamps
 int     Sys_Milliseconds( void );
 
+// high resolution timer for the profiler, wraps every ~35 minutes so only
+// differences between two calls are meaningful
+int     Sys_Microseconds( void );
+
 void    Sys_SnapVector( float *v );
 
 // the system console is shown when a dedicated server is running
@@ -1159,6 +1224,9 @@ void    Sys_ShowConsole( int level, qboolean quitOnClose );
 void    Sys_SetErrorText( const char *text );
 
 void    Sys_SendPacket( int length, const void *data, netadr_t to );
+// packets sent between these two may be queued and written with one syscall
+void    Sys_BeginPacketBatch( void );
+void    Sys_FlushPacketBatch( void );
 
 qboolean    Sys_StringToAdr( const char *s, netadr_t *a );
 //Does NOT parse port numbers, only base addresses.
@@ -1178,6 +1246,13 @@ char    *Sys_DefaultHomePath( void );
 char **Sys_ListFiles( const char *directory, const char *extension, char *filter, int *numfiles, qboolean wantsubs );
 void    Sys_FreeFileList( char **list );
 
+// read only mapping of a whole file, NULL if it can't be mapped
+void    *Sys_MapFile( const char *path, int *length );
+void    Sys_UnmapFile( void *data, int length );
+
+// size and modification time of a file, qfalse if it doesn't exist
+qboolean Sys_FileStat( const char *path, int *size, int *mtime );
+
 void    Sys_BeginProfiling( void );
 void    Sys_EndProfiling( void );
 
@@ -1232,6 +1307,24 @@ typedef struct {
 	huff_t decompressor;
 } huffman_t;
 
+// static code tables for a tree that doesn't change anymore, like msgHuff after
+// MSG_initHuffman.  Bit compatible with Huff_offsetTransmit / Huff_offsetReceive.
+#define HUFF_LOOKUP_BITS    11
+#define HUFF_MAX_CODE_BITS  24
+
+typedef struct {
+	node_t      *node;          // tree node reached after HUFF_LOOKUP_BITS bits
+	short symbol;
+	short length;               // bits used by symbol, 0 if its code is longer than HUFF_LOOKUP_BITS
+} huffLookup_t;
+
+typedef struct {
+	node_t      *tree;          // decompressor root, for reads too close to the end of the buffer
+	unsigned int code[HMAX];    // first bit sent in bit 0
+	byte length[HMAX];          // 0 if the code is longer than HUFF_MAX_CODE_BITS
+	huffLookup_t lookup[1 << HUFF_LOOKUP_BITS];
+} huffTable_t;
+
 void    Huff_Compress( msg_t *buf, int offset );
 void    Huff_Decompress( msg_t *buf, int offset );
 void    Huff_Init( huffman_t *huff );
@@ -1242,6 +1335,11 @@ void    Huff_offsetReceive( node_t *node, int *ch, byte *fin, int *offset );
 void    Huff_offsetTransmit( huff_t *huff, int ch, byte *fout, int *offset );
 void    Huff_putBit( int bit, byte *fout, int *offset );
 int     Huff_getBit( byte *fout, int *offset );
+void    Huff_putBits( int value, int bits, byte *fout, int *offset );
+int     Huff_getBits( int bits, byte *fin, int *offset );
+void    Huff_BuildTable( huffTable_t *table, huff_t *compressor, huff_t *decompressor );
+void    Huff_tableTransmit( huffTable_t *table, huff_t *huff, int ch, byte *fout, int *offset );
+void    Huff_tableReceive( huffTable_t *table, int *ch, byte *fin, int *offset, int maxoffset );
 
 extern huffman_t clientHuffTables;
 
@@ -1128,14 +1128,49 @@ static int unzlocal_getByte(FILE *fin,int *pi)
 }
 */
 
+/* ===========================================================================
+   Seek and read on the zipfile, from its mapping if it is mapped or from
+   its stdio file otherwise. Same return values as fseek and fread with a
+   count of 1.
+*/
+static int unzlocal_fseek (unz_s* s, long offset, int origin)
+{
+	uLong pos;
+
+	if (s->map==NULL)
+		return fseek(s->file,offset,origin);
+
+	pos = (origin==SEEK_CUR) ? s->map_pos + offset : (uLong)offset;
+	if (pos>(uLong)s->map->size)
+		return -1;
+	s->map_pos = pos;
+	return 0;
+}
+
+static int unzlocal_fread (unz_s* s, void *buf, uLong size)
+{
+	if (s->map==NULL)
+		return fread(buf,(uInt)size,1,s->file);
+
+	if (size>(uLong)s->map->size - s->map_pos)
+	{
+		Com_Memset(buf,0,size);
+		s->map_pos = s->map->size;
+		return 0;
+	}
+	Com_Memcpy(buf,s->map->data + s->map_pos,size);
+	s->map_pos += size;
+	return 1;
+}
+
 /* ===========================================================================
    Reads a long in LSB order from the given gz_stream. Sets 
 */
-static int unzlocal_getShort (FILE* fin, uLong *pX)
+static int unzlocal_getShort (unz_s* s, uLong *pX)
 {
 	short	v;
 
-	fread( &v, sizeof(v), 1, fin );
+	unzlocal_fread( s, &v, sizeof(v) );
 
 	*pX = LittleShort( v);
 	return UNZ_OK;
@@ -1160,11 +1195,11 @@ static int unzlocal_getShort (FILE* fin, uLong *pX)
 */
 }
 
-static int unzlocal_getLong (FILE *fin, uLong *pX)
+static int unzlocal_getLong (unz_s* s, uLong *pX)
 {
 	int		v;
 
-	fread( &v, sizeof(v), 1, fin );
+	unzlocal_fread( s, &v, sizeof(v) );
 
 	*pX = LittleLong( v);
 	return UNZ_OK;
@@ -1317,6 +1352,15 @@ extern unzFile unzReOpen (const char* path, unzFile file)
 	unz_s *s;
 	FILE * fin;
 
+	if (((unz_s*)file)->map!=NULL)
+	{
+		s=(unz_s*)ALLOC(sizeof(unz_s));
+		Com_Memcpy(s, (unz_s*)file, sizeof(unz_s));
+
+		s->map->refCount++;
+		return (unzFile)s;
+	}
+
     fin=fopen(path,"rb");
 	if (fin==NULL)
 		return NULL;
@@ -1358,6 +1402,10 @@ extern unzFile unzOpen (const char* path)
 	if (fin==NULL)
 		return NULL;
 
+	us.file=fin;
+	us.map=NULL;
+	us.map_pos=0;
+
 	central_pos = unzlocal_SearchCentralDir(fin);
 	if (central_pos==0)
 		err=UNZ_ERRNO;
@@ -1366,23 +1414,23 @@ extern unzFile unzOpen (const char* path)
 		err=UNZ_ERRNO;
 
 	/* the signature, already checked */
-	if (unzlocal_getLong(fin,&uL)!=UNZ_OK)
+	if (unzlocal_getLong(&us,&uL)!=UNZ_OK)
 		err=UNZ_ERRNO;
 
 	/* number of this disk */
-	if (unzlocal_getShort(fin,&number_disk)!=UNZ_OK)
+	if (unzlocal_getShort(&us,&number_disk)!=UNZ_OK)
 		err=UNZ_ERRNO;
 
 	/* number of the disk with the start of the central directory */
-	if (unzlocal_getShort(fin,&number_disk_with_CD)!=UNZ_OK)
+	if (unzlocal_getShort(&us,&number_disk_with_CD)!=UNZ_OK)
 		err=UNZ_ERRNO;
 
 	/* total number of entries in the central dir on this disk */
-	if (unzlocal_getShort(fin,&us.gi.number_entry)!=UNZ_OK)
+	if (unzlocal_getShort(&us,&us.gi.number_entry)!=UNZ_OK)
 		err=UNZ_ERRNO;
 
 	/* total number of entries in the central dir */
-	if (unzlocal_getShort(fin,&number_entry_CD)!=UNZ_OK)
+	if (unzlocal_getShort(&us,&number_entry_CD)!=UNZ_OK)
 		err=UNZ_ERRNO;
 
 	if ((number_entry_CD!=us.gi.number_entry) ||
@@ -1391,16 +1439,16 @@ extern unzFile unzOpen (const char* path)
 		err=UNZ_BADZIPFILE;
 
 	/* size of the central directory */
-	if (unzlocal_getLong(fin,&us.size_central_dir)!=UNZ_OK)
+	if (unzlocal_getLong(&us,&us.size_central_dir)!=UNZ_OK)
 		err=UNZ_ERRNO;
 
 	/* offset of start of central directory with respect to the 
 	      starting disk number */
-	if (unzlocal_getLong(fin,&us.offset_central_dir)!=UNZ_OK)
+	if (unzlocal_getLong(&us,&us.offset_central_dir)!=UNZ_OK)
 		err=UNZ_ERRNO;
 
 	/* zipfile comment length */
-	if (unzlocal_getShort(fin,&us.gi.size_comment)!=UNZ_OK)
+	if (unzlocal_getShort(&us,&us.gi.size_comment)!=UNZ_OK)
 		err=UNZ_ERRNO;
 
 	if ((central_pos<us.offset_central_dir+us.size_central_dir) && 
@@ -1413,7 +1461,6 @@ extern unzFile unzOpen (const char* path)
 		return NULL;
 	}
 
-	us.file=fin;
 	us.byte_before_the_zipfile = central_pos -
 		                    (us.offset_central_dir+us.size_central_dir);
 	us.central_pos = central_pos;
@@ -1427,6 +1474,47 @@ extern unzFile unzOpen (const char* path)
 }
 
 
+/*
+  Map the whole zipfile read only, the stdio file is closed once the
+    mapping is in place. Handles reopened afterwards share the mapping.
+*/
+extern int unzMapFile (unzFile file, const char* path)
+{
+	unz_s* s;
+	unz_map_s* map;
+	void* data;
+	int size;
+
+	if (file==NULL)
+		return UNZ_PARAMERROR;
+	s=(unz_s*)file;
+	if (s->map!=NULL)
+		return UNZ_OK;
+
+	data = Sys_MapFile(path,&size);
+	if (data==NULL)
+		return UNZ_ERRNO;
+
+	/* the central directory has to be inside what was mapped */
+	if ((uLong)size<s->central_pos)
+	{
+		Sys_UnmapFile(data,size);
+		return UNZ_BADZIPFILE;
+	}
+
+	map=(unz_map_s*)ALLOC(sizeof(unz_map_s));
+	map->data=(unsigned char*)data;
+	map->size=size;
+	map->refCount=1;
+
+	fclose(s->file);
+	s->file=NULL;
+	s->map=map;
+	s->map_pos=0;
+	return UNZ_OK;
+}
+
+
 /*
   Close a ZipFile opened with unzipOpen.
   If there is files inside the .Zip opened with unzipOpenCurrentFile (see later),
@@ -1442,7 +1530,16 @@ extern int unzClose (unzFile file)
     if (s->pfile_in_zip_read!=NULL)
         unzCloseCurrentFile(file);
 
-	fclose(s->file);
+	if (s->map!=NULL)
+	{
+		if (--s->map->refCount==0)
+		{
+			Sys_UnmapFile(s->map->data,s->map->size);
+			TRYFREE(s->map);
+		}
+	}
+	else
+		fclose(s->file);
 	TRYFREE(s);
 	return UNZ_OK;
 }
@@ -1503,62 +1600,62 @@ static int unzlocal_GetCurrentFileInfoInternal (unzFile file,
 	if (file==NULL)
 		return UNZ_PARAMERROR;
 	s=(unz_s*)file;
-	if (fseek(s->file,s->pos_in_central_dir+s->byte_before_the_zipfile,SEEK_SET)!=0)
+	if (unzlocal_fseek(s,s->pos_in_central_dir+s->byte_before_the_zipfile,SEEK_SET)!=0)
 		err=UNZ_ERRNO;
 
 
 	/* we check the magic */
 	if (err==UNZ_OK) {
-		if (unzlocal_getLong(s->file,&uMagic) != UNZ_OK)
+		if (unzlocal_getLong(s,&uMagic) != UNZ_OK)
 			err=UNZ_ERRNO;
 		else if (uMagic!=0x02014b50)
 			err=UNZ_BADZIPFILE;
 	}
-	if (unzlocal_getShort(s->file,&file_info.version) != UNZ_OK)
+	if (unzlocal_getShort(s,&file_info.version) != UNZ_OK)
 		err=UNZ_ERRNO;
 
-	if (unzlocal_getShort(s->file,&file_info.version_needed) != UNZ_OK)
+	if (unzlocal_getShort(s,&file_info.version_needed) != UNZ_OK)
 		err=UNZ_ERRNO;
 
-	if (unzlocal_getShort(s->file,&file_info.flag) != UNZ_OK)
+	if (unzlocal_getShort(s,&file_info.flag) != UNZ_OK)
 		err=UNZ_ERRNO;
 
-	if (unzlocal_getShort(s->file,&file_info.compression_method) != UNZ_OK)
+	if (unzlocal_getShort(s,&file_info.compression_method) != UNZ_OK)
 		err=UNZ_ERRNO;
 
-	if (unzlocal_getLong(s->file,&file_info.dosDate) != UNZ_OK)
+	if (unzlocal_getLong(s,&file_info.dosDate) != UNZ_OK)
 		err=UNZ_ERRNO;
 
     unzlocal_DosDateToTmuDate(file_info.dosDate,&file_info.tmu_date);
 
-	if (unzlocal_getLong(s->file,&file_info.crc) != UNZ_OK)
+	if (unzlocal_getLong(s,&file_info.crc) != UNZ_OK)
 		err=UNZ_ERRNO;
 
-	if (unzlocal_getLong(s->file,&file_info.compressed_size) != UNZ_OK)
+	if (unzlocal_getLong(s,&file_info.compressed_size) != UNZ_OK)
 		err=UNZ_ERRNO;
 
-	if (unzlocal_getLong(s->file,&file_info.uncompressed_size) != UNZ_OK)
+	if (unzlocal_getLong(s,&file_info.uncompressed_size) != UNZ_OK)
 		err=UNZ_ERRNO;
 
-	if (unzlocal_getShort(s->file,&file_info.size_filename) != UNZ_OK)
+	if (unzlocal_getShort(s,&file_info.size_filename) != UNZ_OK)
 		err=UNZ_ERRNO;
 
-	if (unzlocal_getShort(s->file,&file_info.size_file_extra) != UNZ_OK)
+	if (unzlocal_getShort(s,&file_info.size_file_extra) != UNZ_OK)
 		err=UNZ_ERRNO;
 
-	if (unzlocal_getShort(s->file,&file_info.size_file_comment) != UNZ_OK)
+	if (unzlocal_getShort(s,&file_info.size_file_comment) != UNZ_OK)
 		err=UNZ_ERRNO;
 
-	if (unzlocal_getShort(s->file,&file_info.disk_num_start) != UNZ_OK)
+	if (unzlocal_getShort(s,&file_info.disk_num_start) != UNZ_OK)
 		err=UNZ_ERRNO;
 
-	if (unzlocal_getShort(s->file,&file_info.internal_fa) != UNZ_OK)
+	if (unzlocal_getShort(s,&file_info.internal_fa) != UNZ_OK)
 		err=UNZ_ERRNO;
 
-	if (unzlocal_getLong(s->file,&file_info.external_fa) != UNZ_OK)
+	if (unzlocal_getLong(s,&file_info.external_fa) != UNZ_OK)
 		err=UNZ_ERRNO;
 
-	if (unzlocal_getLong(s->file,&file_info_internal.offset_curfile) != UNZ_OK)
+	if (unzlocal_getLong(s,&file_info_internal.offset_curfile) != UNZ_OK)
 		err=UNZ_ERRNO;
 
 	lSeek+=file_info.size_filename;
@@ -1574,7 +1671,7 @@ static int unzlocal_GetCurrentFileInfoInternal (unzFile file,
 			uSizeRead = fileNameBufferSize;
 
 		if ((file_info.size_filename>0) && (fileNameBufferSize>0))
-			if (fread(szFileName,(uInt)uSizeRead,1,s->file)!=1)
+			if (unzlocal_fread(s,szFileName,uSizeRead)!=1)
 				err=UNZ_ERRNO;
 		lSeek -= uSizeRead;
 	}
@@ -1589,13 +1686,13 @@ static int unzlocal_GetCurrentFileInfoInternal (unzFile file,
 			uSizeRead = extraFieldBufferSize;
 
 		if (lSeek!=0) {
-			if (fseek(s->file,lSeek,SEEK_CUR)==0)
+			if (unzlocal_fseek(s,lSeek,SEEK_CUR)==0)
 				lSeek=0;
 			else
 				err=UNZ_ERRNO;
 		}
 		if ((file_info.size_file_extra>0) && (extraFieldBufferSize>0)) {
-			if (fread(extraField,(uInt)uSizeRead,1,s->file)!=1)
+			if (unzlocal_fread(s,extraField,uSizeRead)!=1)
 				err=UNZ_ERRNO;
 		}
 		lSeek += file_info.size_file_extra - uSizeRead;
@@ -1616,13 +1713,13 @@ static int unzlocal_GetCurrentFileInfoInternal (unzFile file,
 			uSizeRead = commentBufferSize;
 
 		if (lSeek!=0) {
-			if (fseek(s->file,lSeek,SEEK_CUR)==0)
+			if (unzlocal_fseek(s,lSeek,SEEK_CUR)==0)
 				lSeek=0;
 			else
 				err=UNZ_ERRNO;
 		}
 		if ((file_info.size_file_comment>0) && (commentBufferSize>0)) {
-			if (fread(szComment,(uInt)uSizeRead,1,s->file)!=1)
+			if (unzlocal_fread(s,szComment,uSizeRead)!=1)
 				err=UNZ_ERRNO;
 		}
 		lSeek+=file_info.size_file_comment - uSizeRead;
@@ -1814,27 +1911,27 @@ static int unzlocal_CheckCurrentFileCoherencyHeader (unz_s* s, uInt* piSizeVar,
 	*poffset_local_extrafield = 0;
 	*psize_local_extrafield = 0;
 
-	if (fseek(s->file,s->cur_file_info_internal.offset_curfile +
+	if (unzlocal_fseek(s,s->cur_file_info_internal.offset_curfile +
 								s->byte_before_the_zipfile,SEEK_SET)!=0)
 		return UNZ_ERRNO;
 
 
 	if (err==UNZ_OK) {
-		if (unzlocal_getLong(s->file,&uMagic) != UNZ_OK)
+		if (unzlocal_getLong(s,&uMagic) != UNZ_OK)
 			err=UNZ_ERRNO;
 		else if (uMagic!=0x04034b50)
 			err=UNZ_BADZIPFILE;
 	}
-	if (unzlocal_getShort(s->file,&uData) != UNZ_OK)
+	if (unzlocal_getShort(s,&uData) != UNZ_OK)
 		err=UNZ_ERRNO;
 /*
 	else if ((err==UNZ_OK) && (uData!=s->cur_file_info.wVersion))
 		err=UNZ_BADZIPFILE;
 */
-	if (unzlocal_getShort(s->file,&uFlags) != UNZ_OK)
+	if (unzlocal_getShort(s,&uFlags) != UNZ_OK)
 		err=UNZ_ERRNO;
 
-	if (unzlocal_getShort(s->file,&uData) != UNZ_OK)
+	if (unzlocal_getShort(s,&uData) != UNZ_OK)
 		err=UNZ_ERRNO;
 	else if ((err==UNZ_OK) && (uData!=s->cur_file_info.compression_method))
 		err=UNZ_BADZIPFILE;
@@ -1843,36 +1940,36 @@ static int unzlocal_CheckCurrentFileCoherencyHeader (unz_s* s, uInt* piSizeVar,
                          (s->cur_file_info.compression_method!=Z_DEFLATED))
         err=UNZ_BADZIPFILE;
 
-	if (unzlocal_getLong(s->file,&uData) != UNZ_OK) /* date/time */
+	if (unzlocal_getLong(s,&uData) != UNZ_OK) /* date/time */
 		err=UNZ_ERRNO;
 
-	if (unzlocal_getLong(s->file,&uData) != UNZ_OK) /* crc */
+	if (unzlocal_getLong(s,&uData) != UNZ_OK) /* crc */
 		err=UNZ_ERRNO;
 	else if ((err==UNZ_OK) && (uData!=s->cur_file_info.crc) &&
 		                      ((uFlags & 8)==0))
 		err=UNZ_BADZIPFILE;
 
-	if (unzlocal_getLong(s->file,&uData) != UNZ_OK) /* size compr */
+	if (unzlocal_getLong(s,&uData) != UNZ_OK) /* size compr */
 		err=UNZ_ERRNO;
 	else if ((err==UNZ_OK) && (uData!=s->cur_file_info.compressed_size) &&
 							  ((uFlags & 8)==0))
 		err=UNZ_BADZIPFILE;
 
-	if (unzlocal_getLong(s->file,&uData) != UNZ_OK) /* size uncompr */
+	if (unzlocal_getLong(s,&uData) != UNZ_OK) /* size uncompr */
 		err=UNZ_ERRNO;
 	else if ((err==UNZ_OK) && (uData!=s->cur_file_info.uncompressed_size) && 
 							  ((uFlags & 8)==0))
 		err=UNZ_BADZIPFILE;
 
 
-	if (unzlocal_getShort(s->file,&size_filename) != UNZ_OK)
+	if (unzlocal_getShort(s,&size_filename) != UNZ_OK)
 		err=UNZ_ERRNO;
 	else if ((err==UNZ_OK) && (size_filename!=s->cur_file_info.size_filename))
 		err=UNZ_BADZIPFILE;
 
 	*piSizeVar += (uInt)size_filename;
 
-	if (unzlocal_getShort(s->file,&size_extra_field) != UNZ_OK)
+	if (unzlocal_getShort(s,&size_extra_field) != UNZ_OK)
 		err=UNZ_ERRNO;
 	*poffset_local_extrafield= s->cur_file_info_internal.offset_curfile +
 									SIZEZIPLOCALHEADER + size_filename;
@@ -1971,12 +2068,39 @@ extern int unzOpenCurrentFile (unzFile file)
 	
 	pfile_in_zip_read_info->stream.avail_in = (uInt)0;
 
+	/* a mapped zipfile hands inflate (or the copy) the whole compressed
+	   data at once, nothing is read through read_buffer */
+	pfile_in_zip_read_info->map = NULL;
+	if (s->map!=NULL)
+	{
+		uLong pos = pfile_in_zip_read_info->pos_in_zipfile +
+					pfile_in_zip_read_info->byte_before_the_zipfile;
+
+		if ((pos>(uLong)s->map->size) ||
+			(s->cur_file_info.compressed_size>(uLong)s->map->size - pos))
+		{
+			if (pfile_in_zip_read_info->stream_initialised)
+				inflateEnd(&pfile_in_zip_read_info->stream);
+			TRYFREE(pfile_in_zip_read_info->read_buffer);
+			TRYFREE(pfile_in_zip_read_info);
+			return UNZ_BADZIPFILE;
+		}
+
+		pfile_in_zip_read_info->map = s->map->data;
+		pfile_in_zip_read_info->stream.next_in = (Byte*)s->map->data + pos;
+		pfile_in_zip_read_info->stream.avail_in =
+				(uInt)s->cur_file_info.compressed_size;
+		pfile_in_zip_read_info->pos_in_zipfile +=
+				s->cur_file_info.compressed_size;
+		pfile_in_zip_read_info->rest_read_compressed = 0;
+	}
 
 	s->pfile_in_zip_read = pfile_in_zip_read_info;
     return UNZ_OK;
 }
 
 
+
 /*
   Read bytes from the current file.
   buf contain buffer where data must be copied
@@ -2044,16 +2168,18 @@ extern int unzReadCurrentFile  (unzFile file, void *buf, unsigned len)
 
 		if (pfile_in_zip_read_info->compression_method==0)
 		{
-			uInt uDoCopy,i ;
+			uInt uDoCopy ;
 			if (pfile_in_zip_read_info->stream.avail_out < 
                             pfile_in_zip_read_info->stream.avail_in)
 				uDoCopy = pfile_in_zip_read_info->stream.avail_out ;
 			else
 				uDoCopy = pfile_in_zip_read_info->stream.avail_in ;
-				
-			for (i=0;i<uDoCopy;i++)
-				*(pfile_in_zip_read_info->stream.next_out+i) =
-                        *(pfile_in_zip_read_info->stream.next_in+i);
+
+			if (uDoCopy == 0)
+				return (iRead==0) ? UNZ_EOF : iRead;
+
+			Com_Memcpy(pfile_in_zip_read_info->stream.next_out,
+						pfile_in_zip_read_info->stream.next_in,uDoCopy);
 					
 //			pfile_in_zip_read_info->crc32 = crc32(pfile_in_zip_read_info->crc32,
 //								pfile_in_zip_read_info->stream.next_out,
@@ -2192,6 +2318,18 @@ extern int unzGetLocalExtrafield (unzFile file,void *buf,unsigned len)
 	if (read_now==0)
 		return 0;
 	
+	if (pfile_in_zip_read_info->map!=NULL)
+	{
+		if (pfile_in_zip_read_info->offset_local_extrafield +
+			pfile_in_zip_read_info->pos_local_extrafield + read_now >
+			(uLong)s->map->size)
+			return UNZ_ERRNO;
+		Com_Memcpy(buf,pfile_in_zip_read_info->map +
+					pfile_in_zip_read_info->offset_local_extrafield +
+					pfile_in_zip_read_info->pos_local_extrafield,read_now);
+		return (int)read_now;
+	}
+
 	if (fseek(pfile_in_zip_read_info->file,
               pfile_in_zip_read_info->offset_local_extrafield + 
 			  pfile_in_zip_read_info->pos_local_extrafield,SEEK_SET)!=0)
@@ -2260,13 +2398,13 @@ extern int unzGetGlobalComment (unzFile file, char *szComment, uLong uSizeBuf)
 	if (uReadThis>s->gi.size_comment)
 		uReadThis = s->gi.size_comment;
 
-	if (fseek(s->file,s->central_pos+22,SEEK_SET)!=0)
+	if (unzlocal_fseek(s,s->central_pos+22,SEEK_SET)!=0)
 		return UNZ_ERRNO;
 
 	if (uReadThis>0)
     {
       *szComment='\0';
-	  if (fread(szComment,(uInt)uReadThis,1,s->file)!=1)
+	  if (unzlocal_fread(s,szComment,uReadThis)!=1)
 		return UNZ_ERRNO;
     }
 
@@ -132,16 +132,28 @@ typedef struct
 	unsigned long rest_read_compressed; /* number of unsigned char to be decompressed */
 	unsigned long rest_read_uncompressed; /*number of unsigned char to be obtained after decomp*/
 	FILE* file;                 /* io structore of the zipfile */
+	const unsigned char *map;   /* mapped zipfile, or NULL to read from file */
 	unsigned long compression_method;   /* compression method (0==store) */
 	unsigned long byte_before_the_zipfile; /* unsigned char before the zipfile, (>0 for sfx)*/
 } file_in_zip_read_info_s;
 
+/* unz_map_s is a read only mapping of a whole zipfile, shared by every
+	handle reopened on it */
+typedef struct
+{
+	unsigned char *data;
+	int size;
+	int refCount;
+} unz_map_s;
+
 
 /* unz_s contain internal information about the zipfile
 */
 typedef struct
 {
-	FILE* file;                 /* io structore of the zipfile */
+	FILE* file;                 /* io structore of the zipfile, NULL if mapped */
+	unz_map_s *map;             /* mapping of the zipfile, NULL if read from file */
+	unsigned long map_pos;      /* read position in the mapping */
 	unz_global_info gi;       /* public global information */
 	unsigned long byte_before_the_zipfile; /* unsigned char before the zipfile, (>0 for sfx)*/
 	unsigned long num_file;             /* number of the current file in the zipfile*/
@@ -196,6 +208,15 @@ extern unzFile unzReOpen( const char* path, unzFile file );
 	   of this unzip package.
 */
 
+extern int unzMapFile( unzFile file, const char *path );
+
+/*
+  Map the whole zipfile read only and close its stdio file. Handles
+	reopened afterwards share the mapping, stored files are copied and
+	deflated files inflated straight out of it.
+  return UNZ_OK if the file is mapped, the handle keeps using stdio otherwise
+*/
+
 extern int unzClose( unzFile file );
 
 /*
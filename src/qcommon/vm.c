@@ -46,10 +46,15 @@ and one exported function: Perform
 vm_t    *currentVM = NULL; // bk001212
 vm_t    *lastVM    = NULL; // bk001212
 int vm_debugLevel;
+cvar_t  *vm_benchRecord;
 
 #define MAX_VM      3
 vm_t vmTable[MAX_VM];
 
+#if defined( __MACOS__ )
+#define DLL_ONLY    //DAJ
+#endif
+
 
 void VM_VmInfo_f( void );
 void VM_VmProfile_f( void );
@@ -74,6 +79,7 @@ void VM_Init( void ) {
 	Cvar_Get( "vm_cgame", "0", CVAR_ARCHIVE );
 	Cvar_Get( "vm_game",  "0", CVAR_ARCHIVE );
 	Cvar_Get( "vm_ui",    "0", CVAR_ARCHIVE );
+	vm_benchRecord = Cvar_Get( "vm_benchRecord", "", CVAR_CHEAT );
 
 	Cmd_AddCommand( "vmprofile", VM_VmProfile_f );
 	Cmd_AddCommand( "vminfo", VM_VmInfo_f );
@@ -380,6 +386,8 @@ vm_t *VM_Restart( vm_t *vm ) {
 		return vm;
 	}
 
+	VM_BenchForget( vm );
+
 	// load the image
 	Com_Printf( "VM_Restart()\n" );
 	Com_sprintf( filename, sizeof( filename ), "vm/%s.qvm", vm->name );
@@ -432,8 +440,8 @@ vm_t *VM_Restart( vm_t *vm ) {
 ================
 VM_Create
 
-If image ends in .qvm it will be interpreted, otherwise
-it will attempt to load as a system dll
+VMI_NATIVE loads the system dll and falls back to compiling
+vm/<module>.qvm if there is none, the others load the qvm
 ================
 */
 
@@ -481,11 +489,16 @@ vm_t *VM_Create( const char *module, int ( *systemCalls )(int *),
 	if ( interpret == VMI_NATIVE ) {
 		// try to load as a system dll
 		vm->dllHandle = Sys_LoadDll( module, vm->fqpath, &vm->entryPoint, VM_DllSyscall );
-		// TTimo - never try qvm
 		if ( vm->dllHandle ) {
 			return vm;
 		}
+#ifdef DLL_ONLY
+		// TTimo - never try qvm
 		return NULL;
+#else
+		Com_Printf( "Failed to load dll, looking for qvm.\n" );
+		interpret = VMI_COMPILED;
+#endif
 	}
 
 	// load the image
@@ -569,10 +582,16 @@ VM_Free
 */
 void VM_Free( vm_t *vm ) {
 
+	VM_BenchForget( vm );
+
 	if ( vm->dllHandle ) {
 		Sys_UnloadDll( vm->dllHandle );
 		Com_Memset( vm, 0, sizeof( *vm ) );
 	}
+	if ( vm->compiled ) {
+		// code that didn't go on the hunk
+		VM_FreeCompiled( vm );
+	}
 #if 0   // now automatically freed by hunk
 	if ( vm->codeBase ) {
 		Z_Free( vm->codeBase );
@@ -593,9 +612,13 @@ void VM_Free( vm_t *vm ) {
 void VM_Clear( void ) {
 	int i;
 	for ( i = 0; i < MAX_VM; i++ ) {
+		VM_BenchForget( &vmTable[i] );
 		if ( vmTable[i].dllHandle ) {
 			Sys_UnloadDll( vmTable[i].dllHandle );
 		}
+		if ( vmTable[i].compiled ) {
+			VM_FreeCompiled( &vmTable[i] );
+		}
 		Com_Memset( &vmTable[i], 0, sizeof( vm_t ) );
 	}
 	currentVM = NULL;
@@ -666,11 +689,12 @@ locals from sp
 int QDECL VM_Call( vm_t *vm, int callnum, ... ) {
 	vm_t    *oldVM;
 	int r;
+	int i;
+	int vmArgs[MAX_VMMAIN_ARGS];
+	va_list ap;
 	//rcg010207 see dissertation at top of VM_DllSyscall() in this file.
 #if ( ( defined __linux__ ) && ( defined __powerpc__ ) ) || ( defined MACOS_X )
-	int i;
 	int args[16];
-	va_list ap;
 #endif
 
 	if ( !vm ) {
@@ -703,10 +727,22 @@ int QDECL VM_Call( vm_t *vm, int callnum, ... ) {
 							( &callnum )[4], ( &callnum )[5], ( &callnum )[6], ( &callnum )[7],
 							( &callnum )[8],  ( &callnum )[9],  ( &callnum )[10],  ( &callnum )[11],  ( &callnum )[12] );
 #endif
-	} else if ( vm->compiled ) {
-		r = VM_CallCompiled( vm, &callnum );
 	} else {
-		r = VM_CallInterpreted( vm, &callnum );
+		// the arguments can't be read past &callnum on every abi
+		vmArgs[0] = callnum;
+		va_start( ap, callnum );
+		for ( i = 1; i < MAX_VMMAIN_ARGS; i++ )
+			vmArgs[i] = va_arg( ap, int );
+		va_end( ap );
+
+		if ( vm->compiled ) {
+			r = VM_CallCompiled( vm, vmArgs );
+		} else {
+			if ( vm_benchRecord->string[0] ) {
+				VM_BenchRecordCall( vm, vmArgs );
+			}
+			r = VM_CallInterpreted( vm, vmArgs );
+		}
 	}
 
 	if ( oldVM != NULL ) { // bk001220 - assert(currentVM!=NULL) for oldVM==NULL
@@ -830,14 +866,12 @@ void VM_LogSyscalls( int *args ) {
 			 args[0], args[1], args[2], args[3], args[4] );
 }
 
-#if defined( __MACOS__ )
-#define DLL_ONLY    //DAJ
-#endif
-
 #ifdef DLL_ONLY // bk010215 - for DLL_ONLY dedicated servers/builds w/o VM
 int VM_CallCompiled( vm_t *vm, int *args ) {
 	return( 0 );
 }
 
 void VM_Compile( vm_t *vm, vmHeader_t *header ) {}
+
+void VM_FreeCompiled( vm_t *vm ) {}
 #endif // DLL_ONLY
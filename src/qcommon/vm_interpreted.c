@@ -28,6 +28,18 @@ If you have questions concerning this license or the applicable additional terms
 
 #include "vm_local.h"
 
+// superinstructions, only created by VM_PrepareInterpreter from an
+// instruction and the one following it
+#define OP_CONST_LOAD4      ( OP_CVFI + 1 )     // CONST + LOAD4, address premasked
+#define OP_LOCAL_LOAD4      ( OP_CVFI + 2 )     // LOCAL + LOAD4
+#define OP_CONST_CALL       ( OP_CVFI + 3 )     // CONST + CALL, target translated to a pc
+#define OP_MAX_INTERPRETED  ( OP_CVFI + 4 )
+
+// gcc can dispatch each instruction with its own indirect jump
+#if defined( __GNUC__ )
+#define USE_COMPUTED_GOTO
+#endif
+
 #ifdef DEBUG_VM // bk001204
 static char *opnames[256] = {
 	"OP_UNDEF",
@@ -114,7 +126,11 @@ static char *opnames[256] = {
 	"OP_MULF",
 
 	"OP_CVIF",
-	"OP_CVFI"
+	"OP_CVFI",
+
+	"OP_CONST_LOAD4",
+	"OP_LOCAL_LOAD4",
+	"OP_CONST_CALL"
 };
 #endif
 
@@ -156,25 +172,23 @@ void VM_StackTrace( vm_t *vm, int programCounter, int programStack ) {
 
 /*
 ====================
-VM_PrepareInterpreter
+VM_TranslateCode
+
+Unpacks the bytecode into codeBase, vmbench asks for it without the
+superinstructions
 ====================
 */
-void VM_PrepareInterpreter( vm_t *vm, vmHeader_t *header ) {
-	int op;
-	int pc;
+static void VM_TranslateCode( vm_t *vm, vmHeader_t *header, int *codeBase, qboolean fuse ) {
+	int op, lastOp;
+	int pc, lastPc;
 	byte    *code;
 	int instruction;
-	int     *codeBase;
-
-	vm->codeBase = Hunk_Alloc( vm->codeLength * 4, h_high );          // we're now int aligned
-//	memcpy( vm->codeBase, (byte *)header + header->codeOffset, vm->codeLength );
 
 	// we don't need to translate the instructions, but we still need
 	// to find each instructions starting point for jumps
 	pc = 0;
 	instruction = 0;
 	code = (byte *)header + header->codeOffset;
-	codeBase = (int *)vm->codeBase;
 
 	while ( instruction < header->instructionCount ) {
 		vm->instructionPointers[ instruction ] = pc;
@@ -185,6 +199,9 @@ void VM_PrepareInterpreter( vm_t *vm, vmHeader_t *header ) {
 		if ( pc > header->codeLength ) {
 			Com_Error( ERR_FATAL, "VM_PrepareInterpreter: pc > header->codeLength" );
 		}
+		if ( op > OP_CVFI ) {
+			Com_Error( ERR_FATAL, "VM_PrepareInterpreter: bad opcode %i at offset %i", op, pc );
+		}
 
 		pc++;
 
@@ -225,12 +242,30 @@ void VM_PrepareInterpreter( vm_t *vm, vmHeader_t *header ) {
 	}
 	pc = 0;
 	instruction = 0;
-	code = (byte *)header + header->codeOffset;
-	codeBase = (int *)vm->codeBase;
+	lastOp = OP_UNDEF;
+	lastPc = 0;
 
 	while ( instruction < header->instructionCount ) {
 		op = code[ pc ];
 		instruction++;
+
+		// fuse common pairs into the first instruction, the second one is
+		// left in place so jumps to it still work
+		if ( fuse ) {
+			if ( op == OP_LOAD4 && lastOp == OP_CONST ) {
+				codeBase[lastPc] = OP_CONST_LOAD4;
+				codeBase[lastPc + 1] &= vm->dataMask;
+			} else if ( op == OP_LOAD4 && lastOp == OP_LOCAL ) {
+				codeBase[lastPc] = OP_LOCAL_LOAD4;
+			} else if ( op == OP_CALL && lastOp == OP_CONST
+						&& codeBase[lastPc + 1] >= 0 && codeBase[lastPc + 1] < header->instructionCount ) {
+				codeBase[lastPc] = OP_CONST_CALL;
+				codeBase[lastPc + 1] = vm->instructionPointers[codeBase[lastPc + 1]];
+			}
+		}
+		lastOp = op;
+		lastPc = pc;
+
 		pc++;
 		switch ( op ) {
 		case OP_ENTER:
@@ -288,6 +323,16 @@ void VM_PrepareInterpreter( vm_t *vm, vmHeader_t *header ) {
 	}
 }
 
+/*
+====================
+VM_PrepareInterpreter
+====================
+*/
+void VM_PrepareInterpreter( vm_t *vm, vmHeader_t *header ) {
+	vm->codeBase = Hunk_Alloc( vm->codeLength * 4, h_high );          // we're now int aligned
+	VM_TranslateCode( vm, header, (int *)vm->codeBase, qtrue );
+}
+
 /*
 ==============
 VM_Call
@@ -327,6 +372,9 @@ int VM_CallInterpreted( vm_t *vm, int *args ) {
 	int     *codeImage;
 	int v1;
 	int dataMask;
+#ifdef USE_COMPUTED_GOTO
+	const void * const *dispatch;
+#endif
 #ifdef DEBUG_VM
 	vmSymbol_t  *profileSymbol;
 #endif
@@ -379,6 +427,39 @@ int VM_CallInterpreted( vm_t *vm, int *args ) {
 
 #define r2 codeImage[programCounter]
 
+#ifdef USE_COMPUTED_GOTO
+#define VM_CASE( op )   case op: label_ ## op
+	static const void *dispatchTable[OP_MAX_INTERPRETED] = {
+		&&label_OP_UNDEF, &&label_OP_IGNORE, &&label_OP_BREAK,
+		&&label_OP_ENTER, &&label_OP_LEAVE, &&label_OP_CALL, &&label_OP_PUSH, &&label_OP_POP,
+		&&label_OP_CONST, &&label_OP_LOCAL, &&label_OP_JUMP,
+		&&label_OP_EQ, &&label_OP_NE,
+		&&label_OP_LTI, &&label_OP_LEI, &&label_OP_GTI, &&label_OP_GEI,
+		&&label_OP_LTU, &&label_OP_LEU, &&label_OP_GTU, &&label_OP_GEU,
+		&&label_OP_EQF, &&label_OP_NEF,
+		&&label_OP_LTF, &&label_OP_LEF, &&label_OP_GTF, &&label_OP_GEF,
+		&&label_OP_LOAD1, &&label_OP_LOAD2, &&label_OP_LOAD4,
+		&&label_OP_STORE1, &&label_OP_STORE2, &&label_OP_STORE4, &&label_OP_ARG,
+		&&label_OP_BLOCK_COPY,
+		&&label_OP_SEX8, &&label_OP_SEX16,
+		&&label_OP_NEGI, &&label_OP_ADD, &&label_OP_SUB, &&label_OP_DIVI, &&label_OP_DIVU,
+		&&label_OP_MODI, &&label_OP_MODU, &&label_OP_MULI, &&label_OP_MULU,
+		&&label_OP_BAND, &&label_OP_BOR, &&label_OP_BXOR, &&label_OP_BCOM,
+		&&label_OP_LSH, &&label_OP_RSHI, &&label_OP_RSHU,
+		&&label_OP_NEGF, &&label_OP_ADDF, &&label_OP_SUBF, &&label_OP_DIVF, &&label_OP_MULF,
+		&&label_OP_CVIF, &&label_OP_CVFI,
+		&&label_OP_CONST_LOAD4, &&label_OP_LOCAL_LOAD4, &&label_OP_CONST_CALL
+	};
+	// vmbench measures this against sending every opcode through the switch
+	static const void *switchTable[OP_MAX_INTERPRETED] = {
+		[0 ... OP_MAX_INTERPRETED - 1] = &&dispatchSwitch
+	};
+
+	dispatch = vm->switchDispatch ? switchTable : dispatchTable;
+#else
+#define VM_CASE( op )   case op
+#endif
+
 	while ( 1 ) {
 		int opcode, r0, r1;
 //		unsigned int	r2;
@@ -414,22 +495,29 @@ nextInstruction2:
 		profileSymbol->profileCount++;
 #endif
 
+#ifdef USE_COMPUTED_GOTO
+		goto *dispatch[ opcode ];
+dispatchSwitch:
+#endif
 		switch ( opcode ) {
 #ifdef DEBUG_VM
 		default:
 			Com_Error( ERR_DROP, "Bad VM instruction" );  // this should be scanned on load!
 #endif
-		case OP_BREAK:
+		VM_CASE( OP_UNDEF ):
+		VM_CASE( OP_IGNORE ):
+			goto nextInstruction;
+		VM_CASE( OP_BREAK ):
 			vm->breakCount++;
 			goto nextInstruction2;
-		case OP_CONST:
+		VM_CASE( OP_CONST ):
 			opStack++;
 			r1 = r0;
 			r0 = *opStack = r2;
 
 			programCounter += 4;
 			goto nextInstruction2;
-		case OP_LOCAL:
+		VM_CASE( OP_LOCAL ):
 			opStack++;
 			r1 = r0;
 			r0 = *opStack = r2 + programStack;
@@ -437,7 +525,22 @@ nextInstruction2:
 			programCounter += 4;
 			goto nextInstruction2;
 
-		case OP_LOAD4:
+		VM_CASE( OP_CONST_LOAD4 ):
+			opStack++;
+			r1 = r0;
+			r0 = *opStack = *(int *)&image[ r2 ];
+
+			programCounter += 5;
+			goto nextInstruction2;
+		VM_CASE( OP_LOCAL_LOAD4 ):
+			opStack++;
+			r1 = r0;
+			r0 = *opStack = *(int *)&image[ ( r2 + programStack ) & dataMask ];
+
+			programCounter += 5;
+			goto nextInstruction2;
+
+		VM_CASE( OP_LOAD4 ):
 #ifdef DEBUG_VM
 			if ( *opStack & 3 ) {
 				Com_Error( ERR_DROP, "OP_LOAD4 misaligned" );
@@ -445,34 +548,34 @@ nextInstruction2:
 #endif
 			r0 = *opStack = *(int *)&image[ r0 & dataMask ];
 			goto nextInstruction2;
-		case OP_LOAD2:
+		VM_CASE( OP_LOAD2 ):
 			r0 = *opStack = *(unsigned short *)&image[ r0 & dataMask ];
 			goto nextInstruction2;
-		case OP_LOAD1:
+		VM_CASE( OP_LOAD1 ):
 			r0 = *opStack = image[ r0 & dataMask ];
 			goto nextInstruction2;
 
-		case OP_STORE4:
+		VM_CASE( OP_STORE4 ):
 			*(int *)&image[ r1 & ( dataMask & ~3 ) ] = r0;
 			opStack -= 2;
 			goto nextInstruction;
-		case OP_STORE2:
+		VM_CASE( OP_STORE2 ):
 			*(short *)&image[ r1 & ( dataMask & ~1 ) ] = r0;
 			opStack -= 2;
 			goto nextInstruction;
-		case OP_STORE1:
+		VM_CASE( OP_STORE1 ):
 			image[ r1 & dataMask ] = r0;
 			opStack -= 2;
 			goto nextInstruction;
 
-		case OP_ARG:
+		VM_CASE( OP_ARG ):
 			// single byte offset from programStack
 			*(int *)&image[ codeImage[programCounter] + programStack ] = r0;
 			opStack--;
 			programCounter += 1;
 			goto nextInstruction;
 
-		case OP_BLOCK_COPY:
+		VM_CASE( OP_BLOCK_COPY ):
 		{
 			int     *src, *dest;
 			int i, count, srci, desti;
@@ -498,7 +601,7 @@ nextInstruction2:
 		}
 			goto nextInstruction;
 
-		case OP_CALL:
+		VM_CASE( OP_CALL ):
 			// save current program counter
 			*(int *)&image[ programStack ] = programCounter;
 
@@ -548,15 +651,23 @@ nextInstruction2:
 			}
 			goto nextInstruction;
 
+		VM_CASE( OP_CONST_CALL ):
+			// call with a constant target, already translated
+			v1 = r2;
+			programCounter += 5;
+			*(int *)&image[ programStack ] = programCounter;
+			programCounter = v1;
+			goto nextInstruction;
+
 			// push and pop are only needed for discarded or bad function return values
-		case OP_PUSH:
+		VM_CASE( OP_PUSH ):
 			opStack++;
 			goto nextInstruction;
-		case OP_POP:
+		VM_CASE( OP_POP ):
 			opStack--;
 			goto nextInstruction;
 
-		case OP_ENTER:
+		VM_CASE( OP_ENTER ):
 #ifdef DEBUG_VM
 			profileSymbol = VM_ValueToFunctionSymbol( vm, programCounter );
 #endif
@@ -580,7 +691,7 @@ nextInstruction2:
 			}
 #endif
 			goto nextInstruction;
-		case OP_LEAVE:
+		VM_CASE( OP_LEAVE ):
 			// remove our stack frame
 			v1 = r2;
 
@@ -607,13 +718,13 @@ nextInstruction2:
 			===================================================================
 			*/
 
-		case OP_JUMP:
+		VM_CASE( OP_JUMP ):
 			programCounter = r0;
 			programCounter = vm->instructionPointers[ programCounter ];
 			opStack--;
 			goto nextInstruction;
 
-		case OP_EQ:
+		VM_CASE( OP_EQ ):
 			opStack -= 2;
 			if ( r1 == r0 ) {
 				programCounter = r2;    //vm->instructionPointers[r2];
@@ -623,7 +734,7 @@ nextInstruction2:
 				goto nextInstruction;
 			}
 
-		case OP_NE:
+		VM_CASE( OP_NE ):
 			opStack -= 2;
 			if ( r1 != r0 ) {
 				programCounter = r2;    //vm->instructionPointers[r2];
@@ -633,7 +744,7 @@ nextInstruction2:
 				goto nextInstruction;
 			}
 
-		case OP_LTI:
+		VM_CASE( OP_LTI ):
 			opStack -= 2;
 			if ( r1 < r0 ) {
 				programCounter = r2;    //vm->instructionPointers[r2];
@@ -643,7 +754,7 @@ nextInstruction2:
 				goto nextInstruction;
 			}
 
-		case OP_LEI:
+		VM_CASE( OP_LEI ):
 			opStack -= 2;
 			if ( r1 <= r0 ) {
 				programCounter = r2;    //vm->instructionPointers[r2];
@@ -653,7 +764,7 @@ nextInstruction2:
 				goto nextInstruction;
 			}
 
-		case OP_GTI:
+		VM_CASE( OP_GTI ):
 			opStack -= 2;
 			if ( r1 > r0 ) {
 				programCounter = r2;    //vm->instructionPointers[r2];
@@ -663,7 +774,7 @@ nextInstruction2:
 				goto nextInstruction;
 			}
 
-		case OP_GEI:
+		VM_CASE( OP_GEI ):
 			opStack -= 2;
 			if ( r1 >= r0 ) {
 				programCounter = r2;    //vm->instructionPointers[r2];
@@ -673,7 +784,7 @@ nextInstruction2:
 				goto nextInstruction;
 			}
 
-		case OP_LTU:
+		VM_CASE( OP_LTU ):
 			opStack -= 2;
 			if ( ( (unsigned)r1 ) < ( (unsigned)r0 ) ) {
 				programCounter = r2;    //vm->instructionPointers[r2];
@@ -683,7 +794,7 @@ nextInstruction2:
 				goto nextInstruction;
 			}
 
-		case OP_LEU:
+		VM_CASE( OP_LEU ):
 			opStack -= 2;
 			if ( ( (unsigned)r1 ) <= ( (unsigned)r0 ) ) {
 				programCounter = r2;    //vm->instructionPointers[r2];
@@ -693,7 +804,7 @@ nextInstruction2:
 				goto nextInstruction;
 			}
 
-		case OP_GTU:
+		VM_CASE( OP_GTU ):
 			opStack -= 2;
 			if ( ( (unsigned)r1 ) > ( (unsigned)r0 ) ) {
 				programCounter = r2;    //vm->instructionPointers[r2];
@@ -703,7 +814,7 @@ nextInstruction2:
 				goto nextInstruction;
 			}
 
-		case OP_GEU:
+		VM_CASE( OP_GEU ):
 			opStack -= 2;
 			if ( ( (unsigned)r1 ) >= ( (unsigned)r0 ) ) {
 				programCounter = r2;    //vm->instructionPointers[r2];
@@ -713,7 +824,7 @@ nextInstruction2:
 				goto nextInstruction;
 			}
 
-		case OP_EQF:
+		VM_CASE( OP_EQF ):
 			if ( ( (float *)opStack )[-1] == *(float *)opStack ) {
 				programCounter = r2;    //vm->instructionPointers[r2];
 				opStack -= 2;
@@ -724,7 +835,7 @@ nextInstruction2:
 				goto nextInstruction;
 			}
 
-		case OP_NEF:
+		VM_CASE( OP_NEF ):
 			if ( ( (float *)opStack )[-1] != *(float *)opStack ) {
 				programCounter = r2;    //vm->instructionPointers[r2];
 				opStack -= 2;
@@ -735,7 +846,7 @@ nextInstruction2:
 				goto nextInstruction;
 			}
 
-		case OP_LTF:
+		VM_CASE( OP_LTF ):
 			if ( ( (float *)opStack )[-1] < *(float *)opStack ) {
 				programCounter = r2;    //vm->instructionPointers[r2];
 				opStack -= 2;
@@ -746,7 +857,7 @@ nextInstruction2:
 				goto nextInstruction;
 			}
 
-		case OP_LEF:
+		VM_CASE( OP_LEF ):
 			if ( ( (float *)opStack )[-1] <= *(float *)opStack ) {
 				programCounter = r2;    //vm->instructionPointers[r2];
 				opStack -= 2;
@@ -757,7 +868,7 @@ nextInstruction2:
 				goto nextInstruction;
 			}
 
-		case OP_GTF:
+		VM_CASE( OP_GTF ):
 			if ( ( (float *)opStack )[-1] > *(float *)opStack ) {
 				programCounter = r2;    //vm->instructionPointers[r2];
 				opStack -= 2;
@@ -768,7 +879,7 @@ nextInstruction2:
 				goto nextInstruction;
 			}
 
-		case OP_GEF:
+		VM_CASE( OP_GEF ):
 			if ( ( (float *)opStack )[-1] >= *(float *)opStack ) {
 				programCounter = r2;    //vm->instructionPointers[r2];
 				opStack -= 2;
@@ -782,101 +893,101 @@ nextInstruction2:
 
 			//===================================================================
 
-		case OP_NEGI:
+		VM_CASE( OP_NEGI ):
 			*opStack = -r0;
 			goto nextInstruction;
-		case OP_ADD:
+		VM_CASE( OP_ADD ):
 			opStack[-1] = r1 + r0;
 			opStack--;
 			goto nextInstruction;
-		case OP_SUB:
+		VM_CASE( OP_SUB ):
 			opStack[-1] = r1 - r0;
 			opStack--;
 			goto nextInstruction;
-		case OP_DIVI:
+		VM_CASE( OP_DIVI ):
 			opStack[-1] = r1 / r0;
 			opStack--;
 			goto nextInstruction;
-		case OP_DIVU:
+		VM_CASE( OP_DIVU ):
 			opStack[-1] = ( (unsigned)r1 ) / ( (unsigned)r0 );
 			opStack--;
 			goto nextInstruction;
-		case OP_MODI:
+		VM_CASE( OP_MODI ):
 			opStack[-1] = r1 % r0;
 			opStack--;
 			goto nextInstruction;
-		case OP_MODU:
+		VM_CASE( OP_MODU ):
 			opStack[-1] = ( (unsigned)r1 ) % (unsigned)r0;
 			opStack--;
 			goto nextInstruction;
-		case OP_MULI:
+		VM_CASE( OP_MULI ):
 			opStack[-1] = r1 * r0;
 			opStack--;
 			goto nextInstruction;
-		case OP_MULU:
+		VM_CASE( OP_MULU ):
 			opStack[-1] = ( (unsigned)r1 ) * ( (unsigned)r0 );
 			opStack--;
 			goto nextInstruction;
 
-		case OP_BAND:
+		VM_CASE( OP_BAND ):
 			opStack[-1] = ( (unsigned)r1 ) & ( (unsigned)r0 );
 			opStack--;
 			goto nextInstruction;
-		case OP_BOR:
+		VM_CASE( OP_BOR ):
 			opStack[-1] = ( (unsigned)r1 ) | ( (unsigned)r0 );
 			opStack--;
 			goto nextInstruction;
-		case OP_BXOR:
+		VM_CASE( OP_BXOR ):
 			opStack[-1] = ( (unsigned)r1 ) ^ ( (unsigned)r0 );
 			opStack--;
 			goto nextInstruction;
-		case OP_BCOM:
+		VM_CASE( OP_BCOM ):
 			opStack[-1] = ~( (unsigned)r0 );
 			goto nextInstruction;
 
-		case OP_LSH:
+		VM_CASE( OP_LSH ):
 			opStack[-1] = r1 << r0;
 			opStack--;
 			goto nextInstruction;
-		case OP_RSHI:
+		VM_CASE( OP_RSHI ):
 			opStack[-1] = r1 >> r0;
 			opStack--;
 			goto nextInstruction;
-		case OP_RSHU:
+		VM_CASE( OP_RSHU ):
 			opStack[-1] = ( (unsigned)r1 ) >> r0;
 			opStack--;
 			goto nextInstruction;
 
-		case OP_NEGF:
+		VM_CASE( OP_NEGF ):
 			*(float *)opStack =  -*(float *)opStack;
 			goto nextInstruction;
-		case OP_ADDF:
+		VM_CASE( OP_ADDF ):
 			*( float * )( opStack - 1 ) = *( float * )( opStack - 1 ) + *(float *)opStack;
 			opStack--;
 			goto nextInstruction;
-		case OP_SUBF:
+		VM_CASE( OP_SUBF ):
 			*( float * )( opStack - 1 ) = *( float * )( opStack - 1 ) - *(float *)opStack;
 			opStack--;
 			goto nextInstruction;
-		case OP_DIVF:
+		VM_CASE( OP_DIVF ):
 			*( float * )( opStack - 1 ) = *( float * )( opStack - 1 ) / *(float *)opStack;
 			opStack--;
 			goto nextInstruction;
-		case OP_MULF:
+		VM_CASE( OP_MULF ):
 			*( float * )( opStack - 1 ) = *( float * )( opStack - 1 ) * *(float *)opStack;
 			opStack--;
 			goto nextInstruction;
 
-		case OP_CVIF:
+		VM_CASE( OP_CVIF ):
 			*(float *)opStack =  (float)*opStack;
 			goto nextInstruction;
-		case OP_CVFI:
+		VM_CASE( OP_CVFI ):
 			*opStack = (int) *(float *)opStack;
 			goto nextInstruction;
-		case OP_SEX8:
+		VM_CASE( OP_SEX8 ):
 			*opStack = (signed char)*opStack;
 			goto nextInstruction;
-		case OP_SEX16:
+		VM_CASE( OP_SEX16 ):
 			*opStack = (short)*opStack;
 			goto nextInstruction;
 		}
@@ -894,3 +1005,211 @@ done:
 	// return the result
 	return *opStack;
 }
+
+/*
+==============================================================================
+
+VM BENCHMARK
+
+set vm_benchRecord to the name of an interpreted vm and the data segment
+is saved, followed by the next MAX_BENCH_CALLS calls the engine makes into it
+
+==============================================================================
+*/
+
+#define MAX_BENCH_CALLS     16384
+
+typedef struct {
+	int args[MAX_VMMAIN_ARGS];
+} benchCall_t;
+
+static vm_t        *vm_benchVM;            // the vm the calls were recorded from
+static byte        *vm_benchData;          // its data segment when recording started
+static benchCall_t *vm_benchCalls;
+static int vm_numBenchCalls;
+static qboolean vm_benchReplaying;
+
+/*
+==============
+VM_BenchForget
+==============
+*/
+void VM_BenchForget( vm_t *vm ) {
+	if ( vm && vm != vm_benchVM ) {
+		return;
+	}
+	if ( vm_benchData ) {
+		free( vm_benchData );
+	}
+	if ( vm_benchCalls ) {
+		free( vm_benchCalls );
+	}
+	vm_benchVM = NULL;
+	vm_benchData = NULL;
+	vm_benchCalls = NULL;
+	vm_numBenchCalls = 0;
+}
+
+/*
+==============
+VM_BenchRecordCall
+
+Called from VM_Call for interpreted vms while vm_benchRecord is set
+==============
+*/
+void VM_BenchRecordCall( vm_t *vm, int *args ) {
+	if ( vm_benchReplaying || Q_stricmp( vm_benchRecord->string, vm->name ) ) {
+		return;
+	}
+
+	// only calls made from outside the vm, the replay makes the others again
+	if ( vm->programStack != vm->dataMask + 1 ) {
+		return;
+	}
+
+	// setting the cvar again starts a new recording
+	if ( vm_benchRecord->modified ) {
+		vm_benchRecord->modified = qfalse;
+		VM_BenchForget( NULL );
+	}
+
+	if ( !vm_benchVM ) {
+		vm_benchData = malloc( vm->dataMask + 1 );
+		vm_benchCalls = malloc( MAX_BENCH_CALLS * sizeof( *vm_benchCalls ) );
+		if ( !vm_benchData || !vm_benchCalls ) {
+			VM_BenchForget( NULL );
+			Com_Printf( "vm_benchRecord: out of memory\n" );
+			Cvar_Set( "vm_benchRecord", "" );
+			vm_benchRecord->modified = qfalse;
+			return;
+		}
+		Com_Memcpy( vm_benchData, vm->dataBase, vm->dataMask + 1 );
+		vm_benchVM = vm;
+	}
+
+	Com_Memcpy( vm_benchCalls[vm_numBenchCalls].args, args, sizeof( vm_benchCalls[0].args ) );
+	vm_numBenchCalls++;
+
+	if ( vm_numBenchCalls == MAX_BENCH_CALLS ) {
+		Com_Printf( "vm_benchRecord: recorded %i %s calls\n", vm_numBenchCalls, vm->name );
+		Cvar_Set( "vm_benchRecord", "" );
+		vm_benchRecord->modified = qfalse;
+	}
+}
+
+/*
+==============
+VM_Bench_f
+
+Replays the recorded calls from the saved data segment, first on the plain
+bytecode with every instruction going through the switch, then on the
+code with superinstructions and threaded dispatch.  The system calls are
+real, so whatever they do outside the vm happens once per pass; record
+on a local game with nothing else going on.
+==============
+*/
+void VM_Bench_f( void ) {
+	vm_t        *vm;
+	vmHeader_t  *header;
+	char filename[MAX_QPATH];
+	byte        *threadedCode, *liveData;
+	int         *plainCode, *results, *a;
+	int i, r, pass, passes, mode, mismatches;
+	int t0, times[2];
+
+	vm = vm_benchVM;
+	if ( !vm || !vm_numBenchCalls ) {
+		Com_Printf( "no vm calls recorded, set vm_benchRecord to an interpreted vm (vm_game 1 etc) and play for a while\n" );
+		return;
+	}
+	if ( vm->programStack != vm->dataMask + 1 ) {
+		Com_Printf( "can't run vmbench from inside %s\n", vm->name );
+		return;
+	}
+
+	passes = atoi( Cmd_Argv( 1 ) );
+	if ( passes <= 0 ) {
+		passes = 10;
+	}
+
+	// the plain code is translated from the file again
+	Com_sprintf( filename, sizeof( filename ), "vm/%s.qvm", vm->name );
+	FS_ReadFile( filename, (void **)&header );
+	if ( !header ) {
+		Com_Printf( "couldn't load %s\n", filename );
+		return;
+	}
+	for ( i = 0 ; i < sizeof( *header ) / 4 ; i++ ) {
+		( (int *)header )[i] = LittleLong( ( (int *)header )[i] );
+	}
+	if ( header->vmMagic != VM_MAGIC || header->codeLength != vm->codeLength
+		 || header->instructionCount * 4 != vm->instructionPointersLength ) {
+		Com_Printf( "%s has changed since it was loaded\n", filename );
+		FS_FreeFile( header );
+		return;
+	}
+
+	plainCode = malloc( vm->codeLength * 4 );
+	liveData = malloc( vm->dataMask + 1 );
+	if ( !plainCode || !liveData ) {
+		Com_Printf( "vmbench: out of memory\n" );
+		if ( plainCode ) {
+			free( plainCode );
+		}
+		if ( liveData ) {
+			free( liveData );
+		}
+		FS_FreeFile( header );
+		return;
+	}
+	VM_TranslateCode( vm, header, plainCode, qfalse );
+	FS_FreeFile( header );
+
+	results = Z_Malloc( vm_numBenchCalls * sizeof( *results ) );
+	threadedCode = vm->codeBase;
+	Com_Memcpy( liveData, vm->dataBase, vm->dataMask + 1 );
+	vm_benchReplaying = qtrue;
+
+	mismatches = 0;
+	for ( mode = 0 ; mode < 2 ; mode++ ) {
+		vm->codeBase = mode ? threadedCode : (byte *)plainCode;
+		vm->switchDispatch = !mode;
+		times[mode] = 0;
+		for ( pass = 0 ; pass < passes ; pass++ ) {
+			Com_Memcpy( vm->dataBase, vm_benchData, vm->dataMask + 1 );
+			t0 = Sys_Milliseconds();
+			for ( i = 0 ; i < vm_numBenchCalls ; i++ ) {
+				a = vm_benchCalls[i].args;
+				r = VM_Call( vm, a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7], a[8], a[9], a[10], a[11], a[12] );
+				if ( pass ) {
+					continue;
+				}
+				if ( !mode ) {
+					results[i] = r;
+				} else if ( r != results[i] ) {
+					mismatches++;
+				}
+			}
+			times[mode] += Sys_Milliseconds() - t0;
+		}
+	}
+
+	// put the vm back the way the game left it
+	vm->codeBase = threadedCode;
+	vm->switchDispatch = qfalse;
+	Com_Memcpy( vm->dataBase, liveData, vm->dataMask + 1 );
+	vm_benchReplaying = qfalse;
+
+	Z_Free( results );
+	free( liveData );
+	free( plainCode );
+
+	Com_Printf( "%i x %i %s calls\n", passes, vm_numBenchCalls, vm->name );
+	Com_Printf( "switch dispatch: %i msec\n", times[0] );
+#ifdef USE_COMPUTED_GOTO
+	Com_Printf( "threaded dispatch with superinstructions: %i msec\n", times[1] );
+#else
+	Com_Printf( "switch dispatch with superinstructions: %i msec\n", times[1] );
+#endif
+	Com_Printf( "%i return values differ\n", mismatches );
+}
@@ -149,6 +149,7 @@ struct vm_s {
 
 	// for interpreted modules
 	qboolean currentlyInterpreting;
+	qboolean switchDispatch;        // vmbench, every instruction goes through the switch
 
 	qboolean compiled;
 	byte        *codeBase;
@@ -171,14 +172,20 @@ struct vm_s {
 };
 
 
+#define MAX_VMMAIN_ARGS     13      // callnum and the arguments vmMain is passed
+
 extern vm_t    *currentVM;
 extern int vm_debugLevel;
+extern cvar_t  *vm_benchRecord;
 
 void VM_Compile( vm_t *vm, vmHeader_t *header );
 int VM_CallCompiled( vm_t *vm, int *args );
+void VM_FreeCompiled( vm_t *vm );
 
 void VM_PrepareInterpreter( vm_t *vm, vmHeader_t *header );
 int VM_CallInterpreted( vm_t *vm, int *args );
+void VM_BenchRecordCall( vm_t *vm, int *args );
+void VM_BenchForget( vm_t *vm );
 
 vmSymbol_t *VM_ValueToFunctionSymbol( vm_t *vm, int value );
 int VM_SymbolToValue( vm_t *vm, const char *symbol );
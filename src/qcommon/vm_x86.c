@@ -726,6 +726,16 @@ void VM_Compile( vm_t *vm, vmHeader_t *header ) {
 
 }
 
+/*
+=================
+VM_FreeCompiled
+
+The code is on the hunk
+=================
+*/
+void VM_FreeCompiled( vm_t *vm ) {
+}
+
 /*
 ==============
 VM_CallCompiled
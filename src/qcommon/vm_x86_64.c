@@ -0,0 +1,799 @@
+/*
+===========================================================================
+
+Wolfenstein: Enemy Territory GPL Source Code
+Copyright (C) 1999-2010 id Software LLC, a ZeniMax Media company.
+
+This file is part of the Wolfenstein: Enemy Territory GPL Source Code (Wolf ET Source Code).
+
+Wolf ET Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Wolf ET Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Wolf ET Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Wolf: ET Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Wolf ET Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+// vm_x86_64.c -- load time compiler and execution environment for x86-64
+
+#include "vm_local.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+/*
+
+  eax	scratch
+  ebx	scratch
+  ecx	scratch (required for shifts)
+  edx	scratch (required for divisions)
+  esi	program stack
+  rdi	opstack
+  rbp	vmCallState_t of the current VM_CallCompiled
+  r8	data base
+  xmm0	scratch
+
+  The generated code is position independent, it only holds absolute
+  addresses of C functions and of vm->instructionPointers, which contains
+  offsets from the start of the code. Branches are rel32, so everything is
+  emitted twice, the first pass only sizes the instructions.
+
+*/
+
+// what the generated code shares with C, addressed off rbp
+typedef struct {
+	int programStack;               // 0
+	int callNum;                    // 4, syscall number or block copy size
+	int         *opStack;           // 8
+	byte        *dataBase;          // 16
+	vm_t        *vm;                // 24
+} vmCallState_t;
+
+// stubs at the start of the code, before the first instruction
+#define STUB_ENTRY      0
+static int stubCall;
+static int stubError;
+
+static byte    *buf;
+static int compiledOfs;
+static int maxLength;
+static byte    *code;
+static int pc;
+static int pass;
+
+static int  Constant4( void ) {
+	int v;
+
+	v = code[pc] | ( code[pc + 1] << 8 ) | ( code[pc + 2] << 16 ) | ( code[pc + 3] << 24 );
+	pc += 4;
+	return v;
+}
+
+static int  Constant1( void ) {
+	int v;
+
+	v = code[pc];
+	pc += 1;
+	return v;
+}
+
+static void Emit1( int v ) {
+	if ( compiledOfs >= maxLength ) {
+		Com_Error( ERR_FATAL, "VM_CompileX86_64: maxLength exceeded" );
+	}
+	buf[ compiledOfs ] = v;
+	compiledOfs++;
+}
+
+static void Emit4( int v ) {
+	Emit1( v & 255 );
+	Emit1( ( v >> 8 ) & 255 );
+	Emit1( ( v >> 16 ) & 255 );
+	Emit1( ( v >> 24 ) & 255 );
+}
+
+static void Emit8( void *p ) {
+	unsigned long long v = (unsigned long long)(size_t)p;
+
+	Emit4( (int)( v & 0xffffffff ) );
+	Emit4( (int)( v >> 32 ) );
+}
+
+static int Hex( int c ) {
+	if ( c >= 'a' && c <= 'f' ) {
+		return 10 + c - 'a';
+	}
+	if ( c >= 'A' && c <= 'F' ) {
+		return 10 + c - 'A';
+	}
+	if ( c >= '0' && c <= '9' ) {
+		return c - '0';
+	}
+
+	Com_Error( ERR_DROP, "Hex: bad char '%c'", c );
+
+	return 0;
+}
+static void EmitString( const char *string ) {
+	int c1, c2;
+	int v;
+
+	while ( 1 ) {
+		c1 = string[0];
+		c2 = string[1];
+
+		v = ( Hex( c1 ) << 4 ) | Hex( c2 );
+		Emit1( v );
+
+		if ( !string[2] ) {
+			break;
+		}
+		string += 3;
+	}
+}
+
+/*
+=================
+EmitRel32
+
+Displacement from the end of the rel32 to a code offset
+=================
+*/
+static void EmitRel32( int target ) {
+	Emit4( target - ( compiledOfs + 4 ) );
+}
+
+/*
+=================
+EmitBranch
+
+jcc or call to a bytecode instruction, the offsets are only known in the
+second pass
+=================
+*/
+static void EmitBranch( vm_t *vm, const char *opcode, int instruction, int instructionCount ) {
+	if ( instruction < 0 || instruction >= instructionCount ) {
+		Com_Error( ERR_DROP, "VM_CompileX86_64: jump to %i out of range at offset %i", instruction, pc );
+	}
+	EmitString( opcode );
+	if ( pass ) {
+		EmitRel32( vm->instructionPointers[ instruction ] );
+	} else {
+		Emit4( 0 );
+	}
+}
+
+/*
+=================
+EmitCallC
+
+Calls func( state ) with the vm registers saved in the state and a
+16 byte aligned stack
+=================
+*/
+static void EmitCallC( void *func ) {
+	EmitString( "48 B8" );           // mov rax, func
+	Emit8( func );
+	EmitString( "89 75 00" );        // mov dword ptr [rbp], esi
+	EmitString( "48 89 7D 08" );     // mov qword ptr [rbp+8], rdi
+	EmitString( "48 89 E3" );        // mov rbx, rsp
+	EmitString( "48 83 E4 F0" );     // and rsp, -16
+	EmitString( "48 83 EC 20" );     // sub rsp, 32 (win64 shadow space)
+#ifdef _WIN32
+	EmitString( "48 89 E9" );        // mov rcx, rbp
+#else
+	EmitString( "48 89 EF" );        // mov rdi, rbp
+#endif
+	EmitString( "FF D0" );           // call rax
+	EmitString( "48 89 DC" );        // mov rsp, rbx
+	EmitString( "8B 75 00" );        // mov esi, dword ptr [rbp]
+	EmitString( "48 8B 7D 08" );     // mov rdi, qword ptr [rbp+8]
+	EmitString( "4C 8B 45 10" );     // mov r8, qword ptr [rbp+16]
+}
+
+/*
+=================
+EmitJumpTable
+
+Jumps to the bytecode instruction in eax, which has to be range checked
+=================
+*/
+static void EmitJumpTable( vm_t *vm, int instructionCount ) {
+	EmitString( "3D" );              // cmp eax, instructionCount
+	Emit4( instructionCount );
+	EmitString( "0F 83" );           // jae stubError
+	EmitRel32( stubError );
+	EmitString( "48 BB" );           // mov rbx, instructionPointers
+	Emit8( vm->instructionPointers );
+	EmitString( "8B 04 83" );        // mov eax, dword ptr [rbx+rax*4]
+	EmitString( "48 8D 1D" );        // lea rbx, [rip+codeBase]
+	EmitRel32( 0 );
+	EmitString( "48 01 D8" );        // add rax, rbx
+	EmitString( "FF E0" );           // jmp rax
+}
+
+/*
+=================
+VM_SystemCall64
+
+Called by the generated code for negative call targets
+=================
+*/
+static void VM_SystemCall64( vmCallState_t *state ) {
+	vm_t    *vm;
+	int     *args;
+
+	vm = state->vm;
+	args = ( int * )( state->dataBase + state->programStack + 4 );
+
+	// save the stack to allow recursive VM entry
+	vm->programStack = state->programStack - 4;
+	args[0] = state->callNum;
+//VM_LogSyscalls( args );
+	state->opStack[1] = vm->systemCall( args );
+}
+
+/*
+=================
+VM_BlockCopy64
+=================
+*/
+static void VM_BlockCopy64( vmCallState_t *state ) {
+	int     *src, *dest;
+	int dataMask;
+	int i, count, srci, desti;
+
+	dataMask = state->vm->dataMask;
+
+	// same range check as the interpreter
+	count = state->callNum;
+	srci = state->opStack[0] & dataMask;
+	desti = state->opStack[-1] & dataMask;
+	count = ( ( srci + count ) & dataMask ) - srci;
+	count = ( ( desti + count ) & dataMask ) - desti;
+
+	if ( ( srci | desti | count ) & 3 ) {
+		Com_Error( ERR_DROP, "OP_BLOCK_COPY not dword aligned" );
+	}
+	src = (int *)&state->dataBase[ srci ];
+	dest = (int *)&state->dataBase[ desti ];
+	count >>= 2;
+	for ( i = count - 1 ; i >= 0 ; i-- ) {
+		dest[i] = src[i];
+	}
+}
+
+/*
+=================
+VM_BadJump64
+=================
+*/
+static void VM_BadJump64( vmCallState_t *state ) {
+	Com_Error( ERR_DROP, "VM_CallCompiled: jump or call out of range in %s", state->vm->name );
+}
+
+/*
+=================
+EmitStubs
+=================
+*/
+static void EmitStubs( vm_t *vm, int instructionCount ) {
+	int systemCall;
+
+	// void entry( vmCallState_t *state )
+	EmitString( "53" );              // push rbx
+	EmitString( "55" );              // push rbp
+	EmitString( "56" );              // push rsi (callee saved on win64)
+	EmitString( "57" );              // push rdi
+#ifdef _WIN32
+	EmitString( "48 89 CD" );        // mov rbp, rcx
+#else
+	EmitString( "48 89 FD" );        // mov rbp, rdi
+#endif
+	EmitString( "8B 75 00" );        // mov esi, dword ptr [rbp]
+	EmitString( "48 8B 7D 08" );     // mov rdi, qword ptr [rbp+8]
+	EmitString( "4C 8B 45 10" );     // mov r8, qword ptr [rbp+16]
+	EmitBranch( vm, "E8", 0, instructionCount );    // call instruction 0
+	EmitString( "89 75 00" );        // mov dword ptr [rbp], esi
+	EmitString( "48 89 7D 08" );     // mov qword ptr [rbp+8], rdi
+	EmitString( "5F" );              // pop rdi
+	EmitString( "5E" );              // pop rsi
+	EmitString( "5D" );              // pop rbp
+	EmitString( "5B" );              // pop rbx
+	EmitString( "C3" );              // ret
+
+	// bad jump or call target, doesn't return
+	stubError = compiledOfs;
+	EmitCallC( VM_BadJump64 );
+
+	// OP_CALL, the target is on the opstack
+	stubCall = compiledOfs;
+	EmitString( "8B 07" );           // mov eax, dword ptr [rdi]
+	EmitString( "48 83 EF 04" );     // sub rdi, 4
+	EmitString( "85 C0" );           // test eax, eax
+	EmitString( "7C 02" );           // jl systemCall
+	EmitString( "EB" );              // jmp jumpTable, the vm function returns to our caller
+	Emit1( 0 );
+	systemCall = compiledOfs;
+	EmitString( "F7 D0" );           // not eax
+	EmitString( "89 45 04" );        // mov dword ptr [rbp+4], eax
+	EmitCallC( VM_SystemCall64 );
+	EmitString( "48 83 C7 04" );     // add rdi, 4 (the return value)
+	EmitString( "C3" );              // ret
+	buf[ systemCall - 1 ] = compiledOfs - systemCall;
+	EmitJumpTable( vm, instructionCount );
+}
+
+/*
+=================
+VM_Compile
+=================
+*/
+void VM_Compile( vm_t *vm, vmHeader_t *header ) {
+	int op;
+	int v;
+	int instruction;
+
+	// no instruction needs more than 64 bytes, and the stubs are ~200
+	maxLength = header->instructionCount * 64 + 1024;
+	buf = Z_Malloc( maxLength );
+	code = (byte *)header + header->codeOffset;
+
+	// the first pass sizes the code, the second emits it with known offsets
+	for ( pass = 0 ; pass < 2 ; pass++ ) {
+		compiledOfs = 0;
+		EmitStubs( vm, header->instructionCount );
+
+		pc = 0;
+		instruction = 0;
+		while ( instruction < header->instructionCount ) {
+			if ( pass && vm->instructionPointers[ instruction ] != compiledOfs ) {
+				Com_Error( ERR_FATAL, "VM_CompileX86_64: phase error at instruction %i", instruction );
+			}
+			vm->instructionPointers[ instruction ] = compiledOfs;
+			instruction++;
+
+			if ( pc >= header->codeLength ) {
+				Com_Error( ERR_FATAL, "VM_CompileX86_64: pc > header->codeLength" );
+			}
+
+			op = code[ pc ];
+			pc++;
+			switch ( op ) {
+			case OP_UNDEF:
+			case OP_IGNORE:
+				break;
+			case OP_BREAK:
+				EmitString( "CC" );                  // int 3
+				break;
+			case OP_ENTER:
+				EmitString( "81 EE" );               // sub esi, 0x12345678
+				Emit4( Constant4() );
+				break;
+			case OP_LEAVE:
+				EmitString( "81 C6" );               // add esi, 0x12345678
+				Emit4( Constant4() );
+				EmitString( "C3" );                  // ret
+				break;
+			case OP_CONST:
+				EmitString( "48 83 C7 04" );         // add rdi, 4
+				EmitString( "C7 07" );               // mov dword ptr [rdi], 0x12345678
+				Emit4( Constant4() );
+				break;
+			case OP_LOCAL:
+				EmitString( "48 83 C7 04" );         // add rdi, 4
+				EmitString( "8D 86" );               // lea eax, [rsi+0x12345678]
+				Emit4( Constant4() );
+				EmitString( "89 07" );               // mov dword ptr [rdi], eax
+				break;
+			case OP_ARG:
+				EmitString( "8B 07" );               // mov eax, dword ptr [rdi]
+				EmitString( "8D 9E" );               // lea ebx, [rsi+0x12345678]
+				Emit4( Constant1() );
+				EmitString( "81 E3" );               // and ebx, 0x12345678
+				Emit4( vm->dataMask & ~3 );
+				EmitString( "41 89 04 18" );         // mov dword ptr [r8+rbx], eax
+				EmitString( "48 83 EF 04" );         // sub rdi, 4
+				break;
+			case OP_CALL:
+				EmitString( "41 C7 04 30" );         // mov dword ptr [r8+rsi], 0x12345678
+				Emit4( pc );
+				EmitString( "E8" );                  // call stubCall
+				EmitRel32( stubCall );
+				break;
+			case OP_PUSH:
+				EmitString( "48 83 C7 04" );         // add rdi, 4
+				break;
+			case OP_POP:
+				EmitString( "48 83 EF 04" );         // sub rdi, 4
+				break;
+			case OP_JUMP:
+				EmitString( "8B 07" );               // mov eax, dword ptr [rdi]
+				EmitString( "48 83 EF 04" );         // sub rdi, 4
+				EmitJumpTable( vm, header->instructionCount );
+				break;
+
+			case OP_EQ:
+			case OP_NE:
+			case OP_LTI:
+			case OP_LEI:
+			case OP_GTI:
+			case OP_GEI:
+			case OP_LTU:
+			case OP_LEU:
+			case OP_GTU:
+			case OP_GEU:
+				EmitString( "48 83 EF 08" );         // sub rdi, 8
+				EmitString( "8B 47 04" );            // mov eax, dword ptr [rdi+4]
+				EmitString( "3B 47 08" );            // cmp eax, dword ptr [rdi+8]
+				switch ( op ) {
+				case OP_EQ:  EmitBranch( vm, "0F 84", Constant4(), header->instructionCount ); break;  // je
+				case OP_NE:  EmitBranch( vm, "0F 85", Constant4(), header->instructionCount ); break;  // jne
+				case OP_LTI: EmitBranch( vm, "0F 8C", Constant4(), header->instructionCount ); break;  // jl
+				case OP_LEI: EmitBranch( vm, "0F 8E", Constant4(), header->instructionCount ); break;  // jle
+				case OP_GTI: EmitBranch( vm, "0F 8F", Constant4(), header->instructionCount ); break;  // jg
+				case OP_GEI: EmitBranch( vm, "0F 8D", Constant4(), header->instructionCount ); break;  // jge
+				case OP_LTU: EmitBranch( vm, "0F 82", Constant4(), header->instructionCount ); break;  // jb
+				case OP_LEU: EmitBranch( vm, "0F 86", Constant4(), header->instructionCount ); break;  // jbe
+				case OP_GTU: EmitBranch( vm, "0F 87", Constant4(), header->instructionCount ); break;  // ja
+				case OP_GEU: EmitBranch( vm, "0F 83", Constant4(), header->instructionCount ); break;  // jae
+				}
+				break;
+
+			// ucomiss sets ZF, PF and CF for NaN, which has to compare
+			// the same way as the C code of the interpreter
+			case OP_EQF:
+				EmitString( "48 83 EF 08" );         // sub rdi, 8
+				EmitString( "F3 0F 10 47 04" );      // movss xmm0, dword ptr [rdi+4]
+				EmitString( "0F 2E 47 08" );         // ucomiss xmm0, dword ptr [rdi+8]
+				EmitString( "7A 06" );               // jp +6
+				EmitBranch( vm, "0F 84", Constant4(), header->instructionCount );   // je
+				break;
+			case OP_NEF:
+				EmitString( "48 83 EF 08" );         // sub rdi, 8
+				EmitString( "F3 0F 10 47 04" );      // movss xmm0, dword ptr [rdi+4]
+				EmitString( "0F 2E 47 08" );         // ucomiss xmm0, dword ptr [rdi+8]
+				v = Constant4();
+				EmitBranch( vm, "0F 8A", v, header->instructionCount );             // jp
+				EmitBranch( vm, "0F 85", v, header->instructionCount );             // jne
+				break;
+			case OP_LTF:
+				EmitString( "48 83 EF 08" );         // sub rdi, 8
+				EmitString( "F3 0F 10 47 08" );      // movss xmm0, dword ptr [rdi+8]
+				EmitString( "0F 2E 47 04" );         // ucomiss xmm0, dword ptr [rdi+4]
+				EmitBranch( vm, "0F 87", Constant4(), header->instructionCount );   // ja
+				break;
+			case OP_LEF:
+				EmitString( "48 83 EF 08" );         // sub rdi, 8
+				EmitString( "F3 0F 10 47 08" );      // movss xmm0, dword ptr [rdi+8]
+				EmitString( "0F 2E 47 04" );         // ucomiss xmm0, dword ptr [rdi+4]
+				EmitBranch( vm, "0F 83", Constant4(), header->instructionCount );   // jae
+				break;
+			case OP_GTF:
+				EmitString( "48 83 EF 08" );         // sub rdi, 8
+				EmitString( "F3 0F 10 47 04" );      // movss xmm0, dword ptr [rdi+4]
+				EmitString( "0F 2E 47 08" );         // ucomiss xmm0, dword ptr [rdi+8]
+				EmitBranch( vm, "0F 87", Constant4(), header->instructionCount );   // ja
+				break;
+			case OP_GEF:
+				EmitString( "48 83 EF 08" );         // sub rdi, 8
+				EmitString( "F3 0F 10 47 04" );      // movss xmm0, dword ptr [rdi+4]
+				EmitString( "0F 2E 47 08" );         // ucomiss xmm0, dword ptr [rdi+8]
+				EmitBranch( vm, "0F 83", Constant4(), header->instructionCount );   // jae
+				break;
+
+			case OP_LOAD4:
+				EmitString( "8B 1F" );               // mov ebx, dword ptr [rdi]
+				EmitString( "81 E3" );               // and ebx, 0x12345678
+				Emit4( vm->dataMask );
+				EmitString( "41 8B 04 18" );         // mov eax, dword ptr [r8+rbx]
+				EmitString( "89 07" );               // mov dword ptr [rdi], eax
+				break;
+			case OP_LOAD2:
+				EmitString( "8B 1F" );               // mov ebx, dword ptr [rdi]
+				EmitString( "81 E3" );               // and ebx, 0x12345678
+				Emit4( vm->dataMask );
+				EmitString( "41 0F B7 04 18" );      // movzx eax, word ptr [r8+rbx]
+				EmitString( "89 07" );               // mov dword ptr [rdi], eax
+				break;
+			case OP_LOAD1:
+				EmitString( "8B 1F" );               // mov ebx, dword ptr [rdi]
+				EmitString( "81 E3" );               // and ebx, 0x12345678
+				Emit4( vm->dataMask );
+				EmitString( "41 0F B6 04 18" );      // movzx eax, byte ptr [r8+rbx]
+				EmitString( "89 07" );               // mov dword ptr [rdi], eax
+				break;
+			case OP_STORE4:
+				EmitString( "8B 5F FC" );            // mov ebx, dword ptr [rdi-4]
+				EmitString( "81 E3" );               // and ebx, 0x12345678
+				Emit4( vm->dataMask & ~3 );
+				EmitString( "8B 07" );               // mov eax, dword ptr [rdi]
+				EmitString( "41 89 04 18" );         // mov dword ptr [r8+rbx], eax
+				EmitString( "48 83 EF 08" );         // sub rdi, 8
+				break;
+			case OP_STORE2:
+				EmitString( "8B 5F FC" );            // mov ebx, dword ptr [rdi-4]
+				EmitString( "81 E3" );               // and ebx, 0x12345678
+				Emit4( vm->dataMask & ~1 );
+				EmitString( "8B 07" );               // mov eax, dword ptr [rdi]
+				EmitString( "66 41 89 04 18" );      // mov word ptr [r8+rbx], ax
+				EmitString( "48 83 EF 08" );         // sub rdi, 8
+				break;
+			case OP_STORE1:
+				EmitString( "8B 5F FC" );            // mov ebx, dword ptr [rdi-4]
+				EmitString( "81 E3" );               // and ebx, 0x12345678
+				Emit4( vm->dataMask );
+				EmitString( "8B 07" );               // mov eax, dword ptr [rdi]
+				EmitString( "41 88 04 18" );         // mov byte ptr [r8+rbx], al
+				EmitString( "48 83 EF 08" );         // sub rdi, 8
+				break;
+
+			case OP_BLOCK_COPY:
+				EmitString( "C7 45 04" );            // mov dword ptr [rbp+4], 0x12345678
+				Emit4( Constant4() );
+				EmitCallC( VM_BlockCopy64 );
+				EmitString( "48 83 EF 08" );         // sub rdi, 8
+				break;
+
+			case OP_SEX8:
+				EmitString( "0F BE 07" );            // movsx eax, byte ptr [rdi]
+				EmitString( "89 07" );               // mov dword ptr [rdi], eax
+				break;
+			case OP_SEX16:
+				EmitString( "0F BF 07" );            // movsx eax, word ptr [rdi]
+				EmitString( "89 07" );               // mov dword ptr [rdi], eax
+				break;
+
+			case OP_NEGI:
+				EmitString( "F7 1F" );               // neg dword ptr [rdi]
+				break;
+			case OP_ADD:
+				EmitString( "8B 07" );               // mov eax, dword ptr [rdi]
+				EmitString( "01 47 FC" );            // add dword ptr [rdi-4], eax
+				EmitString( "48 83 EF 04" );         // sub rdi, 4
+				break;
+			case OP_SUB:
+				EmitString( "8B 07" );               // mov eax, dword ptr [rdi]
+				EmitString( "29 47 FC" );            // sub dword ptr [rdi-4], eax
+				EmitString( "48 83 EF 04" );         // sub rdi, 4
+				break;
+			case OP_DIVI:
+				EmitString( "8B 47 FC" );            // mov eax, dword ptr [rdi-4]
+				EmitString( "99" );                  // cdq
+				EmitString( "F7 3F" );               // idiv dword ptr [rdi]
+				EmitString( "89 47 FC" );            // mov dword ptr [rdi-4], eax
+				EmitString( "48 83 EF 04" );         // sub rdi, 4
+				break;
+			case OP_DIVU:
+				EmitString( "8B 47 FC" );            // mov eax, dword ptr [rdi-4]
+				EmitString( "33 D2" );               // xor edx, edx
+				EmitString( "F7 37" );               // div dword ptr [rdi]
+				EmitString( "89 47 FC" );            // mov dword ptr [rdi-4], eax
+				EmitString( "48 83 EF 04" );         // sub rdi, 4
+				break;
+			case OP_MODI:
+				EmitString( "8B 47 FC" );            // mov eax, dword ptr [rdi-4]
+				EmitString( "99" );                  // cdq
+				EmitString( "F7 3F" );               // idiv dword ptr [rdi]
+				EmitString( "89 57 FC" );            // mov dword ptr [rdi-4], edx
+				EmitString( "48 83 EF 04" );         // sub rdi, 4
+				break;
+			case OP_MODU:
+				EmitString( "8B 47 FC" );            // mov eax, dword ptr [rdi-4]
+				EmitString( "33 D2" );               // xor edx, edx
+				EmitString( "F7 37" );               // div dword ptr [rdi]
+				EmitString( "89 57 FC" );            // mov dword ptr [rdi-4], edx
+				EmitString( "48 83 EF 04" );         // sub rdi, 4
+				break;
+			case OP_MULI:
+				EmitString( "8B 47 FC" );            // mov eax, dword ptr [rdi-4]
+				EmitString( "F7 2F" );               // imul dword ptr [rdi]
+				EmitString( "89 47 FC" );            // mov dword ptr [rdi-4], eax
+				EmitString( "48 83 EF 04" );         // sub rdi, 4
+				break;
+			case OP_MULU:
+				EmitString( "8B 47 FC" );            // mov eax, dword ptr [rdi-4]
+				EmitString( "F7 27" );               // mul dword ptr [rdi]
+				EmitString( "89 47 FC" );            // mov dword ptr [rdi-4], eax
+				EmitString( "48 83 EF 04" );         // sub rdi, 4
+				break;
+			case OP_BAND:
+				EmitString( "8B 07" );               // mov eax, dword ptr [rdi]
+				EmitString( "21 47 FC" );            // and dword ptr [rdi-4], eax
+				EmitString( "48 83 EF 04" );         // sub rdi, 4
+				break;
+			case OP_BOR:
+				EmitString( "8B 07" );               // mov eax, dword ptr [rdi]
+				EmitString( "09 47 FC" );            // or dword ptr [rdi-4], eax
+				EmitString( "48 83 EF 04" );         // sub rdi, 4
+				break;
+			case OP_BXOR:
+				EmitString( "8B 07" );               // mov eax, dword ptr [rdi]
+				EmitString( "31 47 FC" );            // xor dword ptr [rdi-4], eax
+				EmitString( "48 83 EF 04" );         // sub rdi, 4
+				break;
+			case OP_BCOM:
+				EmitString( "F7 17" );               // not dword ptr [rdi]
+				break;
+			case OP_LSH:
+				EmitString( "8B 0F" );               // mov ecx, dword ptr [rdi]
+				EmitString( "D3 67 FC" );            // shl dword ptr [rdi-4], cl
+				EmitString( "48 83 EF 04" );         // sub rdi, 4
+				break;
+			case OP_RSHI:
+				EmitString( "8B 0F" );               // mov ecx, dword ptr [rdi]
+				EmitString( "D3 7F FC" );            // sar dword ptr [rdi-4], cl
+				EmitString( "48 83 EF 04" );         // sub rdi, 4
+				break;
+			case OP_RSHU:
+				EmitString( "8B 0F" );               // mov ecx, dword ptr [rdi]
+				EmitString( "D3 6F FC" );            // shr dword ptr [rdi-4], cl
+				EmitString( "48 83 EF 04" );         // sub rdi, 4
+				break;
+
+			case OP_NEGF:
+				EmitString( "81 37" );               // xor dword ptr [rdi], 0x80000000
+				Emit4( 0x80000000 );
+				break;
+			case OP_ADDF:
+				EmitString( "48 83 EF 04" );         // sub rdi, 4
+				EmitString( "F3 0F 10 07" );         // movss xmm0, dword ptr [rdi]
+				EmitString( "F3 0F 58 47 04" );      // addss xmm0, dword ptr [rdi+4]
+				EmitString( "F3 0F 11 07" );         // movss dword ptr [rdi], xmm0
+				break;
+			case OP_SUBF:
+				EmitString( "48 83 EF 04" );         // sub rdi, 4
+				EmitString( "F3 0F 10 07" );         // movss xmm0, dword ptr [rdi]
+				EmitString( "F3 0F 5C 47 04" );      // subss xmm0, dword ptr [rdi+4]
+				EmitString( "F3 0F 11 07" );         // movss dword ptr [rdi], xmm0
+				break;
+			case OP_DIVF:
+				EmitString( "48 83 EF 04" );         // sub rdi, 4
+				EmitString( "F3 0F 10 07" );         // movss xmm0, dword ptr [rdi]
+				EmitString( "F3 0F 5E 47 04" );      // divss xmm0, dword ptr [rdi+4]
+				EmitString( "F3 0F 11 07" );         // movss dword ptr [rdi], xmm0
+				break;
+			case OP_MULF:
+				EmitString( "48 83 EF 04" );         // sub rdi, 4
+				EmitString( "F3 0F 10 07" );         // movss xmm0, dword ptr [rdi]
+				EmitString( "F3 0F 59 47 04" );      // mulss xmm0, dword ptr [rdi+4]
+				EmitString( "F3 0F 11 07" );         // movss dword ptr [rdi], xmm0
+				break;
+			case OP_CVIF:
+				EmitString( "F3 0F 2A 07" );         // cvtsi2ss xmm0, dword ptr [rdi]
+				EmitString( "F3 0F 11 07" );         // movss dword ptr [rdi], xmm0
+				break;
+			case OP_CVFI:
+				// truncates like the C cast of the interpreter
+				EmitString( "F3 0F 2C 07" );         // cvttss2si eax, dword ptr [rdi]
+				EmitString( "89 07" );               // mov dword ptr [rdi], eax
+				break;
+
+			default:
+				Com_Error( ERR_DROP, "VM_CompileX86_64: bad opcode %i at offset %i", op, pc );
+			}
+		}
+	}
+
+	// copy to exact size executable memory
+	vm->codeLength = compiledOfs;
+#ifdef _WIN32
+	{
+		DWORD oldProtect;
+
+		vm->codeBase = VirtualAlloc( NULL, compiledOfs, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE );
+		if ( !vm->codeBase ) {
+			Com_Error( ERR_FATAL, "VM_CompileX86_64: VirtualAlloc failed" );
+		}
+		memcpy( vm->codeBase, buf, compiledOfs );
+		if ( !VirtualProtect( vm->codeBase, compiledOfs, PAGE_EXECUTE_READ, &oldProtect ) ) {
+			Com_Error( ERR_FATAL, "VM_CompileX86_64: VirtualProtect failed" );
+		}
+	}
+#else
+	vm->codeBase = mmap( NULL, compiledOfs, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+	if ( vm->codeBase == MAP_FAILED ) {
+		vm->codeBase = NULL;
+		Com_Error( ERR_FATAL, "VM_CompileX86_64: mmap failed" );
+	}
+	memcpy( vm->codeBase, buf, compiledOfs );
+	if ( mprotect( vm->codeBase, compiledOfs, PROT_READ | PROT_EXEC ) < 0 ) {
+		Com_Error( ERR_FATAL, "VM_CompileX86_64: mprotect failed to change PROT_EXEC" );
+	}
+#endif
+	Z_Free( buf );
+	Com_Printf( "VM file %s compiled to %i bytes of code\n", vm->name, compiledOfs );
+}
+
+/*
+=================
+VM_FreeCompiled
+=================
+*/
+void VM_FreeCompiled( vm_t *vm ) {
+	if ( !vm->codeBase ) {
+		return;
+	}
+#ifdef _WIN32
+	VirtualFree( vm->codeBase, 0, MEM_RELEASE );
+#else
+	munmap( vm->codeBase, vm->codeLength );
+#endif
+	vm->codeBase = NULL;
+}
+
+/*
+==============
+VM_CallCompiled
+
+This function is called directly by the generated code
+==============
+*/
+int VM_CallCompiled( vm_t *vm, int *args ) {
+	int stack[1024];
+	int programStack;
+	int stackOnEntry;
+	byte    *image;
+	vmCallState_t state;
+
+	currentVM = vm;
+
+	// interpret the code
+	vm->currentlyInterpreting = qtrue;
+
+	// we might be called recursively, so this might not be the very top
+	programStack = vm->programStack;
+	stackOnEntry = programStack;
+
+	// set up the stack frame
+	image = vm->dataBase;
+
+	programStack -= 48;
+
+	*(int *)&image[ programStack + 44] = args[9];
+	*(int *)&image[ programStack + 40] = args[8];
+	*(int *)&image[ programStack + 36] = args[7];
+	*(int *)&image[ programStack + 32] = args[6];
+	*(int *)&image[ programStack + 28] = args[5];
+	*(int *)&image[ programStack + 24] = args[4];
+	*(int *)&image[ programStack + 20] = args[3];
+	*(int *)&image[ programStack + 16] = args[2];
+	*(int *)&image[ programStack + 12] = args[1];
+	*(int *)&image[ programStack + 8 ] = args[0];
+	*(int *)&image[ programStack + 4 ] = 0; // return stack
+	*(int *)&image[ programStack ] = -1;    // will terminate the loop on return
+
+	// off we go into generated code...
+	state.programStack = programStack;
+	state.callNum = 0;
+	state.opStack = stack;
+	state.dataBase = image;
+	state.vm = vm;
+	( (void ( * )( vmCallState_t * ))( vm->codeBase + STUB_ENTRY ) )( &state );
+
+	if ( state.opStack != &stack[1] ) {
+		Com_Error( ERR_DROP, "opStack corrupted in compiled code" );
+	}
+	if ( state.programStack != stackOnEntry - 48 ) {
+		Com_Error( ERR_DROP, "programStack corrupted in compiled code" );
+	}
+
+	vm->programStack = stackOnEntry;
+
+	return stack[1];
+}
@@ -50,6 +50,7 @@ If you have questions concerning this license or the applicable additional terms
 #define MAX_BPS_WINDOW      20          // NERVE - SMF - net debugging
 
 #define MAX_IPS_NUM 1024
+#define IPS_HASH_BITS 10
 #define MAX_PACKETS_IN_TIME 50
 #define GETSTATUS_ACTIVATE_ANTIDDOS 60
 
@@ -62,10 +63,24 @@ typedef struct svEntity_s {
 	int clusternums[MAX_ENT_CLUSTERS];
 	int lastCluster;                // if all the clusters don't fit in clusternums
 	int areanum, areanum2;
-	int snapshotCounter;            // used to prevent double adding from portal views
 	int originCluster;              // Gordon: calced upon linking, for origin only bmodel vis checks
+
+	struct worldGridLink_s *gridLinks;  // cells this entity is linked into with sv_worldGrid
+	int gridRange[4];               // cell mins x/y, maxs x/y of those links
+	int gridStamp;                  // last area query that tested this entity
 } svEntity_t;
 
+// SV_inPVS memo of the cluster and area a point lies in, the bsp never
+// changes while a map is loaded so entries stay valid until sv is cleared
+#define PVS_POINT_CACHE     512         // must be a power of two
+
+typedef struct {
+	vec3_t point;
+	int cluster;
+	int area;
+	qboolean valid;
+} pvsPointCache_t;
+
 typedef enum {
 	SS_DEAD,            // no map loaded
 	SS_LOADING,         // spawning level entities
@@ -81,7 +96,6 @@ typedef struct {
 	// show_bug.cgi?id=475
 	// the serverId associated with the current checksumFeed (always <= serverId)
 	int checksumFeedServerId;
-	int snapshotCounter;                // incremented for each snapshot built
 	int timeResidual;                   // <= 1000 / sv_frame->value
 	int nextFrameTime;                  // when time > nextFrameTime, process world
 	struct cmodel_s *models[MAX_MODELS];
@@ -120,6 +134,8 @@ typedef struct {
 
 	int num_tagheaders;
 	int num_tags;
+
+	pvsPointCache_t pvsPointCache[PVS_POINT_CACHE];
 } server_t;
 
 
@@ -210,6 +226,8 @@ typedef struct client_s {
 	int ping;
 	int rate;                           // bytes / second
 	int snapshotMsec;                   // requests a snapshot every snapshotMsec unless rate choked
+	byte snapshotHeld[MAX_GENTITIES];   // snapshots in a row an entity change was held back by sv_snapshotBudget
+	int snapshotChanged[MAX_GENTITIES]; // last snapshot that sent an entity a change
 	int pureAuthentic;
 	qboolean gotCP;  // TTimo - additional flag to distinguish between a bad pure checksum, and no cp command at all
 	netchan_t netchan;
@@ -312,7 +330,10 @@ typedef struct {
 		int getinfo_time; 
 		int getstatusLimitTime;
 		int getstatusRestrictionTime;
+		int queryTime;                  // sv_queryRate token bucket
+		int hashNext;                   // next entry + 1 with the same hash, 0 ends the chain
 	} ips[MAX_IPS_NUM];
+	int ipsHash[1 << IPS_HASH_BITS];        // first entry + 1 for each address hash
 	//static int getstatus_time[GETSTATUS_ACTIVATE_ANTIDDOS] = {0};
 	int getstatusTime;
 	unsigned int lastPlayerLeftTime;
@@ -431,6 +452,16 @@ extern cvar_t *sv_packetdelay;
 //fretn
 extern cvar_t *sv_fullmsg;
 
+extern cvar_t *sv_snapshotWorkers;
+extern cvar_t *sv_worldGrid;
+extern cvar_t *sv_snapshotBudget;
+extern cvar_t *sv_snapshotMaxHold;
+extern cvar_t *sv_worldGridCellSize;
+extern cvar_t *sv_demoKeyframe;
+extern cvar_t *sv_autoRecord;
+extern cvar_t *sv_queryRate;
+extern cvar_t *sv_queryBurst;
+
 //===========================================================
 
 //
@@ -451,6 +482,9 @@ qboolean SV_VerifyChallenge( char *challenge );
 
 void SV_SendToChatConnectedServers( char *msg );
 
+void SV_QueryCacheInvalidate( void );
+void SV_QueryStats_f( void );
+
 
 //
 // sv_init.c
@@ -517,9 +551,21 @@ void SV_WriteFrameToClient( client_t *client, msg_t *msg );
 void SV_SendMessageToClient( msg_t *msg, client_t *client );
 void SV_SendClientMessages( void );
 void SV_SendClientSnapshot( client_t *client );
+void SV_ShutdownSnapshotWorkers( void );
+void SV_RunWorkerJobs( workerFunc_t func, void *data, int count, int numThreads );
 //bani
 void SV_SendClientIdle( client_t *client );
 
+//
+// sv_demo.c
+//
+void SV_DemoStart( const char *name );
+void SV_DemoStop( void );
+void SV_DemoFrame( void );
+void SV_DemoConfigstringModified( int index );
+void SV_Record_f( void );
+void SV_StopRecord_f( void );
+
 //
 // sv_game.c
 //
@@ -583,6 +629,8 @@ clipHandle_t SV_ClipHandleForEntity( const sharedEntity_t *ent );
 
 
 void SV_SectorList_f( void );
+void SV_AreaRecord_f( void );
+void SV_AreaBench_f( void );
 
 
 int SV_AreaEntities( const vec3_t mins, const vec3_t maxs, int *entityList, int maxcount );
@@ -610,6 +658,10 @@ void SV_Trace( trace_t *results, const vec3_t start, const vec3_t mins, const ve
 // passEntityNum is explicitly excluded from clipping checks (normally ENTITYNUM_NONE)
 
 
+void SV_TraceBatch( const traceRay_t *rays, trace_t *results, int numRays );
+// runs numRays traces sharing one area query, results[i] is what SV_Trace would give for rays[i]
+
+
 void SV_ClipToEntity( trace_t *trace, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int entityNum, int contentmask, int capsule );
 // clip to a specific entity
 
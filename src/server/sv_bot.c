@@ -562,6 +562,7 @@ SV_BotLibSetup
 */
 int SV_BotLibSetup( void ) {
 	static cvar_t *bot_norcd;
+	static cvar_t *bot_precomputeroutes;
 	static cvar_t *bot_frameroutingupdates;
 
 #ifdef PRE_RELEASE_DEMO
@@ -581,6 +582,10 @@ int SV_BotLibSetup( void ) {
 	bot_norcd = Cvar_Get( "bot_norcd", "0", 0 );
 	botlib_export->BotLibVarSet( "bot_norcd", bot_norcd->string );
 
+	// number of threads used to build the whole route cache at map load, 0 builds it on demand
+	bot_precomputeroutes = Cvar_Get( "bot_precomputeroutes", "0", CVAR_ARCHIVE );
+	botlib_export->BotLibVarSet( "bot_precomputeroutes", bot_precomputeroutes->string );
+
 	// RF, set AAS routing max per frame
 	if ( SV_GameIsSinglePlayer() ) {
 		bot_frameroutingupdates = Cvar_Get( "bot_frameroutingupdates", "9999999", 0 );
@@ -633,6 +638,7 @@ void SV_BotInitCvars( void ) {
 	Cvar_Get( "bot_grapple", "0", 0 );          //enable grapple
 	Cvar_Get( "bot_rocketjump", "0", 0 );           //enable rocket jumping
 	Cvar_Get( "bot_norcd", "0", 0 );                //enable creation of RCD file
+	Cvar_Get( "bot_precomputeroutes", "0", CVAR_ARCHIVE );  //threads building all routing cache at map load
 
 	bot_enable = Cvar_VariableIntegerValue( "bot_enable" );
 }
@@ -650,6 +656,15 @@ void BotImport_DrawPolygon( int color, int numpoints, float* points ) {
 }
 #endif
 
+/*
+==================
+BotImport_RunJobs
+==================
+*/
+void BotImport_RunJobs( void ( *func )( void *data, int index ), void *data, int count ) {
+	SV_RunWorkerJobs( func, data, count, Cvar_VariableIntegerValue( "bot_precomputeroutes" ) );
+}
+
 /*
 ==================
 SV_BotInitBotLib
@@ -687,6 +702,10 @@ void SV_BotInitBotLib( void ) {
 	botlib_import.FS_Write = FS_Write;
 	botlib_import.FS_FCloseFile = FS_FCloseFile;
 	botlib_import.FS_Seek = FS_Seek;
+	botlib_import.FS_MapFile = FS_MapFile;
+	botlib_import.FS_UnmapFile = FS_UnmapFile;
+
+	botlib_import.RunJobs = BotImport_RunJobs;
 
 	//debug lines
 	botlib_import.DebugLineCreate = BotImport_DebugLineCreate;
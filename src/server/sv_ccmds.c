@@ -1778,6 +1778,9 @@ void SV_AddOperatorCommands( void ) {
 	Cmd_AddCommand( "systeminfo", SV_Systeminfo_f );
 	Cmd_AddCommand( "dumpuser", SV_DumpUser_f );
 	Cmd_AddCommand( "map_restart", SV_MapRestart_f );
+	Cmd_AddCommand( "svrecord", SV_Record_f );
+	Cmd_AddCommand( "svstoprecord", SV_StopRecord_f );
+	Cmd_AddCommand( "querystats", SV_QueryStats_f );
 	//
 	Cmd_AddCommand( "putspec", SV_Putspec_f );
 	Cmd_AddCommand( "clearvelocity", SV_ClearVelocity_f );
@@ -1816,6 +1819,8 @@ void SV_AddOperatorCommands( void ) {
 	//
 	Cmd_AddCommand( "fieldinfo", SV_FieldInfo_f );
 	Cmd_AddCommand( "sectorlist", SV_SectorList_f );
+	Cmd_AddCommand( "arearecord", SV_AreaRecord_f );
+	Cmd_AddCommand( "areabench", SV_AreaBench_f );
 	Cmd_AddCommand( "map", SV_Map_f );
 	Cmd_AddCommand( "gameCompleteStatus", SV_GameCompleteStatus_f );      // NERVE - SMF
 #ifndef PRE_RELEASE_DEMO_NODEVMAP
@@ -0,0 +1,530 @@
+/*
+===========================================================================
+
+Wolfenstein: Enemy Territory GPL Source Code
+Copyright (C) 1999-2010 id Software LLC, a ZeniMax Media company. 
+
+This file is part of the Wolfenstein: Enemy Territory GPL Source Code (Wolf ET Source Code).  
+
+Wolf ET Source Code is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+Wolf ET Source Code is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Wolf ET Source Code.  If not, see <http://www.gnu.org/licenses/>.
+
+In addition, the Wolf: ET Source Code is also subject to certain additional terms. You should have received a copy of these additional terms immediately following the terms and conditions of the GNU General Public License which accompanied the Wolf ET Source Code.  If not, please request a copy in writing from id Software at the address below.
+
+If you have questions concerning this license or the applicable additional terms, you may contact in writing id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+
+===========================================================================
+*/
+
+
+
+#include "server.h"
+
+/*
+=============================================================================
+
+SERVER DEMOS
+
+Records every entity and player state the game produces, independent of any
+client's view, so a match can be archived without running spectator clients.
+
+The main thread only copies the frame into a slot, the delta encoding and the
+file writes are done by a background job.  Jobs run in order, and a slot is
+only reused once the job that last used it has finished.
+
+File layout, all messages are huffman compressed like network messages:
+
+[long serverTime] [long length] [message] ... [long -1] [long -1]
+
+The first message holds the protocol, the configstrings and the entity
+baselines, each frame message holds any configstrings that changed followed
+by svc_snapshot:
+
+[long serverTime] [byte keyframe] [long clients 0-31] [long clients 32-63]
+[playerstate deltas of the active clients] [entity deltas] [svc_EOF]
+
+Keyframes delta from the baselines and null playerstates, the other frames
+delta from the previous frame the way SV_EmitPacketEntities does.
+
+=============================================================================
+*/
+
+#define SV_DEMO_SLOTS       4
+#define SV_DEMO_MSGLEN      0x40000
+
+typedef struct {
+	int numEntities;
+	entityState_t entities[MAX_GENTITIES];      // sorted by number
+	int clientMask[2];
+	playerState_t ps[MAX_CLIENTS];
+} svDemoState_t;
+
+typedef struct {
+	int ticket;                     // background job that last used this slot
+	qboolean frame;                 // qfalse for the header
+	qboolean keyframe;
+	qboolean overflowed;            // set by the job if the message didn't fit
+	qboolean writeFailed;           // set by the job if the file write came up short
+	int serverTime;
+	svDemoState_t   *state;
+	msg_t msg;
+	byte            *msgData;
+} svDemoSlot_t;
+
+typedef struct {
+	qboolean recording;
+	FILE            *file;          // raw stdio, the background job can't use the fs handles
+	char name[MAX_QPATH];
+
+	svDemoSlot_t slots[SV_DEMO_SLOTS];
+	int nextSlot;
+
+	svDemoState_t   *prev;          // last frame written, owned by the background job
+	qboolean writeError;            // owned by the background job, skips the writes after a failure
+	int lastFrameTime;
+	int lastKeyframeTime;
+	qboolean csModified[MAX_CONFIGSTRINGS];
+} svDemo_t;
+
+static svDemo_t sv_demo;
+
+/*
+==================
+SV_DemoClientActive
+==================
+*/
+static qboolean SV_DemoClientActive( const svDemoState_t *state, int clientNum ) {
+	if ( !state ) {
+		return qfalse;
+	}
+	return ( state->clientMask[clientNum >> 5] & ( 1u << ( clientNum & 31 ) ) ) != 0;
+}
+
+/*
+==================
+SV_DemoWriteEntities
+
+Same merge as SV_EmitPacketEntities, from may be NULL for a keyframe
+==================
+*/
+static void SV_DemoWriteEntities( msg_t *msg, svDemoState_t *from, svDemoState_t *to ) {
+	entityState_t   *oldent, *newent;
+	int oldindex, newindex;
+	int oldnum, newnum;
+	int from_num_entities;
+
+	from_num_entities = from ? from->numEntities : 0;
+
+	newent = NULL;
+	oldent = NULL;
+	newindex = 0;
+	oldindex = 0;
+	while ( newindex < to->numEntities || oldindex < from_num_entities ) {
+		if ( newindex >= to->numEntities ) {
+			newnum = 9999;
+		} else {
+			newent = &to->entities[newindex];
+			newnum = newent->number;
+		}
+
+		if ( oldindex >= from_num_entities ) {
+			oldnum = 9999;
+		} else {
+			oldent = &from->entities[oldindex];
+			oldnum = oldent->number;
+		}
+
+		if ( newnum == oldnum ) {
+			MSG_WriteDeltaEntity( msg, oldent, newent, qfalse );
+			oldindex++;
+			newindex++;
+			continue;
+		}
+
+		if ( newnum < oldnum ) {
+			MSG_WriteDeltaEntity( msg, &sv.svEntities[newnum].baseline, newent, qtrue );
+			newindex++;
+			continue;
+		}
+
+		if ( newnum > oldnum ) {
+			MSG_WriteDeltaEntity( msg, oldent, NULL, qtrue );
+			oldindex++;
+			continue;
+		}
+	}
+
+	MSG_WriteBits( msg, ( MAX_GENTITIES - 1 ), GENTITYNUM_BITS );
+}
+
+/*
+==================
+SV_DemoWriteJob
+
+Runs on the background thread, encodes the slot's frame if it has one and
+appends the message to the file
+==================
+*/
+static void SV_DemoWriteJob( void *data ) {
+	svDemoSlot_t    *slot;
+	svDemoState_t   *from, *to;
+	int i, len;
+
+	slot = (svDemoSlot_t *)data;
+	to = slot->state;
+
+	if ( slot->frame ) {
+		from = slot->keyframe ? NULL : sv_demo.prev;
+
+		MSG_WriteByte( &slot->msg, svc_snapshot );
+		MSG_WriteLong( &slot->msg, slot->serverTime );
+		MSG_WriteByte( &slot->msg, slot->keyframe );
+		MSG_WriteLong( &slot->msg, to->clientMask[0] );
+		MSG_WriteLong( &slot->msg, to->clientMask[1] );
+
+		for ( i = 0 ; i < MAX_CLIENTS ; i++ ) {
+			if ( !SV_DemoClientActive( to, i ) ) {
+				continue;
+			}
+			if ( SV_DemoClientActive( from, i ) ) {
+				MSG_WriteDeltaPlayerstate( &slot->msg, &from->ps[i], &to->ps[i] );
+			} else {
+				MSG_WriteDeltaPlayerstate( &slot->msg, NULL, &to->ps[i] );
+			}
+		}
+
+		SV_DemoWriteEntities( &slot->msg, from, to );
+
+		MSG_WriteByte( &slot->msg, svc_EOF );
+	}
+
+	// a message that didn't fit is dropped, and prev is left alone so the
+	// next frame still deltas from what is in the file
+	if ( slot->msg.overflowed ) {
+		slot->overflowed = qtrue;
+		return;
+	}
+
+	// FS_Write can print and error, neither of which is safe off the main
+	// thread, so failures are only flagged here and the main thread stops
+	// the demo once it sees them
+	if ( sv_demo.writeError ) {
+		slot->writeFailed = qtrue;
+		return;
+	}
+
+	len = LittleLong( slot->serverTime );
+	if ( fwrite( &len, 4, 1, sv_demo.file ) != 1 ) {
+		sv_demo.writeError = slot->writeFailed = qtrue;
+		return;
+	}
+	len = LittleLong( slot->msg.cursize );
+	if ( fwrite( &len, 4, 1, sv_demo.file ) != 1 ) {
+		sv_demo.writeError = slot->writeFailed = qtrue;
+		return;
+	}
+	if ( fwrite( slot->msg.data, 1, slot->msg.cursize, sv_demo.file ) != (size_t)slot->msg.cursize ) {
+		sv_demo.writeError = slot->writeFailed = qtrue;
+		return;
+	}
+
+	if ( slot->frame ) {
+		// this frame becomes the delta source, hand the old one back to the slot
+		slot->state = sv_demo.prev;
+		sv_demo.prev = to;
+	}
+}
+
+/*
+==================
+SV_DemoNextSlot
+
+Waits for the next slot's previous job and sets up its message, returns
+NULL if the job couldn't write the file and the demo was stopped
+==================
+*/
+static svDemoSlot_t *SV_DemoNextSlot( void ) {
+	svDemoSlot_t    *slot;
+
+	slot = &sv_demo.slots[sv_demo.nextSlot];
+	sv_demo.nextSlot = ( sv_demo.nextSlot + 1 ) % SV_DEMO_SLOTS;
+
+	Sys_WaitBackgroundJob( slot->ticket );
+
+	if ( slot->overflowed ) {
+		Com_Printf( S_COLOR_YELLOW "WARNING: server demo message overflowed, frame %i dropped\n", slot->serverTime );
+		slot->overflowed = qfalse;
+	}
+
+	if ( slot->writeFailed ) {
+		SV_DemoStop();
+		return NULL;
+	}
+
+	MSG_Init( &slot->msg, slot->msgData, SV_DEMO_MSGLEN );
+
+	return slot;
+}
+
+/*
+==================
+SV_DemoStart
+==================
+*/
+void SV_DemoStart( const char *name ) {
+	svDemoSlot_t    *slot;
+	entityState_t   *base, nullstate;
+	qtime_t now;
+	int i;
+
+	if ( sv_demo.recording ) {
+		Com_Printf( "Already recording %s.\n", sv_demo.name );
+		return;
+	}
+
+	if ( sv.state != SS_GAME ) {
+		Com_Printf( "You must be running a map to record a server demo.\n" );
+		return;
+	}
+
+	if ( name && name[0] ) {
+		Com_sprintf( sv_demo.name, sizeof( sv_demo.name ), "svdemos/%s.svdm", name );
+	} else {
+		Com_RealTime( &now );
+		Com_sprintf( sv_demo.name, sizeof( sv_demo.name ), "svdemos/%04d-%02d-%02d-%02d%02d%02d-%s.svdm",
+					 1900 + now.tm_year, now.tm_mon + 1, now.tm_mday, now.tm_hour, now.tm_min, now.tm_sec,
+					 Cvar_VariableString( "mapname" ) );
+	}
+
+	sv_demo.file = FS_FOpenRawFileWrite( sv_demo.name );
+	if ( !sv_demo.file ) {
+		Com_Printf( "ERROR: couldn't open %s.\n", sv_demo.name );
+		return;
+	}
+
+	// RF, avoid trying to allocate large chunks on a fragmented zone
+	for ( i = 0 ; i < SV_DEMO_SLOTS ; i++ ) {
+		sv_demo.slots[i].ticket = 0;
+		sv_demo.slots[i].overflowed = qfalse;
+		sv_demo.slots[i].writeFailed = qfalse;
+		sv_demo.slots[i].state = malloc( sizeof( svDemoState_t ) );
+		sv_demo.slots[i].msgData = malloc( SV_DEMO_MSGLEN );
+		if ( !sv_demo.slots[i].state || !sv_demo.slots[i].msgData ) {
+			Com_Error( ERR_FATAL, "SV_DemoStart: out of memory" );
+		}
+	}
+	sv_demo.prev = malloc( sizeof( svDemoState_t ) );
+	if ( !sv_demo.prev ) {
+		Com_Error( ERR_FATAL, "SV_DemoStart: out of memory" );
+	}
+	sv_demo.prev->numEntities = 0;
+	sv_demo.prev->clientMask[0] = sv_demo.prev->clientMask[1] = 0;
+	sv_demo.writeError = qfalse;
+	sv_demo.nextSlot = 0;
+	sv_demo.lastFrameTime = -1;
+	sv_demo.lastKeyframeTime = -1;
+	memset( sv_demo.csModified, 0, sizeof( sv_demo.csModified ) );
+	sv_demo.recording = qtrue;
+
+	Com_Printf( "recording server demo to %s.\n", sv_demo.name );
+
+	// the header is a gamestate without the client specific parts
+	slot = SV_DemoNextSlot();
+	if ( !slot ) {
+		return;
+	}
+	slot->frame = qfalse;
+	slot->serverTime = svs.time;
+
+	MSG_WriteLong( &slot->msg, PROTOCOL_VERSION );
+	MSG_WriteByte( &slot->msg, svc_gamestate );
+
+	for ( i = 0 ; i < MAX_CONFIGSTRINGS ; i++ ) {
+		if ( sv.configstrings[i][0] ) {
+			MSG_WriteByte( &slot->msg, svc_configstring );
+			MSG_WriteShort( &slot->msg, i );
+			MSG_WriteBigString( &slot->msg, sv.configstrings[i] );
+		}
+	}
+
+	memset( &nullstate, 0, sizeof( nullstate ) );
+	for ( i = 0 ; i < MAX_GENTITIES ; i++ ) {
+		base = &sv.svEntities[i].baseline;
+		if ( !base->number ) {
+			continue;
+		}
+		MSG_WriteByte( &slot->msg, svc_baseline );
+		MSG_WriteDeltaEntity( &slot->msg, &nullstate, base, qtrue );
+	}
+
+	MSG_WriteByte( &slot->msg, svc_EOF );
+
+	slot->ticket = Sys_QueueBackgroundJob( SV_DemoWriteJob, slot );
+}
+
+/*
+==================
+SV_DemoStop
+==================
+*/
+void SV_DemoStop( void ) {
+	qboolean failed;
+	int i, len;
+
+	if ( !sv_demo.recording ) {
+		return;
+	}
+
+	failed = qfalse;
+	for ( i = 0 ; i < SV_DEMO_SLOTS ; i++ ) {
+		Sys_WaitBackgroundJob( sv_demo.slots[i].ticket );
+		if ( sv_demo.slots[i].writeFailed ) {
+			failed = qtrue;
+		}
+	}
+
+	len = -1;
+	if ( fwrite( &len, 4, 1, sv_demo.file ) != 1 || fwrite( &len, 4, 1, sv_demo.file ) != 1 ) {
+		failed = qtrue;
+	}
+	if ( fclose( sv_demo.file ) ) {
+		failed = qtrue;
+	}
+	sv_demo.file = NULL;
+
+	if ( failed ) {
+		Com_Printf( S_COLOR_YELLOW "WARNING: couldn't write server demo %s, the file is incomplete\n", sv_demo.name );
+	}
+
+	for ( i = 0 ; i < SV_DEMO_SLOTS ; i++ ) {
+		free( sv_demo.slots[i].state );
+		free( sv_demo.slots[i].msgData );
+		sv_demo.slots[i].state = NULL;
+		sv_demo.slots[i].msgData = NULL;
+	}
+	free( sv_demo.prev );
+	sv_demo.prev = NULL;
+
+	sv_demo.recording = qfalse;
+
+	Com_Printf( "stopped server demo %s.\n", sv_demo.name );
+}
+
+/*
+==================
+SV_DemoConfigstringModified
+
+Called from SV_SetConfigstring, the string goes out with the next frame
+==================
+*/
+void SV_DemoConfigstringModified( int index ) {
+	if ( sv_demo.recording ) {
+		sv_demo.csModified[index] = qtrue;
+	}
+}
+
+/*
+==================
+SV_DemoFrame
+
+Called once the game has run, queues the new frame if there is one
+==================
+*/
+void SV_DemoFrame( void ) {
+	svDemoSlot_t    *slot;
+	svDemoState_t   *state;
+	sharedEntity_t  *gent;
+	client_t        *cl;
+	int i;
+
+	if ( !sv_demo.recording || svs.time == sv_demo.lastFrameTime ) {
+		return;
+	}
+	sv_demo.lastFrameTime = svs.time;
+
+	slot = SV_DemoNextSlot();
+	if ( !slot ) {
+		return;
+	}
+	slot->frame = qtrue;
+	slot->serverTime = svs.time;
+
+	slot->keyframe = sv_demo.lastKeyframeTime < 0 ||
+					 svs.time - sv_demo.lastKeyframeTime >= sv_demoKeyframe->integer;
+	if ( slot->keyframe ) {
+		sv_demo.lastKeyframeTime = svs.time;
+	}
+
+	for ( i = 0 ; i < MAX_CONFIGSTRINGS ; i++ ) {
+		if ( !sv_demo.csModified[i] ) {
+			continue;
+		}
+		sv_demo.csModified[i] = qfalse;
+
+		MSG_WriteByte( &slot->msg, svc_configstring );
+		MSG_WriteShort( &slot->msg, i );
+		MSG_WriteBigString( &slot->msg, sv.configstrings[i] );
+	}
+
+	state = slot->state;
+
+	state->numEntities = 0;
+	for ( i = 0 ; i < sv.num_entities ; i++ ) {
+		gent = SV_GentityNum( i );
+		if ( !gent->r.linked || ( gent->r.svFlags & SVF_NOCLIENT ) ) {
+			continue;
+		}
+		state->entities[state->numEntities++] = gent->s;
+	}
+
+	state->clientMask[0] = state->clientMask[1] = 0;
+	for ( i = 0, cl = svs.clients ; i < sv_maxclients->integer ; i++, cl++ ) {
+		if ( cl->state != CS_ACTIVE ) {
+			continue;
+		}
+		state->clientMask[i >> 5] |= 1u << ( i & 31 );
+		state->ps[i] = *SV_GameClientNum( i );
+	}
+
+	slot->ticket = Sys_QueueBackgroundJob( SV_DemoWriteJob, slot );
+}
+
+/*
+==================
+SV_Record_f
+
+svrecord [name]
+==================
+*/
+void SV_Record_f( void ) {
+	if ( Cmd_Argc() > 2 ) {
+		Com_Printf( "svrecord [name]\n" );
+		return;
+	}
+
+	SV_DemoStart( Cmd_Argc() == 2 ? Cmd_Argv( 1 ) : NULL );
+}
+
+/*
+==================
+SV_StopRecord_f
+==================
+*/
+void SV_StopRecord_f( void ) {
+	if ( !sv_demo.recording ) {
+		Com_Printf( "Not recording a server demo.\n" );
+		return;
+	}
+
+	SV_DemoStop();
+}
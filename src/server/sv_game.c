@@ -154,6 +154,35 @@ void SV_SetBrushModel( sharedEntity_t *ent, const char *name ) {
 
 
 
+/*
+=================
+SV_PointClusterArea
+
+The game keeps asking about the same handful of points (player eyes and
+origins, sound and hint positions), so remember where they are instead of
+walking the bsp every time
+=================
+*/
+static void SV_PointClusterArea( const vec3_t p, int *cluster, int *area ) {
+	pvsPointCache_t *c;
+	const unsigned int  *v;
+	int leafnum;
+
+	v = (const unsigned int *)p;
+	c = &sv.pvsPointCache[( ( v[0] * 73856093 ) ^ ( v[1] * 19349663 ) ^ ( v[2] * 83492791 ) ) & ( PVS_POINT_CACHE - 1 )];
+
+	if ( !c->valid || c->point[0] != p[0] || c->point[1] != p[1] || c->point[2] != p[2] ) {
+		leafnum = CM_PointLeafnum( p );
+		VectorCopy( p, c->point );
+		c->cluster = CM_LeafCluster( leafnum );
+		c->area = CM_LeafArea( leafnum );
+		c->valid = qtrue;
+	}
+
+	*cluster = c->cluster;
+	*area = c->area;
+}
+
 /*
 =================
 SV_inPVS
@@ -162,19 +191,14 @@ Also checks portalareas so that doors block sight
 =================
 */
 qboolean SV_inPVS( const vec3_t p1, const vec3_t p2 ) {
-	int leafnum;
 	int cluster;
 	int area1, area2;
 	byte    *mask;
 
-	leafnum = CM_PointLeafnum( p1 );
-	cluster = CM_LeafCluster( leafnum );
-	area1 = CM_LeafArea( leafnum );
+	SV_PointClusterArea( p1, &cluster, &area1 );
 	mask = CM_ClusterPVS( cluster );
 
-	leafnum = CM_PointLeafnum( p2 );
-	cluster = CM_LeafCluster( leafnum );
-	area2 = CM_LeafArea( leafnum );
+	SV_PointClusterArea( p2, &cluster, &area2 );
 	if ( mask && ( !( mask[cluster >> 3] & ( 1 << ( cluster & 7 ) ) ) ) ) {
 		return qfalse;
 	}
@@ -193,19 +217,14 @@ Does NOT check portalareas
 =================
 */
 qboolean SV_inPVSIgnorePortals( const vec3_t p1, const vec3_t p2 ) {
-	int leafnum;
 	int cluster;
 	int area1, area2;
 	byte    *mask;
 
-	leafnum = CM_PointLeafnum( p1 );
-	cluster = CM_LeafCluster( leafnum );
-	area1 = CM_LeafArea( leafnum );
+	SV_PointClusterArea( p1, &cluster, &area1 );
 	mask = CM_ClusterPVS( cluster );
 
-	leafnum = CM_PointLeafnum( p2 );
-	cluster = CM_LeafCluster( leafnum );
-	area2 = CM_LeafArea( leafnum );
+	SV_PointClusterArea( p2, &cluster, &area2 );
 
 	if ( mask && ( !( mask[cluster >> 3] & ( 1 << ( cluster & 7 ) ) ) ) ) {
 		return qfalse;
@@ -1011,6 +1030,13 @@ int SV_GameSystemCalls( int *args ) {
 	case G_FS_PAK_INFO_FOR_FILE:
 		return FS_PakInfoForFile( VMA( 1 ), VMA( 2 ) );
 
+	case G_TRACEBATCH:
+		if ( args[3] < 0 || args[3] > MAX_TRACEBATCH ) {
+			Com_Error( ERR_DROP, "G_TRACEBATCH: bad ray count %i", args[3] );
+		}
+		SV_TraceBatch( VMA( 1 ), VMA( 2 ), args[3] );
+		return 0;
+
 	default:
 		Com_Error( ERR_DROP, "Bad game system trap: %i", args[0] );
 	}
@@ -1112,7 +1138,7 @@ void SV_InitGameProgs( void ) {
 	sv.num_tags = 0;
 
 	// load the dll
-	gvm = VM_Create( "qagame", SV_GameSystemCalls, VMI_NATIVE );
+	gvm = VM_Create( "qagame", SV_GameSystemCalls, Cvar_VariableIntegerValue( "vm_game" ) );
 	if ( !gvm ) {
 		Com_Error( ERR_FATAL, "VM_Create on game failed" );
 	}
@@ -78,6 +78,8 @@ void SV_SetConfigstring( int index, const char *val ) {
 	Z_Free( sv.configstrings[index] );
 	sv.configstrings[index] = CopyString( val );
 	sv.configstringsmodified[index] = qtrue;
+
+	SV_DemoConfigstringModified( index );
 }
 
 void SV_UpdateConfigStrings( void ) {
@@ -519,6 +521,9 @@ void SV_SpawnServer( char *server, qboolean killBots ) {
 		SV_FinalCommand( "spawnserver", qfalse );
 	}
 
+	// the baselines are about to change
+	SV_DemoStop();
+
 	// shut down the existing game if it is running
 	SV_ShutdownGameProgs();
 
@@ -743,6 +748,9 @@ void SV_SpawnServer( char *server, qboolean killBots ) {
 	SV_SetConfigstring( CS_WOLFINFO, Cvar_InfoString( CVAR_WOLFINFO ) );
 	cvar_modifiedFlags &= ~CVAR_WOLFINFO;
 
+	// the serverinfo changes above won't be seen by SV_Frame
+	SV_QueryCacheInvalidate();
+
 	// any media configstring setting now should issue a warning
 	// and any configstring changes should be reliably transmitted
 	// to all clients
@@ -757,6 +765,10 @@ void SV_SpawnServer( char *server, qboolean killBots ) {
 
 	Cvar_Set( "sv_serverRestarting", "0" );
 
+	if ( sv_autoRecord->integer ) {
+		SV_DemoStart( NULL );
+	}
+
 	Com_Printf( "-----------------------------------\n" );
 
 	if ( *sv_chatConnectedServers->string ) {
@@ -849,6 +861,9 @@ void SV_Init( void ) {
 
 	sv_mapNames = Cvar_Get( "sv_mapNames", "", CVAR_ROM );
 
+	// lets the game know it can use G_TRACEBATCH
+	Cvar_Get( "sv_traceBatch", "1", CVAR_ROM );
+
 	// server vars
 	sv_rconPassword = Cvar_Get( "rconPassword", "", CVAR_TEMP );
 	sv_privatePassword = Cvar_Get( "sv_privatePassword", "", CVAR_TEMP );
@@ -964,6 +979,16 @@ void SV_Init( void ) {
 	// ET://someserver.com
 	sv_fullmsg = Cvar_Get( "sv_fullmsg", "Server is full.", CVAR_ARCHIVE );
 
+	sv_snapshotWorkers = Cvar_Get( "sv_snapshotWorkers", "0", CVAR_ARCHIVE );
+	sv_snapshotBudget = Cvar_Get( "sv_snapshotBudget", "0", CVAR_ARCHIVE );
+	sv_snapshotMaxHold = Cvar_Get( "sv_snapshotMaxHold", "1", CVAR_ARCHIVE );
+	sv_worldGrid = Cvar_Get( "sv_worldGrid", "0", CVAR_ARCHIVE );
+	sv_worldGridCellSize = Cvar_Get( "sv_worldGridCellSize", "256", CVAR_ARCHIVE );
+	sv_demoKeyframe = Cvar_Get( "sv_demoKeyframe", "10000", CVAR_ARCHIVE );
+	sv_autoRecord = Cvar_Get( "sv_autoRecord", "0", CVAR_ARCHIVE );
+	sv_queryRate = Cvar_Get( "sv_queryRate", "0", CVAR_ARCHIVE );     // off by default, 2 with a burst of 8 suits public servers
+	sv_queryBurst = Cvar_Get( "sv_queryBurst", "8", CVAR_ARCHIVE );
+
 	// initialize bot cvars so they are listed and can be set before loading the botlib
 	SV_BotInitCvars();
 
@@ -1038,6 +1063,8 @@ void SV_Shutdown( char *finalmsg ) {
 
 	SV_RemoveOperatorCommands();
 	SV_MasterShutdown();
+	SV_DemoStop();
+	SV_ShutdownSnapshotWorkers();
 	SV_ShutdownGameProgs();
 
 	// free current level
@@ -133,6 +133,16 @@ cvar_t  *sv_packetdelay;
 // fretn
 cvar_t  *sv_fullmsg;
 
+cvar_t  *sv_snapshotWorkers;     // worker threads building client snapshots, 0 builds them on the main thread
+cvar_t  *sv_snapshotBudget;      // hold back unimportant entity changes instead of rate delaying snapshots
+cvar_t  *sv_snapshotMaxHold;     // snapshots in a row an entity change may be held back
+cvar_t  *sv_worldGrid;           // use a uniform grid instead of the sector tree for area queries, read at map load
+cvar_t  *sv_worldGridCellSize;
+cvar_t  *sv_demoKeyframe;
+cvar_t  *sv_autoRecord;
+cvar_t  *sv_queryRate;           // getstatus/getinfo packets per second allowed from one address, 0 is unlimited
+cvar_t  *sv_queryBurst;
+
 void SVC_GameCompleteStatus( netadr_t from );       // NERVE - SMF
 
 #define LL( x ) x = LittleLong( x )
@@ -447,6 +457,157 @@ qboolean SV_VerifyChallenge( char *challenge ) {
 	return qtrue;
 }
 
+/*
+=============================================================================
+
+QUERY RESPONSE CACHE
+
+The getstatus and getinfo responses only depend on the serverinfo cvars,
+a few other cvars and the state, score, ping and name of each client.
+They are built once and reused until SV_QueryCacheFrame sees one of those
+change, only the challenge is added to each response.
+
+=============================================================================
+*/
+
+typedef struct {
+	qboolean connected;
+	qboolean bot;
+	int score;
+	int ping;
+	int name;                           // hash of the originalname
+} queryClient_t;
+
+typedef struct {
+	qboolean statusValid;
+	char statusInfo[MAX_INFO_STRING];   // serverinfo without the challenge
+	int statusInfoLength;
+	char statusPlayers[MAX_MSGLEN];
+
+	qboolean infoValid;
+	int infoCount;                      // "clients" the info response was built with
+	char info[MAX_INFO_STRING];         // without the challenge
+	int infoLength;
+
+	// what the responses were built from
+	queryClient_t clients[MAX_CLIENTS];
+	int maxclients;
+	int serverLoad;
+	int cvarCount;                      // modificationCounts of the cvars that aren't serverinfo
+
+	// stats for querystats
+	int statusHits;
+	int statusMisses;
+	int infoHits;
+	int infoMisses;
+	int drops;
+} queryCache_t;
+
+static queryCache_t sv_queryCache;
+
+/*
+================
+SV_QueryCacheInvalidate
+================
+*/
+void SV_QueryCacheInvalidate( void ) {
+	sv_queryCache.statusValid = qfalse;
+	sv_queryCache.infoValid = qfalse;
+}
+
+/*
+================
+SV_QueryCacheFrame
+
+Called every frame before the modified serverinfo cvars are cleared
+================
+*/
+static void SV_QueryCacheFrame( void ) {
+	queryClient_t qc;
+	client_t        *cl;
+	int i, cvarCount;
+
+	if ( cvar_modifiedFlags & ( CVAR_SERVERINFO | CVAR_SERVERINFO_NOUPDATE | CVAR_SYSTEMINFO ) ) {
+		SV_QueryCacheInvalidate();
+	}
+
+	cvarCount = sv_needpass->modificationCount + sv_infoCountBots->modificationCount;
+	if ( cvarCount != sv_queryCache.cvarCount || svs.serverLoad != sv_queryCache.serverLoad ) {
+		sv_queryCache.cvarCount = cvarCount;
+		sv_queryCache.serverLoad = svs.serverLoad;
+		sv_queryCache.infoValid = qfalse;
+	}
+
+	if ( sv_maxclients->integer != sv_queryCache.maxclients ) {
+		sv_queryCache.maxclients = sv_maxclients->integer;
+		memset( sv_queryCache.clients, 0, sizeof( sv_queryCache.clients ) );
+		SV_QueryCacheInvalidate();
+	}
+
+	for ( i = 0, cl = svs.clients ; i < sv_maxclients->integer ; i++, cl++ ) {
+		memset( &qc, 0, sizeof( qc ) );
+		if ( cl->state >= CS_CONNECTED ) {
+			qc.connected = qtrue;
+			qc.bot = cl->netchan.remoteAddress.type == NA_BOT;
+			qc.score = SV_GameClientNum( i )->persistant[PERS_SCORE];
+			qc.ping = cl->ping;
+			qc.name = Com_HashKey( Info_ValueForKey( cl->userinfo, "originalname" ), MAX_NAME_LENGTH );
+		}
+
+		if ( memcmp( &qc, &sv_queryCache.clients[i], sizeof( qc ) ) ) {
+			if ( qc.connected != sv_queryCache.clients[i].connected || qc.bot != sv_queryCache.clients[i].bot ) {
+				sv_queryCache.infoValid = qfalse;
+			}
+			sv_queryCache.clients[i] = qc;
+			sv_queryCache.statusValid = qfalse;
+		}
+	}
+}
+
+/*
+================
+SV_QueryLimited
+
+Token bucket per source address, checked before the packet is parsed
+================
+*/
+static qboolean SV_QueryLimited( int ips_index ) {
+	int interval;
+
+	if ( sv_queryRate->integer <= 0 ) {
+		return qfalse;
+	}
+
+	interval = 1000 / sv_queryRate->integer;
+	if ( svs.ips[ips_index].queryTime < svs.time - interval * sv_queryBurst->integer ) {
+		svs.ips[ips_index].queryTime = svs.time - interval * sv_queryBurst->integer;
+	}
+	if ( svs.ips[ips_index].queryTime + interval > svs.time ) {
+		sv_queryCache.drops++;
+		return qtrue;
+	}
+	svs.ips[ips_index].queryTime += interval;
+
+	return qfalse;
+}
+
+/*
+================
+SV_QueryStats_f
+================
+*/
+void SV_QueryStats_f( void ) {
+	int total;
+
+	total = sv_queryCache.statusHits + sv_queryCache.statusMisses;
+	Com_Printf( "getstatus: %i responses, %i built, %.1f%% cached\n", total, sv_queryCache.statusMisses,
+				total ? 100.0f * sv_queryCache.statusHits / total : 0.0f );
+	total = sv_queryCache.infoHits + sv_queryCache.infoMisses;
+	Com_Printf( "getinfo:   %i responses, %i built, %.1f%% cached\n", total, sv_queryCache.infoMisses,
+				total ? 100.0f * sv_queryCache.infoHits / total : 0.0f );
+	Com_Printf( "%i queries dropped by sv_queryRate\n", sv_queryCache.drops );
+}
+
 /*
 ================
 SVC_Status
@@ -458,13 +619,14 @@ the simple info query.
 */
 void SVC_Status( netadr_t from ) {
 	char player[1024];
-	char status[MAX_MSGLEN];
+	char    *status;
 	int i;
 	client_t    *cl;
 	playerState_t   *ps;
 	int statusLength;
 	int playerLength;
-	char infostring[MAX_INFO_STRING];
+	char    *infostring;
+	char    *challenge;
 
 	// ignore if we are in single player
 	if ( SV_GameIsSinglePlayer() ) {
@@ -472,47 +634,62 @@ void SVC_Status( netadr_t from ) {
 	}
 
 	//bani - bugtraq 12534
-	if ( !SV_VerifyChallenge( Cmd_Argv( 1 ) ) ) {
+	challenge = Cmd_Argv( 1 );
+	if ( !SV_VerifyChallenge( challenge ) ) {
 		return;
 	}
 
-	strcpy( infostring, Cvar_InfoString( CVAR_SERVERINFO | CVAR_SERVERINFO_NOUPDATE ) );
-
-	// echo back the parameter to status. so master servers can use it as a challenge
-	// to prevent timed spoofed reply packets that add ghost servers
-	Info_SetValueForKey( infostring, "challenge", Cmd_Argv( 1 ) );
+	infostring = sv_queryCache.statusInfo;
+	status = sv_queryCache.statusPlayers;
 
-	// add "demo" to the sv_keywords if restricted
-	if ( Cvar_VariableValue( "fs_restrict" ) ) {
-		char keywords[MAX_INFO_STRING];
+	if ( sv_queryCache.statusValid ) {
+		sv_queryCache.statusHits++;
+	} else {
+		sv_queryCache.statusMisses++;
 
-		Com_sprintf( keywords, sizeof( keywords ), "ettest %s",
-					 Info_ValueForKey( infostring, "sv_keywords" ) );
-		Info_SetValueForKey( infostring, "sv_keywords", keywords );
-	}
+		Q_strncpyz( infostring, Cvar_InfoString( CVAR_SERVERINFO | CVAR_SERVERINFO_NOUPDATE ), sizeof( sv_queryCache.statusInfo ) );
 
-	status[0] = 0;
-	statusLength = 0;
+		// add "demo" to the sv_keywords if restricted
+		if ( Cvar_VariableValue( "fs_restrict" ) ) {
+			char keywords[MAX_INFO_STRING];
 
-	for ( i = 0 ; i < sv_maxclients->integer ; i++ ) {
-		cl = &svs.clients[i];
-		if ( cl->state >= CS_CONNECTED ) {
-			ps = SV_GameClientNum( i );
-			Com_sprintf( player, sizeof( player ), "%i %i \"%s\"\n",
-						 ps->persistant[PERS_SCORE], cl->ping, Info_ValueForKey( cl->userinfo, "originalname" ) );
-			playerLength = strlen( player );
-			if ( statusLength + playerLength >= sizeof( status ) ) {
-				break;      // can't hold any more
+			Com_sprintf( keywords, sizeof( keywords ), "ettest %s",
+						 Info_ValueForKey( infostring, "sv_keywords" ) );
+			Info_SetValueForKey( infostring, "sv_keywords", keywords );
+		}
+		sv_queryCache.statusInfoLength = strlen( infostring );
+
+		status[0] = 0;
+		statusLength = 0;
+
+		for ( i = 0 ; i < sv_maxclients->integer ; i++ ) {
+			cl = &svs.clients[i];
+			if ( cl->state >= CS_CONNECTED ) {
+				ps = SV_GameClientNum( i );
+				Com_sprintf( player, sizeof( player ), "%i %i \"%s\"\n",
+							 ps->persistant[PERS_SCORE], cl->ping, Info_ValueForKey( cl->userinfo, "originalname" ) );
+				playerLength = strlen( player );
+				if ( statusLength + playerLength >= sizeof( sv_queryCache.statusPlayers ) ) {
+					break;      // can't hold any more
+				}
+				strcpy( status + statusLength, player );
+				statusLength += playerLength;
 			}
-			strcpy( status + statusLength, player );
-			statusLength += playerLength;
 		}
+		/*if ( statusLength == 0 && sv_pretendNonEmpty->integer ) {
+			strcpy( status, "0 0 \"NO PLAYER\"\n" );
+		}*/
+
+		sv_queryCache.statusValid = qtrue;
 	}
-	/*if ( statusLength == 0 && sv_pretendNonEmpty->integer ) {
-		strcpy( status, "0 0 \"NO PLAYER\"\n" );
-	}*/
 
-	NET_OutOfBandPrint( NS_SERVER, from, "statusResponse\n%s\n%s", infostring, status );
+	// echo back the parameter to status. so master servers can use it as a challenge
+	// to prevent timed spoofed reply packets that add ghost servers
+	if ( challenge[0] && sv_queryCache.statusInfoLength + strlen( "\\challenge\\" ) + strlen( challenge ) < MAX_INFO_STRING ) {
+		NET_OutOfBandPrint( NS_SERVER, from, "statusResponse\n%s\\challenge\\%s\n%s", infostring, challenge, status );
+	} else {
+		NET_OutOfBandPrint( NS_SERVER, from, "statusResponse\n%s\n%s", infostring, status );
+	}
 }
 
 /*
@@ -590,10 +767,11 @@ if a user is interested in a server to do a full status
 void SVC_Info( netadr_t from ) {
 	int i, count;
 	char    *gamedir;
-	char infostring[MAX_INFO_STRING];
+	char    *infostring;
 	char    *antilag;
 	char    *weaprestrict;
 	char    *balancedteams;
+	char    *challenge;
 
 	// ignore if we are in single player
 	if ( SV_GameIsSinglePlayer() ) {
@@ -601,7 +779,8 @@ void SVC_Info( netadr_t from ) {
 	}
 
 	//bani - bugtraq 12534
-	if ( !SV_VerifyChallenge( Cmd_Argv( 1 ) ) ) {
+	challenge = Cmd_Argv( 1 );
+	if ( !SV_VerifyChallenge( challenge ) ) {
 		return;
 	}
 
@@ -634,60 +813,74 @@ void SVC_Info( netadr_t from ) {
 		}
 	}
 
-	infostring[0] = 0;
+	infostring = sv_queryCache.info;
 
-	// echo back the parameter to status. so servers can use it as a challenge
-	// to prevent timed spoofed reply packets that add ghost servers
-	Info_SetValueForKey( infostring, "challenge", Cmd_Argv( 1 ) );
+	if ( sv_queryCache.infoValid && count == sv_queryCache.infoCount ) {
+		sv_queryCache.infoHits++;
+	} else {
+		sv_queryCache.infoMisses++;
+
+		infostring[0] = 0;
+
+		Info_SetValueForKey( infostring, "protocol", va( "%i", PROTOCOL_VERSION ) );
+		Info_SetValueForKey( infostring, "hostname", sv_hostname->string );
+		Info_SetValueForKey( infostring, "serverload", va( "%i", svs.serverLoad ) );
+		Info_SetValueForKey( infostring, "mapname", sv_mapname->string );
+		Info_SetValueForKey( infostring, "clients", va( "%i", count ) );
+		Info_SetValueForKey( infostring, "sv_maxclients", va( "%i", sv_maxclients->integer - sv_privateClients->integer ) );
+		//Info_SetValueForKey( infostring, "gametype", va("%i", sv_gametype->integer ) );
+		Info_SetValueForKey( infostring, "gametype", Cvar_VariableString( "g_gametype" ) );
+		Info_SetValueForKey( infostring, "pure", va( "%i", sv_pure->integer ) );
+
+		if ( sv_minPing->integer ) {
+			Info_SetValueForKey( infostring, "minPing", va( "%i", sv_minPing->integer ) );
+		}
+		if ( sv_maxPing->integer ) {
+			Info_SetValueForKey( infostring, "maxPing", va( "%i", sv_maxPing->integer ) );
+		}
+		gamedir = Cvar_VariableString( "fs_game" );
+		if ( *gamedir ) {
+			Info_SetValueForKey( infostring, "game", gamedir );
+		}
+		Info_SetValueForKey( infostring, "sv_allowAnonymous", va( "%i", sv_allowAnonymous->integer ) );
 
-	Info_SetValueForKey( infostring, "protocol", va( "%i", PROTOCOL_VERSION ) );
-	Info_SetValueForKey( infostring, "hostname", sv_hostname->string );
-	Info_SetValueForKey( infostring, "serverload", va( "%i", svs.serverLoad ) );
-	Info_SetValueForKey( infostring, "mapname", sv_mapname->string );
-	Info_SetValueForKey( infostring, "clients", va( "%i", count ) );
-	Info_SetValueForKey( infostring, "sv_maxclients", va( "%i", sv_maxclients->integer - sv_privateClients->integer ) );
-	//Info_SetValueForKey( infostring, "gametype", va("%i", sv_gametype->integer ) );
-	Info_SetValueForKey( infostring, "gametype", Cvar_VariableString( "g_gametype" ) );
-	Info_SetValueForKey( infostring, "pure", va( "%i", sv_pure->integer ) );
+		// Rafael gameskill
+	//	Info_SetValueForKey (infostring, "gameskill", va ("%i", sv_gameskill->integer));
+		// done
 
-	if ( sv_minPing->integer ) {
-		Info_SetValueForKey( infostring, "minPing", va( "%i", sv_minPing->integer ) );
-	}
-	if ( sv_maxPing->integer ) {
-		Info_SetValueForKey( infostring, "maxPing", va( "%i", sv_maxPing->integer ) );
-	}
-	gamedir = Cvar_VariableString( "fs_game" );
-	if ( *gamedir ) {
-		Info_SetValueForKey( infostring, "game", gamedir );
-	}
-	Info_SetValueForKey( infostring, "sv_allowAnonymous", va( "%i", sv_allowAnonymous->integer ) );
+		Info_SetValueForKey( infostring, "friendlyFire", va( "%i", sv_friendlyFire->integer ) );        // NERVE - SMF
+		Info_SetValueForKey( infostring, "maxlives", va( "%i", sv_maxlives->integer ? 1 : 0 ) );        // NERVE - SMF
+		Info_SetValueForKey( infostring, "needpass", va( "%i", sv_needpass->integer ? 1 : 0 ) );
+		Info_SetValueForKey( infostring, "gamename", GAMENAME_STRING );                               // Arnout: to be able to filter out Quake servers
 
-	// Rafael gameskill
-//	Info_SetValueForKey (infostring, "gameskill", va ("%i", sv_gameskill->integer));
-	// done
+		// TTimo
+		antilag = Cvar_VariableString( "g_antilag" );
+		if ( antilag ) {
+			Info_SetValueForKey( infostring, "g_antilag", antilag );
+		}
 
-	Info_SetValueForKey( infostring, "friendlyFire", va( "%i", sv_friendlyFire->integer ) );        // NERVE - SMF
-	Info_SetValueForKey( infostring, "maxlives", va( "%i", sv_maxlives->integer ? 1 : 0 ) );        // NERVE - SMF
-	Info_SetValueForKey( infostring, "needpass", va( "%i", sv_needpass->integer ? 1 : 0 ) );
-	Info_SetValueForKey( infostring, "gamename", GAMENAME_STRING );                               // Arnout: to be able to filter out Quake servers
+		weaprestrict = Cvar_VariableString( "g_heavyWeaponRestriction" );
+		if ( weaprestrict ) {
+			Info_SetValueForKey( infostring, "weaprestrict", weaprestrict );
+		}
 
-	// TTimo
-	antilag = Cvar_VariableString( "g_antilag" );
-	if ( antilag ) {
-		Info_SetValueForKey( infostring, "g_antilag", antilag );
-	}
+		balancedteams = Cvar_VariableString( "g_balancedteams" );
+		if ( balancedteams ) {
+			Info_SetValueForKey( infostring, "balancedteams", balancedteams );
+		}
 
-	weaprestrict = Cvar_VariableString( "g_heavyWeaponRestriction" );
-	if ( weaprestrict ) {
-		Info_SetValueForKey( infostring, "weaprestrict", weaprestrict );
+		sv_queryCache.infoLength = strlen( infostring );
+		sv_queryCache.infoCount = count;
+		sv_queryCache.infoValid = qtrue;
 	}
 
-	balancedteams = Cvar_VariableString( "g_balancedteams" );
-	if ( balancedteams ) {
-		Info_SetValueForKey( infostring, "balancedteams", balancedteams );
+	// echo back the parameter to status. so servers can use it as a challenge
+	// to prevent timed spoofed reply packets that add ghost servers
+	if ( challenge[0] && sv_queryCache.infoLength + strlen( "\\challenge\\" ) + strlen( challenge ) < MAX_INFO_STRING ) {
+		NET_OutOfBandPrint( NS_SERVER, from, "infoResponse\n\\challenge\\%s%s", challenge, infostring );
+	} else {
+		NET_OutOfBandPrint( NS_SERVER, from, "infoResponse\n%s", infostring );
 	}
-
-	NET_OutOfBandPrint( NS_SERVER, from, "infoResponse\n%s", infostring );
 }
 
 /*
@@ -778,6 +971,77 @@ void SVC_RemoteCommand( netadr_t from, msg_t *msg ) {
 	Com_EndRedirect();
 }
 
+/*
+=================
+SV_HashIp
+=================
+*/
+static int SV_HashIp( const byte *ip ) {
+	return ( ( ip[0] | ( ip[1] << 8 ) | ( ip[2] << 16 ) | ( (unsigned)ip[3] << 24 ) ) * 2654435761u ) >> ( 32 - IPS_HASH_BITS );
+}
+
+/*
+=================
+SV_FindIp
+
+Returns the svs.ips entry for the address, or -1
+=================
+*/
+static int SV_FindIp( netadr_t from ) {
+	int i;
+
+	for ( i = svs.ipsHash[SV_HashIp( from.ip )] - 1 ; i >= 0 ; i = svs.ips[i].hashNext - 1 ) {
+		if ( svs.ips[i].ip[0] == from.ip[0] && svs.ips[i].ip[1] == from.ip[1] && svs.ips[i].ip[2] == from.ip[2] && svs.ips[i].ip[3] == from.ip[3] ) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+/*
+=================
+SV_AddIp
+
+Takes over the oldest svs.ips entry once they are all in use
+=================
+*/
+static int SV_AddIp( netadr_t from ) {
+	int i, *link;
+
+	if ( svs.numIps >= MAX_IPS_NUM ) {
+		svs.numIps = 0;
+	}
+	i = svs.numIps;
+
+	// unlink the address that used this entry before
+	for ( link = &svs.ipsHash[SV_HashIp( svs.ips[i].ip )] ; *link ; link = &svs.ips[*link - 1].hashNext ) {
+		if ( *link - 1 == i ) {
+			*link = svs.ips[i].hashNext;
+			break;
+		}
+	}
+
+	svs.ips[i].ip[0] = from.ip[0];
+	svs.ips[i].ip[1] = from.ip[1];
+	svs.ips[i].ip[2] = from.ip[2];
+	svs.ips[i].ip[3] = from.ip[3];
+
+	svs.ips[i].getinfo_time = -45245;
+	svs.ips[i].getstatus_time = -45245;
+	svs.ips[i].maxPacketsTime = -9999;
+	svs.ips[i].getstatusLimitTime = -9999;
+	svs.ips[i].getstatusRestrictionTime = 0;
+	svs.ips[i].queryTime = -99999;
+
+	svs.ips[i].hashNext = svs.ipsHash[SV_HashIp( from.ip )];
+	svs.ipsHash[SV_HashIp( from.ip )] = i + 1;
+
+	svs.numIps++;
+
+	return i;
+}
+
 /*
 =================
 SV_ConnectionlessPacket
@@ -795,41 +1059,30 @@ void SV_ConnectionlessPacket( netadr_t from, msg_t *msg ) {
 	fileHandle_t logfile;
 	char	log[128];
 
-	qboolean ipFound = qfalse;
+	qboolean queryChecked = qfalse;
 	int ips_index;
 	int i, j;
 
-	for(i = 0; i < svs.numIps; i++){
-		if(svs.ips[i].ip[0] == from.ip[0] && svs.ips[i].ip[1] == from.ip[1] && svs.ips[i].ip[2] == from.ip[2] && svs.ips[i].ip[3] == from.ip[3]){
-			if ( svs.ips[i].maxPacketsTime < svs.time - 4900 ) {
-				svs.ips[i].maxPacketsTime = svs.time - 4900;
-			}
-			if ( svs.ips[i].maxPacketsTime >= svs.time ) {
-				return;
-			}
-			svs.ips[i].maxPacketsTime += 4900 / MAX_PACKETS_IN_TIME;
-			ips_index = i;
-			ipFound = qtrue;
+	ips_index = SV_FindIp( from );
+	if ( ips_index >= 0 ) {
+		i = ips_index;
+		if ( svs.ips[i].maxPacketsTime < svs.time - 4900 ) {
+			svs.ips[i].maxPacketsTime = svs.time - 4900;
 		}
+		if ( svs.ips[i].maxPacketsTime >= svs.time ) {
+			return;
+		}
+		svs.ips[i].maxPacketsTime += 4900 / MAX_PACKETS_IN_TIME;
+	} else {
+		ips_index = SV_AddIp( from );
 	}
 
-	if(ipFound == qfalse){
-		if(svs.numIps >= MAX_IPS_NUM){
-			svs.numIps = 0;
-		}
-		
-		for(i = 0; i < 4; i++){
-			svs.ips[svs.numIps].ip[i] = from.ip[i];
+	// drop query floods before spending any time on the packet
+	if ( !Q_stricmpn( "getstatus", (char *)&msg->data[4], 9 ) || !Q_stricmpn( "getinfo", (char *)&msg->data[4], 7 ) ) {
+		if ( SV_QueryLimited( ips_index ) ) {
+			return;
 		}
-
-		svs.ips[svs.numIps].getinfo_time = -45245;
-		svs.ips[svs.numIps].getstatus_time = -45245;
-		svs.ips[svs.numIps].maxPacketsTime = -9999;
-		svs.ips[svs.numIps].getstatusLimitTime = -9999;
-		svs.ips[svs.numIps].getstatusRestrictionTime = 0;
-		ips_index = svs.numIps;
-		
-		svs.numIps++;
+		queryChecked = qtrue;
 	}
 
 	MSG_BeginReadingOOB( msg );
@@ -846,6 +1099,10 @@ void SV_ConnectionlessPacket( netadr_t from, msg_t *msg ) {
 	c = Cmd_Argv( 0 );
 	Com_DPrintf( "SV packet %s : %s\n", NET_AdrToString( from ), c );
 
+	if ( ( !Q_stricmp( c,"getstatus" ) || !Q_stricmp( c,"getinfo" ) ) && !queryChecked && SV_QueryLimited( ips_index ) ) {
+		return;
+	}
+
 	if ( !Q_stricmp( c,"getstatus" ) ) {
 		//qboolean found = qfalse;
 		//cvar_t *max_getstatus;
@@ -1195,6 +1452,8 @@ void SV_Frame( int msec ) {
 	int startTime;
 	char mapname[MAX_QPATH];
 	int frameStartTime = 0, frameEndTime;
+	int perfStart, perfFrameStart;
+	int i, numClients;
 
 	// the menu kills the server with this cvar
 	if ( sv_killserver->integer ) {
@@ -1250,6 +1509,8 @@ void SV_Frame( int msec ) {
 		return;
 	}
 
+	SV_QueryCacheFrame();
+
 	// update infostrings if anything has been changed
 	if ( cvar_modifiedFlags & CVAR_SERVERINFO ) {
 		SV_SetConfigstring( CS_SERVERINFO, Cvar_InfoString( CVAR_SERVERINFO | CVAR_SERVERINFO_NOUPDATE ) );
@@ -1275,6 +1536,8 @@ void SV_Frame( int msec ) {
 		startTime = 0;  // quite a compiler warning
 	}
 
+	perfFrameStart = Perf_Begin();
+
 	// update ping based on the all received frames
 	SV_CalcPings();
 
@@ -1288,9 +1551,14 @@ void SV_Frame( int msec ) {
 		svs.time += frameMsec;
 
 		// let everything in the world think and move
+		perfStart = Perf_Begin();
 		VM_Call( gvm, GAME_RUN_FRAME, svs.time );
+		Perf_End( PERF_GAME_RUN_FRAME, perfStart );
 	}
 
+	// copy the new frame out for the server demo
+	SV_DemoFrame();
+
 	if ( com_speeds->integer ) {
 		time_game = Sys_Milliseconds() - startTime;
 	}
@@ -1299,11 +1567,24 @@ void SV_Frame( int msec ) {
 	SV_CheckTimeouts();
 
 	// send messages back to the clients
+	perfStart = Perf_Begin();
 	SV_SendClientMessages();
+	Perf_End( PERF_SEND_MESSAGES, perfStart );
 
 	// send a heartbeat to the master if needed
 	SV_MasterHeartbeat( HEARTBEAT_GAME );
 
+	Perf_End( PERF_SV_FRAME, perfFrameStart );
+	if ( com_perfStats->integer ) {
+		numClients = 0;
+		for ( i = 0 ; i < sv_maxclients->integer ; i++ ) {
+			if ( svs.clients[i].state >= CS_CONNECTED ) {
+				numClients++;
+			}
+		}
+		Perf_EndFrame( numClients );
+	}
+
 	if ( com_dedicated->integer ) {
 		frameEndTime = Sys_Milliseconds();
 
@@ -29,6 +29,10 @@ If you have questions concerning this license or the applicable additional terms
 
 #include "server.h"
 
+//#define	MAX_SNAPSHOT_ENTITIES	1024
+#define MAX_SNAPSHOT_ENTITIES   2048
+
+#define HEADER_RATE_BYTES   48      // include our header, IP header, and some overhead
 
 /*
 =============================================================================
@@ -57,9 +61,13 @@ A normal server packet will look like:
 SV_EmitPacketEntities
 
 Writes a delta update of an entityState_t list to the message.
+Each frame's entities are read from the array passed with it, which is
+svs.snapshotEntities or, for a snapshot built on a worker thread, the
+frame's private copy.
 =============
 */
-static void SV_EmitPacketEntities( clientSnapshot_t *from, clientSnapshot_t *to, msg_t *msg ) {
+static void SV_EmitPacketEntities( clientSnapshot_t *from, entityState_t *fromEntities, int numFromEntities,
+								   clientSnapshot_t *to, entityState_t *toEntities, int numToEntities, msg_t *msg ) {
 	entityState_t   *oldent, *newent;
 	int oldindex, newindex;
 	int oldnum, newnum;
@@ -80,14 +88,14 @@ static void SV_EmitPacketEntities( clientSnapshot_t *from, clientSnapshot_t *to,
 		if ( newindex >= to->num_entities ) {
 			newnum = 9999;
 		} else {
-			newent = &svs.snapshotEntities[( to->first_entity + newindex ) % svs.numSnapshotEntities];
+			newent = &toEntities[( to->first_entity + newindex ) % numToEntities];
 			newnum = newent->number;
 		}
 
 		if ( oldindex >= from_num_entities ) {
 			oldnum = 9999;
 		} else {
-			oldent = &svs.snapshotEntities[( from->first_entity + oldindex ) % svs.numSnapshotEntities];
+			oldent = &fromEntities[( from->first_entity + oldindex ) % numFromEntities];
 			oldnum = oldent->number;
 		}
 
@@ -123,41 +131,280 @@ static void SV_EmitPacketEntities( clientSnapshot_t *from, clientSnapshot_t *to,
 
 /*
 ==================
-SV_WriteSnapshotToClient
+SV_SnapshotDeltaFrame
+
+Picks the previous frame the snapshot being created will be delta
+compressed against, returns NULL for a full snapshot
 ==================
 */
-static void SV_WriteSnapshotToClient( client_t *client, msg_t *msg ) {
-	clientSnapshot_t    *frame, *oldframe;
-	int lastframe;
-	int i;
-	int snapFlags;
-
-	// this is the snapshot we are creating
-	frame = &client->frames[ client->netchan.outgoingSequence & PACKET_MASK ];
+static clientSnapshot_t *SV_SnapshotDeltaFrame( client_t *client, int *lastframe ) {
+	clientSnapshot_t    *oldframe;
 
 	// try to use a previous frame as the source for delta compressing the snapshot
 	if ( client->deltaMessage <= 0 || client->state != CS_ACTIVE ) {
 		// client is asking for a retransmit
 		oldframe = NULL;
-		lastframe = 0;
+		*lastframe = 0;
 	} else if ( client->netchan.outgoingSequence - client->deltaMessage
 				>= ( PACKET_BACKUP - 3 ) ) {
 		// client hasn't gotten a good message through in a long time
 		Com_DPrintf( "%s: Delta request from out of date packet.\n", client->name );
 		oldframe = NULL;
-		lastframe = 0;
+		*lastframe = 0;
 	} else {
 		// we have a valid snapshot to delta from
 		oldframe = &client->frames[ client->deltaMessage & PACKET_MASK ];
-		lastframe = client->netchan.outgoingSequence - client->deltaMessage;
+		*lastframe = client->netchan.outgoingSequence - client->deltaMessage;
 
 		// the snapshot's entities may still have rolled off the buffer, though
 		if ( oldframe->first_entity <= svs.nextSnapshotEntities - svs.numSnapshotEntities ) {
 			Com_DPrintf( "%s: Delta request from out of date entities.\n", client->name );
 			oldframe = NULL;
-			lastframe = 0;
+			*lastframe = 0;
+		}
+	}
+
+	return oldframe;
+}
+
+/*
+==================
+SV_ClientRate
+
+Bytes per second the client may be sent
+==================
+*/
+static int SV_ClientRate( client_t *client ) {
+	int rate;
+	int maxRate;
+
+	rate = client->rate;
+	// work on the appropriate max rate (client or download)
+	if ( !*client->downloadName ) {
+		maxRate = sv_maxRate->integer;
+	} else
+	{
+		maxRate = sv_dl_maxRate->integer;
+	}
+	if ( maxRate ) {
+		if ( maxRate < rate ) {
+			rate = maxRate;
+		}
+	}
+
+	return rate;
+}
+
+/*
+=============================================================================
+
+SNAPSHOT BUDGET
+
+With sv_snapshotBudget set, a snapshot that would not fit into what the
+client's rate allows per snapshotMsec holds back the least important entity
+changes instead of being sent late.  A held entity is written with the state
+of the frame being delta'd from, which costs no bits at all and leaves the
+client exactly where it was, and the frame records that state so later
+snapshots send the real change.  Nothing is held more than
+sv_snapshotMaxHold snapshots in a row, and new entities, removals, events
+and the client's own entity always go out.
+
+Holding is only safe while no snapshot sent after the delta frame carried
+a newer state of the entity, otherwise a client that got that snapshot
+would see the entity jump back, so snapshotChanged remembers the last
+snapshot that sent each entity a change.  The higher the latency, the
+fewer snapshots there are in which a changing entity can wait.
+
+=============================================================================
+*/
+
+typedef struct {
+	entityState_t   *newent;
+	entityState_t   *oldent;
+	int bits;
+	float priority;
+} snapshotDelta_t;
+
+static int QDECL SV_QsortSnapshotDeltas( const void *a, const void *b ) {
+	const snapshotDelta_t *da, *db;
+
+	da = (const snapshotDelta_t *)a;
+	db = (const snapshotDelta_t *)b;
+
+	if ( da->priority > db->priority ) {
+		return -1;
+	}
+	if ( da->priority < db->priority ) {
+		return 1;
+	}
+	return da->newent->number - db->newent->number;
+}
+
+/*
+==================
+SV_SnapshotBudgetBits
+
+Returns 0 if the client isn't rate limited
+==================
+*/
+static int SV_SnapshotBudgetBits( client_t *client ) {
+	int bytes;
+
+	if ( *client->downloadName ) {
+		return 0;
+	}
+
+	// local and lan clients get every frame, see SV_SendMessageToClient
+	if ( client->netchan.remoteAddress.type == NA_LOOPBACK ||
+		 ( sv_lanForceRate->integer && Sys_IsLANAddress( client->netchan.remoteAddress ) ) ) {
+		return 0;
+	}
+
+	bytes = SV_ClientRate( client ) * client->snapshotMsec / 1000 - HEADER_RATE_BYTES;
+	if ( bytes < 1 ) {
+		bytes = 1;
+	}
+
+	return bytes * 8;
+}
+
+/*
+==================
+SV_BudgetSnapshotEntities
+
+Fits the entity deltas of frame into what is left of the client's
+per snapshot budget after usedBytes, holding back the rest
+==================
+*/
+static void SV_BudgetSnapshotEntities( client_t *client, clientSnapshot_t *oldframe,
+									   entityState_t *oldEntities, int numOldEntities,
+									   clientSnapshot_t *frame, entityState_t *entities, int numEntities,
+									   int usedBytes ) {
+	snapshotDelta_t deltas[MAX_SNAPSHOT_ENTITIES];
+	snapshotDelta_t *d;
+	entityState_t   *oldent, *newent;
+	int oldindex, newindex;
+	int oldnum, newnum;
+	int numDeltas, budget, i;
+	int maxHold, sequence;
+	vec3_t delta;
+	float weight;
+
+	budget = SV_SnapshotBudgetBits( client );
+	if ( !budget ) {
+		return;
+	}
+	// what is already in the message, and the end of entities marker
+	budget -= usedBytes * 8 + GENTITYNUM_BITS;
+
+	maxHold = sv_snapshotMaxHold->integer;
+	if ( maxHold < 1 ) {
+		return;
+	}
+
+	sequence = client->netchan.outgoingSequence;
+
+	// same walk as SV_EmitPacketEntities, charging everything that
+	// has to go out and collecting the changes that could wait
+	numDeltas = 0;
+	newindex = 0;
+	oldindex = 0;
+	while ( newindex < frame->num_entities || oldindex < oldframe->num_entities ) {
+		if ( newindex >= frame->num_entities ) {
+			newent = NULL;
+			newnum = 9999;
+		} else {
+			newent = &entities[( frame->first_entity + newindex ) % numEntities];
+			newnum = newent->number;
+		}
+
+		if ( oldindex >= oldframe->num_entities ) {
+			oldent = NULL;
+			oldnum = 9999;
+		} else {
+			oldent = &oldEntities[( oldframe->first_entity + oldindex ) % numOldEntities];
+			oldnum = oldent->number;
+		}
+
+		if ( newnum < oldnum ) {
+			// entering, sent from the baseline
+			client->snapshotHeld[newnum] = 0;
+			client->snapshotChanged[newnum] = sequence;
+			budget -= MSG_DeltaEntityBits( &sv.svEntities[newnum].baseline, newent ) + GENTITYNUM_BITS + 2;
+			newindex++;
+			continue;
+		}
+
+		if ( newnum > oldnum ) {
+			// leaving
+			budget -= GENTITYNUM_BITS + 1;
+			oldindex++;
+			continue;
+		}
+
+		oldindex++;
+		newindex++;
+
+		i = MSG_DeltaEntityBits( oldent, newent );
+		if ( !i ) {
+			client->snapshotHeld[newnum] = 0;
+			continue;
+		}
+
+		if ( client->snapshotHeld[newnum] >= maxHold
+			 || client->snapshotChanged[newnum] > client->deltaMessage
+			 || newent->event != oldent->event
+			 || newnum == frame->ps.clientNum ) {
+			client->snapshotHeld[newnum] = 0;
+			client->snapshotChanged[newnum] = sequence;
+			budget -= i;
+			continue;
+		}
+
+		d = &deltas[numDeltas++];
+		d->newent = newent;
+		d->oldent = oldent;
+		d->bits = i;
+
+		// closer is more important, players more so than everything else,
+		// and anything held back last time catches up
+		VectorSubtract( newent->pos.trBase, frame->ps.origin, delta );
+		weight = newnum < sv_maxclients->integer ? 4.0f : 1.0f;
+		d->priority = weight * ( 1 + client->snapshotHeld[newnum] ) / ( 64.0f + VectorLength( delta ) );
+	}
+
+	if ( !numDeltas ) {
+		return;
+	}
+
+	qsort( deltas, numDeltas, sizeof( deltas[0] ), SV_QsortSnapshotDeltas );
+
+	for ( i = 0, d = deltas ; i < numDeltas ; i++, d++ ) {
+		if ( d->bits <= budget ) {
+			budget -= d->bits;
+			client->snapshotHeld[d->newent->number] = 0;
+			client->snapshotChanged[d->newent->number] = sequence;
+			continue;
 		}
+
+		// keep the state the client already has, the real one goes out later
+		*d->newent = *d->oldent;
+		client->snapshotHeld[d->newent->number]++;
 	}
+}
+
+/*
+==================
+SV_WriteSnapshotFrom
+
+Doesn't touch any shared server state, so it can run on a worker thread
+==================
+*/
+static void SV_WriteSnapshotFrom( client_t *client, clientSnapshot_t *oldframe, int lastframe,
+								  entityState_t *oldEntities, int numOldEntities,
+								  clientSnapshot_t *frame, entityState_t *entities, int numEntities, msg_t *msg ) {
+	int i;
+	int snapFlags;
 
 	MSG_WriteByte( msg, svc_snapshot );
 
@@ -201,7 +448,11 @@ static void SV_WriteSnapshotToClient( client_t *client, msg_t *msg ) {
 	}
 
 	// delta encode the entities
-	SV_EmitPacketEntities( oldframe, frame, msg );
+	if ( oldframe && sv_snapshotBudget->integer ) {
+		SV_BudgetSnapshotEntities( client, oldframe, oldEntities, numOldEntities,
+								   frame, entities, numEntities, msg->cursize );
+	}
+	SV_EmitPacketEntities( oldframe, oldEntities, numOldEntities, frame, entities, numEntities, msg );
 
 	// padding for rate debugging
 	if ( sv_padPackets->integer ) {
@@ -211,6 +462,21 @@ static void SV_WriteSnapshotToClient( client_t *client, msg_t *msg ) {
 	}
 }
 
+/*
+==================
+SV_WriteSnapshotToClient
+==================
+*/
+static void SV_WriteSnapshotToClient( client_t *client, msg_t *msg ) {
+	clientSnapshot_t    *oldframe;
+	int lastframe;
+
+	oldframe = SV_SnapshotDeltaFrame( client, &lastframe );
+	SV_WriteSnapshotFrom( client, oldframe, lastframe, svs.snapshotEntities, svs.numSnapshotEntities,
+						  &client->frames[ client->netchan.outgoingSequence & PACKET_MASK ],
+						  svs.snapshotEntities, svs.numSnapshotEntities, msg );
+}
+
 
 /*
 ==================
@@ -239,14 +505,18 @@ Build a client snapshot structure
 =============================================================================
 */
 
-//#define	MAX_SNAPSHOT_ENTITIES	1024
-#define MAX_SNAPSHOT_ENTITIES   2048
-
 typedef struct {
 	int numSnapshotEntities;
 	int snapshotEntities[MAX_SNAPSHOT_ENTITIES];
+	byte added[MAX_GENTITIES / 8];              // used to prevent double adding from portal views
+	// worker threads can't call into the game, so entities with a
+	// snapshotCallback are flagged here and filtered on the main thread
+	qboolean deferCallbacks;
+	byte callbacks[MAX_GENTITIES / 8];
 } snapshotEntityNumbers_t;
 
+#define SNAPSHOT_ENT_ADDED( eNums, num )  ( ( eNums )->added[( num ) >> 3] & ( 1 << ( ( num ) & 7 ) ) )
+
 /*
 =======================
 SV_QsortEntityNumbers
@@ -276,11 +546,13 @@ SV_AddEntToSnapshot
 ===============
 */
 static void SV_AddEntToSnapshot( sharedEntity_t* clientEnt, svEntity_t *svEnt, sharedEntity_t *gEnt, snapshotEntityNumbers_t *eNums ) {
+	int num = gEnt->s.number;
+
 	// if we have already added this entity to this snapshot, don't add again
-	if ( svEnt->snapshotCounter == sv.snapshotCounter ) {
+	if ( SNAPSHOT_ENT_ADDED( eNums, num ) ) {
 		return;
 	}
-	svEnt->snapshotCounter = sv.snapshotCounter;
+	eNums->added[num >> 3] |= 1 << ( num & 7 );
 
 	// if we are full, silently discard entities
 	if ( eNums->numSnapshotEntities == MAX_SNAPSHOT_ENTITIES ) {
@@ -288,7 +560,9 @@ static void SV_AddEntToSnapshot( sharedEntity_t* clientEnt, svEntity_t *svEnt, s
 	}
 
 	if ( gEnt->r.snapshotCallback ) {
-		if ( !(qboolean)VM_Call( gvm, GAME_SNAPSHOT_CALLBACK, gEnt->s.number, clientEnt->s.number ) ) {
+		if ( eNums->deferCallbacks ) {
+			eNums->callbacks[num >> 3] |= 1 << ( num & 7 );
+		} else if ( !(qboolean)VM_Call( gvm, GAME_SNAPSHOT_CALLBACK, num, clientEnt->s.number ) ) {
 			return;
 		}
 	}
@@ -297,47 +571,76 @@ static void SV_AddEntToSnapshot( sharedEntity_t* clientEnt, svEntity_t *svEnt, s
 	eNums->numSnapshotEntities++;
 }
 
+/*
+=============================================================================
+
+Per frame visibility cache
+
+Which entities pass the pvs and area checks only depends on the cluster and
+area of the viewpoint, so clients standing in the same place share a single
+walk over all the entities.  The per client filters (single client flags,
+portals, visibility dummies, snapshot callbacks) are applied on top of it.
+
+=============================================================================
+*/
+
+#define MAX_SNAPSHOT_VIS_CACHE  ( MAX_CLIENTS * 2 )     // power of two
+
+typedef struct {
+	int cluster, area;
+	int generation;
+	byte visible[MAX_GENTITIES / 8];
+} snapshotVisCache_t;
+
+static snapshotVisCache_t sv_snapshotVisCache[MAX_SNAPSHOT_VIS_CACHE];
+static int sv_snapshotVisGeneration;
+static qboolean sv_snapshotVisCacheActive;
+
 /*
 ===============
-SV_AddEntitiesVisibleFromPoint
+SV_BeginSnapshotVisCache
+
+Entities don't move or change flags until SV_EndSnapshotVisCache,
+so the cache can be filled and used in between
 ===============
 */
-static void SV_AddEntitiesVisibleFromPoint( vec3_t origin, clientSnapshot_t *frame,
-//									snapshotEntityNumbers_t *eNums, qboolean portal, clientSnapshot_t *oldframe, qboolean localClient ) {
-//									snapshotEntityNumbers_t *eNums, qboolean portal ) {
-											snapshotEntityNumbers_t *eNums /*, qboolean portal, qboolean localClient*/  ) {
-	int e, i;
-	sharedEntity_t *ent, *playerEnt;
-	svEntity_t  *svEnt;
-	int l;
-	int clientarea, clientcluster;
-	int leafnum;
-	int c_fullsend;
-	byte    *clientpvs;
-	byte    *bitvector;
+static void SV_BeginSnapshotVisCache( void ) {
+	sv_snapshotVisGeneration++;
+	sv_snapshotVisCacheActive = qtrue;
+}
 
-	// during an error shutdown message we may need to transmit
-	// the shutdown message after the server has shutdown, so
-	// specfically check for it
-	if ( !sv.state ) {
-		return;
-	}
+static void SV_EndSnapshotVisCache( void ) {
+	sv_snapshotVisCacheActive = qfalse;
+}
 
-	leafnum = CM_PointLeafnum( origin );
-	clientarea = CM_LeafArea( leafnum );
-	clientcluster = CM_LeafCluster( leafnum );
+/*
+===============
+SV_InvalidateSnapshotVisCache
 
-	// calculate the visible areas
-	frame->areabytes = CM_WriteAreaBits( frame->areabits, clientarea );
+The game has run (a client was dropped), so everything cached may be stale
+===============
+*/
+static void SV_InvalidateSnapshotVisCache( void ) {
+	sv_snapshotVisGeneration++;
+}
+
+/*
+===============
+SV_ComputeVisibleEntities
 
-	clientpvs = CM_ClusterPVS( clientcluster );
+Sets the bits of all the entities that can possibly be seen from cluster / area
+===============
+*/
+static void SV_ComputeVisibleEntities( int cluster, int area, byte *visible ) {
+	int e, i;
+	sharedEntity_t *ent;
+	svEntity_t  *svEnt;
+	int l;
+	byte    *bitvector;
 
-	c_fullsend = 0;
+	memset( visible, 0, MAX_GENTITIES / 8 );
 
-	playerEnt = SV_GentityNum( frame->ps.clientNum );
-	if ( playerEnt->r.svFlags & SVF_SELF_PORTAL ) {
-		SV_AddEntitiesVisibleFromPoint( playerEnt->s.origin2, frame, eNums );
-	}
+	bitvector = CM_ClusterPVS( cluster );
 
 	for ( e = 0 ; e < sv.num_entities ; e++ ) {
 		ent = SV_GentityNum( e );
@@ -357,48 +660,28 @@ static void SV_AddEntitiesVisibleFromPoint( vec3_t origin, clientSnapshot_t *fra
 			continue;
 		}
 
-		// entities can be flagged to be sent to only one client
-		if ( ent->r.svFlags & SVF_SINGLECLIENT ) {
-			if ( ent->r.singleClient != frame->ps.clientNum ) {
-				continue;
-			}
-		}
-		// entities can be flagged to be sent to everyone but one client
-		if ( ent->r.svFlags & SVF_NOTSINGLECLIENT ) {
-			if ( ent->r.singleClient == frame->ps.clientNum ) {
-				continue;
-			}
-		}
-
 		svEnt = SV_SvEntityForGentity( ent );
 
-		// don't double add an entity through portals
-		if ( svEnt->snapshotCounter == sv.snapshotCounter ) {
-			continue;
-		}
-
 		// broadcast entities are always sent
 		if ( ent->r.svFlags & SVF_BROADCAST ) {
-			SV_AddEntToSnapshot( playerEnt, svEnt, ent, eNums );
+			visible[e >> 3] |= 1 << ( e & 7 );
 			continue;
 		}
 
-		bitvector = clientpvs;
-
 		// Gordon: just check origin for being in pvs, ignore bmodel extents
 		if ( ent->r.svFlags & SVF_IGNOREBMODELEXTENTS ) {
 			if ( bitvector[svEnt->originCluster >> 3] & ( 1 << ( svEnt->originCluster & 7 ) ) ) {
-				SV_AddEntToSnapshot( playerEnt, svEnt, ent, eNums );
+				visible[e >> 3] |= 1 << ( e & 7 );
 			}
 			continue;
 		}
 
 		// ignore if not touching a PV leaf
 		// check area
-		if ( !CM_AreasConnected( clientarea, svEnt->areanum ) ) {
+		if ( !CM_AreasConnected( area, svEnt->areanum ) ) {
 			// doors can legally straddle two areas, so
 			// we may need to check another one
-			if ( !CM_AreasConnected( clientarea, svEnt->areanum2 ) ) {
+			if ( !CM_AreasConnected( area, svEnt->areanum2 ) ) {
 				continue;
 			}
 		}
@@ -432,33 +715,156 @@ static void SV_AddEntitiesVisibleFromPoint( vec3_t origin, clientSnapshot_t *fra
 			}
 		}
 
-		//----(SA) added "visibility dummies"
-		if ( ent->r.svFlags & SVF_VISDUMMY ) {
-			sharedEntity_t *ment = 0;
+		visible[e >> 3] |= 1 << ( e & 7 );
+	}
+}
 
-			//find master;
-			ment = SV_GentityNum( ent->s.otherEntityNum );
+/*
+===============
+SV_SnapshotVisibleEntities
 
-			if ( ment ) {
-				svEntity_t *master = 0;
-				master = SV_SvEntityForGentity( ment );
+Returns the cached visible set for cluster / area, filling the cache when
+allowed.  Worker threads only read the cache, anything they miss (portal
+views) is computed into scratch.
+===============
+*/
+static byte *SV_SnapshotVisibleEntities( int cluster, int area, byte *scratch, qboolean fill ) {
+	snapshotVisCache_t  *cache;
+	int i, hash;
 
-				if ( master->snapshotCounter == sv.snapshotCounter || !ment->r.linked ) {
-					continue;
-				}
+	if ( !sv_snapshotVisCacheActive ) {
+		SV_ComputeVisibleEntities( cluster, area, scratch );
+		return scratch;
+	}
 
-				SV_AddEntToSnapshot( playerEnt, master, ment, eNums );
-			}
-			continue;   // master needs to be added, but not this dummy ent
+	hash = ( cluster * 31 + area ) & ( MAX_SNAPSHOT_VIS_CACHE - 1 );
+	for ( i = 0 ; i < MAX_SNAPSHOT_VIS_CACHE ; i++ ) {
+		cache = &sv_snapshotVisCache[( hash + i ) & ( MAX_SNAPSHOT_VIS_CACHE - 1 )];
+		if ( cache->generation != sv_snapshotVisGeneration ) {
+			break;      // free slot, the key isn't cached
 		}
-		//----(SA) end
-		else if ( ent->r.svFlags & SVF_VISDUMMY_MULTIPLE ) {
-			{
-				int h;
-				sharedEntity_t *ment = 0;
-				svEntity_t *master = 0;
+		if ( cache->cluster == cluster && cache->area == area ) {
+			return cache->visible;
+		}
+	}
 
-				for ( h = 0; h < sv.num_entities; h++ )
+	if ( !fill || i == MAX_SNAPSHOT_VIS_CACHE ) {
+		SV_ComputeVisibleEntities( cluster, area, scratch );
+		return scratch;
+	}
+
+	cache->cluster = cluster;
+	cache->area = area;
+	SV_ComputeVisibleEntities( cluster, area, cache->visible );
+	cache->generation = sv_snapshotVisGeneration;
+
+	return cache->visible;
+}
+
+/*
+===============
+SV_AddEntitiesVisibleFromPoint
+===============
+*/
+static void SV_AddEntitiesVisibleFromPoint( vec3_t origin, clientSnapshot_t *frame,
+//									snapshotEntityNumbers_t *eNums, qboolean portal, clientSnapshot_t *oldframe, qboolean localClient ) {
+//									snapshotEntityNumbers_t *eNums, qboolean portal ) {
+											snapshotEntityNumbers_t *eNums /*, qboolean portal, qboolean localClient*/  ) {
+	int e;
+	sharedEntity_t *ent, *playerEnt;
+	svEntity_t  *svEnt;
+	int clientarea, clientcluster;
+	int leafnum;
+	byte    *visible;
+	byte scratch[MAX_GENTITIES / 8];
+
+	// during an error shutdown message we may need to transmit
+	// the shutdown message after the server has shutdown, so
+	// specfically check for it
+	if ( !sv.state ) {
+		return;
+	}
+
+	leafnum = CM_PointLeafnum( origin );
+	clientarea = CM_LeafArea( leafnum );
+	clientcluster = CM_LeafCluster( leafnum );
+
+	// calculate the visible areas
+	frame->areabytes = CM_WriteAreaBits( frame->areabits, clientarea );
+
+	playerEnt = SV_GentityNum( frame->ps.clientNum );
+	if ( playerEnt->r.svFlags & SVF_SELF_PORTAL ) {
+		SV_AddEntitiesVisibleFromPoint( playerEnt->s.origin2, frame, eNums );
+	}
+
+	visible = SV_SnapshotVisibleEntities( clientcluster, clientarea, scratch, !eNums->deferCallbacks );
+
+	for ( e = 0 ; e < sv.num_entities ; e++ ) {
+		// skip quickly over runs of entities that can't be seen from here
+		if ( !visible[e >> 3] ) {
+			e |= 7;
+			continue;
+		}
+		if ( !( visible[e >> 3] & ( 1 << ( e & 7 ) ) ) ) {
+			continue;
+		}
+
+		ent = SV_GentityNum( e );
+
+		// entities can be flagged to be sent to only one client
+		if ( ent->r.svFlags & SVF_SINGLECLIENT ) {
+			if ( ent->r.singleClient != frame->ps.clientNum ) {
+				continue;
+			}
+		}
+		// entities can be flagged to be sent to everyone but one client
+		if ( ent->r.svFlags & SVF_NOTSINGLECLIENT ) {
+			if ( ent->r.singleClient == frame->ps.clientNum ) {
+				continue;
+			}
+		}
+
+		svEnt = SV_SvEntityForGentity( ent );
+
+		// don't double add an entity through portals
+		if ( SNAPSHOT_ENT_ADDED( eNums, e ) ) {
+			continue;
+		}
+
+		// broadcast entities are always sent, and origin only
+		// entities have had all their checks done by the pvs pass
+		if ( ent->r.svFlags & ( SVF_BROADCAST | SVF_IGNOREBMODELEXTENTS ) ) {
+			SV_AddEntToSnapshot( playerEnt, svEnt, ent, eNums );
+			continue;
+		}
+
+		//----(SA) added "visibility dummies"
+		if ( ent->r.svFlags & SVF_VISDUMMY ) {
+			sharedEntity_t *ment = 0;
+
+			//find master;
+			ment = SV_GentityNum( ent->s.otherEntityNum );
+
+			if ( ment ) {
+				svEntity_t *master = 0;
+				master = SV_SvEntityForGentity( ment );
+
+				if ( SNAPSHOT_ENT_ADDED( eNums, ment->s.number ) || !ment->r.linked ) {
+					continue;
+				}
+
+				SV_AddEntToSnapshot( playerEnt, master, ment, eNums );
+			}
+			continue;   // master needs to be added, but not this dummy ent
+		}
+		//----(SA) end
+		else if ( ent->r.svFlags & SVF_VISDUMMY_MULTIPLE ) {
+			{
+				int h;
+				sharedEntity_t *ment = 0;
+				svEntity_t *master = 0;
+
+				for ( h = 0; h < sv.num_entities; h++ )
 				{
 					ment = SV_GentityNum( h );
 
@@ -485,7 +891,7 @@ static void SV_AddEntitiesVisibleFromPoint( vec3_t origin, clientSnapshot_t *fra
 						continue;
 					}
 
-					if ( master->snapshotCounter == sv.snapshotCounter ) {
+					if ( SNAPSHOT_ENT_ADDED( eNums, h ) ) {
 						continue;
 					}
 
@@ -512,38 +918,26 @@ static void SV_AddEntitiesVisibleFromPoint( vec3_t origin, clientSnapshot_t *fra
 
 /*
 =============
-SV_BuildClientSnapshot
-
-Decides which entities are going to be visible to the client, and
-copies off the playerstate and areabits.
+SV_BeginClientSnapshot
 
-This properly handles multiple recursive portals, but the render
-currently doesn't.
-
-For viewing through other player's eyes, clent can be something other than client->gentity
+Clears the frame being created and copies off the playerstate.
+Returns qfalse if the client has no entity to build a snapshot for,
+otherwise org is set to the client's viewpoint.
 =============
 */
-static void SV_BuildClientSnapshot( client_t *client ) {
-	vec3_t org;
-//	clientSnapshot_t			*frame, *oldframe;
+static qboolean SV_BeginClientSnapshot( client_t *client, snapshotEntityNumbers_t *eNums, vec3_t org ) {
 	clientSnapshot_t            *frame;
-	snapshotEntityNumbers_t entityNumbers;
-	int i;
-	sharedEntity_t              *ent;
-	entityState_t               *state;
-	svEntity_t                  *svEnt;
 	sharedEntity_t              *clent;
 	int clientNum;
 	playerState_t               *ps;
 
-	// bump the counter used to prevent double adding
-	sv.snapshotCounter++;
-
 	// this is the frame we are creating
 	frame = &client->frames[ client->netchan.outgoingSequence & PACKET_MASK ];
 
 	// clear everything in this snapshot
-	entityNumbers.numSnapshotEntities = 0;
+	eNums->numSnapshotEntities = 0;
+	memset( eNums->added, 0, sizeof( eNums->added ) );
+	memset( eNums->callbacks, 0, sizeof( eNums->callbacks ) );
 	memset( frame->areabits, 0, sizeof( frame->areabits ) );
 
 	// show_bug.cgi?id=62
@@ -551,7 +945,7 @@ static void SV_BuildClientSnapshot( client_t *client ) {
 
 	clent = client->gentity;
 	if ( !clent || client->state == CS_ZOMBIE ) {
-		return;
+		return qfalse;
 	}
 
 	// grab the current playerState_t
@@ -564,9 +958,7 @@ static void SV_BuildClientSnapshot( client_t *client ) {
 	if ( clientNum < 0 || clientNum >= MAX_GENTITIES ) {
 		Com_Error( ERR_DROP, "SV_SvEntityForGentity: bad gEnt" );
 	}
-	svEnt = &sv.svEntities[ clientNum ];
-
-	svEnt->snapshotCounter = sv.snapshotCounter;
+	eNums->added[clientNum >> 3] |= 1 << ( clientNum & 7 );
 
 	if ( clent->r.svFlags & SVF_SELF_PORTAL_EXCLUSIVE ) {
 		// find the client's viewpoint
@@ -587,37 +979,121 @@ static void SV_BuildClientSnapshot( client_t *client ) {
 	}
 //----(SA)	end
 
+	return qtrue;
+}
+
+/*
+=============
+SV_GatherClientSnapshot
+
+Safe to run on a worker thread when eNums->deferCallbacks is set
+=============
+*/
+static void SV_GatherClientSnapshot( clientSnapshot_t *frame, snapshotEntityNumbers_t *eNums, vec3_t org ) {
+	int i;
+
 	// add all the entities directly visible to the eye, which
 	// may include portal entities that merge other viewpoints
-	SV_AddEntitiesVisibleFromPoint( org, frame, &entityNumbers /*, qfalse, client->netchan.remoteAddress.type == NA_LOOPBACK*/ );
-
-	// if there were portals visible, there may be out of order entities
-	// in the list which will need to be resorted for the delta compression
-	// to work correctly.  This also catches the error condition
-	// of an entity being included twice.
-	qsort( entityNumbers.snapshotEntities, entityNumbers.numSnapshotEntities,
-		   sizeof( entityNumbers.snapshotEntities[0] ), SV_QsortEntityNumbers );
+	SV_AddEntitiesVisibleFromPoint( org, frame, eNums /*, qfalse, client->netchan.remoteAddress.type == NA_LOOPBACK*/ );
 
 	// now that all viewpoint's areabits have been OR'd together, invert
 	// all of them to make it a mask vector, which is what the renderer wants
 	for ( i = 0 ; i < MAX_MAP_AREA_BYTES / 4 ; i++ ) {
 		( (int *)frame->areabits )[i] = ( (int *)frame->areabits )[i] ^ -1;
 	}
+}
 
-	// copy the entity states out
-	frame->num_entities = 0;
-	frame->first_entity = svs.nextSnapshotEntities;
-	for ( i = 0 ; i < entityNumbers.numSnapshotEntities ; i++ ) {
-		ent = SV_GentityNum( entityNumbers.snapshotEntities[i] );
-		state = &svs.snapshotEntities[svs.nextSnapshotEntities % svs.numSnapshotEntities];
-		*state = ent->s;
-		svs.nextSnapshotEntities++;
-		// this should never hit, map should always be restarted first in SV_Frame
-		if ( svs.nextSnapshotEntities >= 0x7FFFFFFE ) {
-			Com_Error( ERR_FATAL, "svs.nextSnapshotEntities wrapped" );
+/*
+=============
+SV_RunSnapshotCallbacks
+
+Asks the game about the entities flagged while gathering with deferCallbacks,
+in the same order they would have been asked while gathering
+=============
+*/
+static void SV_RunSnapshotCallbacks( clientSnapshot_t *frame, snapshotEntityNumbers_t *eNums ) {
+	int i, num, count;
+
+	count = 0;
+	for ( i = 0 ; i < eNums->numSnapshotEntities ; i++ ) {
+		num = eNums->snapshotEntities[i];
+		if ( eNums->callbacks[num >> 3] & ( 1 << ( num & 7 ) ) ) {
+			if ( !(qboolean)VM_Call( gvm, GAME_SNAPSHOT_CALLBACK, num, frame->ps.clientNum ) ) {
+				continue;
+			}
 		}
-		frame->num_entities++;
+		eNums->snapshotEntities[count++] = num;
+	}
+	eNums->numSnapshotEntities = count;
+}
+
+/*
+=============
+SV_AllocSnapshotEntities
+
+Sorts the entity list and reserves its slots in svs.snapshotEntities
+=============
+*/
+static void SV_AllocSnapshotEntities( clientSnapshot_t *frame, snapshotEntityNumbers_t *eNums ) {
+	// if there were portals visible, there may be out of order entities
+	// in the list which will need to be resorted for the delta compression
+	// to work correctly.  This also catches the error condition
+	// of an entity being included twice.
+	qsort( eNums->snapshotEntities, eNums->numSnapshotEntities,
+		   sizeof( eNums->snapshotEntities[0] ), SV_QsortEntityNumbers );
+
+	frame->num_entities = eNums->numSnapshotEntities;
+	frame->first_entity = svs.nextSnapshotEntities;
+	svs.nextSnapshotEntities += eNums->numSnapshotEntities;
+	// this should never hit, map should always be restarted first in SV_Frame
+	if ( svs.nextSnapshotEntities >= 0x7FFFFFFE ) {
+		Com_Error( ERR_FATAL, "svs.nextSnapshotEntities wrapped" );
+	}
+}
+
+/*
+=============
+SV_CopySnapshotEntities
+=============
+*/
+static void SV_CopySnapshotEntities( clientSnapshot_t *frame, snapshotEntityNumbers_t *eNums ) {
+	int i;
+
+	for ( i = 0 ; i < eNums->numSnapshotEntities ; i++ ) {
+		svs.snapshotEntities[( frame->first_entity + i ) % svs.numSnapshotEntities] = SV_GentityNum( eNums->snapshotEntities[i] )->s;
+	}
+}
+
+/*
+=============
+SV_BuildClientSnapshot
+
+Decides which entities are going to be visible to the client, and
+copies off the playerstate and areabits.
+
+This properly handles multiple recursive portals, but the render
+currently doesn't.
+
+For viewing through other player's eyes, clent can be something other than client->gentity
+=============
+*/
+static void SV_BuildClientSnapshot( client_t *client ) {
+	vec3_t org;
+	clientSnapshot_t            *frame;
+	snapshotEntityNumbers_t entityNumbers;
+
+	frame = &client->frames[ client->netchan.outgoingSequence & PACKET_MASK ];
+
+	if ( !SV_BeginClientSnapshot( client, &entityNumbers, org ) ) {
+		return;
 	}
+
+	entityNumbers.deferCallbacks = qfalse;
+	SV_GatherClientSnapshot( frame, &entityNumbers, org );
+
+	// copy the entity states out
+	SV_AllocSnapshotEntities( frame, &entityNumbers );
+	SV_CopySnapshotEntities( frame, &entityNumbers );
 }
 
 
@@ -630,11 +1106,9 @@ to take to clear, based on the current rate
 TTimo - use sv_maxRate or sv_dl_maxRate depending on regular or downloading client
 ====================
 */
-#define HEADER_RATE_BYTES   48      // include our header, IP header, and some overhead
 static int SV_RateMsec( client_t *client, int messageSize ) {
 	int rate;
 	int rateMsec;
-	int maxRate;
 
 	// individual messages will never be larger than fragment size
 	if ( messageSize > 1500 ) {
@@ -644,19 +1118,7 @@ static int SV_RateMsec( client_t *client, int messageSize ) {
 	if ( sv_maxRate->integer && sv_maxRate->integer < 1000 ) {
 		Cvar_Set( "sv_MaxRate", "1000" );
 	}
-	rate = client->rate;
-	// work on the appropriate max rate (client or download)
-	if ( !*client->downloadName ) {
-		maxRate = sv_maxRate->integer;
-	} else
-	{
-		maxRate = sv_dl_maxRate->integer;
-	}
-	if ( maxRate ) {
-		if ( maxRate < rate ) {
-			rate = maxRate;
-		}
-	}
+	rate = SV_ClientRate( client );
 	rateMsec = ( messageSize + HEADER_RATE_BYTES ) * 1000 / rate;
 
 	return rateMsec;
@@ -755,6 +1217,7 @@ void SV_SendClientIdle( client_t *client ) {
 		MSG_Clear( &msg );
 
 		SV_DropClient( client, "Msg overflowed" );
+		SV_InvalidateSnapshotVisCache();
 		return;
 	}
 
@@ -764,6 +1227,33 @@ void SV_SendClientIdle( client_t *client ) {
 	sv.ubpsTotalBytes += msg.uncompsize / 8;    // NERVE - SMF - net debugging
 }
 
+/*
+=======================
+SV_SendSnapshotMessage
+
+Adds any download data to a snapshot message and sends it
+=======================
+*/
+static void SV_SendSnapshotMessage( client_t *client, msg_t *msg ) {
+	// Add any download data if the client is downloading
+	SV_WriteDownloadToClient( client, msg );
+
+	// check for overflow
+	if ( msg->overflowed ) {
+		Com_Printf( "WARNING: msg overflowed for %s\n", client->name );
+		MSG_Clear( msg );
+
+		SV_DropClient( client, "Msg overflowed" );
+		SV_InvalidateSnapshotVisCache();
+		return;
+	}
+
+	SV_SendMessageToClient( msg, client );
+
+	sv.bpsTotalBytes += msg->cursize;           // NERVE - SMF - net debugging
+	sv.ubpsTotalBytes += msg->uncompsize / 8;   // NERVE - SMF - net debugging
+}
+
 /*
 =======================
 SV_SendClientSnapshot
@@ -775,6 +1265,7 @@ Also called by SV_FinalCommand
 void SV_SendClientSnapshot( client_t *client ) {
 	byte msg_buf[MAX_MSGLEN];
 	msg_t msg;
+	int perfStart;
 
 	//bani
 	if ( client->state < CS_ACTIVE ) {
@@ -787,7 +1278,9 @@ void SV_SendClientSnapshot( client_t *client ) {
 	}
 
 	// build the snapshot
+	perfStart = Perf_Begin();
 	SV_BuildClientSnapshot( client );
+	Perf_End( PERF_BUILD_SNAPSHOT, perfStart );
 
 	// bots need to have their snapshots build, but
 	// the query them directly without needing to be sent
@@ -809,77 +1302,527 @@ void SV_SendClientSnapshot( client_t *client ) {
 	// and the playerState_t
 	SV_WriteSnapshotToClient( client, &msg );
 
-	// Add any download data if the client is downloading
-	SV_WriteDownloadToClient( client, &msg );
+	SV_SendSnapshotMessage( client, &msg );
+}
 
-	// check for overflow
-	if ( msg.overflowed ) {
-		Com_Printf( "WARNING: msg overflowed for %s\n", client->name );
-		MSG_Clear( &msg );
 
-		SV_DropClient( client, "Msg overflowed" );
+/*
+=============================================================================
+
+Parallel snapshots
+
+With sv_snapshotWorkers set, the snapshots of all clients due this frame are
+gathered, delta encoded and Huffman compressed on worker threads.  Everything
+that calls into the game, fills svs.snapshotEntities or touches the network
+stays on the main thread and runs in client order, so the packets are the
+same ones SV_SendClientSnapshot would have sent.
+
+The workers encode every new frame from a private copy of its entities,
+which only goes into svs.snapshotEntities when the message is sent.  So when
+sending drops a client, and the game changes under the snapshots already
+built for the clients after it, those can be thrown away and the rest of
+the frame is sent the serial way from where the ring was.
+
+=============================================================================
+*/
+
+/*
+=======================
+SV_ClientNeedsMessage
+=======================
+*/
+static qboolean SV_ClientNeedsMessage( client_t *c ) {
+	// rain - changed <= CS_ZOMBIE to < CS_ZOMBIE so that the
+	// disconnect reason is properly sent in the network stream
+	if ( c->state < CS_ZOMBIE ) {
+		return qfalse;      // not connected
+	}
+
+	// RF, needed to insert this otherwise bots would cause error drops in sv_net_chan.c:
+	// --> "netchan queue is not properly initialized in SV_Netchan_TransmitNextFragment\n"
+	if ( c->gentity && c->gentity->r.svFlags & SVF_BOT ) {
+		return qfalse;
+	}
+
+	if ( svs.time < c->nextSnapshotTime ) {
+		return qfalse;      // not time yet
+	}
+
+	return qtrue;
+}
+
+/*
+=======================
+SV_SendClientMessage
+
+Returns qfalse if the client wasn't due a message
+=======================
+*/
+static qboolean SV_SendClientMessage( client_t *c ) {
+	if ( !SV_ClientNeedsMessage( c ) ) {
+		return qfalse;
+	}
+
+	// send additional message fragments if the last message
+	// was too large to send at once
+	if ( c->netchan.unsentFragments ) {
+		c->nextSnapshotTime = svs.time +
+							  SV_RateMsec( c, c->netchan.unsentLength - c->netchan.unsentFragmentStart );
+		SV_Netchan_TransmitNextFragment( c );
+		return qtrue;
+	}
+
+	// generate and send a new message
+	SV_SendClientSnapshot( c );
+	return qtrue;
+}
+
+typedef enum {
+	SJ_FRAGMENT,                            // send the next fragment of the last message
+	SJ_IDLE,                                // client is loading, see SV_SendClientIdle
+	SJ_EMPTY,                               // zombie without an entity, nothing to gather
+	SJ_SNAPSHOT
+} snapshotJobType_t;
+
+typedef struct {
+	client_t                *client;
+	snapshotJobType_t type;
+	vec3_t org;
+	snapshotEntityNumbers_t entityNumbers;
+
+	clientSnapshot_t        *oldframe;
+	int lastframe;
+	int ringEnd;                            // svs.nextSnapshotEntities once this client's entities are allocated
+
+	// the frame being created, its first_entity indexes entities
+	// until they are stored in svs.snapshotEntities
+	clientSnapshot_t frame;
+	int firstStaged;
+	entityState_t           *entities;
+
+	// sv_snapshotBudget state of the frame's entities before encoding
+	byte held[MAX_SNAPSHOT_ENTITIES];
+	int changed[MAX_SNAPSHOT_ENTITIES];
+
+	msg_t msg;
+	byte msgBuf[MAX_MSGLEN];
+} snapshotJob_t;
+
+static snapshotJob_t    *sv_snapshotJobs;
+static int sv_numSnapshotWorkers;
+
+static entityState_t    *sv_snapshotStaged;
+static int sv_numSnapshotStaged;
+
+/*
+=======================
+SV_ShutdownSnapshotWorkers
+=======================
+*/
+void SV_ShutdownSnapshotWorkers( void ) {
+	if ( sv_numSnapshotWorkers ) {
+		Sys_StopWorkers();
+		sv_numSnapshotWorkers = 0;
+	}
+	if ( sv_snapshotJobs ) {
+		free( sv_snapshotJobs );
+		sv_snapshotJobs = NULL;
+	}
+	if ( sv_snapshotStaged ) {
+		free( sv_snapshotStaged );
+		sv_snapshotStaged = NULL;
+		sv_numSnapshotStaged = 0;
+	}
+
+	// start them again with the next server
+	if ( sv_snapshotWorkers ) {
+		sv_snapshotWorkers->modified = qtrue;
+	}
+}
+
+/*
+=======================
+SV_RunWorkerJobs
+
+Lets other server code run a batch of jobs on the snapshot worker
+threads, such as the bot library precomputing its route cache.  If
+they aren't running a pool of numThreads, counting the calling
+thread, is started for the batch only.
+=======================
+*/
+void SV_RunWorkerJobs( workerFunc_t func, void *data, int count, int numThreads ) {
+	int started;
+
+	if ( sv_numSnapshotWorkers ) {
+		Sys_RunWorkers( func, data, count );
 		return;
 	}
 
-	SV_SendMessageToClient( &msg, client );
+	started = Sys_StartWorkers( numThreads - 1 );
+	Sys_RunWorkers( func, data, count );
+	if ( started ) {
+		Sys_StopWorkers();
+	}
+}
 
-	sv.bpsTotalBytes += msg.cursize;            // NERVE - SMF - net debugging
-	sv.ubpsTotalBytes += msg.uncompsize / 8;    // NERVE - SMF - net debugging
+/*
+=======================
+SV_InitSnapshotWorkers
+=======================
+*/
+static void SV_InitSnapshotWorkers( void ) {
+	SV_ShutdownSnapshotWorkers();
+	sv_snapshotWorkers->modified = qfalse;
+
+	if ( sv_snapshotWorkers->integer <= 0 ) {
+		return;
+	}
+
+	sv_numSnapshotWorkers = Sys_StartWorkers( sv_snapshotWorkers->integer );
+	if ( !sv_numSnapshotWorkers ) {
+		Com_Printf( "WARNING: no snapshot worker threads, building snapshots on the main thread\n" );
+		return;
+	}
+
+	// RF, avoid trying to allocate large chunk on a fragmented zone
+	sv_snapshotJobs = malloc( MAX_CLIENTS * sizeof( *sv_snapshotJobs ) );
+	if ( !sv_snapshotJobs ) {
+		Com_Printf( "WARNING: couldn't allocate snapshot jobs, building snapshots on the main thread\n" );
+		Sys_StopWorkers();
+		sv_numSnapshotWorkers = 0;
+		return;
+	}
+
+	Com_Printf( "Building snapshots on %i worker threads\n", sv_numSnapshotWorkers );
 }
 
+/*
+=======================
+SV_GatherSnapshotJob
+
+Worker thread
+=======================
+*/
+static void SV_GatherSnapshotJob( void *data, int index ) {
+	snapshotJob_t   *job = &( (snapshotJob_t *)data )[index];
+	client_t        *client = job->client;
+
+	if ( job->type != SJ_SNAPSHOT ) {
+		return;
+	}
+
+	SV_GatherClientSnapshot( &client->frames[ client->netchan.outgoingSequence & PACKET_MASK ], &job->entityNumbers, job->org );
+}
 
 /*
 =======================
-SV_SendClientMessages
+SV_WriteSnapshotJob
+
+Worker thread
 =======================
 */
+static void SV_WriteSnapshotJob( void *data, int index ) {
+	snapshotJob_t   *job = &( (snapshotJob_t *)data )[index];
+	client_t        *client = job->client;
+	int i, num;
 
-void SV_SendClientMessages( void ) {
+	if ( job->type != SJ_SNAPSHOT && job->type != SJ_EMPTY ) {
+		return;
+	}
+
+	// copy the entity states out
+	if ( job->type == SJ_SNAPSHOT ) {
+		for ( i = 0 ; i < job->entityNumbers.numSnapshotEntities ; i++ ) {
+			num = job->entityNumbers.snapshotEntities[i];
+			job->entities[i] = SV_GentityNum( num )->s;
+			job->held[i] = client->snapshotHeld[num];
+			job->changed[i] = client->snapshotChanged[num];
+		}
+	}
+
+	// NOTE, MRE: all server->client messages now acknowledge
+	// let the client know which reliable clientCommands we have received
+	MSG_WriteLong( &job->msg, client->lastClientCommand );
+
+	// (re)send any reliable server commands
+	SV_UpdateServerCommandsToClient( client, &job->msg );
+
+	// send over all the relevant entityState_t
+	// and the playerState_t
+	SV_WriteSnapshotFrom( client, job->oldframe, job->lastframe, svs.snapshotEntities, svs.numSnapshotEntities,
+						  &job->frame, job->entities, MAX_SNAPSHOT_ENTITIES, &job->msg );
+}
+
+/*
+=======================
+SV_StoreSnapshotJob
+
+Moves the entities of a snapshot built on the workers to its ring slots
+=======================
+*/
+static void SV_StoreSnapshotJob( snapshotJob_t *job ) {
+	clientSnapshot_t    *frame;
 	int i;
-	client_t    *c;
-	int numclients = 0;         // NERVE - SMF - net debugging
 
-	sv.bpsTotalBytes = 0;       // NERVE - SMF - net debugging
-	sv.ubpsTotalBytes = 0;      // NERVE - SMF - net debugging
+	if ( job->type != SJ_SNAPSHOT ) {
+		return;
+	}
 
-	// Gordon: update any changed configstrings from this frame
-	SV_UpdateConfigStrings();
+	frame = &job->client->frames[ job->client->netchan.outgoingSequence & PACKET_MASK ];
+	for ( i = 0 ; i < frame->num_entities ; i++ ) {
+		svs.snapshotEntities[( frame->first_entity + i ) % svs.numSnapshotEntities] = job->entities[i];
+	}
+}
 
-	// send a message to each connected client
+/*
+=======================
+SV_DiscardSnapshotJob
+
+Gives the client back the sv_snapshotBudget state it had before the
+snapshot was encoded, for a snapshot that won't be sent
+=======================
+*/
+static void SV_DiscardSnapshotJob( snapshotJob_t *job ) {
+	client_t    *client = job->client;
+	int i, num;
+
+	if ( job->type != SJ_SNAPSHOT ) {
+		return;
+	}
+
+	for ( i = 0 ; i < job->entityNumbers.numSnapshotEntities ; i++ ) {
+		num = job->entityNumbers.snapshotEntities[i];
+		client->snapshotHeld[num] = job->held[i];
+		client->snapshotChanged[num] = job->changed[i];
+	}
+}
+
+/*
+=======================
+SV_FixEntityNumbers
+
+SV_AddEntitiesVisibleFromPoint repairs these as it goes,
+do it up front so the worker threads only read the entities
+=======================
+*/
+static void SV_FixEntityNumbers( void ) {
+	int e;
+	sharedEntity_t  *ent;
+
+	for ( e = 0 ; e < sv.num_entities ; e++ ) {
+		ent = SV_GentityNum( e );
+		if ( ent->r.linked && ent->s.number != e ) {
+			Com_DPrintf( "FIXING ENT->S.NUMBER!!!\n" );
+			ent->s.number = e;
+		}
+	}
+}
+
+/*
+=======================
+SV_FillSnapshotVisCache
+=======================
+*/
+static void SV_FillSnapshotVisCache( int numJobs ) {
+	int i, leafnum;
+	snapshotJob_t   *job;
+	byte scratch[MAX_GENTITIES / 8];
+
+	for ( i = 0, job = sv_snapshotJobs ; i < numJobs ; i++, job++ ) {
+		if ( job->type == SJ_SNAPSHOT ) {
+			leafnum = CM_PointLeafnum( job->org );
+			SV_SnapshotVisibleEntities( CM_LeafCluster( leafnum ), CM_LeafArea( leafnum ), scratch, qtrue );
+		}
+	}
+}
+
+/*
+=======================
+SV_SendClientSnapshotsParallel
+
+Returns the number of clients a message was sent to
+=======================
+*/
+static int SV_SendClientSnapshotsParallel( void ) {
+	int i, j, numJobs, numStaged;
+	client_t            *c;
+	snapshotJob_t       *job;
+	clientSnapshot_t    *frame;
+	clientState_t state;
+	int perfStart;
+
+	// decide what every client gets this frame
+	numJobs = 0;
 	for ( i = 0; i < sv_maxclients->integer; i++ ) {
 		c = &svs.clients[i];
 
-		// rain - changed <= CS_ZOMBIE to < CS_ZOMBIE so that the
-		// disconnect reason is properly sent in the network stream
-		if ( c->state < CS_ZOMBIE ) {
-			continue;       // not connected
+		if ( !SV_ClientNeedsMessage( c ) ) {
+			continue;
+		}
+
+		job = &sv_snapshotJobs[numJobs++];
+		job->client = c;
+		job->entities = NULL;
+
+		if ( c->netchan.unsentFragments ) {
+			job->type = SJ_FRAGMENT;
+		} else if ( c->state < CS_ACTIVE && c->state != CS_ZOMBIE ) {
+			job->type = SJ_IDLE;
+		} else if ( SV_BeginClientSnapshot( c, &job->entityNumbers, job->org ) ) {
+			job->type = SJ_SNAPSHOT;
+			job->entityNumbers.deferCallbacks = qtrue;
+		} else {
+			job->type = SJ_EMPTY;
+		}
+	}
+
+	if ( !numJobs ) {
+		return 0;
+	}
+
+	// everything up to the delta encoding counts as one snapshot build
+	perfStart = Perf_Begin();
+
+	// find the visible entities of every client, the workers can
+	// only read the visibility cache so fill it for them first
+	if ( sv.state ) {
+		SV_FixEntityNumbers();
+		SV_FillSnapshotVisCache( numJobs );
+	}
+	Sys_RunWorkers( SV_GatherSnapshotJob, sv_snapshotJobs, numJobs );
+
+	// let the game filter the entities and allocate their
+	// ring slots in the same order as the serial path
+	numStaged = 0;
+	for ( i = 0, job = sv_snapshotJobs ; i < numJobs ; i++, job++ ) {
+		c = job->client;
+
+		if ( job->type == SJ_SNAPSHOT ) {
+			frame = &c->frames[ c->netchan.outgoingSequence & PACKET_MASK ];
+			SV_RunSnapshotCallbacks( frame, &job->entityNumbers );
+			SV_AllocSnapshotEntities( frame, &job->entityNumbers );
+			job->firstStaged = numStaged;
+			numStaged += frame->num_entities;
 		}
+		job->ringEnd = svs.nextSnapshotEntities;
 
-		// RF, needed to insert this otherwise bots would cause error drops in sv_net_chan.c:
-		// --> "netchan queue is not properly initialized in SV_Netchan_TransmitNextFragment\n"
-		if ( c->gentity && c->gentity->r.svFlags & SVF_BOT ) {
+		if ( job->type != SJ_SNAPSHOT && job->type != SJ_EMPTY ) {
 			continue;
 		}
 
-		if ( svs.time < c->nextSnapshotTime ) {
-			continue;       // not time yet
+		job->oldframe = SV_SnapshotDeltaFrame( c, &job->lastframe );
+		job->frame = c->frames[ c->netchan.outgoingSequence & PACKET_MASK ];
+		job->frame.first_entity = 0;
+
+		MSG_Init( &job->msg, job->msgBuf, sizeof( job->msgBuf ) );
+		job->msg.allowoverflow = qtrue;
+	}
+
+	// the workers copy the entity states out to here, the ring is
+	// left alone until the messages are sent
+	if ( numStaged > sv_numSnapshotStaged ) {
+		free( sv_snapshotStaged );
+		sv_snapshotStaged = malloc( numStaged * sizeof( *sv_snapshotStaged ) );
+		if ( !sv_snapshotStaged ) {
+			Com_Error( ERR_FATAL, "SV_SendClientSnapshotsParallel: couldn't allocate %i entity states", numStaged );
 		}
+		sv_numSnapshotStaged = numStaged;
+	}
+	for ( i = 0, job = sv_snapshotJobs ; i < numJobs ; i++, job++ ) {
+		if ( job->type == SJ_SNAPSHOT ) {
+			job->entities = sv_snapshotStaged + job->firstStaged;
+		}
+	}
 
-		numclients++;       // NERVE - SMF - net debugging
+	Perf_End( PERF_BUILD_SNAPSHOT, perfStart );
 
-		// send additional message fragments if the last message
-		// was too large to send at once
-		if ( c->netchan.unsentFragments ) {
+	// copy out, delta encode and compress
+	Sys_RunWorkers( SV_WriteSnapshotJob, sv_snapshotJobs, numJobs );
+
+	// send everything in client order
+	for ( i = 0, job = sv_snapshotJobs ; i < numJobs ; i++, job++ ) {
+		c = job->client;
+		state = c->state;
+
+		switch ( job->type ) {
+		case SJ_FRAGMENT:
 			c->nextSnapshotTime = svs.time +
 								  SV_RateMsec( c, c->netchan.unsentLength - c->netchan.unsentFragmentStart );
 			SV_Netchan_TransmitNextFragment( c );
+			break;
+		case SJ_IDLE:
+			SV_SendClientIdle( c );
+			break;
+		default:
+			SV_StoreSnapshotJob( job );
+			SV_SendSnapshotMessage( c, &job->msg );
+			break;
+		}
+
+		if ( c->state == state ) {
 			continue;
 		}
 
-		// generate and send a new message
-		SV_SendClientSnapshot( c );
+		// the client was dropped for overflowing its message, and the
+		// game may have changed anything the snapshots of the clients
+		// after it were built from, so build those over the serial way
+		for ( j = i + 1 ; j < numJobs ; j++ ) {
+			SV_DiscardSnapshotJob( &sv_snapshotJobs[j] );
+		}
+		svs.nextSnapshotEntities = job->ringEnd;
+
+		numJobs = i + 1;
+		for ( j = c - svs.clients + 1 ; j < sv_maxclients->integer ; j++ ) {
+			if ( SV_SendClientMessage( &svs.clients[j] ) ) {
+				numJobs++;
+			}
+		}
+		break;
+	}
+
+	return numJobs;
+}
+
+/*
+=======================
+SV_SendClientMessages
+=======================
+*/
+
+void SV_SendClientMessages( void ) {
+	int i;
+	int numclients = 0;         // NERVE - SMF - net debugging
+
+	sv.bpsTotalBytes = 0;       // NERVE - SMF - net debugging
+	sv.ubpsTotalBytes = 0;      // NERVE - SMF - net debugging
+
+	// Gordon: update any changed configstrings from this frame
+	SV_UpdateConfigStrings();
+
+	if ( sv_snapshotWorkers->modified ) {
+		SV_InitSnapshotWorkers();
+	}
+
+	SV_BeginSnapshotVisCache();
+
+	// queue this frame's datagrams and write them out together below
+	Sys_BeginPacketBatch();
+
+	// send a message to each connected client
+	if ( sv_numSnapshotWorkers ) {
+		numclients = SV_SendClientSnapshotsParallel();
+	} else {
+		for ( i = 0; i < sv_maxclients->integer; i++ ) {
+			if ( SV_SendClientMessage( &svs.clients[i] ) ) {
+				numclients++;   // NERVE - SMF - net debugging
+			}
+		}
 	}
 
+	SV_EndSnapshotVisCache();
+
+	Sys_FlushPacketBatch();
+
 	// NERVE - SMF - net debugging
 	if ( sv_showAverageBPS->integer && numclients > 0 ) {
 		float ave = 0, uave = 0;
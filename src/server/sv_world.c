@@ -81,6 +81,43 @@ typedef struct worldSector_s {
 worldSector_t sv_worldSectors[AREA_NODES];
 int sv_numworldSectors;
 
+/*
+The sector tree leaves anything that straddles a split at the splitting node,
+so on large maps most brush models and movers end up at the top few nodes and
+are tested by every area query.  With sv_worldGrid set, entities are also
+linked into every cell of a uniform x/y grid that their box touches and
+SV_AreaEntities walks only the cells under the query box.  Boxes covering more
+than GRID_MAX_ENT_CELLS cells go into one extra cell that every query scans.
+The tree is still maintained so the two can be compared by areabench.
+*/
+
+#define GRID_MAX_DIM        64
+#define GRID_MAX_ENT_CELLS  16
+#define GRID_MAX_LINKS      ( MAX_GENTITIES * GRID_MAX_ENT_CELLS )
+
+typedef struct worldGridLink_s {
+	svEntity_t  *ent;
+	int cell;
+	struct worldGridLink_s  *prevInCell, *nextInCell;
+	struct worldGridLink_s  *nextForEntity;
+} worldGridLink_t;
+
+typedef struct {
+	qboolean active;
+	vec2_t origin;
+	float cellSize;
+	int dim[2];
+	int numCells;                                   // the oversize cell is cells[numCells]
+	worldGridLink_t *cells[GRID_MAX_DIM * GRID_MAX_DIM + 1];
+	worldGridLink_t links[GRID_MAX_LINKS];
+	worldGridLink_t *freeLinks;
+	int queryStamp;
+} worldGrid_t;
+
+static worldGrid_t sv_areaGrid;
+
+static void SV_CreateWorldGrid( vec3_t mins, vec3_t maxs );
+
 
 /*
 ===============
@@ -101,6 +138,31 @@ void SV_SectorList_f( void ) {
 		}
 		Com_Printf( "sector %i: %i entities\n", i, c );
 	}
+
+	if ( sv_areaGrid.active ) {
+		worldGridLink_t *link;
+		int used, most;
+
+		used = most = 0;
+		for ( i = 0 ; i < sv_areaGrid.numCells ; i++ ) {
+			c = 0;
+			for ( link = sv_areaGrid.cells[i] ; link ; link = link->nextInCell ) {
+				c++;
+			}
+			if ( c ) {
+				used++;
+			}
+			if ( c > most ) {
+				most = c;
+			}
+		}
+		c = 0;
+		for ( link = sv_areaGrid.cells[sv_areaGrid.numCells] ; link ; link = link->nextInCell ) {
+			c++;
+		}
+		Com_Printf( "grid %ix%i cells of %i units: %i occupied, %i entities in the fullest, %i oversize\n",
+					sv_areaGrid.dim[0], sv_areaGrid.dim[1], (int)sv_areaGrid.cellSize, used, most, c );
+	}
 }
 
 /*
@@ -162,6 +224,189 @@ void SV_ClearWorld( void ) {
 	h = CM_InlineModel( 0 );
 	CM_ModelBounds( h, mins, maxs );
 	SV_CreateworldSector( 0, mins, maxs );
+
+	SV_CreateWorldGrid( mins, maxs );
+}
+
+
+/*
+===============
+SV_CreateWorldGrid
+
+Sizes the grid to the world bounds, growing the cells on big maps
+so neither axis needs more than GRID_MAX_DIM of them
+===============
+*/
+static void SV_CreateWorldGrid( vec3_t mins, vec3_t maxs ) {
+	worldGrid_t *grid;
+	float size;
+	int i;
+
+	grid = &sv_areaGrid;
+	grid->active = qfalse;
+
+	if ( !sv_worldGrid->integer ) {
+		return;
+	}
+
+	grid->cellSize = sv_worldGridCellSize->value;
+	if ( grid->cellSize < 64 ) {
+		grid->cellSize = 64;
+	}
+
+	for ( i = 0 ; i < 2 ; i++ ) {
+		size = maxs[i] - mins[i];
+		if ( size / grid->cellSize > GRID_MAX_DIM ) {
+			grid->cellSize = size / GRID_MAX_DIM;
+		}
+	}
+
+	for ( i = 0 ; i < 2 ; i++ ) {
+		grid->origin[i] = mins[i];
+		grid->dim[i] = (int)ceil( ( maxs[i] - mins[i] ) / grid->cellSize );
+		if ( grid->dim[i] < 1 ) {
+			grid->dim[i] = 1;
+		} else if ( grid->dim[i] > GRID_MAX_DIM ) {
+			grid->dim[i] = GRID_MAX_DIM;
+		}
+	}
+
+	grid->numCells = grid->dim[0] * grid->dim[1];
+	memset( grid->cells, 0, sizeof( grid->cells ) );
+
+	grid->freeLinks = NULL;
+	for ( i = GRID_MAX_LINKS - 1 ; i >= 0 ; i-- ) {
+		grid->links[i].nextForEntity = grid->freeLinks;
+		grid->freeLinks = &grid->links[i];
+	}
+
+	grid->queryStamp = 0;
+	grid->active = qtrue;
+}
+
+/*
+===============
+SV_GridCellRange
+
+Cells covered by the box, clamped to the grid.  Anything outside the
+world lands in the edge cells, so boxes that overlap still share a cell.
+===============
+*/
+static void SV_GridCellRange( const float *mins, const float *maxs, int range[4] ) {
+	worldGrid_t *grid;
+	int i, lo, hi;
+
+	grid = &sv_areaGrid;
+
+	for ( i = 0 ; i < 2 ; i++ ) {
+		lo = (int)floor( ( mins[i] - grid->origin[i] ) / grid->cellSize );
+		hi = (int)floor( ( maxs[i] - grid->origin[i] ) / grid->cellSize );
+
+		if ( lo < 0 ) {
+			lo = 0;
+		} else if ( lo >= grid->dim[i] ) {
+			lo = grid->dim[i] - 1;
+		}
+		if ( hi < 0 ) {
+			hi = 0;
+		} else if ( hi >= grid->dim[i] ) {
+			hi = grid->dim[i] - 1;
+		}
+
+		range[i] = lo;
+		range[i + 2] = hi;
+	}
+}
+
+/*
+===============
+SV_UnlinkGridEntity
+===============
+*/
+static void SV_UnlinkGridEntity( svEntity_t *ent ) {
+	worldGrid_t *grid;
+	worldGridLink_t *link, *next;
+
+	grid = &sv_areaGrid;
+
+	for ( link = ent->gridLinks ; link ; link = next ) {
+		next = link->nextForEntity;
+
+		if ( link->prevInCell ) {
+			link->prevInCell->nextInCell = link->nextInCell;
+		} else {
+			grid->cells[link->cell] = link->nextInCell;
+		}
+		if ( link->nextInCell ) {
+			link->nextInCell->prevInCell = link->prevInCell;
+		}
+
+		link->ent = NULL;
+		link->nextForEntity = grid->freeLinks;
+		grid->freeLinks = link;
+	}
+
+	ent->gridLinks = NULL;
+}
+
+/*
+===============
+SV_LinkGridCell
+===============
+*/
+static void SV_LinkGridCell( svEntity_t *ent, int cell ) {
+	worldGrid_t *grid;
+	worldGridLink_t *link;
+
+	grid = &sv_areaGrid;
+
+	// every entity needs at most GRID_MAX_ENT_CELLS links, so this can't run dry
+	link = grid->freeLinks;
+	grid->freeLinks = link->nextForEntity;
+
+	link->ent = ent;
+	link->cell = cell;
+	link->prevInCell = NULL;
+	link->nextInCell = grid->cells[cell];
+	if ( link->nextInCell ) {
+		link->nextInCell->prevInCell = link;
+	}
+	grid->cells[cell] = link;
+
+	link->nextForEntity = ent->gridLinks;
+	ent->gridLinks = link;
+}
+
+/*
+===============
+SV_LinkGridEntity
+
+Entities that move within the cells they already occupy keep their links
+===============
+*/
+static void SV_LinkGridEntity( svEntity_t *ent, sharedEntity_t *gEnt ) {
+	int range[4];
+	int x, y;
+
+	SV_GridCellRange( gEnt->r.absmin, gEnt->r.absmax, range );
+
+	if ( ent->gridLinks && !memcmp( range, ent->gridRange, sizeof( range ) ) ) {
+		return;
+	}
+
+	SV_UnlinkGridEntity( ent );
+	memcpy( ent->gridRange, range, sizeof( range ) );
+
+	if ( ( range[2] - range[0] + 1 ) * ( range[3] - range[1] + 1 ) > GRID_MAX_ENT_CELLS ) {
+		SV_LinkGridCell( ent, sv_areaGrid.numCells );
+		return;
+	}
+
+	for ( y = range[1] ; y <= range[3] ; y++ ) {
+		for ( x = range[0] ; x <= range[2] ; x++ ) {
+			SV_LinkGridCell( ent, y * sv_areaGrid.dim[0] + x );
+		}
+	}
 }
 
 
@@ -171,15 +416,10 @@ SV_UnlinkEntity
 
 ===============
 */
-void SV_UnlinkEntity( sharedEntity_t *gEnt ) {
-	svEntity_t      *ent;
+static void SV_UnlinkSectorEntity( svEntity_t *ent ) {
 	svEntity_t      *scan;
 	worldSector_t   *ws;
 
-	ent = SV_SvEntityForGentity( gEnt );
-
-	gEnt->r.linked = qfalse;
-
 	ws = ent->worldSector;
 	if ( !ws ) {
 		return;     // not linked in anywhere
@@ -201,6 +441,19 @@ void SV_UnlinkEntity( sharedEntity_t *gEnt ) {
 	Com_Printf( "WARNING: SV_UnlinkEntity: not found in worldSector\n" );
 }
 
+void SV_UnlinkEntity( sharedEntity_t *gEnt ) {
+	svEntity_t      *ent;
+
+	ent = SV_SvEntityForGentity( gEnt );
+
+	gEnt->r.linked = qfalse;
+
+	SV_UnlinkSectorEntity( ent );
+	if ( ent->gridLinks ) {
+		SV_UnlinkGridEntity( ent );
+	}
+}
+
 
 /*
 ===============
@@ -228,7 +481,10 @@ void SV_LinkEntity( sharedEntity_t *gEnt ) {
 	}
 
 	if ( ent->worldSector ) {
-		SV_UnlinkEntity( gEnt );    // unlink from old position
+		// unlink from old position, the grid links are only
+		// replaced below if the entity changed cells
+		gEnt->r.linked = qfalse;
+		SV_UnlinkSectorEntity( ent );
 	}
 
 	// encode the size into the entityState_t for client prediction
@@ -313,6 +569,9 @@ void SV_LinkEntity( sharedEntity_t *gEnt ) {
 	// if none of the leafs were inside the map, the
 	// entity is outside the world and can be considered unlinked
 	if ( !num_leafs ) {
+		if ( ent->gridLinks ) {
+			SV_UnlinkGridEntity( ent );
+		}
 		return;
 	}
 
@@ -375,6 +634,10 @@ void SV_LinkEntity( sharedEntity_t *gEnt ) {
 	ent->nextEntityInWorldSector = node->entities;
 	node->entities = ent;
 
+	if ( sv_areaGrid.active ) {
+		SV_LinkGridEntity( ent, gEnt );
+	}
+
 	gEnt->r.linked = qtrue;
 }
 
@@ -449,25 +712,258 @@ void SV_AreaEntities_r( worldSector_t *node, areaParms_t *ap ) {
 	}
 }
 
+/*
+====================
+SV_AreaEntitiesGridCell
+
+Returns qfalse once the list is full
+====================
+*/
+static qboolean SV_AreaEntitiesGridCell( worldGridLink_t *link, areaParms_t *ap ) {
+	svEntity_t  *check;
+	sharedEntity_t *gcheck;
+
+	for ( ; link ; link = link->nextInCell ) {
+		check = link->ent;
+
+		// entities spanning several cells are only tested once
+		if ( check->gridStamp == sv_areaGrid.queryStamp ) {
+			continue;
+		}
+		check->gridStamp = sv_areaGrid.queryStamp;
+
+		gcheck = SV_GEntityForSvEntity( check );
+
+		if ( !gcheck->r.linked ) {
+			continue;
+		}
+
+		if ( gcheck->r.absmin[0] > ap->maxs[0]
+			 || gcheck->r.absmin[1] > ap->maxs[1]
+			 || gcheck->r.absmin[2] > ap->maxs[2]
+			 || gcheck->r.absmax[0] < ap->mins[0]
+			 || gcheck->r.absmax[1] < ap->mins[1]
+			 || gcheck->r.absmax[2] < ap->mins[2] ) {
+			continue;
+		}
+
+		if ( ap->count == ap->maxcount ) {
+			Com_Printf( "SV_AreaEntities: MAXCOUNT\n" );
+			return qfalse;
+		}
+
+		ap->list[ap->count] = check - sv.svEntities;
+		ap->count++;
+	}
+
+	return qtrue;
+}
+
+/*
+====================
+SV_AreaEntitiesGrid
+====================
+*/
+static void SV_AreaEntitiesGrid( areaParms_t *ap ) {
+	worldGrid_t *grid;
+	int range[4];
+	int x, y, i;
+
+	grid = &sv_areaGrid;
+
+	if ( ++grid->queryStamp <= 0 ) {
+		for ( i = 0 ; i < MAX_GENTITIES ; i++ ) {
+			sv.svEntities[i].gridStamp = 0;
+		}
+		grid->queryStamp = 1;
+	}
+
+	if ( !SV_AreaEntitiesGridCell( grid->cells[grid->numCells], ap ) ) {
+		return;
+	}
+
+	SV_GridCellRange( ap->mins, ap->maxs, range );
+
+	for ( y = range[1] ; y <= range[3] ; y++ ) {
+		for ( x = range[0] ; x <= range[2] ; x++ ) {
+			if ( !SV_AreaEntitiesGridCell( grid->cells[y * grid->dim[0] + x], ap ) ) {
+				return;
+			}
+		}
+	}
+}
+
 /*
 ================
 SV_AreaEntities
 ================
 */
+static vec3_t   *sv_areaQueries;        // mins/maxs pairs captured by arearecord
+static int sv_numAreaQueries;
+static int sv_maxAreaQueries;
+
 int SV_AreaEntities( const vec3_t mins, const vec3_t maxs, int *entityList, int maxcount ) {
 	areaParms_t ap;
 
+	if ( sv_numAreaQueries < sv_maxAreaQueries ) {
+		VectorCopy( mins, sv_areaQueries[sv_numAreaQueries * 2 + 0] );
+		VectorCopy( maxs, sv_areaQueries[sv_numAreaQueries * 2 + 1] );
+		if ( ++sv_numAreaQueries == sv_maxAreaQueries ) {
+			Com_Printf( "arearecord: captured %i area queries\n", sv_numAreaQueries );
+		}
+	}
+
 	ap.mins = mins;
 	ap.maxs = maxs;
 	ap.list = entityList;
 	ap.count = 0;
 	ap.maxcount = maxcount;
 
-	SV_AreaEntities_r( sv_worldSectors, &ap );
+	if ( sv_areaGrid.active ) {
+		SV_AreaEntitiesGrid( &ap );
+	} else {
+		SV_AreaEntities_r( sv_worldSectors, &ap );
+	}
 
 	return ap.count;
 }
 
+/*
+================
+SV_AreaRecord_f
+
+arearecord <count> captures the boxes of the next <count> area queries,
+which is every SV_Trace, SV_PointContents and trap_EntitiesInBox the game makes
+================
+*/
+void SV_AreaRecord_f( void ) {
+	int count;
+
+	if ( Cmd_Argc() != 2 ) {
+		Com_Printf( "usage: arearecord <count>\n" );
+		return;
+	}
+
+	count = atoi( Cmd_Argv( 1 ) );
+
+	if ( sv_areaQueries ) {
+		Z_Free( sv_areaQueries );
+		sv_areaQueries = NULL;
+	}
+	sv_numAreaQueries = sv_maxAreaQueries = 0;
+
+	if ( count <= 0 ) {
+		return;
+	}
+
+	sv_areaQueries = Z_Malloc( count * 2 * sizeof( vec3_t ) );
+	sv_maxAreaQueries = count;
+}
+
+static int SV_CompareEntityNums( const void *a, const void *b ) {
+	return *(const int *)a - *(const int *)b;
+}
+
+/*
+================
+SV_AreaBench_f
+
+areabench [passes] replays the captured queries against the current world,
+timing the sector tree and the grid and checking they return the same entities
+================
+*/
+void SV_AreaBench_f( void ) {
+	int passes, pass, i, j;
+	int treeList[MAX_GENTITIES], gridList[MAX_GENTITIES];
+	int treeCount, gridCount, mismatches;
+	int start, treeMsec, gridMsec;
+	areaParms_t ap;
+	vec3_t      *q;
+
+	if ( !sv_numAreaQueries ) {
+		Com_Printf( "areabench: no queries captured, use arearecord first\n" );
+		return;
+	}
+
+	passes = Cmd_Argc() > 1 ? atoi( Cmd_Argv( 1 ) ) : 10;
+	if ( passes < 1 ) {
+		passes = 1;
+	}
+
+	// stop capturing so the benchmark doesn't record itself
+	sv_maxAreaQueries = sv_numAreaQueries;
+
+	ap.list = treeList;
+	ap.maxcount = MAX_GENTITIES;
+
+	start = Sys_Milliseconds();
+	for ( pass = 0 ; pass < passes ; pass++ ) {
+		for ( i = 0, q = sv_areaQueries ; i < sv_numAreaQueries ; i++, q += 2 ) {
+			ap.mins = q[0];
+			ap.maxs = q[1];
+			ap.count = 0;
+			SV_AreaEntities_r( sv_worldSectors, &ap );
+		}
+	}
+	treeMsec = Sys_Milliseconds() - start;
+
+	Com_Printf( "%i queries x %i passes\n", sv_numAreaQueries, passes );
+	Com_Printf( "sector tree: %i msec\n", treeMsec );
+
+	if ( !sv_areaGrid.active ) {
+		Com_Printf( "grid: not active, set sv_worldGrid 1 and reload the map\n" );
+		return;
+	}
+
+	ap.list = gridList;
+
+	start = Sys_Milliseconds();
+	for ( pass = 0 ; pass < passes ; pass++ ) {
+		for ( i = 0, q = sv_areaQueries ; i < sv_numAreaQueries ; i++, q += 2 ) {
+			ap.mins = q[0];
+			ap.maxs = q[1];
+			ap.count = 0;
+			SV_AreaEntitiesGrid( &ap );
+		}
+	}
+	gridMsec = Sys_Milliseconds() - start;
+
+	Com_Printf( "grid: %i msec\n", gridMsec );
+
+	// both have to come up with the same set, in whatever order
+	mismatches = 0;
+	for ( i = 0, q = sv_areaQueries ; i < sv_numAreaQueries ; i++, q += 2 ) {
+		ap.mins = q[0];
+		ap.maxs = q[1];
+
+		ap.list = treeList;
+		ap.count = 0;
+		SV_AreaEntities_r( sv_worldSectors, &ap );
+		treeCount = ap.count;
+
+		ap.list = gridList;
+		ap.count = 0;
+		SV_AreaEntitiesGrid( &ap );
+		gridCount = ap.count;
+
+		qsort( treeList, treeCount, sizeof( int ), SV_CompareEntityNums );
+		qsort( gridList, gridCount, sizeof( int ), SV_CompareEntityNums );
+
+		if ( treeCount != gridCount ) {
+			mismatches++;
+			continue;
+		}
+		for ( j = 0 ; j < treeCount ; j++ ) {
+			if ( treeList[j] != gridList[j] ) {
+				mismatches++;
+				break;
+			}
+		}
+	}
+
+	Com_Printf( "%i queries returned different entities\n", mismatches );
+}
+
 
 
 //===========================================================================
@@ -539,21 +1035,19 @@ void SV_ClipToEntity( trace_t *trace, const vec3_t start, const vec3_t mins, con
 
 /*
 ====================
-SV_ClipMoveToEntities
+SV_ClipMoveToEntityList
 
+Clips the move against the given candidate entities, in list order
 ====================
 */
-void SV_ClipMoveToEntities( moveclip_t *clip ) {
-	int i, num;
-	int touchlist[MAX_GENTITIES];
+static void SV_ClipMoveToEntityList( moveclip_t *clip, const int *touchlist, int num ) {
+	int i;
 	sharedEntity_t *touch;
 	int passOwnerNum;
 	trace_t trace;
 	clipHandle_t clipHandle;
 	float       *origin, *angles;
 
-	num = SV_AreaEntities( clip->boxmins, clip->boxmaxs, touchlist, MAX_GENTITIES );
-
 	if ( clip->passEntityNum != ENTITYNUM_NONE ) {
 		passOwnerNum = ( SV_GentityNum( clip->passEntityNum ) )->r.ownerNum;
 		if ( passOwnerNum == ENTITYNUM_NONE ) {
@@ -645,6 +1139,67 @@ void SV_ClipMoveToEntities( moveclip_t *clip ) {
 	}
 }
 
+/*
+====================
+SV_ClipMoveToEntities
+
+====================
+*/
+void SV_ClipMoveToEntities( moveclip_t *clip ) {
+	int num;
+	int touchlist[MAX_GENTITIES];
+
+	num = SV_AreaEntities( clip->boxmins, clip->boxmaxs, touchlist, MAX_GENTITIES );
+
+	SV_ClipMoveToEntityList( clip, touchlist, num );
+}
+
+/*
+==================
+SV_StartMoveClip
+
+Clips the move to the world and sets up the clip for the entity pass.
+Returns qfalse if the world trace is already the final result.
+==================
+*/
+static qboolean SV_StartMoveClip( moveclip_t *clip, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int passEntityNum, int contentmask, int capsule ) {
+	int i;
+
+	memset( clip, 0, sizeof( moveclip_t ) );
+
+	// clip to world
+	CM_BoxTrace( &clip->trace, start, end, mins, maxs, 0, contentmask, capsule );
+	clip->trace.entityNum = clip->trace.fraction != 1.0 ? ENTITYNUM_WORLD : ENTITYNUM_NONE;
+	if ( clip->trace.fraction == 0 || passEntityNum == -2 ) {
+		return qfalse;      // blocked immediately by the world
+	}
+
+	clip->contentmask = contentmask;
+	clip->start = start;
+//	VectorCopy( clip->trace.endpos, clip->end );
+	VectorCopy( end, clip->end );
+	clip->mins = mins;
+	clip->maxs = maxs;
+	clip->passEntityNum = passEntityNum;
+	clip->capsule = capsule;
+
+	// create the bounding box of the entire move
+	// we can limit it to the part of the move not
+	// already clipped off by the world, which can be
+	// a significant savings for line of sight and shot traces
+	for ( i = 0 ; i < 3 ; i++ ) {
+		if ( end[i] > start[i] ) {
+			clip->boxmins[i] = clip->start[i] + clip->mins[i] - 1;
+			clip->boxmaxs[i] = clip->end[i] + clip->maxs[i] + 1;
+		} else {
+			clip->boxmins[i] = clip->end[i] + clip->mins[i] - 1;
+			clip->boxmaxs[i] = clip->start[i] + clip->maxs[i] + 1;
+		}
+	}
+
+	return qtrue;
+}
+
 
 /*
 ==================
@@ -656,7 +1211,9 @@ passEntityNum and entities owned by passEntityNum are explicitly not checked.
 */
 void SV_Trace( trace_t *results, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int passEntityNum, int contentmask, int capsule ) {
 	moveclip_t clip;
-	int i;
+	int perfStart;
+
+	perfStart = Perf_Begin();
 
 	if ( !mins ) {
 		mins = vec3_origin;
@@ -665,43 +1222,88 @@ void SV_Trace( trace_t *results, const vec3_t start, const vec3_t mins, const ve
 		maxs = vec3_origin;
 	}
 
-	memset( &clip, 0, sizeof( moveclip_t ) );
+	if ( SV_StartMoveClip( &clip, start, mins, maxs, end, passEntityNum, contentmask, capsule ) ) {
+		// clip to other solid entities
+		SV_ClipMoveToEntities( &clip );
+	}
 
-	// clip to world
-	CM_BoxTrace( &clip.trace, start, end, mins, maxs, 0, contentmask, capsule );
-	clip.trace.entityNum = clip.trace.fraction != 1.0 ? ENTITYNUM_WORLD : ENTITYNUM_NONE;
-	if ( clip.trace.fraction == 0 || passEntityNum == -2 ) {
-		*results = clip.trace;
-		return;     // blocked immediately by the world
-	}
-
-	clip.contentmask = contentmask;
-	clip.start = start;
-//	VectorCopy( clip.trace.endpos, clip.end );
-	VectorCopy( end, clip.end );
-	clip.mins = mins;
-	clip.maxs = maxs;
-	clip.passEntityNum = passEntityNum;
-	clip.capsule = capsule;
+	*results = clip.trace;
 
-	// create the bounding box of the entire move
-	// we can limit it to the part of the move not
-	// already clipped off by the world, which can be
-	// a significant savings for line of sight and shot traces
-	for ( i = 0 ; i < 3 ; i++ ) {
-		if ( end[i] > start[i] ) {
-			clip.boxmins[i] = clip.start[i] + clip.mins[i] - 1;
-			clip.boxmaxs[i] = clip.end[i] + clip.maxs[i] + 1;
-		} else {
-			clip.boxmins[i] = clip.end[i] + clip.mins[i] - 1;
-			clip.boxmaxs[i] = clip.start[i] + clip.maxs[i] + 1;
+	Perf_End( PERF_TRACE, perfStart );
+}
+
+/*
+==================
+SV_TraceBatch
+
+Runs numRays independent traces with a single area query covering all of
+them. Each ray only clips against the entities that overlap its own move
+bounds, in the order the sector tree would have returned them, so the
+results match calling SV_Trace once per ray (with sv_worldGrid the entity
+order can differ, which only matters for exact ties).
+==================
+*/
+void SV_TraceBatch( const traceRay_t *rays, trace_t *results, int numRays ) {
+	moveclip_t clips[MAX_TRACEBATCH];
+	qboolean active[MAX_TRACEBATCH];
+	int touchlist[MAX_GENTITIES], raylist[MAX_GENTITIES];
+	vec3_t mins, maxs;
+	int i, j, num, raynum, numActive;
+	const traceRay_t *ray;
+	moveclip_t *clip;
+	sharedEntity_t *touch;
+	int perfStart;
+
+	perfStart = Perf_Begin();
+
+	numActive = 0;
+	ClearBounds( mins, maxs );
+
+	for ( i = 0, ray = rays ; i < numRays ; i++, ray++ ) {
+		active[i] = SV_StartMoveClip( &clips[i], ray->start, ray->mins, ray->maxs, ray->end, ray->passEntityNum, ray->contentmask, ray->capsule );
+		if ( !active[i] ) {
+			continue;
 		}
+
+		AddPointToBounds( clips[i].boxmins, mins, maxs );
+		AddPointToBounds( clips[i].boxmaxs, mins, maxs );
+		numActive++;
 	}
 
-	// clip to other solid entities
-	SV_ClipMoveToEntities( &clip );
+	if ( numActive ) {
+		num = SV_AreaEntities( mins, maxs, touchlist, MAX_GENTITIES );
 
-	*results = clip.trace;
+		for ( i = 0, clip = clips ; i < numRays ; i++, clip++ ) {
+			if ( !active[i] ) {
+				continue;
+			}
+
+			// same bounds test as SV_AreaEntities, against this ray's box only
+			raynum = 0;
+			for ( j = 0 ; j < num ; j++ ) {
+				touch = SV_GentityNum( touchlist[j] );
+
+				if ( touch->r.absmin[0] > clip->boxmaxs[0]
+					 || touch->r.absmin[1] > clip->boxmaxs[1]
+					 || touch->r.absmin[2] > clip->boxmaxs[2]
+					 || touch->r.absmax[0] < clip->boxmins[0]
+					 || touch->r.absmax[1] < clip->boxmins[1]
+					 || touch->r.absmax[2] < clip->boxmins[2] ) {
+					continue;
+				}
+
+				raylist[raynum++] = touchlist[j];
+			}
+
+			SV_ClipMoveToEntityList( clip, raylist, raynum );
+		}
+	}
+
+	for ( i = 0 ; i < numRays ; i++ ) {
+		results[i] = clips[i].trace;
+	}
+
+	Perf_End( PERF_TRACE, perfStart );
 }
 
 
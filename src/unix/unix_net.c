@@ -28,6 +28,11 @@ If you have questions concerning this license or the applicable additional terms
 
 // unix_net.c
 
+// recvmmsg/sendmmsg are GNU extensions
+#if defined( __linux__ ) && !defined( _GNU_SOURCE )
+#define _GNU_SOURCE
+#endif
+
 #include "../game/q_shared.h"
 #include "../qcommon/qcommon.h"
 
@@ -53,7 +58,12 @@ If you have questions concerning this license or the applicable additional terms
 #import <net/if_dl.h> // for 'struct sockaddr_dl'
 #endif
 
+#if defined( __linux__ ) && defined( MSG_WAITFORONE )
+#define NET_MMSG
+#endif
+
 static cvar_t   *noudp;
+static cvar_t   *net_batch;     // drain/send several datagrams per syscall where supported
 
 netadr_t net_local_adr;
 
@@ -155,6 +165,221 @@ qboolean    Sys_StringToAdr( const char *s, netadr_t *a ) {
 
 //=============================================================================
 
+#ifdef NET_MMSG
+
+#define NET_RECV_BATCH      16
+#define NET_SEND_BATCH      128
+#define NET_SEND_POOL       ( 4 * MAX_MSGLEN )
+
+typedef struct {
+	struct mmsghdr hdr[NET_RECV_BATCH];
+	struct iovec iov[NET_RECV_BATCH];
+	struct sockaddr_in from[NET_RECV_BATCH];
+	byte data[NET_RECV_BATCH][MAX_MSGLEN];
+	int count;                      // datagrams returned by the last recvmmsg
+	int current;                    // next one to hand to Sys_GetPacket
+} netRecvBatch_t;
+
+typedef struct {
+	struct mmsghdr hdr[NET_SEND_BATCH];
+	struct iovec iov[NET_SEND_BATCH];
+	struct sockaddr_in to[NET_SEND_BATCH];
+	byte pool[NET_SEND_POOL];
+	int poolUsed;
+	int count;
+	qboolean active;                // between Sys_BeginPacketBatch and Sys_FlushPacketBatch
+} netSendBatch_t;
+
+static netRecvBatch_t netRecv;
+static netSendBatch_t netSend;
+static qboolean netBatchMissing;    // the kernel lacks the syscalls, use recvfrom/sendto
+
+static qboolean NET_BatchAvailable( void ) {
+	return net_batch && net_batch->integer && !netBatchMissing;
+}
+
+static void NET_BatchUnsupported( void ) {
+	if ( !netBatchMissing ) {
+		Com_Printf( "recvmmsg/sendmmsg not supported, falling back to recvfrom/sendto\n" );
+		netBatchMissing = qtrue;
+	}
+}
+
+/*
+==================
+NET_RecvBatch
+
+Fills the receive ring with as many pending datagrams as are queued on the socket
+==================
+*/
+static qboolean NET_RecvBatch( int net_socket ) {
+	int i, ret;
+
+	for ( i = 0 ; i < NET_RECV_BATCH ; i++ ) {
+		netRecv.iov[i].iov_base = netRecv.data[i];
+		netRecv.iov[i].iov_len = sizeof( netRecv.data[i] );
+		memset( &netRecv.hdr[i], 0, sizeof( netRecv.hdr[i] ) );
+		netRecv.hdr[i].msg_hdr.msg_name = &netRecv.from[i];
+		netRecv.hdr[i].msg_hdr.msg_namelen = sizeof( netRecv.from[i] );
+		netRecv.hdr[i].msg_hdr.msg_iov = &netRecv.iov[i];
+		netRecv.hdr[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	netRecv.count = netRecv.current = 0;
+
+	ret = recvmmsg( net_socket, netRecv.hdr, NET_RECV_BATCH, MSG_DONTWAIT, NULL );
+	if ( ret == -1 ) {
+		if ( errno == ENOSYS ) {
+			NET_BatchUnsupported();
+		} else if ( errno != EWOULDBLOCK && errno != ECONNREFUSED ) {
+			Com_Printf( "NET_GetPacket: %s\n", NET_ErrorString() );
+		}
+		return qfalse;
+	}
+
+	netRecv.count = ret;
+	return qtrue;
+}
+
+/*
+==================
+NET_GetBatchedPacket
+==================
+*/
+static qboolean NET_GetBatchedPacket( netadr_t *net_from, msg_t *net_message ) {
+	struct mmsghdr *hdr;
+	int len;
+
+	while ( netRecv.current < netRecv.count ) {
+		hdr = &netRecv.hdr[netRecv.current];
+		len = hdr->msg_len;
+
+		SockadrToNetadr( &netRecv.from[netRecv.current], net_from );
+		net_message->readcount = 0;
+
+		if ( len >= net_message->maxsize || ( hdr->msg_hdr.msg_flags & MSG_TRUNC ) ) {
+			Com_Printf( "Oversize packet from %s\n", NET_AdrToString( *net_from ) );
+			netRecv.current++;
+			continue;
+		}
+
+		memcpy( net_message->data, netRecv.data[netRecv.current], len );
+		net_message->cursize = len;
+		netRecv.current++;
+		return qtrue;
+	}
+
+	return qfalse;
+}
+
+/*
+==================
+Sys_BeginPacketBatch
+
+Packets sent on the ip socket are queued until Sys_FlushPacketBatch
+==================
+*/
+void Sys_BeginPacketBatch( void ) {
+	if ( !ip_socket || !NET_BatchAvailable() ) {
+		return;
+	}
+	netSend.active = qtrue;
+}
+
+/*
+==================
+NET_FlushSendQueue
+==================
+*/
+static void NET_FlushSendQueue( void ) {
+	int sent, ret;
+	netadr_t to;
+
+	sent = 0;
+	while ( sent < netSend.count ) {
+		ret = sendmmsg( ip_socket, netSend.hdr + sent, netSend.count - sent, 0 );
+		if ( ret > 0 ) {
+			sent += ret;
+			continue;
+		}
+
+		if ( errno == ENOSYS ) {
+			// send the rest one at a time
+			for ( ; sent < netSend.count ; sent++ ) {
+				ret = sendto( ip_socket, netSend.iov[sent].iov_base, netSend.iov[sent].iov_len, 0,
+							  (struct sockaddr *)&netSend.to[sent], sizeof( netSend.to[sent] ) );
+				if ( ret == -1 ) {
+					SockadrToNetadr( &netSend.to[sent], &to );
+					Com_Printf( "NET_SendPacket ERROR: %s to %s\n", NET_ErrorString(), NET_AdrToString( to ) );
+				}
+			}
+			NET_BatchUnsupported();
+			break;
+		}
+
+		// the first message in the remaining batch failed, report and skip it
+		SockadrToNetadr( &netSend.to[sent], &to );
+		Com_Printf( "NET_SendPacket ERROR: %s to %s\n", NET_ErrorString(), NET_AdrToString( to ) );
+		sent++;
+	}
+
+	netSend.count = 0;
+	netSend.poolUsed = 0;
+}
+
+/*
+==================
+Sys_FlushPacketBatch
+==================
+*/
+void Sys_FlushPacketBatch( void ) {
+	NET_FlushSendQueue();
+	netSend.active = qfalse;
+}
+
+/*
+==================
+NET_QueuePacket
+
+Returns qfalse if the packet has to go out immediately
+==================
+*/
+static qboolean NET_QueuePacket( int net_socket, int length, const void *data, netadr_t *to ) {
+	int i;
+
+	if ( !netSend.active || net_socket != ip_socket || length > NET_SEND_POOL ) {
+		return qfalse;
+	}
+
+	if ( netSend.count == NET_SEND_BATCH || netSend.poolUsed + length > NET_SEND_POOL ) {
+		NET_FlushSendQueue();
+	}
+
+	i = netSend.count++;
+	memcpy( netSend.pool + netSend.poolUsed, data, length );
+	NetadrToSockadr( to, &netSend.to[i] );
+	netSend.iov[i].iov_base = netSend.pool + netSend.poolUsed;
+	netSend.iov[i].iov_len = length;
+	memset( &netSend.hdr[i], 0, sizeof( netSend.hdr[i] ) );
+	netSend.hdr[i].msg_hdr.msg_name = &netSend.to[i];
+	netSend.hdr[i].msg_hdr.msg_namelen = sizeof( netSend.to[i] );
+	netSend.hdr[i].msg_hdr.msg_iov = &netSend.iov[i];
+	netSend.hdr[i].msg_hdr.msg_iovlen = 1;
+	netSend.poolUsed += length;
+
+	return qtrue;
+}
+
+#else
+
+void Sys_BeginPacketBatch( void ) {
+}
+
+void Sys_FlushPacketBatch( void ) {
+}
+
+#endif
+
 qboolean    Sys_GetPacket( netadr_t *net_from, msg_t *net_message ) {
 	int ret;
 	struct sockaddr_in from;
@@ -163,6 +388,23 @@ qboolean    Sys_GetPacket( netadr_t *net_from, msg_t *net_message ) {
 	int protocol;
 	int err;
 
+#ifdef NET_MMSG
+	// hand out whatever the last recvmmsg left in the ring first
+	if ( NET_GetBatchedPacket( net_from, net_message ) ) {
+		return qtrue;
+	}
+
+	if ( ip_socket && NET_BatchAvailable() ) {
+		if ( NET_RecvBatch( ip_socket ) ) {
+			return NET_GetBatchedPacket( net_from, net_message );
+		}
+		if ( !netBatchMissing ) {
+			return qfalse;
+		}
+		// recvmmsg missing, fall through to recvfrom
+	}
+#endif
+
 	for ( protocol = 0 ; protocol < 2 ; protocol++ )
 	{
 		if ( protocol == 0 ) {
@@ -230,6 +472,12 @@ void    Sys_SendPacket( int length, const void *data, netadr_t to ) {
 		return;
 	}
 
+#ifdef NET_MMSG
+	if ( NET_QueuePacket( net_socket, length, data, &to ) ) {
+		return;
+	}
+#endif
+
 	NetadrToSockadr( &to, &addr );
 
 	ret = sendto( net_socket, data, length, 0, (struct sockaddr *)&addr, sizeof( addr ) );
@@ -538,6 +786,7 @@ NET_Init
 */
 void NET_Init( void ) {
 	noudp = Cvar_Get( "net_noudp", "0", 0 );
+	net_batch = Cvar_Get( "net_batch", "1", CVAR_ARCHIVE );
 	// open sockets
 	if ( !noudp->value ) {
 		NET_OpenIP();
@@ -694,6 +943,7 @@ NET_Shutdown
 ====================
 */
 void    NET_Shutdown( void ) {
+	Sys_FlushPacketBatch();
 	if ( ip_socket ) {
 		close( ip_socket );
 		ip_socket = 0;
@@ -28,6 +28,7 @@ If you have questions concerning this license or the applicable additional terms
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <fcntl.h>
 #include <errno.h>
 #include <stdio.h>
 #include <dirent.h>
@@ -35,6 +36,7 @@ If you have questions concerning this license or the applicable additional terms
 #include <sys/mman.h>
 #include <sys/time.h>
 #include <pwd.h>
+#include <pthread.h>
 
 #include "../game/q_shared.h"
 #include "../qcommon/qcommon.h"
@@ -81,6 +83,19 @@ int Sys_Milliseconds( void ) {
 	return curtime;
 }
 
+/*
+================
+Sys_Microseconds
+================
+*/
+int Sys_Microseconds( void ) {
+	struct timeval tp;
+
+	gettimeofday( &tp, NULL );
+
+	return (int)( (unsigned int)( tp.tv_sec - sys_timeBase ) * 1000000u + tp.tv_usec );
+}
+
 #if !defined( DEDICATED )
 /*
 ================
@@ -330,6 +345,65 @@ void    Sys_FreeFileList( char **list ) {
 	Z_Free( list );
 }
 
+/*
+================
+Sys_MapFile
+================
+*/
+void *Sys_MapFile( const char *path, int *length ) {
+	struct stat st;
+	void *data;
+	int fd;
+
+	fd = open( path, O_RDONLY );
+	if ( fd == -1 ) {
+		return NULL;
+	}
+
+	if ( fstat( fd, &st ) == -1 || st.st_size <= 0 || st.st_size > 0x7fffffff ) {
+		close( fd );
+		return NULL;
+	}
+
+	data = mmap( NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+	// the mapping keeps its own reference to the file
+	close( fd );
+	if ( data == MAP_FAILED ) {
+		return NULL;
+	}
+
+	*length = (int)st.st_size;
+	return data;
+}
+
+/*
+================
+Sys_UnmapFile
+================
+*/
+void Sys_UnmapFile( void *data, int length ) {
+	if ( data ) {
+		munmap( data, length );
+	}
+}
+
+/*
+================
+Sys_FileStat
+================
+*/
+qboolean Sys_FileStat( const char *path, int *size, int *mtime ) {
+	struct stat st;
+
+	if ( stat( path, &st ) == -1 || st.st_size > 0x7fffffff ) {
+		return qfalse;
+	}
+
+	*size = (int)st.st_size;
+	*mtime = (int)st.st_mtime;
+	return qtrue;
+}
+
 char *Sys_Cwd( void ) {
 	static char cwd[MAX_OSPATH];
 
@@ -459,3 +533,294 @@ void Sys_EnterCriticalSection( void *ptr ) {
 
 void Sys_LeaveCriticalSection( void *ptr ) {
 }
+
+/*
+==============================================================
+
+WORKER THREADS
+
+A small pool of pthreads used to split data parallel work, such as building
+client snapshots, across processors.  Jobs are handed out one index at a time,
+the calling thread works on the batch as well and only returns once every job
+of the batch has completed.
+
+==============================================================
+*/
+
+typedef struct {
+	pthread_t threads[MAX_SYS_WORKERS];
+	int numThreads;
+
+	pthread_mutex_t lock;
+	pthread_cond_t wake;                // signaled when a new batch is posted
+	pthread_cond_t done;                // signaled when the last job of a batch finishes
+
+	workerFunc_t func;
+	void            *data;
+	int numJobs;
+	int nextJob;
+	int pendingJobs;
+	int batch;                          // incremented for each Sys_RunWorkers call
+	qboolean shutdown;
+} sysWorkers_t;
+
+static sysWorkers_t sys_workers;
+
+/*
+==================
+Sys_WorkerRunJobs
+
+Takes jobs from the current batch until none are left, lock must be held
+==================
+*/
+static void Sys_WorkerRunJobs( void ) {
+	int job;
+
+	while ( sys_workers.nextJob < sys_workers.numJobs ) {
+		job = sys_workers.nextJob++;
+
+		pthread_mutex_unlock( &sys_workers.lock );
+		sys_workers.func( sys_workers.data, job );
+		pthread_mutex_lock( &sys_workers.lock );
+
+		if ( --sys_workers.pendingJobs == 0 ) {
+			pthread_cond_broadcast( &sys_workers.done );
+		}
+	}
+}
+
+static void *Sys_WorkerThread( void *arg ) {
+	int batch = 0;
+
+	pthread_mutex_lock( &sys_workers.lock );
+	while ( 1 ) {
+		while ( !sys_workers.shutdown && batch == sys_workers.batch ) {
+			pthread_cond_wait( &sys_workers.wake, &sys_workers.lock );
+		}
+		if ( sys_workers.shutdown ) {
+			break;
+		}
+		batch = sys_workers.batch;
+		Sys_WorkerRunJobs();
+	}
+	pthread_mutex_unlock( &sys_workers.lock );
+
+	return NULL;
+}
+
+/*
+==================
+Sys_StartWorkers
+==================
+*/
+int Sys_StartWorkers( int count ) {
+	int i, err;
+
+	Sys_StopWorkers();
+
+	if ( count > MAX_SYS_WORKERS ) {
+		count = MAX_SYS_WORKERS;
+	}
+	if ( count <= 0 ) {
+		return 0;
+	}
+
+	pthread_mutex_init( &sys_workers.lock, NULL );
+	pthread_cond_init( &sys_workers.wake, NULL );
+	pthread_cond_init( &sys_workers.done, NULL );
+	sys_workers.shutdown = qfalse;
+	sys_workers.batch = 0;
+	sys_workers.numJobs = sys_workers.nextJob = sys_workers.pendingJobs = 0;
+
+	for ( i = 0 ; i < count ; i++ ) {
+		err = pthread_create( &sys_workers.threads[i], NULL, Sys_WorkerThread, NULL );
+		if ( err ) {
+			Com_Printf( "Sys_StartWorkers: pthread_create failed: %s\n", strerror( err ) );
+			break;
+		}
+	}
+	sys_workers.numThreads = i;
+
+	if ( !sys_workers.numThreads ) {
+		pthread_cond_destroy( &sys_workers.done );
+		pthread_cond_destroy( &sys_workers.wake );
+		pthread_mutex_destroy( &sys_workers.lock );
+	}
+
+	return sys_workers.numThreads;
+}
+
+/*
+==================
+Sys_StopWorkers
+==================
+*/
+void Sys_StopWorkers( void ) {
+	int i;
+
+	if ( !sys_workers.numThreads ) {
+		return;
+	}
+
+	pthread_mutex_lock( &sys_workers.lock );
+	sys_workers.shutdown = qtrue;
+	pthread_cond_broadcast( &sys_workers.wake );
+	pthread_mutex_unlock( &sys_workers.lock );
+
+	for ( i = 0 ; i < sys_workers.numThreads ; i++ ) {
+		pthread_join( sys_workers.threads[i], NULL );
+	}
+	sys_workers.numThreads = 0;
+
+	pthread_cond_destroy( &sys_workers.done );
+	pthread_cond_destroy( &sys_workers.wake );
+	pthread_mutex_destroy( &sys_workers.lock );
+}
+
+/*
+==================
+Sys_RunWorkers
+==================
+*/
+void Sys_RunWorkers( workerFunc_t func, void *data, int count ) {
+	int i;
+
+	if ( count <= 0 ) {
+		return;
+	}
+
+	if ( !sys_workers.numThreads || count == 1 ) {
+		for ( i = 0 ; i < count ; i++ ) {
+			func( data, i );
+		}
+		return;
+	}
+
+	pthread_mutex_lock( &sys_workers.lock );
+	sys_workers.func = func;
+	sys_workers.data = data;
+	sys_workers.numJobs = count;
+	sys_workers.nextJob = 0;
+	sys_workers.pendingJobs = count;
+	sys_workers.batch++;
+	com_workersActive = qtrue;
+	pthread_cond_broadcast( &sys_workers.wake );
+
+	Sys_WorkerRunJobs();
+
+	while ( sys_workers.pendingJobs ) {
+		pthread_cond_wait( &sys_workers.done, &sys_workers.lock );
+	}
+	com_workersActive = qfalse;
+	pthread_mutex_unlock( &sys_workers.lock );
+}
+
+/*
+==============================================================
+
+BACKGROUND JOBS
+
+One thread that runs queued jobs in order while the main thread carries on.
+The thread is started by the first job and stays around until exit.  If it
+can't be started the jobs simply run when they are queued.
+
+==============================================================
+*/
+
+typedef struct {
+	pthread_t thread;
+	qboolean started;
+	qboolean failed;
+
+	pthread_mutex_t lock;
+	pthread_cond_t wake;                // signaled when a job is queued
+	pthread_cond_t done;                // signaled when a job finishes
+
+	backgroundFunc_t funcs[MAX_BACKGROUND_JOBS];
+	void            *data[MAX_BACKGROUND_JOBS];
+	int queued;                         // tickets handed out so far
+	int finished;                       // jobs run so far, the oldest pending job is finished % MAX_BACKGROUND_JOBS
+} sysBackground_t;
+
+static sysBackground_t sys_background = { 0, qfalse, qfalse, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER };
+
+static void *Sys_BackgroundThread( void *arg ) {
+	backgroundFunc_t func;
+	void            *data;
+	int job;
+
+	pthread_mutex_lock( &sys_background.lock );
+	while ( 1 ) {
+		while ( sys_background.finished == sys_background.queued ) {
+			pthread_cond_wait( &sys_background.wake, &sys_background.lock );
+		}
+		job = sys_background.finished % MAX_BACKGROUND_JOBS;
+		func = sys_background.funcs[job];
+		data = sys_background.data[job];
+
+		pthread_mutex_unlock( &sys_background.lock );
+		func( data );
+		pthread_mutex_lock( &sys_background.lock );
+
+		sys_background.finished++;
+		pthread_cond_broadcast( &sys_background.done );
+	}
+
+	return NULL;
+}
+
+/*
+==================
+Sys_QueueBackgroundJob
+==================
+*/
+int Sys_QueueBackgroundJob( backgroundFunc_t func, void *data ) {
+	int err, job;
+
+	if ( !sys_background.started && !sys_background.failed ) {
+		err = pthread_create( &sys_background.thread, NULL, Sys_BackgroundThread, NULL );
+		if ( err ) {
+			Com_Printf( "Sys_QueueBackgroundJob: pthread_create failed: %s\n", strerror( err ) );
+			sys_background.failed = qtrue;
+		} else {
+			pthread_detach( sys_background.thread );
+			sys_background.started = qtrue;
+		}
+	}
+
+	if ( !sys_background.started ) {
+		func( data );
+		sys_background.finished++;
+		return ++sys_background.queued;
+	}
+
+	pthread_mutex_lock( &sys_background.lock );
+	while ( sys_background.queued - sys_background.finished >= MAX_BACKGROUND_JOBS ) {
+		pthread_cond_wait( &sys_background.done, &sys_background.lock );
+	}
+	job = sys_background.queued % MAX_BACKGROUND_JOBS;
+	sys_background.funcs[job] = func;
+	sys_background.data[job] = data;
+	job = ++sys_background.queued;
+	pthread_cond_signal( &sys_background.wake );
+	pthread_mutex_unlock( &sys_background.lock );
+
+	return job;
+}
+
+/*
+==================
+Sys_WaitBackgroundJob
+==================
+*/
+void Sys_WaitBackgroundJob( int ticket ) {
+	if ( !sys_background.started ) {
+		return;
+	}
+
+	pthread_mutex_lock( &sys_background.lock );
+	while ( sys_background.finished < ticket ) {
+		pthread_cond_wait( &sys_background.done, &sys_background.lock );
+	}
+	pthread_mutex_unlock( &sys_background.lock );
+}
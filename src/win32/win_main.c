@@ -39,6 +39,8 @@ If you have questions concerning this license or the applicable additional terms
 #include <direct.h>
 #include <io.h>
 #include <conio.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #define CD_BASEDIR  "et"
 #define CD_EXE      "et.exe"
@@ -429,6 +431,72 @@ void    Sys_FreeFileList( char **list ) {
 	Z_Free( list );
 }
 
+/*
+================
+Sys_MapFile
+================
+*/
+void *Sys_MapFile( const char *path, int *length ) {
+	HANDLE file, mapping;
+	DWORD size, sizeHigh;
+	void *data;
+
+	file = CreateFile( path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+	if ( file == INVALID_HANDLE_VALUE ) {
+		return NULL;
+	}
+
+	size = GetFileSize( file, &sizeHigh );
+	if ( size == 0xffffffff || sizeHigh || !size || size > 0x7fffffff ) {
+		CloseHandle( file );
+		return NULL;
+	}
+
+	mapping = CreateFileMapping( file, NULL, PAGE_READONLY, 0, 0, NULL );
+	CloseHandle( file );
+	if ( !mapping ) {
+		return NULL;
+	}
+
+	// the view keeps the mapping and the file open
+	data = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+	CloseHandle( mapping );
+	if ( !data ) {
+		return NULL;
+	}
+
+	*length = (int)size;
+	return data;
+}
+
+/*
+================
+Sys_UnmapFile
+================
+*/
+void Sys_UnmapFile( void *data, int length ) {
+	if ( data ) {
+		UnmapViewOfFile( data );
+	}
+}
+
+/*
+================
+Sys_FileStat
+================
+*/
+qboolean Sys_FileStat( const char *path, int *size, int *mtime ) {
+	struct _stat st;
+
+	if ( _stat( path, &st ) == -1 || st.st_size > 0x7fffffff ) {
+		return qfalse;
+	}
+
+	*size = (int)st.st_size;
+	*mtime = (int)st.st_mtime;
+	return qtrue;
+}
+
 //========================================================
 
 
@@ -315,6 +315,13 @@ qboolean Sys_GetPacket( netadr_t *net_from, msg_t *net_message ) {
 
 //=============================================================================
 
+// no batched socket calls on win32, packets go out as they are sent
+void Sys_BeginPacketBatch( void ) {
+}
+
+void Sys_FlushPacketBatch( void ) {
+}
+
 static char socksBuf[4096];
 
 /*
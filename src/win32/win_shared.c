@@ -60,6 +60,26 @@ int Sys_Milliseconds( void ) {
 	return sys_curtime;
 }
 
+/*
+================
+Sys_Microseconds
+================
+*/
+int Sys_Microseconds( void ) {
+	static LARGE_INTEGER base, freq;
+	LARGE_INTEGER now;
+	LONGLONG ticks;
+
+	if ( !freq.QuadPart ) {
+		QueryPerformanceFrequency( &freq );
+		QueryPerformanceCounter( &base );
+	}
+	QueryPerformanceCounter( &now );
+
+	ticks = now.QuadPart - base.QuadPart;
+	return (int)( ( ticks / freq.QuadPart ) * 1000000 + ( ticks % freq.QuadPart ) * 1000000 / freq.QuadPart );
+}
+
 /*
 ================
 Sys_SnapVector
@@ -584,3 +604,297 @@ char *Sys_GetCurrentUser( void ) {
 
 	return s_userName;
 }
+
+/*
+==============================================================
+
+WORKER THREADS
+
+A small pool of threads used to split data parallel work, such as building
+client snapshots, across processors.  Jobs are handed out one index at a time,
+the calling thread works on the batch as well and only returns once every job
+of the batch has completed.
+
+==============================================================
+*/
+
+typedef struct {
+	HANDLE threads[MAX_SYS_WORKERS];
+	int numThreads;
+
+	CRITICAL_SECTION lock;
+	HANDLE wake;                        // semaphore, released once per thread for each batch
+	HANDLE done;                        // auto reset, set when the last job of a batch finishes
+
+	workerFunc_t func;
+	void            *data;
+	int numJobs;
+	int nextJob;
+	int pendingJobs;
+	qboolean shutdown;
+} sysWorkers_t;
+
+static sysWorkers_t sys_workers;
+
+/*
+==================
+Sys_WorkerRunJobs
+
+Takes jobs from the current batch until none are left
+==================
+*/
+static void Sys_WorkerRunJobs( void ) {
+	int job;
+
+	EnterCriticalSection( &sys_workers.lock );
+	while ( sys_workers.nextJob < sys_workers.numJobs ) {
+		job = sys_workers.nextJob++;
+
+		LeaveCriticalSection( &sys_workers.lock );
+		sys_workers.func( sys_workers.data, job );
+		EnterCriticalSection( &sys_workers.lock );
+
+		if ( --sys_workers.pendingJobs == 0 ) {
+			SetEvent( sys_workers.done );
+		}
+	}
+	LeaveCriticalSection( &sys_workers.lock );
+}
+
+static DWORD WINAPI Sys_WorkerThread( LPVOID arg ) {
+	while ( 1 ) {
+		WaitForSingleObject( sys_workers.wake, INFINITE );
+		if ( sys_workers.shutdown ) {
+			break;
+		}
+		Sys_WorkerRunJobs();
+	}
+
+	return 0;
+}
+
+/*
+==================
+Sys_StartWorkers
+==================
+*/
+int Sys_StartWorkers( int count ) {
+	int i;
+	DWORD threadId;
+
+	Sys_StopWorkers();
+
+	if ( count > MAX_SYS_WORKERS ) {
+		count = MAX_SYS_WORKERS;
+	}
+	if ( count <= 0 ) {
+		return 0;
+	}
+
+	InitializeCriticalSection( &sys_workers.lock );
+	sys_workers.wake = CreateSemaphore( NULL, 0, MAX_SYS_WORKERS * 2, NULL );
+	sys_workers.done = CreateEvent( NULL, FALSE, FALSE, NULL );
+	sys_workers.shutdown = qfalse;
+	sys_workers.numJobs = sys_workers.nextJob = sys_workers.pendingJobs = 0;
+
+	for ( i = 0 ; i < count ; i++ ) {
+		sys_workers.threads[i] = CreateThread( NULL, 0, Sys_WorkerThread, NULL, 0, &threadId );
+		if ( !sys_workers.threads[i] ) {
+			Com_Printf( "Sys_StartWorkers: CreateThread failed: %i\n", (int)GetLastError() );
+			break;
+		}
+	}
+	sys_workers.numThreads = i;
+
+	if ( !sys_workers.numThreads ) {
+		CloseHandle( sys_workers.done );
+		CloseHandle( sys_workers.wake );
+		DeleteCriticalSection( &sys_workers.lock );
+	}
+
+	return sys_workers.numThreads;
+}
+
+/*
+==================
+Sys_StopWorkers
+==================
+*/
+void Sys_StopWorkers( void ) {
+	int i;
+
+	if ( !sys_workers.numThreads ) {
+		return;
+	}
+
+	sys_workers.shutdown = qtrue;
+	ReleaseSemaphore( sys_workers.wake, sys_workers.numThreads, NULL );
+	WaitForMultipleObjects( sys_workers.numThreads, sys_workers.threads, TRUE, INFINITE );
+
+	for ( i = 0 ; i < sys_workers.numThreads ; i++ ) {
+		CloseHandle( sys_workers.threads[i] );
+	}
+	sys_workers.numThreads = 0;
+
+	CloseHandle( sys_workers.done );
+	CloseHandle( sys_workers.wake );
+	DeleteCriticalSection( &sys_workers.lock );
+}
+
+/*
+==================
+Sys_RunWorkers
+==================
+*/
+void Sys_RunWorkers( workerFunc_t func, void *data, int count ) {
+	int i;
+
+	if ( count <= 0 ) {
+		return;
+	}
+
+	if ( !sys_workers.numThreads || count == 1 ) {
+		for ( i = 0 ; i < count ; i++ ) {
+			func( data, i );
+		}
+		return;
+	}
+
+	EnterCriticalSection( &sys_workers.lock );
+	sys_workers.func = func;
+	sys_workers.data = data;
+	sys_workers.numJobs = count;
+	sys_workers.nextJob = 0;
+	sys_workers.pendingJobs = count;
+	ResetEvent( sys_workers.done );
+	com_workersActive = qtrue;
+	LeaveCriticalSection( &sys_workers.lock );
+
+	ReleaseSemaphore( sys_workers.wake, sys_workers.numThreads, NULL );
+
+	Sys_WorkerRunJobs();
+
+	WaitForSingleObject( sys_workers.done, INFINITE );
+	com_workersActive = qfalse;
+}
+
+/*
+==============================================================
+
+BACKGROUND JOBS
+
+One thread that runs queued jobs in order while the main thread carries on.
+The thread is started by the first job and stays around until exit.  If it
+can't be started the jobs simply run when they are queued.
+
+==============================================================
+*/
+
+typedef struct {
+	HANDLE thread;
+	qboolean started;
+	qboolean failed;
+
+	CRITICAL_SECTION lock;
+	HANDLE wake;                        // semaphore, released once for each queued job
+	HANDLE done;                        // auto reset, set when a job finishes
+
+	backgroundFunc_t funcs[MAX_BACKGROUND_JOBS];
+	void            *data[MAX_BACKGROUND_JOBS];
+	int queued;                         // tickets handed out so far
+	int finished;                       // jobs run so far, the oldest pending job is finished % MAX_BACKGROUND_JOBS
+} sysBackground_t;
+
+static sysBackground_t sys_background;
+
+static DWORD WINAPI Sys_BackgroundThread( LPVOID arg ) {
+	backgroundFunc_t func;
+	void            *data;
+	int job;
+
+	while ( 1 ) {
+		WaitForSingleObject( sys_background.wake, INFINITE );
+
+		EnterCriticalSection( &sys_background.lock );
+		job = sys_background.finished % MAX_BACKGROUND_JOBS;
+		func = sys_background.funcs[job];
+		data = sys_background.data[job];
+		LeaveCriticalSection( &sys_background.lock );
+
+		func( data );
+
+		EnterCriticalSection( &sys_background.lock );
+		sys_background.finished++;
+		LeaveCriticalSection( &sys_background.lock );
+		SetEvent( sys_background.done );
+	}
+
+	return 0;
+}
+
+/*
+==================
+Sys_QueueBackgroundJob
+==================
+*/
+int Sys_QueueBackgroundJob( backgroundFunc_t func, void *data ) {
+	int job;
+	DWORD threadId;
+
+	if ( !sys_background.started && !sys_background.failed ) {
+		InitializeCriticalSection( &sys_background.lock );
+		sys_background.wake = CreateSemaphore( NULL, 0, MAX_BACKGROUND_JOBS, NULL );
+		sys_background.done = CreateEvent( NULL, FALSE, FALSE, NULL );
+		sys_background.thread = CreateThread( NULL, 0, Sys_BackgroundThread, NULL, 0, &threadId );
+		if ( !sys_background.thread ) {
+			Com_Printf( "Sys_QueueBackgroundJob: CreateThread failed: %i\n", (int)GetLastError() );
+			CloseHandle( sys_background.done );
+			CloseHandle( sys_background.wake );
+			DeleteCriticalSection( &sys_background.lock );
+			sys_background.failed = qtrue;
+		} else {
+			sys_background.started = qtrue;
+		}
+	}
+
+	if ( !sys_background.started ) {
+		func( data );
+		sys_background.finished++;
+		return ++sys_background.queued;
+	}
+
+	EnterCriticalSection( &sys_background.lock );
+	while ( sys_background.queued - sys_background.finished >= MAX_BACKGROUND_JOBS ) {
+		LeaveCriticalSection( &sys_background.lock );
+		WaitForSingleObject( sys_background.done, INFINITE );
+		EnterCriticalSection( &sys_background.lock );
+	}
+	job = sys_background.queued % MAX_BACKGROUND_JOBS;
+	sys_background.funcs[job] = func;
+	sys_background.data[job] = data;
+	job = ++sys_background.queued;
+	LeaveCriticalSection( &sys_background.lock );
+
+	ReleaseSemaphore( sys_background.wake, 1, NULL );
+
+	return job;
+}
+
+/*
+==================
+Sys_WaitBackgroundJob
+==================
+*/
+void Sys_WaitBackgroundJob( int ticket ) {
+	if ( !sys_background.started ) {
+		return;
+	}
+
+	EnterCriticalSection( &sys_background.lock );
+	while ( sys_background.finished < ticket ) {
+		LeaveCriticalSection( &sys_background.lock );
+		WaitForSingleObject( sys_background.done, INFINITE );
+		EnterCriticalSection( &sys_background.lock );
+	}
+	LeaveCriticalSection( &sys_background.lock );
+}